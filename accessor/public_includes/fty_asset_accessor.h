@@ -23,14 +23,27 @@
 
 #include <fty_asset_dto.h>
 #include <fty/expected.h>
+#include <functional>
 #include <list>
 #include <string>
 
+namespace messagebus
+{
+    class MessageBus;
+}
+
 namespace fty
 {
     class AssetAccessor
     {
     public:
+        /// creates the bus client of each request, same signature as messagebus::MlmMessageBus
+        using MsgBusFactory =
+            std::function<messagebus::MessageBus*(const std::string& endpoint, const std::string& clientName)>;
+
+        /// replaces the malamute client, e.g. by fty::LocalBroker in benchmarks; set it before any request
+        static void setMessageBusFactory(const MsgBusFactory& factory);
+
         static fty::Expected<uint32_t> assetInameToID(const std::string& iname);
         static fty::Expected<fty::Asset> getAsset(const std::string& iname);
         static void notifyStatusUpdate(const std::string& iname, const std::string& oldStatus, const std::string& newStatus);
@@ -40,6 +40,17 @@ namespace fty
     static constexpr const char *ACCESSOR_NAME = "fty-asset-accessor";
     static constexpr const char *ENDPOINT = "ipc://@/malamute";
 
+    static AssetAccessor::MsgBusFactory& busFactory()
+    {
+        static AssetAccessor::MsgBusFactory factory = messagebus::MlmMessageBus;
+        return factory;
+    }
+
+    void AssetAccessor::setMessageBusFactory(const MsgBusFactory& factory)
+    {
+        busFactory() = factory;
+    }
+
     /// static helper to send a MessageBus synchronous request
     static messagebus::Message sendSyncReq(const std::string& command, messagebus::UserData data)
     {
@@ -49,7 +60,7 @@ namespace fty
 
         std::string clientName = ss.str();
 
-        std::unique_ptr<messagebus::MessageBus> interface(messagebus::MlmMessageBus(ENDPOINT, clientName));
+        std::unique_ptr<messagebus::MessageBus> interface(busFactory()(ENDPOINT, clientName));
         messagebus::Message msg;
 
         interface->connect();
@@ -74,7 +85,7 @@ namespace fty
 
         std::string clientName = ss.str();
 
-        std::unique_ptr<messagebus::MessageBus> interface(messagebus::MlmMessageBus(ENDPOINT, clientName));
+        std::unique_ptr<messagebus::MessageBus> interface(busFactory()(ENDPOINT, clientName));
         messagebus::Message msg;
 
         interface->connect();
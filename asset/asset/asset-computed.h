@@ -24,8 +24,21 @@
  * \brief Helper functions for computed values for assets
  */
 #pragma once
+#include <cstdint>
 #include <map>
 #include <string>
 
+/// Computed figures of one rack, with the same values as free_u_size and rack_outlets_available
+struct RackComputed
+{
+    int                        freeUSize = -1;
+    std::map<std::string, int> outlets; // "sum" and free outlets per (e)PDU id, -1 where unknown
+};
+
+using RackComputedMap = std::map<uint32_t, RackComputed>;
+
 int free_u_size(uint32_t elementId);
 int rack_outlets_available(uint32_t elementId, std::map<std::string, int>& res);
+
+/// Figures of every rack in the datacenter in two queries, returns 0 or -1 on database failure
+int racks_computed(uint32_t datacenterId, RackComputedMap& res);
@@ -2,10 +2,27 @@
 
 #include "asset-db.h"
 #include <fty_common_asset_types.h>
+#include <functional>
 #include <vector>
 
+namespace messagebus {
+class MessageBus;
+}
+
 namespace fty::asset {
 
+/// creates the bus client of a configure publisher, same signature as messagebus::MlmMessageBus
+using ConfigureBusFactory =
+    std::function<messagebus::MessageBus*(const std::string& endpoint, const std::string& clientName)>;
+
+/// Publishes through bus clients instead of malamute, e.g. fty::LocalBroker in benchmarks; an empty factory restores
+/// malamute. The stream messages go to the FTY_PROTO_STREAM_ASSETS topic, REPUBLISH requests to the "asset-agent"
+/// queue, and a flush has nothing to wait for. Clients of the previous factory are destroyed.
+void setConfigureBusFactory(const ConfigureBusFactory& factory);
+
+/// Publishes the rows on the assets stream and asks fty-asset to republish created/updated ones.
+/// All calls of the process share one client that stays connected between them, agentName only prefixes the error of a
+/// failure; returns once the broker has received everything.
 Expected<void> sendConfigure(
     const std::vector<std::pair<db::AssetElement, persist::asset_operation>>& rows, const std::string& agentName);
 
@@ -228,6 +228,14 @@ Expected<uint16_t> selectMonitorDeviceTypeId(fty::db::Connection& conn, const st
 /// @return nothing or error
 Expected<void> selectAssetElementSuperParent(uint32_t id, SelectCallback&& cb); //! test
 
+/// Selects parents of several devices in one query, the row id column tells them apart
+/// @param conn database established connection
+/// @param ids asset element ids
+/// @param cb callback function
+/// @return nothing or error
+Expected<void> selectAssetElementSuperParents(
+    fty::db::Connection& conn, const std::vector<uint32_t>& ids, SelectCallback&& cb);
+
 /// Selects assets from given container (DB, room, rack, ...) without - accepted values: "location", "powerchain" or
 /// empty string
 /// @param conn database established connection
@@ -272,6 +280,11 @@ Expected<std::map<uint32_t, std::string>> selectShortElements(uint16_t typeId, u
 /// @return count or error
 Expected<int> countKeytag(const std::string& keytag, const std::string& value); //! test
 
+/// Counts active devices of the given subtypes
+/// @param subtypes device subtype ids
+/// @return count or error
+Expected<int> countActiveDevices(const std::vector<uint16_t>& subtypes);
+
 /// Converts asset id to monitor id
 /// @param assetElementId asset element id
 /// @return monitor id or error
@@ -300,6 +313,12 @@ Expected<uint> deleteAssetGroupLinks(fty::db::Connection& conn, uint32_t assetGr
 /// @return list of children or error
 Expected<std::vector<uint32_t>> selectAssetsByParent(uint32_t parentId);
 
+/// Selects u_size and location_u_pos of a rack and of all its children in one query
+/// @param rackId rack id
+/// @param cb callback function, rows have id, u_size and u_pos columns (empty when not set)
+/// @return nothing or error
+Expected<void> selectRackUPositions(uint32_t rackId, SelectCallback&& cb);
+
 /// Selects all corresponding links for element
 /// @param elementId element id
 /// @return list of devices where element is linked or error
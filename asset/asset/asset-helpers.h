@@ -2,6 +2,7 @@
 #include "error.h"
 #include <fty/expected.h>
 #include <string>
+#include <vector>
 
 namespace fty {
 class FullAsset;
@@ -21,6 +22,9 @@ namespace activation {
     AssetExpected<bool> isActivable(const std::string& assetJson);
     AssetExpected<void> activate(const std::string& assetJson);
     AssetExpected<void> deactivate(const std::string& assetJson);
+
+    /// activates the assets in a few exchanges with the activator, one result per asset
+    std::vector<AssetExpected<void>> activate(const std::vector<std::string>& assetsJson);
 } // namespace activation
 
 } // namespace fty::asset
@@ -4,6 +4,7 @@
 #include <fty_common_asset_types.h>
 #include <map>
 #include <set>
+#include <vector>
 
 namespace tntdb {
 class Connection;
@@ -30,6 +31,7 @@ private:
     std::string                        mandatoryMissing() const;
     std::map<std::string, std::string> sanitizeRowExtNames(size_t row, bool sanitize) const;
     AssetExpected<db::AssetElement>    processRow(size_t row, const std::set<uint32_t>& ids, bool sanitize, bool checkLic);
+    void                               activatePending();
     uint16_t                           getPriority(const std::string& s) const;
     bool                               isDate(const std::string& key) const;
     std::string                        matchExtAttr(const std::string& value, const std::string& key) const;
@@ -57,9 +59,18 @@ private:
         const std::map<std::string, std::string>& extattributesRO) const;
 
 private:
+    struct Activation
+    {
+        size_t   row;
+        uint32_t id;
+        bool     power;
+        bool     created;
+    };
+
     const CsvMap&            m_cm;
     ImportResMap             m_el;
     persist::asset_operation m_operation;
+    std::vector<Activation>  m_activate; // rows stored as nonactive, waiting for activation
 };
 
 } // namespace fty::asset
@@ -1,5 +1,8 @@
 #pragma once
 #include "error.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
 
 namespace fty::asset {
 
@@ -9,8 +12,32 @@ struct LimitationsStruct
     int global_configurability;
 };
 
+/// Limitations of the license, cached for the whole process.
+/// The cache follows LICENSING-ANNOUNCEMENTS, etn-licensing is asked only when nothing was heard within the
+/// staleness bound.
 AssetExpected<LimitationsStruct> getLicensingLimitation();
 
-}
+/// Applies one announced metric to the cache, returns false if it is not a limitation
+bool updateLicensingLimitation(const std::string& name, const std::string& type, const std::string& value);
+
+/// Replaces the cached limitations as if etn-licensing had just answered, e.g. in tests
+void setLicensingLimitation(const LimitationsStruct& limitations);
+
+/// How long cached limitations and the active device count are trusted, 60 s by default
+void setLicensingStaleness(std::chrono::seconds staleness);
+
+/// Device subtypes counted against max_active_power_devices
+bool isPowerDevice(uint16_t subtypeId);
 
+/// Active power devices, counted in the database once per staleness bound and kept up to date in between.
+/// recount skips the cache, other processes change the count too and a rejection must not rest on a stale one.
+AssetExpected<int> activePowerDevices(bool recount = false);
 
+/// Adjusts the count after this process activated (+1), deactivated or deleted (-1) an active power device
+void activePowerDevicesChanged(int delta);
+
+/// Stops following LICENSING-ANNOUNCEMENTS, to be called before the process exits as statics do not stop it.
+/// The next getLicensingLimitation() starts following them again.
+void destroyLicensingCache();
+
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+
+namespace fty::asset {
+
+/// Shared memory metrics of a set of assets, read in one directory pass.
+///
+/// Meant to live as long as one request: values are not refreshed, and assets outside the set are not covered, the
+/// caller reads those one by one as before.
+class MetricSnapshot
+{
+public:
+    MetricSnapshot() = default;
+
+    /// reads the listed metrics (all of them if empty) of the assets
+    explicit MetricSnapshot(const std::set<std::string>& assets, const std::set<std::string>& metrics = {});
+
+    /// true if metrics of the asset were read, even if it has none; false for all if reading failed
+    bool covers(const std::string& asset) const;
+
+    std::optional<std::string> value(const std::string& asset, const std::string& metric) const;
+
+    /// NaN if the value is not a number
+    std::optional<double> number(const std::string& asset, const std::string& metric) const;
+
+    /// count of metrics read
+    size_t size() const;
+
+private:
+    std::set<std::string>                                     m_assets;
+    std::map<std::string, std::map<std::string, std::string>> m_values;
+};
+
+} // namespace fty::asset
@@ -0,0 +1,67 @@
+#pragma once
+#include "error.h"
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace fty::asset {
+
+/// Occupied U positions of racks, one bit per U.
+///
+/// A rack is loaded with a single query for itself and all its children, then kept up to date by place() and
+/// remove() for changes made by this process. Racks not loaded within the staleness bound are read again, which
+/// catches changes made elsewhere.
+class RackOccupancy
+{
+public:
+    static RackOccupancy& instance();
+
+    /// checks that size U starting at loc (1 based) fit into the rack, ignoring asset id itself
+    AssetExpected<void> check(uint32_t rackId, uint32_t id, uint32_t size, uint32_t loc);
+
+    /// lowest position where size U fit, 0 if there is none
+    AssetExpected<uint32_t> findFirstFit(uint32_t rackId, uint32_t size);
+
+    /// records asset id at loc in the rack, moves it if it was placed elsewhere
+    void place(uint32_t rackId, uint32_t id, uint32_t size, uint32_t loc);
+
+    /// forgets the position of asset id, or the whole rack if id is a rack
+    void remove(uint32_t id);
+
+    void clear();
+
+    void setStaleness(std::chrono::seconds staleness);
+
+private:
+    struct Slot
+    {
+        uint32_t loc;
+        uint32_t size;
+    };
+
+    struct Rack
+    {
+        uint32_t                              size = 0; // U, 0 if the rack has no u_size
+        std::vector<uint64_t>                 bits;
+        std::map<uint32_t, Slot>              assets;
+        std::chrono::steady_clock::time_point loaded;
+
+        void set(const Slot& slot);
+        void rebuild(uint32_t except = 0);
+        bool isFree(uint32_t loc, uint32_t size, uint32_t& blocker) const;
+    };
+
+    RackOccupancy() = default;
+
+    AssetExpected<Rack*> rack(uint32_t rackId);
+
+    std::mutex                             m_lock;
+    std::unordered_map<uint32_t, Rack>     m_racks;
+    std::unordered_map<uint32_t, uint32_t> m_parent; // asset id -> rack id
+    std::chrono::seconds                   m_staleness{10};
+};
+
+} // namespace fty::asset
@@ -1,8 +1,19 @@
 #pragma once
+#include "asset/asset-computed.h"
+#include "asset/asset-metrics.h"
 #include <string>
 
 namespace fty::asset {
 
 std::string getJsonAsset(uint32_t elemId);
 
+/// Figures read once for all assets of a listing, assets not found here are read one by one
+struct JsonCache
+{
+    RackComputedMap racks; // see racks_computed
+    MetricSnapshot  metrics;
+};
+
+std::string getJsonAsset(uint32_t elemId, const JsonCache& cache);
+
 }
@@ -0,0 +1,234 @@
+#include "asset/asset-computed.h"
+#include "asset/asset-configure-inform.h"
+#include "asset/asset-manager.h"
+#include "asset/asset-metrics.h"
+#include "asset/asset-rack-occupancy.h"
+#include "asset/json.h"
+#include "test-db/generator.h"
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <fty_asset_fake_activator.h>
+#include <fty_asset_local_bus.h>
+#include <fty_common_db_connection.h>
+#include <fty_common_messagebus.h>
+#include <fty_proto.h>
+#include <thread>
+
+// Sizes are asset counts of the generated datacenter, see fty::GeneratorConfig::forAssets
+
+static bool prepare(benchmark::State& state, fty::Generated& data)
+{
+    auto ret = fty::Generator::dataset(uint64_t(state.range(0)));
+    if (!ret) {
+        state.SkipWithError(ret.error().c_str());
+        return false;
+    }
+    data = *ret;
+    return true;
+}
+
+static std::vector<std::string> names(const std::vector<uint32_t>& ids)
+{
+    std::vector<std::string> ret;
+    fty::db::Connection      conn;
+    for (uint32_t id : ids) {
+        ret.push_back(conn.selectRow("SELECT name FROM t_bios_asset_element WHERE id_asset_element = :id",
+            "id"_p = id).get("name"));
+    }
+    return ret;
+}
+
+// =====================================================================================================================
+
+static void exportCsv(benchmark::State& state)
+{
+    fty::Generated data;
+    if (!prepare(state, data)) {
+        return;
+    }
+
+    for (auto _ : state) {
+        auto csv = fty::asset::AssetManager::exportCsv();
+        if (!csv) {
+            state.SkipWithError(csv.error().toString().c_str());
+            break;
+        }
+        benchmark::DoNotOptimize(csv->size());
+    }
+    state.counters["assets"] = double(data.assets);
+}
+BENCHMARK(exportCsv)->Arg(1000)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+static void importCsv(benchmark::State& state)
+{
+    fty::Generated data;
+    if (!prepare(state, data)) {
+        return;
+    }
+    auto csv = fty::asset::AssetManager::exportCsv();
+    if (!csv) {
+        state.SkipWithError(csv.error().toString().c_str());
+        return;
+    }
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        fty::Generator::clear();
+        state.ResumeTiming();
+
+        // no notifications, no licensing nor activation
+        auto ret = fty::asset::AssetManager::importCsv(*csv, "bench", false);
+        if (!ret) {
+            state.SkipWithError(ret.error().toString().c_str());
+            break;
+        }
+    }
+    state.counters["assets"] = double(data.assets);
+
+    // the imported assets have other ids than the generated ones
+    fty::Generator::clear();
+}
+BENCHMARK(importCsv)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond)->Iterations(3);
+
+// =====================================================================================================================
+
+// JSON of the racks of one datacenter, as a listing renders them
+static void rackJson(benchmark::State& state)
+{
+    fty::Generated data;
+    if (!prepare(state, data)) {
+        return;
+    }
+    bool cached = state.range(1);
+
+    size_t                count = std::min<size_t>(data.racks.size(), 200);
+    std::vector<uint32_t> racks(data.racks.begin(), data.racks.begin() + long(count));
+    auto                  rackNames = names(racks);
+
+    for (auto _ : state) {
+        if (!cached) {
+            for (uint32_t rack : racks) {
+                benchmark::DoNotOptimize(fty::asset::getJsonAsset(rack));
+            }
+            continue;
+        }
+
+        fty::asset::JsonCache cache;
+        racks_computed(data.datacenters.front(), cache.racks);
+        cache.metrics = fty::asset::MetricSnapshot({rackNames.begin(), rackNames.end()}, {"realpower.nominal"});
+        for (uint32_t rack : racks) {
+            benchmark::DoNotOptimize(fty::asset::getJsonAsset(rack, cache));
+        }
+    }
+    state.counters["racks"] = double(racks.size());
+}
+BENCHMARK(rackJson)
+    ->ArgNames({"assets", "cached"})
+    ->Args({10000, 0})
+    ->Args({10000, 1})
+    ->Unit(benchmark::kMillisecond);
+
+static void rackFirstFit(benchmark::State& state)
+{
+    fty::Generated data;
+    if (!prepare(state, data)) {
+        return;
+    }
+
+    auto& occupancy = fty::asset::RackOccupancy::instance();
+    occupancy.clear();
+    for (auto _ : state) {
+        for (uint32_t rack : data.racks) {
+            benchmark::DoNotOptimize(occupancy.findFirstFit(rack, 2));
+        }
+    }
+    state.counters["racks"] = double(data.racks.size());
+}
+BENCHMARK(rackFirstFit)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+// =====================================================================================================================
+
+// one exchange per asset against batches, with a simulated round trip to the activator
+static void activation(benchmark::State& state)
+{
+    size_t assets = size_t(state.range(0));
+    bool   batch  = state.range(1);
+
+    std::vector<std::string> payloads(assets, R"({"id":"server","type":"device","subtype":"server"})");
+
+    uint64_t before = fty::activation::exchanges();
+    for (auto _ : state) {
+        fty::activation::FakeActivator fake(assets);
+        auto                           transport = fake.transport();
+        fty::activation::setTransport([&](const std::vector<std::string>& payload) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            return transport(payload);
+        });
+
+        if (batch) {
+            benchmark::DoNotOptimize(fty::activation::activate(payloads));
+        } else {
+            for (const auto& payload : payloads) {
+                benchmark::DoNotOptimize(fty::activation::activate({payload}));
+            }
+        }
+    }
+    fty::activation::setTransport({});
+
+    state.counters["exchanges"] =
+        benchmark::Counter(double(fty::activation::exchanges() - before), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(activation)
+    ->ArgNames({"assets", "batch"})
+    ->Args({1000, 0})
+    ->Args({1000, 1})
+    ->Unit(benchmark::kMillisecond);
+
+// =====================================================================================================================
+
+// configure notifications of a batch of devices through the in-process bus, the cost of the path without a broker
+static void configureInform(benchmark::State& state)
+{
+    fty::Generated data;
+    if (!prepare(state, data)) {
+        return;
+    }
+
+    std::vector<std::pair<fty::asset::db::AssetElement, persist::asset_operation>> rows;
+    for (uint32_t id : data.devices) {
+        if (rows.size() == size_t(state.range(1))) {
+            break;
+        }
+        auto element = fty::asset::db::selectAssetElementWebById(id);
+        if (!element) {
+            state.SkipWithError(element.error().c_str());
+            return;
+        }
+        rows.emplace_back(*element, persist::asset_operation::UPDATE);
+    }
+
+    fty::LocalBroker                        broker;
+    std::unique_ptr<messagebus::MessageBus> stream(broker.client("stream"));
+    uint64_t                                published = 0;
+    stream->subscribe(FTY_PROTO_STREAM_ASSETS, [&published](messagebus::Message) {
+        ++published;
+    });
+    fty::asset::setConfigureBusFactory(broker.factory());
+
+    for (auto _ : state) {
+        if (auto sent = fty::asset::sendConfigure(rows, "bench-configure"); !sent) {
+            state.SkipWithError(sent.error().c_str());
+            break;
+        }
+    }
+
+    // drops the bus client of the publisher before the broker goes away
+    fty::asset::setConfigureBusFactory({});
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(rows.size()));
+    state.counters["published"] = benchmark::Counter(double(published), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(configureInform)
+    ->ArgNames({"assets", "rows"})
+    ->Args({10000, 1000})
+    ->Unit(benchmark::kMillisecond);
@@ -19,29 +19,129 @@
  */
 
 #include "asset/asset-computed.h"
+#include "sql-trace.h"
+#include <fmt/format.h>
 #include <fty/convert.h>
 #include <fty_common.h>
-#include <fty_common_db_asset.h>
-#include <fty_common_db_dbpath.h>
-#include <functional>
-#include <tntdb/connection.h>
-#include <tntdb/row.h>
+#include <fty_common_asset_types.h>
+#include <fty_common_db_connection.h>
+#include <fty_log.h>
 
-static int s_get_devices_usize(tntdb::Connection& conn, std::set<uint32_t>& elements)
+// Both queries take the racks from v_bios_asset_element_super_parent AS r, the caller adds the WHERE
+// clause. Descendants are matched on any of the ten parent levels, as select_assets_by_container does.
+
+static std::string s_usize_sql()
 {
-    int size = 0;
+    static const std::string sql = R"(
+        SELECT
+            r.id_asset_element                              AS id,
+            COALESCE(MAX(rs.value), '')                     AS rack_size,
+            COUNT(d.id_asset_element)                       AS devices,
+            COALESCE(SUM(CAST(ds.value AS UNSIGNED)), 0)    AS used
+        FROM
+            v_bios_asset_element_super_parent AS r
+        LEFT JOIN
+            t_bios_asset_ext_attributes AS rs
+            ON rs.id_asset_element = r.id_asset_element AND rs.keytag = 'u_size'
+        LEFT JOIN
+            v_bios_asset_element_super_parent AS d
+            ON r.id_asset_element IN (
+                d.id_parent1, d.id_parent2, d.id_parent3,
+                d.id_parent4, d.id_parent5, d.id_parent6,
+                d.id_parent7, d.id_parent8, d.id_parent9,
+                d.id_parent10
+            )
+        LEFT JOIN
+            t_bios_asset_ext_attributes AS ds
+            ON ds.id_asset_element = d.id_asset_element AND ds.keytag = 'u_size'
+    )";
+    return sql;
+}
 
-    std::function<void(const tntdb::Row&)> sumarize = [&size](const tntdb::Row& row) {
-        uint32_t tmp = fty::convert<uint32_t>(row.getString("value"));
-        if (tmp != UINT32_MAX) {
-            size += int(tmp);
-        }
-    };
+static std::string s_outlets_sql()
+{
+    static const std::string sql = fmt::format(R"(
+        SELECT
+            r.id_asset_element                  AS rack,
+            d.id_asset_element                  AS id,
+            COALESCE(MAX(o.value), '')          AS outlets,
+            COUNT(l.id_asset_device_src)        AS used
+        FROM
+            v_bios_asset_element_super_parent AS r
+        INNER JOIN
+            v_bios_asset_element_super_parent AS d
+            ON r.id_asset_element IN (
+                d.id_parent1, d.id_parent2, d.id_parent3,
+                d.id_parent4, d.id_parent5, d.id_parent6,
+                d.id_parent7, d.id_parent8, d.id_parent9,
+                d.id_parent10
+            ) AND d.id_asset_device_type IN ({}, {})
+        LEFT JOIN
+            t_bios_asset_ext_attributes AS o
+            ON o.id_asset_element = d.id_asset_element AND o.keytag = 'outlet.count'
+        LEFT JOIN
+            t_bios_asset_link AS l
+            ON l.id_asset_device_src = d.id_asset_element
+    )", persist::EPDU, persist::PDU);
+    return sql;
+}
+
+static int s_usize(const std::string& value)
+{
+    if (value.empty()) {
+        return 0;
+    }
+    uint32_t size = fty::convert<uint32_t>(value);
+    return size != UINT32_MAX ? int(size) : 0;
+}
+
+static int s_free_u_size(const fty::db::Row& row)
+{
+    int rackSize = s_usize(row.get("rack_size"));
+    if (!rackSize) {
+        return -1;
+    }
+    if (row.get<uint32_t>("devices") == 0) {
+        return rackSize;
+    }
+    // devices without any size are reported as unknown, not as an empty rack
+    int used = row.get<int>("used");
+    if (!used) {
+        return -1;
+    }
+    return rackSize - used;
+}
+
+static int s_outlet_count(std::string value)
+{
+    if (value.empty()) {
+        return -1;
+    }
+
+    auto dot = value.find('.');
+    if (dot != std::string::npos) {
+        value.erase(dot);
+    }
+
+    // validation: too big values in DB are weird
+    // we're not going to have epdu with more 10K+ outlets
+    // in the near future - if so, then fix this code
+    if (value.size() > 5) {
+        return -1;
+    }
+
+    uint32_t count = fty::convert<uint32_t>(value);
+    return count != UINT32_MAX ? int(count) : -1;
+}
 
-    int rv = DBAssets::select_asset_ext_attribute_by_keytag(conn, "u_size", elements, sumarize);
-    if (rv != 0)
-        return rv;
-    return size;
+// free outlets of one (e)PDU row, -1 if unknown
+static int s_outlets_available(const fty::db::Row& row)
+{
+    int count = s_outlet_count(row.get("outlets"));
+    if (count == -1) {
+        return -1;
+    }
+    return count - row.get<int>("used");
 }
 
 /* TODO: function reports only success or -1 indicating some error, which will be expressed
@@ -49,37 +149,16 @@ static int s_get_devices_usize(tntdb::Connection& conn, std::set<uint32_t>& elem
  *       item.ecpp must be reworked substantially.*/
 int free_u_size(uint32_t elementId)
 {
+    static const std::string sql = s_usize_sql() + R"(
+        WHERE r.id_asset_element = :id
+        GROUP BY r.id_asset_element
+    )";
+
     try {
-        tntdb::Connection conn;
-        conn = tntdb::connect(DBConn::url);
-
-        // get the rack u_size
-        std::set<uint32_t> rack_id{elementId};
-        int                freeusize = s_get_devices_usize(conn, rack_id);
-        if (!freeusize) {
-            return -1;
-        }
-        log_debug("rack size is %i", freeusize);
-
-        // get id of the devices inside the rack
-        std::set<uint32_t>                     element_ids{};
-        std::function<void(const tntdb::Row&)> func = [&element_ids](const tntdb::Row& row) {
-            uint32_t asset_id = 0;
-            row["asset_id"].get(asset_id);
-            element_ids.insert(asset_id);
-        };
-
-        auto rv = DBAssets::select_assets_by_container(conn, elementId, func);
-        if (rv == -1) {
-            log_debug("free_u_size() rv is null");
-            return -1;
-        }
-        // substract sum( device size ) if there are some
-        int freeusize2 = s_get_devices_usize(conn, element_ids);
-        if (!freeusize2) {
-            return -1;
-        }
-        freeusize -= element_ids.empty() ? 0 : freeusize2;
+        fty::asset::TracedConnection conn;
+
+        auto row       = conn.selectRow(sql, "id"_p = elementId);
+        int  freeusize = s_free_u_size(row);
         log_debug("freeusize %d", freeusize);
         return freeusize;
     } catch (const std::exception& ex) {
@@ -88,73 +167,77 @@ int free_u_size(uint32_t elementId)
     }
 }
 
-static uint32_t s_select_outlet_count(tntdb::Connection& conn, uint32_t id)
+int rack_outlets_available(uint32_t elementId, std::map<std::string, int>& res)
 {
-    static const char* KEY = "outlet.count";
+    static const std::string sql = s_outlets_sql() + R"(
+        WHERE r.id_asset_element = :id
+        GROUP BY r.id_asset_element, d.id_asset_element
+    )";
 
-    std::map<std::string, std::pair<std::string, bool>> res;
-    int                                                 ret = DBAssets::select_ext_attributes(conn, id, res);
+    res["sum"] = -1;
 
-    if (ret != 0 || res.count(KEY) == 0)
-        return UINT32_MAX;
-
-    std::string foo   = res.at(KEY).first.c_str();
-    auto        dot_i = foo.find('.');
-    if (dot_i != std::string::npos) {
-        foo.erase(dot_i, foo.size() - dot_i);
+    int  sum     = 0;
+    bool tainted = false;
+    try {
+        fty::asset::TracedConnection conn;
+        for (const auto& row : conn.select(sql, "id"_p = elementId)) {
+            int count = s_outlets_available(row);
+            if (count >= 0) {
+                sum += count;
+            } else {
+                tainted = true;
+            }
+            res[row.get("id")] = count;
+        }
+    } catch (const std::exception& e) {
+        log_error("%s", e.what());
+        return -1;
     }
 
-    // validation: too big values in DB are weird
-    // we're not going to have epdu with more 10K+ outlets
-    // in the near future - if so, then fix this code
-    if (foo.size() > 5)
-        return UINT32_MAX;
-
-    return fty::convert<uint32_t>(foo);
+    if (!tainted) {
+        res["sum"] = sum;
+    }
+    return 0;
 }
 
-int rack_outlets_available(uint32_t elementId, std::map<std::string, int>& res)
+int racks_computed(uint32_t datacenterId, RackComputedMap& res)
 {
-    int               sum     = -1;
-    bool              tainted = false;
-    tntdb::Connection conn;
-    res["sum"] = sum;
-
-    std::function<void(const tntdb::Row& row)> cb = [&conn, &sum, &tainted, &res](const tntdb::Row& row) {
-        uint32_t device_subtype = 0;
-        row["subtype_id"].get(device_subtype);
-        if (!persist::is_epdu(int(device_subtype)) && !persist::is_pdu(int(device_subtype)))
-            return;
-
-        uint32_t device_asset_id = 0;
-        row["asset_id"].get(device_asset_id);
-
-        uint32_t foo          = s_select_outlet_count(conn, device_asset_id);
-        int      outlet_count = foo != UINT32_MAX ? int(foo) : -1;
-
-        int outlet_used = DBAssets::count_of_link_src(conn, device_asset_id);
-        if (outlet_used == -1)
-            outlet_count = -1;
-        else
-            outlet_count -= outlet_used;
-
-        if (outlet_count >= 0)
-            sum += outlet_count;
-        else
-            tainted = true;
-        res[std::to_string(device_asset_id)] = outlet_count;
-    };
-
-    int rv;
+    static const std::string where = fmt::format(R"(
+        WHERE r.id_type = {} AND :dcId IN (
+            r.id_parent1, r.id_parent2, r.id_parent3,
+            r.id_parent4, r.id_parent5, r.id_parent6,
+            r.id_parent7, r.id_parent8, r.id_parent9,
+            r.id_parent10
+        )
+    )", persist::RACK);
+
+    static const std::string usizeSql   = s_usize_sql() + where + " GROUP BY r.id_asset_element";
+    static const std::string outletsSql = s_outlets_sql() + where + " GROUP BY r.id_asset_element, d.id_asset_element";
+
     try {
-        conn = tntdb::connect(DBConn::url);
-        rv   = DBAssets::select_assets_by_container(conn, elementId, cb);
-    } catch (std::exception& e) {
-        log_error("%s", e.what());
+        fty::asset::TracedConnection conn;
+
+        for (const auto& row : conn.select(usizeSql, "dcId"_p = datacenterId)) {
+            RackComputed& rack = res[row.get<uint32_t>("id")];
+
+            rack.freeUSize      = s_free_u_size(row);
+            rack.outlets["sum"] = 0;
+        }
+
+        for (const auto& row : conn.select(outletsSql, "dcId"_p = datacenterId)) {
+            auto& outlets = res[row.get<uint32_t>("rack")].outlets;
+            int   count   = s_outlets_available(row);
+
+            outlets[row.get("id")] = count;
+            if (count < 0) {
+                outlets["sum"] = -1;
+            } else if (outlets["sum"] >= 0) {
+                outlets["sum"] += count;
+            }
+        }
+    } catch (const std::exception& e) {
+        log_error("racks_computed fails %s", e.what());
         return -1;
     }
-
-    if (!tainted)
-        res["sum"] = sum + 1; // sum is initialized to -1
-    return rv;
+    return 0;
 }
@@ -22,12 +22,16 @@
 #include <fty_common_db_connection.h>
 #include <fty_common.h>
 #include <fty_common_db.h>
+#include <fty_common_messagebus.h>
 #include <fty_common_mlm_utils.h>
 #include <fty_proto.h>
-#include <thread>
 #include <malamute.h>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <thread>
 #include <fty_log.h>
+#include <unistd.h>
 
 namespace fty::asset {
 
@@ -41,65 +45,285 @@ static zhash_t* s_map2zhash(const std::map<std::string, std::string>& m)
     return ret;
 }
 
-static bool getDcUPSes(fty::db::Connection& conn, const std::string& assetName, zhash_t* hash)
+static bool getDcUPSes(fty::db::Connection& conn, uint32_t dcId, std::vector<std::string>& listUps)
 {
-    std::vector<std::string> listUps;
-
     auto cb = [&listUps](const fty::db::Row& row) {
         listUps.push_back(row.get("name"));
     };
 
-    auto dcId = db::nameToAssetId(assetName);
-    if (!dcId) {
-        return false;
-    }
-
     auto rv = db::selectAssetsByContainer(
-        conn, *dcId, {persist::asset_type::DEVICE}, {persist::asset_subtype::UPS}, "", "active", cb);
+        conn, dcId, {persist::asset_type::DEVICE}, {persist::asset_subtype::UPS}, "", "active", cb);
 
-    if (!rv) {
-        return false;
-    }
-
-    int i = 0;
-    for (auto& ups : listUps) {
-        char key[14];
-        sprintf(key, "ups%d", i);
-        char* ups_name = strdup(ups.c_str());
-        zhash_insert(hash, key, reinterpret_cast<void*>(ups_name));
-        i++;
-    }
-    return true;
+    return bool(rv);
 }
 
-
 static void* voidify(const std::string& str)
 {
     return reinterpret_cast<void*>(const_cast<char*>(str.c_str()));
 }
 
-Expected<void> sendConfigure(
-    const std::vector<std::pair<db::AssetElement, persist::asset_operation>>& rows, const std::string& agentName)
+// names per REPUBLISH request, keeps single frames of an import reasonably small
+static constexpr size_t REPUBLISH_BATCH = 500;
+
+// how long a flush waits for its own message to come back from the broker
+static constexpr int FLUSH_TIMEOUT_MS = 5000;
+
+static std::mutex          s_busLock;
+static ConfigureBusFactory s_busFactory;
+
+static ConfigureBusFactory busFactory()
+{
+    std::lock_guard<std::mutex> lock(s_busLock);
+    return s_busFactory;
+}
+
+/// Producer on the assets stream, kept connected between calls.
+///
+/// Malamute delivers the messages of one client in order, so a mailbox message sent to ourselves and
+/// received back proves that everything sent before it has reached the broker. With a bus factory set the messages go
+/// through a messagebus client instead, see setConfigureBusFactory().
+class ConfigurePublisher
+{
+public:
+    explicit ConfigurePublisher(const std::string& address)
+        : m_address(address)
+    {
+    }
+
+    ~ConfigurePublisher()
+    {
+        mlm_client_destroy(&m_client);
+    }
+
+    ConfigurePublisher(const ConfigurePublisher&) = delete;
+    ConfigurePublisher& operator=(const ConfigurePublisher&) = delete;
+
+    std::mutex& mutex()
+    {
+        return m_lock;
+    }
+
+    Expected<void> connect()
+    {
+        if (auto factory = busFactory()) {
+            mlm_client_destroy(&m_client);
+            if (m_bus) {
+                return {};
+            }
+            return deliver([&]() {
+                m_bus.reset(factory(MLM_ENDPOINT, m_address));
+                m_bus->connect();
+            });
+        }
+
+        m_bus.reset();
+        if (m_client) {
+            return {};
+        }
+
+        m_client = mlm_client_new();
+        if (!m_client) {
+            return unexpected("mlm_client_new () failed.");
+        }
+
+        if (mlm_client_connect(m_client, MLM_ENDPOINT, 1000, m_address.c_str()) == -1) {
+            mlm_client_destroy(&m_client);
+            return unexpected("mlm_client_connect () failed.");
+        }
+
+        if (mlm_client_set_producer(m_client, FTY_PROTO_STREAM_ASSETS) == -1) {
+            mlm_client_destroy(&m_client);
+            return unexpected(" mlm_client_set_producer () failed.");
+        }
+        return {};
+    }
+
+    // broken connection is dropped, the next call connects again
+    void reset()
+    {
+        mlm_client_destroy(&m_client);
+        m_bus.reset();
+    }
+
+    Expected<void> send(const std::string& subject, zmsg_t** msg)
+    {
+        if (m_bus) {
+            messagebus::Message message;
+            message.metaData()[messagebus::Message::SUBJECT] = subject;
+            message.metaData()[messagebus::Message::FROM]    = m_address;
+            for (zframe_t* frame = zmsg_first(*msg); frame; frame = zmsg_next(*msg)) {
+                message.userData().emplace_back(reinterpret_cast<const char*>(zframe_data(frame)), zframe_size(frame));
+            }
+            zmsg_destroy(msg);
+            return deliver([&]() {
+                m_bus->publish(FTY_PROTO_STREAM_ASSETS, message);
+            });
+        }
+
+        if (mlm_client_send(m_client, subject.c_str(), msg) != 0) {
+            zmsg_destroy(msg);
+            reset();
+            return unexpected("mlm_client_send () failed.");
+        }
+        return {};
+    }
+
+    Expected<void> republish(const std::vector<std::string>& names)
+    {
+        if (m_bus) {
+            for (size_t i = 0; i < names.size(); i += REPUBLISH_BATCH) {
+                messagebus::Message message;
+                message.metaData()[messagebus::Message::SUBJECT] = "REPUBLISH";
+                message.metaData()[messagebus::Message::FROM]    = m_address;
+                message.metaData()[messagebus::Message::TO]      = "asset-agent";
+                for (size_t j = i; j < std::min(names.size(), i + REPUBLISH_BATCH); ++j) {
+                    message.userData().push_back(names[j]);
+                }
+                if (auto sent = deliver([&]() {
+                        m_bus->sendRequest("asset-agent", message);
+                    });
+                    !sent) {
+                    return sent;
+                }
+            }
+            return {};
+        }
+
+        for (size_t i = 0; i < names.size(); i += REPUBLISH_BATCH) {
+            zmsg_t* republish = zmsg_new();
+            for (size_t j = i; j < std::min(names.size(), i + REPUBLISH_BATCH); ++j) {
+                zmsg_addstr(republish, names[j].c_str());
+            }
+            if (mlm_client_sendto(m_client, "asset-agent", "REPUBLISH", nullptr, 5000, &republish) != 0) {
+                zmsg_destroy(&republish);
+                reset();
+                return unexpected("mlm_client_sendto () failed.");
+            }
+        }
+        return {};
+    }
+
+    Expected<void> flush()
+    {
+        // a bus client hands its messages over before returning, nothing is in flight
+        if (m_bus) {
+            return {};
+        }
+
+        std::string token = std::to_string(++m_flushes);
+
+        zmsg_t* ping = zmsg_new();
+        zmsg_addstr(ping, token.c_str());
+        if (mlm_client_sendto(m_client, m_address.c_str(), "FLUSH", nullptr, FLUSH_TIMEOUT_MS, &ping) != 0) {
+            zmsg_destroy(&ping);
+            reset();
+            return unexpected("mlm_client_sendto () failed.");
+        }
+
+        zpoller_t* poller   = zpoller_new(mlm_client_msgpipe(m_client), nullptr);
+        int64_t    deadline = zclock_mono() + FLUSH_TIMEOUT_MS;
+        bool       acked    = false;
+
+        while (!acked) {
+            int64_t left = deadline - zclock_mono();
+            if (left <= 0 || !zpoller_wait(poller, int(left))) {
+                break;
+            }
+            zmsg_t* reply = mlm_client_recv(m_client);
+            if (!reply) {
+                break;
+            }
+            // anything else in the mailbox is not for us
+            char* received = zmsg_popstr(reply);
+            acked          = streq(mlm_client_subject(m_client), "FLUSH") && received && token == received;
+            zstr_free(&received);
+            zmsg_destroy(&reply);
+        }
+        zpoller_destroy(&poller);
+
+        if (!acked) {
+            reset();
+            return unexpected("flush of asset notifications timed out.");
+        }
+        return {};
+    }
+
+private:
+    template <typename Func>
+    Expected<void> deliver(Func&& func)
+    {
+        try {
+            func();
+        } catch (const std::exception& e) {
+            reset();
+            return unexpected("message bus failed: {}", e.what());
+        }
+        return {};
+    }
+
+    std::mutex                              m_lock;
+    std::string                             m_address;
+    mlm_client_t*                           m_client  = nullptr;
+    std::unique_ptr<messagebus::MessageBus> m_bus;
+    uint64_t                                m_flushes = 0;
+};
+
+static std::mutex                          s_publisherLock;
+static std::unique_ptr<ConfigurePublisher> s_publisher;
+
+// one client per process whatever the caller, its address must stay unique on the broker for the flush round-trip
+static ConfigurePublisher& publisher()
 {
-    mlm_client_t* client = mlm_client_new();
+    std::lock_guard<std::mutex> guard(s_publisherLock);
 
-    if (!client) {
-        return unexpected("mlm_client_new () failed.");
+    if (!s_publisher) {
+        s_publisher = std::make_unique<ConfigurePublisher>("asset-configure-inform." + std::to_string(getpid()));
     }
+    return *s_publisher;
+}
 
-    int r = mlm_client_connect(client, MLM_ENDPOINT, 1000, agentName.c_str());
-    if (r == -1) {
-        mlm_client_destroy(&client);
-        return unexpected("mlm_client_connect () failed.");
+void setConfigureBusFactory(const ConfigureBusFactory& factory)
+{
+    {
+        std::lock_guard<std::mutex> lock(s_busLock);
+        s_busFactory = factory;
     }
 
-    r = mlm_client_set_producer(client, FTY_PROTO_STREAM_ASSETS);
-    if (r == -1) {
-        mlm_client_destroy(&client);
-        return unexpected(" mlm_client_set_producer () failed.");
+    // the client of the previous factory must not outlive it, the publisher connects again on its next call
+    std::lock_guard<std::mutex> guard(s_publisherLock);
+    if (s_publisher) {
+        std::lock_guard<std::mutex> lock(s_publisher->mutex());
+        s_publisher->reset();
     }
+}
 
+static Expected<void> publish(ConfigurePublisher& pub,
+    const std::vector<std::pair<db::AssetElement, persist::asset_operation>>& rows)
+{
     fty::db::Connection conn;
+
+    // parents of the whole batch at once, keyed by asset id
+    std::map<uint32_t, fty::db::Row> superParents;
+    {
+        std::vector<uint32_t> ids;
+        ids.reserve(rows.size());
+        for (const auto& oneRow : rows) {
+            ids.push_back(oneRow.first.id);
+        }
+
+        auto res = db::selectAssetElementSuperParents(conn, ids, [&superParents](const fty::db::Row& row) {
+            superParents.emplace(row.get<uint32_t>("id"), row);
+        });
+        if (!res) {
+            logError("selectAssetElementSuperParents error: {}", res.error());
+            return unexpected("persist::select_asset_element_super_parent () failed.");
+        }
+    }
+
+    // UPSes of each datacenter, read once per batch
+    std::map<uint32_t, std::vector<std::string>> dcUpses;
+    std::vector<std::string>                     republish;
+
     for (const auto& oneRow : rows) {
 
         std::string s_priority    = std::to_string(oneRow.first.priority);
@@ -107,6 +331,7 @@ Expected<void> sendConfigure(
         std::string s_asset_name  = oneRow.first.name;
         std::string s_asset_type  = persist::typeid_to_type(oneRow.first.typeId);
         std::string s_subtypeName = persist::subtypeid_to_subtype(oneRow.first.subtypeId);
+        std::string s_operation   = operation2str(oneRow.second);
 
         std::string subject;
         subject = persist::typeid_to_type(oneRow.first.typeId);
@@ -125,71 +350,81 @@ Expected<void> sendConfigure(
 
         // this is a bit hack, but we now that our topology ends with datacenter (hopefully)
         std::string dc_name;
+        uint32_t    dc_id = 0;
 
-        auto cb = [aux, &dc_name](const fty::db::Row& row) {
-            for (const auto& name : {"parent_name1", "parent_name2", "parent_name3", "parent_name4", "parent_name5",
-                     "parent_name6", "parent_name7", "parent_name8", "parent_name9", "parent_name10"}) {
-                std::string foo       = row.get(name);
-                std::string hash_name = name;
-                // 11 == strlen ("parent_name")
-                hash_name.insert(11, 1, '.');
+        auto parents = superParents.find(oneRow.first.id);
+        if (parents != superParents.end()) {
+            for (int i = 1; i <= 10; ++i) {
+                std::string foo = parents->second.get("parent_name" + std::to_string(i));
                 if (!foo.empty()) {
-                    zhash_insert(aux, hash_name.c_str(), voidify(foo));
+                    zhash_insert(aux, ("parent_name." + std::to_string(i)).c_str(), voidify(foo));
                     dc_name = foo;
+                    dc_id   = parents->second.get<uint32_t>("id_parent" + std::to_string(i));
                 }
             }
-        };
-        auto res = db::selectAssetElementSuperParent(oneRow.first.id, cb);
-        if (!res) {
-            logError("selectAssetElementSuperParent error: {}", res.error());
-            zhash_destroy(&aux);
-            mlm_client_destroy(&client);
-            return unexpected("persist::select_asset_element_super_parent () failed.");
         }
 
         zhash_t* ext = s_map2zhash(oneRow.first.ext);
-
-        zmsg_t* msg = fty_proto_encode_asset(aux, oneRow.first.name.c_str(), operation2str(oneRow.second).c_str(), ext);
-
-        r = mlm_client_send(client, subject.c_str(), &msg);
-        if (r != 0) {
-            mlm_client_destroy(&client);
-            return unexpected("mlm_client_send () failed.");
-        }
-
+        zmsg_t*  msg = fty_proto_encode_asset(aux, oneRow.first.name.c_str(), s_operation.c_str(), ext);
         zhash_destroy(&aux);
         zhash_destroy(&ext);
 
+        if (auto sent = pub.send(subject, &msg); !sent) {
+            return sent;
+        }
+
         // ask fty-asset to republish so we would get UUID
-        if (streq(operation2str(oneRow.second).c_str(), FTY_PROTO_ASSET_OP_CREATE) ||
-            streq(operation2str(oneRow.second).c_str(), FTY_PROTO_ASSET_OP_UPDATE)) {
-            zmsg_t* republish = zmsg_new();
-            zmsg_addstr(republish, s_asset_name.c_str());
-            mlm_client_sendto(client, "asset-agent", "REPUBLISH", nullptr, 5000, &republish);
+        if (streq(s_operation.c_str(), FTY_PROTO_ASSET_OP_CREATE) ||
+            streq(s_operation.c_str(), FTY_PROTO_ASSET_OP_UPDATE)) {
+            republish.push_back(s_asset_name);
         }
 
         // data for uptime
         if (oneRow.first.subtypeId == persist::asset_subtype::UPS) {
-            zhash_t* aux1 = zhash_new();
+            auto upses = dcUpses.find(dc_id);
+            if (upses == dcUpses.end()) {
+                upses = dcUpses.emplace(dc_id, std::vector<std::string>{}).first;
+                if (!dc_id || !getDcUPSes(conn, dc_id, upses->second)) {
+                    log_error("Cannot read upses for dc with id = %s", dc_name.c_str());
+                }
+            }
 
-            if (!getDcUPSes(conn, dc_name, aux1))
-                log_error("Cannot read upses for dc with id = %s", dc_name.c_str());
+            zhash_t* aux1 = zhash_new();
+            zhash_autofree(aux1);
+            for (size_t i = 0; i < upses->second.size(); ++i) {
+                zhash_insert(aux1, ("ups" + std::to_string(i)).c_str(), voidify(upses->second[i]));
+            }
+            zhash_update(aux1, "type", const_cast<char*>("datacenter"));
 
-            zhash_update(aux1, "type", reinterpret_cast<void*>(const_cast<char*>("datacenter")));
             zmsg_t*     msg1     = fty_proto_encode_asset(aux1, dc_name.c_str(), "inventory", nullptr);
             std::string subject1 = "datacenter.unknown@";
-            subject.append(dc_name);
-            r = mlm_client_send(client, subject.c_str(), &msg1);
+            subject1.append(dc_name);
             zhash_destroy(&aux1);
-            if (r != 0) {
-                mlm_client_destroy(&client);
-                return unexpected("mlm_client_send () failed.");
+
+            if (auto sent = pub.send(subject1, &msg1); !sent) {
+                return sent;
             }
         }
     }
 
-    zclock_sleep(500); // ensure that everything was send before we destroy the client
-    mlm_client_destroy(&client);
+    if (auto sent = pub.republish(republish); !sent) {
+        return sent;
+    }
+    return pub.flush();
+}
+
+Expected<void> sendConfigure(
+    const std::vector<std::pair<db::AssetElement, persist::asset_operation>>& rows, const std::string& agentName)
+{
+    ConfigurePublisher&         pub = publisher();
+    std::lock_guard<std::mutex> lock(pub.mutex());
+
+    if (auto connected = pub.connect(); !connected) {
+        return unexpected("{}: {}", agentName, connected.error());
+    }
+    if (auto published = publish(pub, rows); !published) {
+        return unexpected("{}: {}", agentName, published.error());
+    }
     return {};
 }
 
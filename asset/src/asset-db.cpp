@@ -1,5 +1,6 @@
 #include "asset/asset-db.h"
 #include "asset/error.h"
+#include "sql-trace.h"
 #include <fty/string-utils.h>
 #include <fty/translate.h>
 #include <fty_common_asset_types.h>
@@ -70,7 +71,7 @@ Expected<uint32_t> nameToAssetId(const std::string& assetName)
     )";
 
     try {
-        fty::db::Connection db;
+        TracedConnection db;
 
         auto res = db.selectRow(sql, "assetName"_p = assetName);
 
@@ -99,7 +100,7 @@ Expected<std::pair<std::string, std::string>> idToNameExtName(uint32_t assetId)
     )";
 
     try {
-        fty::db::Connection db;
+        TracedConnection db;
 
         auto res = db.selectRow(sql, "assetId"_p = assetId);
 
@@ -124,8 +125,8 @@ Expected<std::string> nameToExtName(std::string assetName)
     )";
 
     try {
-        fty::db::Connection conn;
-        auto                res = conn.selectRow(sql, "asset_name"_p = assetName);
+        TracedConnection conn;
+        auto             res = conn.selectRow(sql, "asset_name"_p = assetName);
         return res.get("value");
     } catch (const fty::db::NotFound&) {
         return unexpected(error(Errors::ElementNotFound).format(assetName));
@@ -150,7 +151,7 @@ Expected<std::string> extNameToAssetName(const std::string& assetExtName)
     )";
 
     try {
-        fty::db::Connection db;
+        TracedConnection db;
 
         auto res = db.selectRow(sql, "extName"_p = assetExtName);
 
@@ -179,7 +180,7 @@ Expected<uint32_t> extNameToAssetId(const std::string& assetExtName)
             keytag = 'name' and value = :extName
     )";
     try {
-        fty::db::Connection db;
+        TracedConnection db;
 
         auto res = db.selectRow(sql, "extName"_p = assetExtName);
 
@@ -220,8 +221,8 @@ Expected<AssetElement> selectAssetElementByName(const std::string& elementName,
     }
 
     try {
-        fty::db::Connection db;
-        fty::db::Row        row;
+        TracedConnection db;
+        fty::db::Row     row;
 
         if (extNameOnly) {
             row = db.selectRow(extNameSql, "name"_p = elementName);
@@ -273,7 +274,7 @@ Expected<void> selectAssetElementWebById(uint32_t elementId, WebAssetElement& as
     )";
 
     try {
-        fty::db::Connection db;
+        TracedConnection db;
 
         auto row = db.selectRow(sql, "id"_p = elementId);
 
@@ -297,7 +298,7 @@ Expected<WebAssetElement> selectAssetElementWebByName(const std::string& name)
     )";
 
     try {
-        fty::db::Connection db;
+        TracedConnection db;
 
         auto row = db.selectRow(sql, "name"_p = name);
 
@@ -323,7 +324,7 @@ Expected<std::vector<WebAssetElement>> selectAssetElementsByType(uint16_t type_i
     )";
 
     try {
-        fty::db::Connection db;
+        TracedConnection db;
 
         auto result = db.select(sql, "typeid"_p = type_id, "vstatus"_p = status);
 
@@ -354,7 +355,7 @@ Expected<Attributes> selectExtAttributes(uint32_t elementId)
     )";
 
     try {
-        fty::db::Connection db;
+        TracedConnection db;
 
         auto result = db.select(sql, "elementId"_p = elementId);
 
@@ -392,7 +393,7 @@ Expected<std::map<uint32_t, std::string>> selectAssetElementGroups(uint32_t elem
 
 
     try {
-        fty::db::Connection db;
+        TracedConnection db;
 
         auto res = db.select(sql, "idelement"_p = elementId);
 
@@ -875,7 +876,7 @@ Expected<uint16_t> selectMonitorDeviceTypeId(fty::db::Connection& conn, const st
 
 // =====================================================================================================================
 
-Expected<void> selectAssetElementSuperParent(uint32_t id, SelectCallback&& cb)
+static const std::string& superParentSelect()
 {
     static const std::string sql = R"(
         SELECT
@@ -929,12 +930,16 @@ Expected<void> selectAssetElementSuperParent(uint32_t id, SelectCallback&& cb)
             v.id_type               as id_type
         FROM
             v_bios_asset_element_super_parent AS v
-        WHERE
-            v.id_asset_element = :id
     )";
+    return sql;
+}
+
+Expected<void> selectAssetElementSuperParent(uint32_t id, SelectCallback&& cb)
+{
+    static const std::string sql = superParentSelect() + " WHERE v.id_asset_element = :id";
 
     try {
-        fty::db::Connection conn;
+        TracedConnection conn;
         for (const auto& row : conn.select(sql, "id"_p = id)) {
             cb(row);
         }
@@ -944,6 +949,27 @@ Expected<void> selectAssetElementSuperParent(uint32_t id, SelectCallback&& cb)
     }
 }
 
+Expected<void> selectAssetElementSuperParents(
+    fty::db::Connection& conn, const std::vector<uint32_t>& ids, SelectCallback&& cb)
+{
+    if (ids.empty()) {
+        return {};
+    }
+
+    std::string list = implode(ids, ", ", [](const auto& it) {
+        return std::to_string(it);
+    });
+
+    try {
+        for (const auto& row : conn.select(superParentSelect() + " WHERE v.id_asset_element IN (" + list + ")")) {
+            cb(row);
+        }
+        return {};
+    } catch (const std::exception& e) {
+        return unexpected(error(Errors::ExceptionForElement).format(e.what(), list));
+    }
+}
+
 // =====================================================================================================================
 
 Expected<void> selectAssetsByContainer(fty::db::Connection& conn, uint32_t elementId, std::vector<uint16_t> types,
@@ -1068,7 +1094,7 @@ Expected<void> selectAssetsWithoutContainer(
     }
 
     try {
-        fty::db::Connection conn;
+        TracedConnection conn;
         for (const auto& row : conn.select(select)) {
             cb(row);
         }
@@ -1086,7 +1112,7 @@ static Expected<std::map<std::string, int>> getDictionary(const std::string& stS
     std::map<std::string, int> mymap;
 
     try {
-        fty::db::Connection db;
+        TracedConnection db;
         for (const auto& row : db.select(stStr)) {
             mymap.emplace(row.get("name"), row.get<int>("id"));
         }
@@ -1137,7 +1163,7 @@ Expected<std::vector<DbAssetLink>> selectAssetDeviceLinksTo(uint32_t elementId,
 
 
     try {
-        fty::db::Connection conn;
+        TracedConnection conn;
 
         // clang-format off
         auto rows = conn.select(sql,
@@ -1182,8 +1208,8 @@ Expected<std::map<uint32_t, std::string>> selectShortElements(uint16_t typeId, u
     }
 
     try {
-        fty::db::Connection conn;
-        auto                st = conn.prepare(sql);
+        TracedConnection conn;
+        auto             st = conn.prepare(sql);
         st.bind("typeid"_p = typeId);
         if (subtypeId) {
             st.bind("subtypeid"_p = subtypeId);
@@ -1215,7 +1241,7 @@ Expected<int> countKeytag(const std::string& keytag, const std::string& value)
     )";
 
     try {
-        fty::db::Connection conn;
+        TracedConnection conn;
         // clang-format off
         return conn.selectRow(sql,
             "keytag"_p = keytag,
@@ -1229,6 +1255,35 @@ Expected<int> countKeytag(const std::string& keytag, const std::string& value)
 
 // =====================================================================================================================
 
+Expected<int> countActiveDevices(const std::vector<uint16_t>& subtypes)
+{
+    if (subtypes.empty()) {
+        return 0;
+    }
+
+    std::string list = implode(subtypes, ", ", [](const auto& it) {
+        return std::to_string(it);
+    });
+
+    std::string sql = R"(
+        SELECT COUNT(*) as count
+        FROM
+            t_bios_asset_element
+        WHERE
+            id_type = :type AND
+            status = 'active' AND
+            id_subtype IN ()" + list + ")";
+
+    try {
+        TracedConnection conn;
+        return conn.selectRow(sql, "type"_p = uint16_t(persist::asset_type::DEVICE)).get<int>("count");
+    } catch (const std::exception& e) {
+        return unexpected(error(Errors::ExceptionForElement).format(e.what(), list));
+    }
+}
+
+// =====================================================================================================================
+
 Expected<uint16_t> convertAssetToMonitor(uint32_t assetElementId)
 {
     static const std::string sql = R"(
@@ -1241,8 +1296,8 @@ Expected<uint16_t> convertAssetToMonitor(uint32_t assetElementId)
     )";
 
     try {
-        fty::db::Connection conn;
-        auto                res = conn.selectRow(sql, "id"_p = assetElementId);
+        TracedConnection conn;
+        auto             res = conn.selectRow(sql, "id"_p = assetElementId);
         return res.get<uint16_t>("id_discovered_device");
     } catch (const fty::db::NotFound&) {
         return 0;
@@ -1333,6 +1388,38 @@ Expected<std::vector<uint32_t>> selectAssetsByParent(uint32_t parentId)
 
 // =====================================================================================================================
 
+Expected<void> selectRackUPositions(uint32_t rackId, SelectCallback&& cb)
+{
+    static const std::string sql = R"(
+        SELECT
+            e.id_asset_element        AS id,
+            COALESCE(s.value, '')     AS u_size,
+            COALESCE(p.value, '')     AS u_pos
+        FROM
+            t_bios_asset_element AS e
+        LEFT JOIN
+            t_bios_asset_ext_attributes AS s
+            ON s.id_asset_element = e.id_asset_element AND s.keytag = 'u_size'
+        LEFT JOIN
+            t_bios_asset_ext_attributes AS p
+            ON p.id_asset_element = e.id_asset_element AND p.keytag = 'location_u_pos'
+        WHERE
+            e.id_asset_element = :rackId OR e.id_parent = :parentId
+    )";
+
+    try {
+        TracedConnection conn;
+        for (const auto& row : conn.select(sql, "rackId"_p = rackId, "parentId"_p = rackId)) {
+            cb(row);
+        }
+        return {};
+    } catch (const std::exception& e) {
+        return unexpected(error(Errors::ExceptionForElement).format(e.what(), rackId));
+    }
+}
+
+// =====================================================================================================================
+
 Expected<std::vector<uint32_t>> selectAssetDeviceLinksSrc(uint32_t elementId)
 {
     static const std::string sql = R"(
@@ -1368,8 +1455,8 @@ Expected<uint32_t> maxNumberOfPowerLinks()
     )";
 
     try {
-        fty::db::Connection conn;
-        auto                res = conn.selectRow(sql);
+        TracedConnection conn;
+        auto             res = conn.selectRow(sql);
         return res.get<uint32_t>("maxCount");
     } catch (const std::exception& e) {
         return unexpected(error(Errors::InternalError).format(e.what()));
@@ -1389,8 +1476,8 @@ Expected<uint32_t> maxNumberOfAssetGroups()
     )";
 
     try {
-        fty::db::Connection conn;
-        auto                res = conn.selectRow(sql);
+        TracedConnection conn;
+        auto             res = conn.selectRow(sql);
         return res.get<uint32_t>("maxCount");
     } catch (const std::exception& e) {
         return unexpected(error(Errors::InternalError).format(e.what()));
@@ -1475,7 +1562,7 @@ Expected<std::vector<std::string>> selectGroupNames(uint32_t id)
     )";
 
     try {
-        fty::db::Connection conn;
+        TracedConnection conn;
 
         std::vector<std::string> result;
         for (const auto& row : conn.select(sql, "id"_p = id)) {
@@ -1500,7 +1587,7 @@ Expected<WebAssetElement> findParentByType(uint32_t assetId, uint16_t parentType
     )";
 
     try {
-        fty::db::Connection conn;
+        TracedConnection conn;
 
         uint32_t aid = assetId;
         while (true) {
@@ -1,14 +1,14 @@
 #include "asset/asset-helpers.h"
 #include "asset/asset-db.h"
+#include "asset/asset-rack-occupancy.h"
 #include <ctime>
 #include <fty_asset_dto.h>
 #include <fty_common_agents.h>
-#include <fty_common_mlm.h>
+#include <fty_asset_activation.h>
 
-#define AGENT_ASSET_ACTIVATOR      "etn-licensing-credits"
-#define COMMAND_IS_ASSET_ACTIVABLE "GET_IS_ASSET_ACTIVABLE"
-#define COMMAND_ACTIVATE_ASSET     "ACTIVATE_ASSET"
-#define COMMAND_DEACTIVATE_ASSET   "DEACTIVATE_ASSET"
+using fty::activation::COMMAND_IS_ASSET_ACTIVABLE;
+using fty::activation::COMMAND_ACTIVATE_ASSET;
+using fty::activation::COMMAND_DEACTIVATE_ASSET;
 
 namespace fty::asset {
 
@@ -75,82 +75,14 @@ AssetExpected<double> sanitizeValueDouble(const std::string& key, const std::str
 
 AssetExpected<void> tryToPlaceAsset(uint32_t id, uint32_t parentId, uint32_t size, uint32_t loc)
 {
-    auto attr = db::selectExtAttributes(parentId);
-    if (!attr) {
-        return {};
-    }
-
-    if (!loc) {
-        return unexpected("Position is wrong, should be greater than 0"_tr);
-    }
-
-    if (!size) {
-        return unexpected("Size is wrong, should be greater than 0"_tr);
-    }
-
-    std::vector<bool> place;
-    place.resize(convert<size_t>(attr->at("u_size").value), false);
-
-    auto children = db::selectAssetsByParent(parentId);
-    if (!children) {
-        return {};
-    }
-
-    for (const auto& child : *children) {
-        if (child == id) {
-            continue;
-        }
-
-        auto chAttr = db::selectExtAttributes(child);
-        if (!chAttr) {
-            continue;
-        }
-        if (!chAttr->count("u_size") && !chAttr->count("location_u_pos")) {
-            continue;
-        }
-
-        size_t isize = convert<size_t>(chAttr->at("u_size").value);
-        size_t iloc  = convert<size_t>(chAttr->at("location_u_pos").value) - 1;
-
-        for (size_t i = iloc; i < iloc + isize; ++i) {
-            if (i < place.size()) {
-                place[i] = true;
-            }
-        }
-    }
-
-    for (size_t i = loc - 1; i < loc + size - 1; ++i) {
-        if (i >= place.size()) {
-            return unexpected("Asset is out bounds"_tr);
-        }
-        if (place[i]) {
-            return unexpected("Asset place is occupied"_tr);
-        }
-    }
-
-    return {};
+    return RackOccupancy::instance().check(parentId, id, size, loc);
 }
 
 static AssetExpected<std::vector<std::string>> activateRequest(const std::string& command, const std::string& asset)
 {
     try {
-        mlm::MlmSyncClient client(AGENT_FTY_ASSET, AGENT_ASSET_ACTIVATOR);
-
-        logDebug("Sending {} request to {}", command, AGENT_ASSET_ACTIVATOR);
-
-        std::vector<std::string> payload = {command, asset};
-
-        std::vector<std::string> receivedFrames = client.syncRequestWithReply(payload);
-
-        // check if the first frame we get is an error
-        if (receivedFrames[0] == "ERROR") {
-            if (receivedFrames.size() == 2) {
-                return unexpected(receivedFrames.at(1));
-            } else {
-                return unexpected("Missing data for error");
-            }
-        }
-        return receivedFrames;
+        // shared client, an error reply is thrown
+        return fty::activation::request({command, asset});
     } catch (const std::exception& e) {
         return unexpected(e.what());
     }
@@ -192,6 +124,19 @@ AssetExpected<void> activation::deactivate(const std::string& asset)
     return {};
 }
 
+std::vector<AssetExpected<void>> activation::activate(const std::vector<std::string>& assetsJson)
+{
+    std::vector<AssetExpected<void>> result;
+    for (const auto& err : fty::activation::activate(assetsJson)) {
+        if (err.empty()) {
+            result.emplace_back();
+        } else {
+            result.emplace_back(unexpected(err));
+        }
+    }
+    return result;
+}
+
 AssetExpected<void> activation::deactivate(const FullAsset& asset)
 {
     return deactivate(asset.toJson());
@@ -1,12 +1,15 @@
 #include "asset/asset-import.h"
 #include "asset/asset-helpers.h"
 #include "asset/asset-licensing.h"
+#include "asset/asset-rack-occupancy.h"
 #include "asset/csv.h"
 #include "asset/json.h"
 #include <fty/string-utils.h>
+#include <fty_asset_activation.h>
 #include <fty_common_db_connection.h>
 #include <fty_common_db_dbpath.h>
 #include <fty_log.h>
+#include <limits>
 #include <regex>
 
 #define AGENT_ASSET_ACTIVATOR "etn-licensing-credits"
@@ -155,6 +158,73 @@ bool Import::isDate(const std::string& key) const
     return std::regex_match(key, rex);
 }
 
+// power devices that may still be activated according to the cached limit and count
+static int freePowerSlots(bool recount = false)
+{
+    auto limitations = getLicensingLimitation();
+    if (!limitations || limitations->max_active_power_devices < 0) {
+        return std::numeric_limits<int>::max();
+    }
+    auto active = activePowerDevices(recount);
+    if (!active) {
+        return std::numeric_limits<int>::max();
+    }
+    return limitations->max_active_power_devices - *active;
+}
+
+void Import::activatePending()
+{
+    const Translate full =
+        "Licensing limitation hit - maximum amount of active power devices allowed in license reached."_tr;
+
+    // a row which threw after storing its asset has no result yet
+    auto fail = [this](size_t row, const Translate& err) {
+        AssetExpected<db::AssetElement> failed = unexpected("licensing-err", err);
+        if (auto it = m_el.find(row); it != m_el.end()) {
+            it->second = unexpected(failed.error());
+        }
+    };
+
+    // a full license is known without asking the activator, it still decides otherwise
+    int                      room      = freePowerSlots();
+    int                      granted   = 0;
+    bool                     recounted = false;
+    std::vector<std::string> assets;
+    std::vector<size_t>      sent;
+
+    for (size_t i = 0; i < m_activate.size(); ++i) {
+        const auto& pending = m_activate[i];
+        if (pending.power && pending.created) {
+            // devices deactivated or deleted elsewhere are only seen in the database
+            if (room <= 0 && !recounted) {
+                room      = freePowerSlots(true) - granted;
+                recounted = true;
+            }
+            if (room <= 0) {
+                logError("Error during asset activation - {}", full);
+                fail(pending.row, full);
+                continue;
+            }
+            --room;
+            ++granted;
+        }
+        assets.push_back(getJsonAsset(pending.id));
+        sent.push_back(i);
+    }
+
+    auto results = activation::activate(assets);
+    for (size_t i = 0; i < sent.size(); ++i) {
+        const auto& pending = m_activate[sent[i]];
+        if (!results[i]) {
+            logError("Error during asset activation - {}", results[i].error());
+            fail(pending.row, results[i].error());
+        } else if (pending.power && pending.created) {
+            activePowerDevicesChanged(1);
+        }
+    }
+    m_activate.clear();
+}
+
 AssetExpected<void> Import::process(bool checkLic)
 {
     auto m = mandatoryMissing();
@@ -173,14 +243,28 @@ AssetExpected<void> Import::process(bool checkLic)
                                       .format("Asset handling"_tr, "Licensing global_configurability limit hit"_tr));
             }
 
-            for (size_t row = 1; row != m_cm.rows(); ++row) {
-                if (auto it = processRow(row, ids, true, checkLic)) {
-                    ids.insert(it->id);
-                    m_el.emplace(row, *it);
-                } else {
-                    m_el.emplace(row, unexpected(it.error()));
+            // stored rows wait nonactive for at most one batch, and are activated even if a later row throws
+            try {
+                for (size_t row = 1; row != m_cm.rows(); ++row) {
+                    if (auto it = processRow(row, ids, true, checkLic)) {
+                        ids.insert(it->id);
+                        m_el.emplace(row, *it);
+                    } else {
+                        m_el.emplace(row, unexpected(it.error()));
+                    }
+                    if (m_activate.size() >= fty::activation::BATCH_SIZE) {
+                        activatePending();
+                    }
+                }
+            } catch (...) {
+                try {
+                    activatePending();
+                } catch (const std::exception& e) {
+                    logError("Activation of the imported assets failed - {}", e.what());
                 }
+                throw;
             }
+            activatePending();
         }
     } else {
         for (size_t row = 1; row != m_cm.rows(); ++row) {
@@ -701,10 +785,18 @@ AssetExpected<db::AssetElement> Import::processRow(
             }
         } else {
             if (idStr != "rackcontroller-0") {
+                // a device already active stays so while the import runs, it needs no activation
+                bool activate  = type == "device" && status == "active" && subtypeId != rackControllerId && checkLic;
+                bool wasActive = false;
+                if (activate) {
+                    auto current = db::selectAssetElementByName(idStr);
+                    wasActive    = current && current->status == "active";
+                }
+
                 fty::db::Transaction trans(conn);
 
-                auto ret = updateDevice(conn, el.id, name, parentId, extattributes, "nonactive", priority, groups,
-                    links, assetTag, extattributesRO);
+                auto ret = updateDevice(conn, el.id, name, parentId, extattributes, wasActive ? "active" : "nonactive",
+                    priority, groups, links, assetTag, extattributesRO);
 
                 if (!ret) {
                     trans.rollback();
@@ -713,13 +805,9 @@ AssetExpected<db::AssetElement> Import::processRow(
                     trans.commit();
                 }
 
-                if (type == "device" && status == "active" && subtypeId != rackControllerId && checkLic) {
-                    // check if we may activate the device
-                    std::string assetJson = getJsonAsset(el.id);
-                    if (auto res = activation::activate(assetJson); !res) {
-                        logError("Error during asset activation - {}", res.error());
-                        return unexpected("licensing-err", res.error());
-                    }
+                if (activate && !wasActive) {
+                    // activated together with the other rows in process()
+                    m_activate.push_back({row, el.id, isPowerDevice(subtypeId), false});
                 }
             } else {
                 fty::db::Transaction trans(conn);
@@ -774,12 +862,8 @@ AssetExpected<db::AssetElement> Import::processRow(
                 el.id = *ret;
 
                 if (type == "device" && status == "active" && subtypeId != rackControllerId && checkLic) {
-                    // check if we may activate the device
-                    std::string assetJson = getJsonAsset(el.id);
-                    if (auto res = activation::activate(assetJson); !res) {
-                        logError("Error during asset activation - {}", res.error());
-                        return unexpected("licensing-err", res.error());
-                    }
+                    // activated together with the other rows in process()
+                    m_activate.push_back({row, el.id, isPowerDevice(subtypeId), true});
                 }
             } else {
                 // this is a transaction
@@ -797,6 +881,14 @@ AssetExpected<db::AssetElement> Import::processRow(
         }
     }
 
+    // keep the occupancy of racks in sync without reading them again
+    if (extattributes.count("u_size") && extattributes.count("location_u_pos")) {
+        RackOccupancy::instance().place(parentId, el.id, convert<uint32_t>(extattributes["u_size"]),
+            convert<uint32_t>(extattributes["location_u_pos"]));
+    } else {
+        RackOccupancy::instance().remove(el.id);
+    }
+
     auto ret = db::extNameToAssetName(ename);
     if (ret) {
         el.name = *ret;
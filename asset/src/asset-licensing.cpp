@@ -1,14 +1,107 @@
 #include "asset/asset-licensing.h"
+#include "asset/asset-db.h"
 #include <zmq.h>
+#include <algorithm>
+#include <fty_common_asset_types.h>
 #include <fty_common_mlm_pool.h>
+#include <fty_log.h>
 #include <fty_proto.h>
 #include <fty/translate.h>
 #include <fty/expected.h>
+#include <malamute.h>
+#include <mutex>
+#include <unistd.h>
+#include <vector>
 
 namespace fty::asset {
 
+// shared by every import and create of the process; the actor is stopped by destroyLicensingCache(), czmq may be
+// gone when statics are destroyed
+struct LicensingCache
+{
+    std::mutex                            lock;
+    LimitationsStruct                     limitations = {-1, 0};
+    std::chrono::steady_clock::time_point updated;
+    bool                                  valid = false;
+    int                                   activeDevices = -1; // -1 until counted
+    std::chrono::steady_clock::time_point counted;
+    std::chrono::seconds                  staleness{60};
+    zactor_t*                             announcements = nullptr;
 
-AssetExpected<LimitationsStruct> getLicensingLimitation()
+    bool fresh(std::chrono::steady_clock::time_point since) const
+    {
+        return std::chrono::steady_clock::now() - since < staleness;
+    }
+};
+
+static LicensingCache& s_cache()
+{
+    static LicensingCache cache;
+    return cache;
+}
+
+static bool s_apply(const char* name, const char* type, const char* value, LimitationsStruct& limitations)
+{
+    if (!streq(name, "rackcontroller-0")) {
+        return false;
+    }
+    if (streq(type, "power_nodes.max_active")) {
+        limitations.max_active_power_devices = atoi(value);
+        log_debug("limitations.max_active_power_device set to %i", limitations.max_active_power_devices);
+        return true;
+    }
+    if (streq(type, "configurability.global")) {
+        limitations.global_configurability = atoi(value);
+        log_debug("limitations.global_configurability set to %i", limitations.global_configurability);
+        return true;
+    }
+    return false;
+}
+
+// keeps the cache in sync with LICENSING-ANNOUNCEMENTS until the process exits
+static void s_announcements(zsock_t* pipe, void* /*args*/)
+{
+    mlm_client_t* client  = mlm_client_new();
+    std::string   address = "asset-licensing-cache." + std::to_string(getpid());
+
+    if (mlm_client_connect(client, MLM_ENDPOINT, 1000, address.c_str()) == -1 ||
+        mlm_client_set_consumer(client, "LICENSING-ANNOUNCEMENTS", ".*") == -1) {
+        log_error("Cannot subscribe to LICENSING-ANNOUNCEMENTS, limitations are queried on demand");
+        mlm_client_destroy(&client);
+        zsock_signal(pipe, 0);
+        return;
+    }
+
+    zpoller_t* poller = zpoller_new(pipe, mlm_client_msgpipe(client), nullptr);
+    zsock_signal(pipe, 0);
+
+    while (!zsys_interrupted) {
+        void* which = zpoller_wait(poller, -1);
+        if (which == pipe || !which) {
+            break;
+        }
+
+        zmsg_t* msg = mlm_client_recv(client);
+        if (!msg) {
+            break;
+        }
+        if (!fty_proto_is(msg)) {
+            zmsg_destroy(&msg);
+            continue;
+        }
+
+        fty_proto_t* metric = fty_proto_decode(&msg);
+        if (metric && fty_proto_id(metric) == FTY_PROTO_METRIC) {
+            updateLicensingLimitation(fty_proto_name(metric), fty_proto_type(metric), fty_proto_value(metric));
+        }
+        fty_proto_destroy(&metric);
+    }
+
+    zpoller_destroy(&poller);
+    mlm_client_destroy(&client);
+}
+
+static AssetExpected<LimitationsStruct> s_query()
 {
     LimitationsStruct limitations;
 
@@ -46,14 +139,7 @@ AssetExpected<LimitationsStruct> getLicensingLimitation()
         while (submsg) {
             fty_proto_t *submetric = fty_proto_decode(&submsg);
             assert (fty_proto_id(submetric) == FTY_PROTO_METRIC);
-            if (streq (fty_proto_name(submetric), "rackcontroller-0") && streq (fty_proto_type(submetric), "power_nodes.max_active")) {
-                limitations.max_active_power_devices = atoi(fty_proto_value (submetric));
-                log_debug("limitations.max_active_power_device set to %i", limitations.max_active_power_devices);
-            }
-            else if (streq (fty_proto_name(submetric), "rackcontroller-0") && streq (fty_proto_type(submetric), "configurability.global")) {
-                limitations.global_configurability = atoi(fty_proto_value (submetric));
-                log_debug("limitations.global_configurability set to %i", limitations.global_configurability);
-            }
+            s_apply(fty_proto_name(submetric), fty_proto_type(submetric), fty_proto_value(submetric), limitations);
             fty_proto_destroy(&submetric);
             submsg = zmsg_popmsg(response);
         }
@@ -65,4 +151,111 @@ AssetExpected<LimitationsStruct> getLicensingLimitation()
     return limitations;
 }
 
+AssetExpected<LimitationsStruct> getLicensingLimitation()
+{
+    LicensingCache& cache = s_cache();
+    std::lock_guard<std::mutex> lock(cache.lock);
+
+    if (!cache.announcements) {
+        cache.announcements = zactor_new(s_announcements, nullptr);
+    }
+
+    if (cache.valid && cache.fresh(cache.updated)) {
+        return cache.limitations;
+    }
+
+    auto limitations = s_query();
+    if (limitations) {
+        cache.limitations = *limitations;
+        cache.updated     = std::chrono::steady_clock::now();
+        cache.valid       = true;
+    }
+    return limitations;
+}
+
+bool updateLicensingLimitation(const std::string& name, const std::string& type, const std::string& value)
+{
+    LicensingCache& cache = s_cache();
+    std::lock_guard<std::mutex> lock(cache.lock);
+
+    LimitationsStruct limitations = cache.limitations;
+    if (!s_apply(name.c_str(), type.c_str(), value.c_str(), limitations)) {
+        return false;
+    }
+
+    // one announcement carries one value, keep the other one only if it is known
+    if (!cache.valid) {
+        return true;
+    }
+    cache.limitations = limitations;
+    cache.updated     = std::chrono::steady_clock::now();
+    return true;
+}
+
+void setLicensingLimitation(const LimitationsStruct& limitations)
+{
+    LicensingCache& cache = s_cache();
+    std::lock_guard<std::mutex> lock(cache.lock);
+
+    cache.limitations = limitations;
+    cache.updated     = std::chrono::steady_clock::now();
+    cache.valid       = true;
+}
+
+void setLicensingStaleness(std::chrono::seconds staleness)
+{
+    LicensingCache& cache = s_cache();
+    std::lock_guard<std::mutex> lock(cache.lock);
+    cache.staleness = staleness;
+}
+
+static const std::vector<uint16_t>& s_powerSubtypes()
+{
+    static const std::vector<uint16_t> power = {persist::asset_subtype::UPS, persist::asset_subtype::GENSET,
+        persist::asset_subtype::EPDU, persist::asset_subtype::PDU, persist::asset_subtype::STS};
+    return power;
+}
+
+bool isPowerDevice(uint16_t subtypeId)
+{
+    const auto& power = s_powerSubtypes();
+    return std::find(power.begin(), power.end(), subtypeId) != power.end();
+}
+
+AssetExpected<int> activePowerDevices(bool recount)
+{
+    LicensingCache& cache = s_cache();
+    std::lock_guard<std::mutex> lock(cache.lock);
+
+    if (!recount && cache.activeDevices >= 0 && cache.fresh(cache.counted)) {
+        return cache.activeDevices;
+    }
+
+    auto count = db::countActiveDevices(s_powerSubtypes());
+    if (!count) {
+        logError("Cannot count active power devices - {}", count.error());
+        return unexpected("Cannot count active power devices"_tr);
+    }
+    cache.activeDevices = *count;
+    cache.counted       = std::chrono::steady_clock::now();
+    return cache.activeDevices;
+}
+
+void activePowerDevicesChanged(int delta)
+{
+    LicensingCache& cache = s_cache();
+    std::lock_guard<std::mutex> lock(cache.lock);
+
+    if (cache.activeDevices >= 0) {
+        cache.activeDevices = std::max(0, cache.activeDevices + delta);
+    }
+}
+
+void destroyLicensingCache()
+{
+    LicensingCache& cache = s_cache();
+    std::lock_guard<std::mutex> lock(cache.lock);
+    zactor_destroy(&cache.announcements);
+}
+
 }
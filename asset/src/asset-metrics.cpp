@@ -0,0 +1,95 @@
+#include "asset/asset-metrics.h"
+#include <cmath>
+#include <fty/string-utils.h>
+#include <fty_log.h>
+#include <fty_proto.h>
+#include <fty_shm.h>
+
+namespace fty::asset {
+
+static std::string escape(const std::string& str)
+{
+    static const std::string special = R"(\^$.|?*+()[]{})";
+
+    std::string ret;
+    for (char ch : str) {
+        if (special.find(ch) != std::string::npos) {
+            ret += '\\';
+        }
+        ret += ch;
+    }
+    return ret;
+}
+
+MetricSnapshot::MetricSnapshot(const std::set<std::string>& assets, const std::set<std::string>& metrics)
+    : m_assets(assets)
+{
+    if (assets.empty()) {
+        return;
+    }
+
+    // asset names are filtered here, a regex of thousands of names costs more than the files it skips
+    std::string type = ".*";
+    if (!metrics.empty()) {
+        type = "(" + implode(metrics, "|", [](const auto& it) {
+            return escape(it);
+        }) + ")";
+    }
+
+    fty::shm::shmMetrics result;
+    if (fty::shm::read_metrics(".*", type, result) != 0) {
+        logWarn("Cannot read metrics {}", type);
+        // nothing is covered, callers read each metric on their own
+        m_assets.clear();
+        return;
+    }
+
+    for (auto& metric : result) {
+        std::string name = fty_proto_name(metric);
+        if (m_assets.count(name)) {
+            m_values[name][fty_proto_type(metric)] = fty_proto_value(metric);
+        }
+    }
+}
+
+bool MetricSnapshot::covers(const std::string& asset) const
+{
+    return m_assets.count(asset) > 0;
+}
+
+std::optional<std::string> MetricSnapshot::value(const std::string& asset, const std::string& metric) const
+{
+    auto it = m_values.find(asset);
+    if (it == m_values.end()) {
+        return std::nullopt;
+    }
+    auto val = it->second.find(metric);
+    if (val == it->second.end()) {
+        return std::nullopt;
+    }
+    return val->second;
+}
+
+std::optional<double> MetricSnapshot::number(const std::string& asset, const std::string& metric) const
+{
+    auto val = value(asset, metric);
+    if (!val) {
+        return std::nullopt;
+    }
+    try {
+        return std::stod(*val);
+    } catch (const std::exception&) {
+        return std::nan("");
+    }
+}
+
+size_t MetricSnapshot::size() const
+{
+    size_t count = 0;
+    for (const auto& it : m_values) {
+        count += it.second.size();
+    }
+    return count;
+}
+
+} // namespace fty::asset
@@ -0,0 +1,234 @@
+#include "asset/asset-rack-occupancy.h"
+#include "asset/asset-db.h"
+#include <fty/convert.h>
+#include <fty_log.h>
+
+namespace fty::asset {
+
+static constexpr uint32_t WORD = 64;
+
+RackOccupancy& RackOccupancy::instance()
+{
+    static RackOccupancy occupancy;
+    return occupancy;
+}
+
+// bits [from, to) of word w
+static uint64_t mask(uint32_t w, uint32_t from, uint32_t to)
+{
+    uint32_t lo = std::max(from, w * WORD) - w * WORD;
+    uint32_t hi = std::min(to, (w + 1) * WORD) - w * WORD;
+    uint64_t m  = hi == WORD ? ~uint64_t(0) : (uint64_t(1) << hi) - 1;
+    return m & ~((uint64_t(1) << lo) - 1);
+}
+
+void RackOccupancy::Rack::set(const Slot& slot)
+{
+    if (!slot.loc || !slot.size) {
+        return;
+    }
+    // positions beyond the rack are not tracked, like before
+    uint32_t from = slot.loc - 1;
+    uint32_t to   = std::min(size, slot.loc - 1 + slot.size);
+    for (uint32_t w = from / WORD; from < to && w <= (to - 1) / WORD; ++w) {
+        bits[w] |= mask(w, from, to);
+    }
+}
+
+void RackOccupancy::Rack::rebuild(uint32_t except)
+{
+    // assets may share positions, so a removal cannot just clear its bits
+    bits.assign((size + WORD - 1) / WORD, 0);
+    for (const auto& asset : assets) {
+        if (asset.first != except) {
+            set(asset.second);
+        }
+    }
+}
+
+bool RackOccupancy::Rack::isFree(uint32_t loc, uint32_t len, uint32_t& blocker) const
+{
+    uint32_t from = loc - 1;
+    uint32_t to   = from + len;
+    for (uint32_t w = from / WORD; w <= (to - 1) / WORD; ++w) {
+        if (uint64_t hit = bits[w] & mask(w, from, to)) {
+            // highest occupied position in the range, a fit can only start after it
+            blocker = w * WORD + (WORD - 1 - uint32_t(__builtin_clzll(hit))) + 1;
+            return false;
+        }
+    }
+    return true;
+}
+
+AssetExpected<RackOccupancy::Rack*> RackOccupancy::rack(uint32_t rackId)
+{
+    auto it = m_racks.find(rackId);
+    if (it != m_racks.end() && std::chrono::steady_clock::now() - it->second.loaded < m_staleness) {
+        return &it->second;
+    }
+
+    Rack loaded;
+    auto res = db::selectRackUPositions(rackId, [&](const fty::db::Row& row) {
+        uint32_t    id   = row.get<uint32_t>("id");
+        std::string size = row.get("u_size");
+        std::string pos  = row.get("u_pos");
+        try {
+            if (id == rackId) {
+                loaded.size = size.empty() ? 0 : convert<uint32_t>(size);
+            } else if (!size.empty() && !pos.empty()) {
+                loaded.assets[id] = {convert<uint32_t>(pos), convert<uint32_t>(size)};
+            }
+        } catch (const std::exception& e) {
+            logWarn("Ignoring position of asset {}: {}", id, e.what());
+        }
+    });
+    if (!res) {
+        return unexpected(res.error());
+    }
+
+    if (it != m_racks.end()) {
+        for (const auto& asset : it->second.assets) {
+            m_parent.erase(asset.first);
+        }
+    }
+
+    loaded.rebuild();
+    for (const auto& asset : loaded.assets) {
+        m_parent[asset.first] = rackId;
+    }
+    loaded.loaded = std::chrono::steady_clock::now();
+
+    Rack& stored = m_racks[rackId];
+    stored       = std::move(loaded);
+    return &stored;
+}
+
+AssetExpected<void> RackOccupancy::check(uint32_t rackId, uint32_t id, uint32_t size, uint32_t loc)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    auto rack = this->rack(rackId);
+    if (!rack || (*rack)->size == 0) {
+        // parent without u_size, nothing to check against
+        return {};
+    }
+
+    if (!loc) {
+        return unexpected("Position is wrong, should be greater than 0"_tr);
+    }
+
+    if (!size) {
+        return unexpected("Size is wrong, should be greater than 0"_tr);
+    }
+
+    if (loc - 1 + size > (*rack)->size) {
+        return unexpected("Asset is out bounds"_tr);
+    }
+
+    // the asset itself does not block its new position
+    bool self = (*rack)->assets.count(id) > 0;
+    if (self) {
+        (*rack)->rebuild(id);
+    }
+
+    uint32_t blocker = 0;
+    bool     free    = (*rack)->isFree(loc, size, blocker);
+
+    if (self) {
+        (*rack)->rebuild();
+    }
+
+    if (!free) {
+        return unexpected("Asset place is occupied"_tr);
+    }
+    return {};
+}
+
+AssetExpected<uint32_t> RackOccupancy::findFirstFit(uint32_t rackId, uint32_t size)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    auto rack = this->rack(rackId);
+    if (!rack) {
+        return unexpected(rack.error());
+    }
+    if (!size) {
+        return unexpected("Size is wrong, should be greater than 0"_tr);
+    }
+
+    uint32_t loc = 1;
+    while (loc - 1 + size <= (*rack)->size) {
+        uint32_t blocker = 0;
+        if ((*rack)->isFree(loc, size, blocker)) {
+            return loc;
+        }
+        loc = blocker + 1;
+    }
+    return 0u;
+}
+
+void RackOccupancy::place(uint32_t rackId, uint32_t id, uint32_t size, uint32_t loc)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    auto parent = m_parent.find(id);
+    if (parent != m_parent.end() && parent->second != rackId) {
+        // moved to another rack
+        auto old = m_racks.find(parent->second);
+        if (old != m_racks.end()) {
+            old->second.assets.erase(id);
+            old->second.rebuild();
+        }
+        m_parent.erase(parent);
+    }
+
+    auto it = m_racks.find(rackId);
+    if (it == m_racks.end()) {
+        // loaded with the new position on first use
+        return;
+    }
+
+    it->second.assets[id] = {loc, size};
+    it->second.rebuild();
+    m_parent[id] = rackId;
+}
+
+void RackOccupancy::remove(uint32_t id)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    if (auto rack = m_racks.find(id); rack != m_racks.end()) {
+        for (const auto& asset : rack->second.assets) {
+            m_parent.erase(asset.first);
+        }
+        m_racks.erase(rack);
+        return;
+    }
+
+    auto parent = m_parent.find(id);
+    if (parent == m_parent.end()) {
+        return;
+    }
+
+    auto rack = m_racks.find(parent->second);
+    if (rack != m_racks.end()) {
+        rack->second.assets.erase(id);
+        rack->second.rebuild();
+    }
+    m_parent.erase(parent);
+}
+
+void RackOccupancy::clear()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_racks.clear();
+    m_parent.clear();
+}
+
+void RackOccupancy::setStaleness(std::chrono::seconds staleness)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_staleness = staleness;
+}
+
+} // namespace fty::asset
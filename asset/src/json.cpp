@@ -48,27 +48,39 @@ static std::string getOutletNumber(const std::string& extAttributeName)
     return oNumber;
 }
 
-static double s_rack_realpower_nominal(const std::string& name)
+static double s_rack_realpower_nominal(const std::string& name, const MetricSnapshot& metrics)
 {
     double      ret = 0.0;
     std::string value;
-    if (fty::shm::read_metric_value(name, "realpower.nominal", value) != 0) {
-        log_warning("No realpower.nominal for '%s'", name.c_str());
-    } else {
-        try {
-            ret = std::stod(value);
-        } catch (const std::exception&) {
-            log_error(
-                "the metric returned a string that does not encode a double value: '%s'. Defaulting to 0.0 value.",
-                value.c_str());
-            ret = std::nan("");
+    if (metrics.covers(name)) {
+        auto val = metrics.value(name, "realpower.nominal");
+        if (!val) {
+            log_warning("No realpower.nominal for '%s'", name.c_str());
+            return ret;
         }
+        value = *val;
+    } else if (fty::shm::read_metric_value(name, "realpower.nominal", value) != 0) {
+        log_warning("No realpower.nominal for '%s'", name.c_str());
+        return ret;
+    }
+
+    try {
+        ret = std::stod(value);
+    } catch (const std::exception&) {
+        log_error("the metric returned a string that does not encode a double value: '%s'. Defaulting to 0.0 value.",
+            value.c_str());
+        ret = std::nan("");
     }
 
     return ret;
 }
 
 std::string getJsonAsset(uint32_t elemId)
+{
+    return getJsonAsset(elemId, JsonCache{});
+}
+
+std::string getJsonAsset(uint32_t elemId, const JsonCache& cache)
 {
     std::string json;
     // Get informations from database
@@ -426,20 +438,27 @@ std::string getJsonAsset(uint32_t elemId)
 
     json += ", \"computed\" : {";
     if (persist::is_rack(tmp->typeId)) {
-        int    freeusize         = free_u_size(tmp->id);
-        double realpower_nominal = s_rack_realpower_nominal(tmp->name.c_str());
+        // precomputed figures of a whole datacenter, or the queries for this rack alone
+        RackComputed computed;
+        if (auto it = cache.racks.find(tmp->id); it != cache.racks.end()) {
+            computed = it->second;
+        } else {
+            computed.freeUSize = free_u_size(tmp->id);
+            if (rack_outlets_available(tmp->id, computed.outlets) != 0) {
+                log_error("Database failure");
+                json = "";
+                return json;
+            }
+        }
+
+        int    freeusize         = computed.freeUSize;
+        double realpower_nominal = s_rack_realpower_nominal(tmp->name, cache.metrics);
 
         json += "\"freeusize\":" + (freeusize >= 0 ? std::to_string(freeusize) : "null");
         json +=
             ",\"realpower.nominal\":" + (!std::isnan(realpower_nominal) ? std::to_string(realpower_nominal) : "null");
         json += ", \"outlet.available\" : {";
-        std::map<std::string, int> res;
-        int                        rv = rack_outlets_available(tmp->id, res);
-        if (rv != 0) {
-            log_error("Database failure");
-            json = "";
-            return json;
-        }
+        const std::map<std::string, int>& res = computed.outlets;
         size_t i = 1;
         for (const auto& it : res) {
 
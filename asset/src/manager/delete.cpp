@@ -5,6 +5,8 @@
 #include "asset/json.h"
 #include <fty_common_asset_types.h>
 #include "asset/asset-helpers.h"
+#include "asset/asset-licensing.h"
+#include "asset/asset-rack-occupancy.h"
 #include <fty_log.h>
 
 namespace fty::asset {
@@ -195,6 +197,13 @@ AssetExpected<db::AssetElement> AssetManager::deleteAsset(const db::AssetElement
         }
     }
 
+    if (ret) {
+        RackOccupancy::instance().remove(asset.id);
+        if (asset.status == "active" && asset.typeId == persist::DEVICE && isPowerDevice(asset.subtypeId)) {
+            activePowerDevicesChanged(-1);
+        }
+    }
+
     if (sendNotify) {
         try {
             logDebug("Deleting all mappings for asset {}", asset.name);
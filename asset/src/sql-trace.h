@@ -0,0 +1,64 @@
+/*  =========================================================================
+    sql-trace - database connection recording its queries in the SQL trace
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <fty_asset_sql_trace.h>
+#include <fty_common_db_connection.h>
+#include <string>
+
+namespace fty::asset {
+
+/// fty::db::Connection whose select, selectRow and execute are traced. Prepared statements are not.
+class TracedConnection : public fty::db::Connection
+{
+public:
+    using fty::db::Connection::Connection;
+
+    template <typename... Args>
+    auto select(const std::string& sql, const Args&... params)
+    {
+        sqltrace::Query query(sql);
+        auto            rows = fty::db::Connection::select(sql, params...);
+        query.rows(rows.size());
+        return rows;
+    }
+
+    template <typename... Args>
+    auto selectRow(const std::string& sql, const Args&... params)
+    {
+        sqltrace::Query query(sql);
+        auto            row = fty::db::Connection::selectRow(sql, params...);
+        query.rows(1);
+        return row;
+    }
+
+    template <typename... Args>
+    auto execute(const std::string& sql, const Args&... params)
+    {
+        sqltrace::Query query(sql);
+        auto            rows = fty::db::Connection::execute(sql, params...);
+        query.rows(rows);
+        return rows;
+    }
+};
+
+} // namespace fty::asset
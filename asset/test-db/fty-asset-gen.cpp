@@ -0,0 +1,109 @@
+#include "generator.h"
+#include "test-db.h"
+#include <asset/asset-manager.h>
+#include <chrono>
+#include <fstream>
+#include <fty_log.h>
+#include <iostream>
+
+static void usage()
+{
+    std::cout << "fty-asset-gen [options]\n"
+                 "  Fills an embedded test database with a synthetic datacenter.\n"
+                 "  --assets N        roughly N assets, overrides the shape options below\n"
+                 "  --datacenters N   datacenters\n"
+                 "  --rooms N         rooms per datacenter\n"
+                 "  --rows N          rows per room\n"
+                 "  --racks N         racks per row\n"
+                 "  --devices N       servers per rack\n"
+                 "  --groups N        groups per datacenter\n"
+                 "  --ext N           custom ext attributes per server\n"
+                 "  --seed N          random seed (default 1)\n"
+                 "  --export FILE     write the generated assets as import CSV\n"
+                 "  -h, --help        this help\n";
+}
+
+int main(int argc, char* argv[])
+{
+    fty::GeneratorConfig config;
+    uint64_t             assets = 0;
+    std::string          exportFile;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            usage();
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "missing value of " << arg << std::endl;
+            return 1;
+        }
+
+        std::string value = argv[++i];
+        try {
+            if (arg == "--assets") {
+                assets = std::stoull(value);
+            } else if (arg == "--datacenters") {
+                config.datacenters = uint32_t(std::stoul(value));
+            } else if (arg == "--rooms") {
+                config.rooms = uint32_t(std::stoul(value));
+            } else if (arg == "--rows") {
+                config.rows = uint32_t(std::stoul(value));
+            } else if (arg == "--racks") {
+                config.racks = uint32_t(std::stoul(value));
+            } else if (arg == "--devices") {
+                config.devices = uint32_t(std::stoul(value));
+            } else if (arg == "--groups") {
+                config.groups = uint32_t(std::stoul(value));
+            } else if (arg == "--ext") {
+                config.extAttributes = uint32_t(std::stoul(value));
+            } else if (arg == "--seed") {
+                config.seed = uint32_t(std::stoul(value));
+            } else if (arg == "--export") {
+                exportFile = value;
+            } else {
+                std::cerr << "unknown option " << arg << std::endl;
+                usage();
+                return 1;
+            }
+        } catch (const std::exception&) {
+            std::cerr << "invalid value of " << arg << ": " << value << std::endl;
+            return 1;
+        }
+    }
+
+    if (assets) {
+        config = fty::GeneratorConfig::forAssets(assets, config.seed);
+    }
+
+    ManageFtyLog::setInstanceFtylog("fty-asset-gen");
+
+    if (auto ret = fty::TestDb::init(); !ret) {
+        std::cerr << "cannot start test database: " << ret.error() << std::endl;
+        return 1;
+    }
+
+    int  rv    = 0;
+    auto start = std::chrono::steady_clock::now();
+    if (auto gen = fty::Generator::populate(config)) {
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        std::cout << gen->assets << " assets, " << gen->links << " links, " << gen->extAttributes
+                  << " ext attributes in " << ms.count() << " ms" << std::endl;
+
+        if (!exportFile.empty()) {
+            if (auto csv = fty::asset::AssetManager::exportCsv()) {
+                std::ofstream(exportFile) << *csv;
+            } else {
+                std::cerr << "export failed: " << csv.error().toString() << std::endl;
+                rv = 1;
+            }
+        }
+    } else {
+        std::cerr << "generation failed: " << gen.error() << std::endl;
+        rv = 1;
+    }
+
+    fty::TestDb::destroy();
+    return rv;
+}
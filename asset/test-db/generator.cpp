@@ -0,0 +1,425 @@
+#include "generator.h"
+#include <algorithm>
+#include <array>
+#include <fmt/format.h>
+#include <fty_common_asset_types.h>
+#include <fty_common_db_connection.h>
+#include <random>
+
+namespace fty {
+
+// =====================================================================================================================
+
+static constexpr size_t BATCH = 1000;
+
+// what dataset() put into the database, reset by clear()
+static uint64_t  s_datasetSize = 0;
+static Generated s_dataset;
+
+struct NewElement
+{
+    std::string name;
+    uint16_t    type;
+    uint16_t    subtype;
+    uint32_t    parent;
+    bool        active;
+    int         priority;
+};
+
+struct NewAttribute
+{
+    uint32_t    id;
+    std::string key;
+    std::string value;
+};
+
+struct NewLink
+{
+    uint32_t src;
+    uint32_t dest;
+    uint32_t outlet;
+    uint32_t input;
+};
+
+// =====================================================================================================================
+
+GeneratorConfig GeneratorConfig::forAssets(uint64_t total, uint32_t seed)
+{
+    GeneratorConfig config;
+    config.seed = seed;
+
+    // a rack holds itself, two ePDUs and the servers
+    uint64_t racks     = std::max<uint64_t>(1, total / (config.devices + 3));
+    config.datacenters = uint32_t(std::max<uint64_t>(1, racks / 5000));
+
+    uint64_t perDc = std::max<uint64_t>(1, racks / config.datacenters);
+    if (perDc >= 100) {
+        config.rooms = uint32_t(perDc / 100);
+        config.rows  = 10;
+        config.racks = 10;
+    } else {
+        config.rooms = 1;
+        config.rows  = uint32_t(std::max<uint64_t>(1, perDc / 10));
+        config.racks = uint32_t(std::min<uint64_t>(10, perDc));
+    }
+    return config;
+}
+
+// =====================================================================================================================
+
+class Writer
+{
+public:
+    Writer(fty::db::Connection& conn)
+        : m_conn(conn)
+    {
+    }
+
+    /// multi-row inserts get consecutive ids (innodb_autoinc_lock_mode <= 1), checked on the last row of a batch
+    std::vector<uint32_t> elements(const std::vector<NewElement>& elements)
+    {
+        std::vector<uint32_t> ids;
+        ids.reserve(elements.size());
+
+        for (size_t from = 0; from < elements.size(); from += BATCH) {
+            size_t to = std::min(elements.size(), from + BATCH);
+
+            std::string sql =
+                "INSERT INTO t_bios_asset_element (name, id_type, id_subtype, id_parent, status, priority) VALUES ";
+            for (size_t i = from; i < to; ++i) {
+                const auto& el = elements[i];
+                sql += fmt::format("{}('{}', {}, {}, {}, '{}', {})", i == from ? "" : ", ", el.name, el.type,
+                    el.subtype, el.parent ? std::to_string(el.parent) : "NULL", el.active ? "active" : "nonactive",
+                    el.priority);
+            }
+            m_conn.execute(sql);
+
+            uint32_t first = uint32_t(m_conn.lastInsertId());
+            uint32_t last  = first + uint32_t(to - from) - 1;
+
+            auto row = m_conn.selectRow(
+                "SELECT name FROM t_bios_asset_element WHERE id_asset_element = :id", "id"_p = last);
+            if (row.get("name") != elements[to - 1].name) {
+                throw std::runtime_error("asset ids of a batch are not consecutive");
+            }
+
+            for (size_t i = from; i < to; ++i) {
+                ids.push_back(first + uint32_t(i - from));
+            }
+        }
+        return ids;
+    }
+
+    void attributes(const std::vector<NewAttribute>& attributes)
+    {
+        batches(attributes,
+            "INSERT INTO t_bios_asset_ext_attributes (id_asset_element, keytag, value, read_only) VALUES ",
+            [](const NewAttribute& attr) {
+                return fmt::format("({}, '{}', '{}', 0)", attr.id, attr.key, attr.value);
+            });
+    }
+
+    void links(const std::vector<NewLink>& links, uint16_t type)
+    {
+        batches(links,
+            "INSERT INTO t_bios_asset_link (id_asset_device_src, src_out, id_asset_device_dest, dest_in, "
+            "id_asset_link_type) VALUES ",
+            [&](const NewLink& link) {
+                return fmt::format("({}, '{}', {}, '{}', {})", link.src, link.outlet, link.dest, link.input, type);
+            });
+    }
+
+    void groups(const std::vector<std::pair<uint32_t, uint32_t>>& relations)
+    {
+        batches(relations, "INSERT INTO t_bios_asset_group_relation (id_asset_group, id_asset_element) VALUES ",
+            [](const std::pair<uint32_t, uint32_t>& rel) {
+                return fmt::format("({}, {})", rel.first, rel.second);
+            });
+    }
+
+private:
+    template <typename T, typename Func>
+    void batches(const std::vector<T>& items, const std::string& insert, Func&& values)
+    {
+        for (size_t from = 0; from < items.size(); from += BATCH) {
+            std::string sql = insert;
+            for (size_t i = from; i < std::min(items.size(), from + BATCH); ++i) {
+                sql += (i == from ? "" : ", ") + values(items[i]);
+            }
+            m_conn.execute(sql);
+        }
+    }
+
+    fty::db::Connection& m_conn;
+};
+
+// =====================================================================================================================
+
+class Builder
+{
+public:
+    Builder(uint32_t seed)
+        : m_rnd(seed)
+    {
+    }
+
+    NewElement element(const std::string& prefix, uint16_t type, uint16_t subtype, uint32_t parent)
+    {
+        // most assets are active, priorities spread over P1..P5
+        bool active   = std::uniform_int_distribution<int>(0, 19)(m_rnd) != 0;
+        int  priority = std::uniform_int_distribution<int>(1, 5)(m_rnd);
+        return {fmt::format("{}-{}", prefix, ++m_seq), type, subtype, parent, active, priority};
+    }
+
+    std::string serial()
+    {
+        return fmt::format("SN{:08X}", std::uniform_int_distribution<uint32_t>()(m_rnd));
+    }
+
+    template <typename T>
+    const T& pick(const std::vector<T>& from)
+    {
+        return from[std::uniform_int_distribution<size_t>(0, from.size() - 1)(m_rnd)];
+    }
+
+    uint32_t number(uint32_t min, uint32_t max)
+    {
+        return std::uniform_int_distribution<uint32_t>(min, max)(m_rnd);
+    }
+
+private:
+    std::mt19937 m_rnd;
+    uint64_t     m_seq = 0;
+};
+
+// =====================================================================================================================
+
+template <typename T>
+static void append(std::vector<T>& to, const std::vector<T>& from)
+{
+    to.insert(to.end(), from.begin(), from.end());
+}
+
+Expected<Generated> Generator::populate(const GeneratorConfig& config)
+{
+    static const std::vector<std::string> models        = {"PowerEdge R640", "ProLiant DL380", "ThinkSystem SR650"};
+    static const std::vector<std::string> manufacturers = {"Dell", "HPE", "Lenovo"};
+    static const std::vector<std::string> outlets       = {"16", "24", "42"};
+
+    Generated ret;
+    Builder   build(config.seed);
+
+    std::vector<NewAttribute>                  attributes;
+    std::vector<NewLink>                       links;
+    std::vector<std::pair<uint32_t, uint32_t>> relations;
+
+    auto named = [&](const std::vector<uint32_t>& ids, const std::vector<NewElement>& els) {
+        for (size_t i = 0; i < ids.size(); ++i) {
+            attributes.push_back({ids[i], "name", els[i].name});
+        }
+    };
+
+    try {
+        fty::db::Connection conn;
+        Writer              write(conn);
+
+        auto linkType = conn.selectRow(
+            "SELECT id_asset_link_type FROM t_bios_asset_link_type WHERE name = :name", "name"_p = "power chain");
+        uint16_t powerChain = linkType.get<uint16_t>("id_asset_link_type");
+
+        // datacenters
+        std::vector<NewElement> level;
+        for (uint32_t d = 0; d < config.datacenters; ++d) {
+            level.push_back(build.element("datacenter", persist::DATACENTER, persist::SUNKNOWN, 0));
+        }
+        ret.datacenters = write.elements(level);
+        named(ret.datacenters, level);
+
+        // feeds, groups and rooms of every datacenter
+        level.clear();
+        for (uint32_t dc : ret.datacenters) {
+            level.push_back(build.element("feed", persist::DEVICE, persist::FEED, dc));
+            level.push_back(build.element("feed", persist::DEVICE, persist::FEED, dc));
+            for (uint32_t g = 0; g < config.groups; ++g) {
+                level.push_back(build.element("group", persist::GROUP, persist::SUNKNOWN, 0));
+            }
+            for (uint32_t r = 0; r < config.rooms; ++r) {
+                level.push_back(build.element("room", persist::ROOM, persist::SUNKNOWN, dc));
+            }
+        }
+        auto ids = write.elements(level);
+        named(ids, level);
+
+        std::vector<std::array<uint32_t, 2>> feeds;     // per datacenter
+        std::vector<std::vector<uint32_t>>   dcGroups;  // per datacenter
+        std::vector<size_t>                  roomDc;    // datacenter index of each room
+        for (size_t d = 0, i = 0; d < ret.datacenters.size(); ++d) {
+            feeds.push_back({ids[i], ids[i + 1]});
+            append(ret.devices, {ids[i], ids[i + 1]});
+            i += 2;
+            dcGroups.emplace_back(ids.begin() + long(i), ids.begin() + long(i + config.groups));
+            append(ret.groups, dcGroups.back());
+            i += config.groups;
+            for (uint32_t r = 0; r < config.rooms; ++r, ++i) {
+                ret.rooms.push_back(ids[i]);
+                roomDc.push_back(d);
+            }
+        }
+
+        // UPSes and rows of every room
+        level.clear();
+        for (uint32_t room : ret.rooms) {
+            level.push_back(build.element("ups", persist::DEVICE, persist::UPS, room));
+            level.push_back(build.element("ups", persist::DEVICE, persist::UPS, room));
+            for (uint32_t r = 0; r < config.rows; ++r) {
+                level.push_back(build.element("row", persist::ROW, persist::SUNKNOWN, room));
+            }
+        }
+        ids = write.elements(level);
+        named(ids, level);
+
+        std::vector<std::array<uint32_t, 2>> upses;   // per room
+        std::vector<size_t>                  rowRoom; // room index of each row
+        for (size_t r = 0, i = 0; r < ret.rooms.size(); ++r) {
+            upses.push_back({ids[i], ids[i + 1]});
+            append(ret.devices, {ids[i], ids[i + 1]});
+            for (uint32_t u = 0; u < 2; ++u) {
+                const auto& feed = feeds[roomDc[r]];
+                links.push_back({feed[0], ids[i + u], 1, 1});
+                links.push_back({feed[1], ids[i + u], 1, 2});
+            }
+            i += 2;
+            for (uint32_t w = 0; w < config.rows; ++w, ++i) {
+                ret.rows.push_back(ids[i]);
+                rowRoom.push_back(r);
+            }
+        }
+
+        // racks
+        level.clear();
+        std::vector<size_t> rackRoom;
+        for (size_t w = 0; w < ret.rows.size(); ++w) {
+            for (uint32_t r = 0; r < config.racks; ++r) {
+                level.push_back(build.element("rack", persist::RACK, persist::SUNKNOWN, ret.rows[w]));
+                rackRoom.push_back(rowRoom[w]);
+            }
+        }
+        ret.racks = write.elements(level);
+        named(ret.racks, level);
+        for (uint32_t rack : ret.racks) {
+            attributes.push_back({rack, "u_size", "42"});
+        }
+
+        // ePDUs and servers of every rack
+        level.clear();
+        for (uint32_t rack : ret.racks) {
+            level.push_back(build.element("epdu", persist::DEVICE, persist::EPDU, rack));
+            level.push_back(build.element("epdu", persist::DEVICE, persist::EPDU, rack));
+            for (uint32_t s = 0; s < config.devices; ++s) {
+                level.push_back(build.element("server", persist::DEVICE, persist::SERVER, rack));
+            }
+        }
+        ids = write.elements(level);
+        named(ids, level);
+        append(ret.devices, ids);
+
+        for (size_t r = 0, i = 0; r < ret.racks.size(); ++r) {
+            uint32_t epdu[2] = {ids[i], ids[i + 1]};
+            i += 2;
+
+            const auto& ups = upses[rackRoom[r]];
+            for (uint32_t e = 0; e < 2; ++e) {
+                attributes.push_back({epdu[e], "outlet.count", build.pick(outlets)});
+                links.push_back({ups[e], epdu[e], uint32_t(r % 8) + 1, 1});
+            }
+
+            const auto& groups = dcGroups[roomDc[rackRoom[r]]];
+            uint32_t    pos    = 1;
+            for (uint32_t s = 0; s < config.devices; ++s, ++i) {
+                uint32_t server = ids[i];
+                uint32_t size   = build.number(1, 2);
+
+                attributes.push_back({server, "u_size", std::to_string(size)});
+                if (pos + size - 1 <= 42) {
+                    attributes.push_back({server, "location_u_pos", std::to_string(pos)});
+                    pos += size;
+                }
+                attributes.push_back({server, "serial_no", build.serial()});
+                attributes.push_back({server, "model", build.pick(models)});
+                attributes.push_back({server, "manufacturer", build.pick(manufacturers)});
+                attributes.push_back({server, "ip.1",
+                    fmt::format("10.{}.{}.{}", (server >> 16) & 0xff, (server >> 8) & 0xff, server & 0xff)});
+                for (uint32_t x = 1; x <= config.extAttributes; ++x) {
+                    attributes.push_back({server, fmt::format("custom.{}", x), std::to_string(build.number(0, 9999))});
+                }
+
+                links.push_back({epdu[0], server, s + 1, 1});
+                links.push_back({epdu[1], server, s + 1, 2});
+
+                // up to two distinct groups
+                if (!groups.empty()) {
+                    uint32_t first = build.pick(groups);
+                    relations.emplace_back(first, server);
+                    uint32_t second = build.pick(groups);
+                    if (second != first && build.number(0, 1)) {
+                        relations.emplace_back(second, server);
+                    }
+                }
+            }
+        }
+
+        write.attributes(attributes);
+        write.links(links, powerChain);
+        write.groups(relations);
+
+        ret.assets = ret.datacenters.size() + ret.rooms.size() + ret.rows.size() + ret.racks.size() +
+                     ret.devices.size() + ret.groups.size();
+        ret.links         = links.size();
+        ret.extAttributes = attributes.size();
+        return ret;
+    } catch (const std::exception& e) {
+        return unexpected(e.what());
+    }
+}
+
+Expected<Generated> Generator::dataset(uint64_t assets)
+{
+    if (s_datasetSize == assets) {
+        return s_dataset;
+    }
+
+    if (auto ret = clear(); !ret) {
+        return unexpected(ret.error());
+    }
+    auto ret = populate(GeneratorConfig::forAssets(assets));
+    if (!ret) {
+        return unexpected(ret.error());
+    }
+
+    s_dataset     = *ret;
+    s_datasetSize = assets;
+    return s_dataset;
+}
+
+Expected<void> Generator::clear()
+{
+    s_datasetSize = 0;
+    try {
+        fty::db::Connection conn;
+        // parents and children go in one statement, the self reference is not checked meanwhile
+        conn.execute("SET FOREIGN_KEY_CHECKS = 0");
+        conn.execute("DELETE FROM t_bios_asset_group_relation");
+        conn.execute("DELETE FROM t_bios_asset_link");
+        conn.execute("DELETE FROM t_bios_asset_ext_attributes");
+        conn.execute("DELETE FROM t_bios_monitor_asset_relation");
+        conn.execute("DELETE FROM t_bios_asset_element");
+        conn.execute("SET FOREIGN_KEY_CHECKS = 1");
+        return {};
+    } catch (const std::exception& e) {
+        return unexpected(e.what());
+    }
+}
+
+// =====================================================================================================================
+
+} // namespace fty
@@ -0,0 +1,61 @@
+#pragma once
+#include <fty/expected.h>
+#include <string>
+#include <vector>
+
+namespace fty {
+
+// =====================================================================================================================
+
+/// Shape of a synthetic datacenter, every count is per parent
+struct GeneratorConfig
+{
+    uint32_t seed          = 1;
+    uint32_t datacenters   = 1;
+    uint32_t rooms         = 2;
+    uint32_t rows          = 5;
+    uint32_t racks         = 10;
+    uint32_t devices       = 20; // servers per rack, each rack has two ePDUs on top
+    uint32_t groups        = 10; // per datacenter
+    uint32_t extAttributes = 5;  // custom attributes per server, on top of the usual ones
+
+    /// hierarchy of roughly total assets
+    static GeneratorConfig forAssets(uint64_t total, uint32_t seed = 1);
+};
+
+/// Ids of what was generated
+struct Generated
+{
+    std::vector<uint32_t> datacenters;
+    std::vector<uint32_t> rooms;
+    std::vector<uint32_t> rows;
+    std::vector<uint32_t> racks;
+    std::vector<uint32_t> devices; // feeds, UPSes, ePDUs and servers
+    std::vector<uint32_t> groups;
+
+    uint64_t assets        = 0;
+    uint64_t links         = 0;
+    uint64_t extAttributes = 0;
+};
+
+/// Fills the test database with a datacenter → room → row → rack → device hierarchy.
+///
+/// Every datacenter has two feeds, every room two UPSes fed by them, every rack two ePDUs fed by the UPSes and every
+/// server is fed by both ePDUs of its rack. Servers get u_size/location_u_pos, ext attributes and a few random groups.
+/// The same seed gives the same data. Rows are written with multi-row INSERTs, a million assets take minutes, not
+/// hours.
+class Generator
+{
+public:
+    static Expected<Generated> populate(const GeneratorConfig& config);
+
+    /// roughly assets with the default seed, the database is only filled again when another size is asked
+    static Expected<Generated> dataset(uint64_t assets);
+
+    /// removes all assets, links, groups and attributes
+    static Expected<void> clear();
+};
+
+// =====================================================================================================================
+
+} // namespace fty
@@ -25,6 +25,8 @@ struct DBData : pack::Node
         Feed,
         Rack,
         Ups,
+        Epdu,
+        Pdu,
         Row,
         Room
     };
@@ -80,6 +82,10 @@ std::istream& operator>>(std::istream& ss, DBData::Types& value)
         value = DBData::Types::Rack;
     } else if (strval == "Ups") {
         value = DBData::Types::Ups;
+    } else if (strval == "Epdu") {
+        value = DBData::Types::Epdu;
+    } else if (strval == "Pdu") {
+        value = DBData::Types::Pdu;
     } else if (strval == "Row") {
         value = DBData::Types::Row;
     } else if (strval == "Room") {
@@ -124,6 +130,8 @@ static void createItem(fty::db::Connection& conn, const DBData::Item& item, std:
             case DBData::Types::Room:
                 return persist::ROOM;
             case DBData::Types::Ups:
+            case DBData::Types::Epdu:
+            case DBData::Types::Pdu:
                 return persist::DEVICE;
             case DBData::Types::Unknown:
                 return persist::TUNKNOWN;
@@ -155,6 +163,10 @@ static void createItem(fty::db::Connection& conn, const DBData::Item& item, std:
                 return persist::SUNKNOWN;
             case DBData::Types::Ups:
                 return persist::UPS;
+            case DBData::Types::Epdu:
+                return persist::EPDU;
+            case DBData::Types::Pdu:
+                return persist::PDU;
             case DBData::Types::Unknown:
                 return persist::SUNKNOWN;
         }
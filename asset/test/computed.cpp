@@ -0,0 +1,234 @@
+#include "asset/asset-computed.h"
+#include <catch2/catch.hpp>
+#include <fty/convert.h>
+#include <fty_common.h>
+#include <fty_common_db_asset.h>
+#include <test-db/sample-db.h>
+#include <tntdb/connect.h>
+
+// Former implementations, one query per device, kept as the reference for the aggregated queries
+
+static int legacyUSize(tntdb::Connection& conn, std::set<uint32_t>& elements)
+{
+    int size = 0;
+
+    std::function<void(const tntdb::Row&)> sumarize = [&size](const tntdb::Row& row) {
+        uint32_t tmp = fty::convert<uint32_t>(row.getString("value"));
+        if (tmp != UINT32_MAX) {
+            size += int(tmp);
+        }
+    };
+
+    int rv = DBAssets::select_asset_ext_attribute_by_keytag(conn, "u_size", elements, sumarize);
+    if (rv != 0)
+        return rv;
+    return size;
+}
+
+static int legacyFreeUSize(uint32_t elementId)
+{
+    tntdb::Connection conn = tntdb::connect(getenv("DBURL"));
+
+    std::set<uint32_t> rack_id{elementId};
+    int                freeusize = legacyUSize(conn, rack_id);
+    if (!freeusize) {
+        return -1;
+    }
+
+    std::set<uint32_t>                     element_ids{};
+    std::function<void(const tntdb::Row&)> func = [&element_ids](const tntdb::Row& row) {
+        uint32_t asset_id = 0;
+        row["asset_id"].get(asset_id);
+        element_ids.insert(asset_id);
+    };
+
+    if (DBAssets::select_assets_by_container(conn, elementId, func) == -1) {
+        return -1;
+    }
+    int freeusize2 = legacyUSize(conn, element_ids);
+    if (!freeusize2) {
+        return -1;
+    }
+    return freeusize - (element_ids.empty() ? 0 : freeusize2);
+}
+
+static uint32_t legacyOutletCount(tntdb::Connection& conn, uint32_t id)
+{
+    static const char* KEY = "outlet.count";
+
+    std::map<std::string, std::pair<std::string, bool>> res;
+    int                                                 ret = DBAssets::select_ext_attributes(conn, id, res);
+
+    if (ret != 0 || res.count(KEY) == 0)
+        return UINT32_MAX;
+
+    std::string foo   = res.at(KEY).first.c_str();
+    auto        dot_i = foo.find('.');
+    if (dot_i != std::string::npos) {
+        foo.erase(dot_i, foo.size() - dot_i);
+    }
+    if (foo.size() > 5)
+        return UINT32_MAX;
+
+    return fty::convert<uint32_t>(foo);
+}
+
+static int legacyOutletsAvailable(uint32_t elementId, std::map<std::string, int>& res)
+{
+    int               sum     = -1;
+    bool              tainted = false;
+    tntdb::Connection conn    = tntdb::connect(getenv("DBURL"));
+    res["sum"]                = sum;
+
+    std::function<void(const tntdb::Row& row)> cb = [&conn, &sum, &tainted, &res](const tntdb::Row& row) {
+        uint32_t device_subtype = 0;
+        row["subtype_id"].get(device_subtype);
+        if (!persist::is_epdu(int(device_subtype)) && !persist::is_pdu(int(device_subtype)))
+            return;
+
+        uint32_t device_asset_id = 0;
+        row["asset_id"].get(device_asset_id);
+
+        uint32_t foo          = legacyOutletCount(conn, device_asset_id);
+        int      outlet_count = foo != UINT32_MAX ? int(foo) : -1;
+
+        int outlet_used = DBAssets::count_of_link_src(conn, device_asset_id);
+        if (outlet_used == -1)
+            outlet_count = -1;
+        else
+            outlet_count -= outlet_used;
+
+        if (outlet_count >= 0)
+            sum += outlet_count;
+        else
+            tainted = true;
+        res[std::to_string(device_asset_id)] = outlet_count;
+    };
+
+    int rv = DBAssets::select_assets_by_container(conn, elementId, cb);
+    if (!tainted)
+        res["sum"] = sum + 1;
+    return rv;
+}
+
+TEST_CASE("Computed / Racks")
+{
+    fty::SampleDb db(R"(
+        items:
+            - type : Datacenter
+              name : datacenter
+              items :
+                  - type  : Rack
+                    name  : rack
+                    attrs :
+                        u_size : "42"
+                    items :
+                        - type  : Server
+                          name  : srv1
+                          attrs :
+                              u_size : "2"
+                        - type  : Server
+                          name  : srv2
+                          attrs :
+                              u_size : "4"
+                        - type  : Server
+                          name  : srv3
+                        - type  : Epdu
+                          name  : epdu
+                          attrs :
+                              outlet.count : "24.0"
+                        - type  : Pdu
+                          name  : pdu
+                          attrs :
+                              outlet.count : "8"
+                  - type  : Rack
+                    name  : empty
+                    attrs :
+                        u_size : "10"
+                  - type  : Rack
+                    name  : nosize
+                    attrs :
+                        u_size : "20"
+                    items :
+                        - type : Server
+                          name : srv4
+                  - type  : Rack
+                    name  : unknown
+                    items :
+                        - type : Epdu
+                          name : epdu2
+                  - type  : Row
+                    name  : row
+                    items :
+                        - type  : Rack
+                          name  : inrow
+                          attrs :
+                              u_size : "42"
+                          items :
+                              - type  : Epdu
+                                name  : epdu3
+                                attrs :
+                                    outlet.count : "999999"
+                              - type  : Server
+                                name  : srv5
+                                attrs :
+                                    u_size : "1"
+        links:
+            - dest : srv1
+              src  : epdu
+              type : power chain
+            - dest : srv2
+              src  : epdu
+              type : power chain
+            - dest : srv1
+              src  : pdu
+              type : power chain
+    )");
+
+    const std::vector<std::string> racks = {"rack", "empty", "nosize", "unknown", "inrow"};
+
+    RackComputedMap all;
+    REQUIRE(racks_computed(db.idByName("datacenter"), all) == 0);
+    CHECK(all.size() == racks.size());
+
+    for (const auto& name : racks) {
+        uint32_t id = db.idByName(name);
+        INFO(name);
+
+        int freeUSize = free_u_size(id);
+        CHECK(freeUSize == legacyFreeUSize(id));
+
+        std::map<std::string, int> outlets;
+        std::map<std::string, int> legacy;
+        CHECK(rack_outlets_available(id, outlets) == 0);
+        CHECK(legacyOutletsAvailable(id, legacy) == 0);
+        CHECK(outlets == legacy);
+
+        REQUIRE(all.count(id));
+        CHECK(all[id].freeUSize == freeUSize);
+        CHECK(all[id].outlets == outlets);
+    }
+
+    CHECK(free_u_size(db.idByName("rack")) == 36);
+    CHECK(free_u_size(db.idByName("empty")) == 10);
+    CHECK(free_u_size(db.idByName("nosize")) == -1);
+    CHECK(free_u_size(db.idByName("unknown")) == -1);
+    CHECK(free_u_size(db.idByName("inrow")) == 41);
+
+    std::map<std::string, int> outlets;
+    CHECK(rack_outlets_available(db.idByName("rack"), outlets) == 0);
+    CHECK(outlets.size() == 3);
+    CHECK(outlets[std::to_string(db.idByName("epdu"))] == 22);
+    CHECK(outlets[std::to_string(db.idByName("pdu"))] == 7);
+    CHECK(outlets["sum"] == 29);
+
+    outlets.clear();
+    CHECK(rack_outlets_available(db.idByName("inrow"), outlets) == 0);
+    CHECK(outlets[std::to_string(db.idByName("epdu3"))] == -1);
+    CHECK(outlets["sum"] == -1);
+
+    outlets.clear();
+    CHECK(rack_outlets_available(db.idByName("empty"), outlets) == 0);
+    CHECK(outlets.size() == 1);
+    CHECK(outlets["sum"] == 0);
+}
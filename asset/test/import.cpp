@@ -1,5 +1,8 @@
+#include "asset/asset-db.h"
+#include "asset/asset-licensing.h"
 #include "asset/asset-manager.h"
 #include <catch2/catch.hpp>
+#include <fty_asset_fake_activator.h>
 #include <test-db/sample-db.h>
 
 TEST_CASE("Import asset")
@@ -35,3 +38,48 @@ NewsFeed,device,feed,Washington DC,active,P1,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,1,,,
         }
     }
 }
+
+TEST_CASE("Import asset - activation when a row fails")
+{
+    fty::SampleDb db(R"(
+        items:
+          - type     : Datacenter
+            name     : datacenter
+            ext-name : Washington DC
+            items:
+              - type     : Feed
+                name     : feed
+                ext-name : Feed1
+    )");
+
+    fty::activation::FakeActivator activator(10);
+    fty::activation::setTransport(activator.transport());
+    fty::asset::setLicensingLimitation({10, 1});
+
+    // a new device, an update of the active feed, then a truncated row which throws
+    static std::string data = R"(name,type,sub_type,location,status,priority,id
+NewFeed,device,feed,Washington DC,active,P1,
+Feed1,device,feed,Washington DC,active,P2,feed
+Broken,device)";
+
+    REQUIRE_THROWS(fty::asset::AssetManager::importCsv(data, "dummy", true));
+
+    // the row stored before the failure is sent to the activator, the active feed is neither sent nor
+    // stored as nonactive
+    CHECK(activator.active() == 1);
+    auto created = fty::asset::db::selectAssetElementByName("NewFeed");
+    REQUIRE(created);
+
+    auto updated = fty::asset::db::selectAssetElementByName("feed");
+    REQUIRE(updated);
+    CHECK(updated->status == "active");
+    CHECK(updated->priority == 2);
+
+    auto el = fty::asset::db::selectAssetElementWebById(created->id);
+    REQUIRE(el);
+    if (auto res = fty::asset::AssetManager::deleteAsset(*el, false); !res) {
+        FAIL(res.error());
+    }
+
+    fty::activation::setTransport({});
+}
@@ -0,0 +1,117 @@
+#include "asset/asset-db.h"
+#include "asset/asset-licensing.h"
+#include "asset/asset-manager.h"
+#include <catch2/catch.hpp>
+#include <fty_asset_fake_activator.h>
+#include <test-db/sample-db.h>
+
+TEST_CASE("Licensing / Announcements update the cached limitations")
+{
+    fty::asset::setLicensingLimitation({5, 1});
+    {
+        auto limitations = fty::asset::getLicensingLimitation();
+        REQUIRE_EXP(limitations);
+        CHECK(limitations->max_active_power_devices == 5);
+        CHECK(limitations->global_configurability == 1);
+    }
+
+    CHECK(fty::asset::updateLicensingLimitation("rackcontroller-0", "power_nodes.max_active", "7"));
+    CHECK(fty::asset::updateLicensingLimitation("rackcontroller-0", "configurability.global", "0"));
+    CHECK(!fty::asset::updateLicensingLimitation("rackcontroller-1", "power_nodes.max_active", "1"));
+    CHECK(!fty::asset::updateLicensingLimitation("rackcontroller-0", "power_nodes.unknown", "1"));
+    {
+        auto limitations = fty::asset::getLicensingLimitation();
+        REQUIRE_EXP(limitations);
+        CHECK(limitations->max_active_power_devices == 7);
+        CHECK(limitations->global_configurability == 0);
+    }
+}
+
+TEST_CASE("Licensing / Active power devices follow deletes")
+{
+    fty::SampleDb db(R"(
+        items:
+          - type     : Datacenter
+            name     : datacenter
+            ext-name : Washington DC
+            items:
+              - type : Ups
+                name : ups
+              - type : Epdu
+                name : epdu
+              - type : Feed
+                name : feed
+    )");
+
+    CHECK(fty::asset::isPowerDevice(persist::UPS));
+    CHECK(!fty::asset::isPowerDevice(persist::FEED));
+
+    auto counted = fty::asset::activePowerDevices(true);
+    REQUIRE_EXP(counted);
+    CHECK(*counted == 2);
+
+    // cached between recounts, adjusted by the process
+    fty::asset::activePowerDevicesChanged(1);
+    CHECK(*fty::asset::activePowerDevices() == 3);
+    fty::asset::activePowerDevicesChanged(-1);
+
+    auto deleted = fty::asset::AssetManager::deleteAsset(db.idByName("ups"), false);
+    REQUIRE_EXP(deleted);
+    CHECK(*fty::asset::activePowerDevices() == 1);
+    CHECK(*fty::asset::activePowerDevices(true) == 1);
+
+    // not a power device, the count does not move
+    auto feed = fty::asset::AssetManager::deleteAsset(db.idByName("feed"), false);
+    REQUIRE_EXP(feed);
+    CHECK(*fty::asset::activePowerDevices() == 1);
+}
+
+TEST_CASE("Licensing / Limit check of an import")
+{
+    fty::SampleDb db(R"(
+        items:
+          - type     : Datacenter
+            name     : datacenter
+            ext-name : Washington DC
+            items:
+              - type : Ups
+                name : ups
+    )");
+
+    fty::activation::FakeActivator activator(10);
+    fty::activation::setTransport(activator.transport());
+    REQUIRE(*fty::asset::activePowerDevices(true) == 1);
+
+    static std::string data = R"(name,type,sub_type,location,status,priority,id
+NewUps,device,ups,Washington DC,active,P1,)";
+
+    SECTION("full license")
+    {
+        fty::asset::setLicensingLimitation({1, 1});
+
+        auto ret = fty::asset::AssetManager::importCsv(data, "dummy", true);
+        REQUIRE_EXP(ret);
+        REQUIRE(!ret->at(1));
+        CHECK(activator.active() == 0);
+    }
+
+    SECTION("stale count is checked again before rejecting")
+    {
+        fty::asset::setLicensingLimitation({2, 1});
+        // a device deactivated by another process is not known here
+        fty::asset::activePowerDevicesChanged(1);
+
+        auto ret = fty::asset::AssetManager::importCsv(data, "dummy", true);
+        REQUIRE_EXP(ret);
+        REQUIRE(ret->at(1));
+        CHECK(activator.active() == 1);
+        CHECK(*fty::asset::activePowerDevices() == 2);
+    }
+
+    if (auto created = fty::asset::db::selectAssetElementByName("NewUps")) {
+        auto res = fty::asset::AssetManager::deleteAsset(created->id, false);
+        REQUIRE_EXP(res);
+    }
+
+    fty::activation::setTransport({});
+}
@@ -5,6 +5,7 @@
 #include <thread>
 #include <fty_log.h>
 #include "test-db/test-db.h"
+#include "asset/asset-licensing.h"
 
 
 int main(int argc, char* argv[])
@@ -23,6 +24,7 @@ int main(int argc, char* argv[])
 
     ManageFtyLog::setInstanceFtylog("asset-test", "conf/logger.conf");
     int result = session.run(argc, argv);
+    fty::asset::destroyLicensingCache();
     fty::TestDb::destroy();
     return result;
 }
@@ -0,0 +1,115 @@
+#include "asset/asset-metrics.h"
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fty_shm.h>
+#include <iostream>
+#include <unistd.h>
+
+// fake shm directory on tmpfs, removed when the test ends
+struct ShmDir
+{
+    ShmDir()
+    {
+        std::string tmpl = "/dev/shm/fty-asset-metrics-XXXXXX";
+        path             = mkdtemp(tmpl.data());
+        fty_shm_set_test_dir(path.c_str());
+    }
+
+    ~ShmDir()
+    {
+        fty_shm_delete_test_dir();
+    }
+
+    std::string path;
+};
+
+TEST_CASE("Metric snapshot")
+{
+    ShmDir dir;
+
+    REQUIRE(fty::shm::write_metric("rack-1", "realpower.nominal", "1200", "W", 300) == 0);
+    REQUIRE(fty::shm::write_metric("rack-1", "load.default", "oops", "%", 300) == 0);
+    REQUIRE(fty::shm::write_metric("rack-2", "realpower.nominal", "800", "W", 300) == 0);
+    REQUIRE(fty::shm::write_metric("rack-3", "realpower.nominal", "500", "W", 300) == 0);
+
+    SECTION("All metrics")
+    {
+        fty::asset::MetricSnapshot metrics({"rack-1", "rack-2", "rack-4"});
+
+        CHECK(metrics.size() == 3);
+        CHECK(metrics.covers("rack-4"));
+        CHECK(!metrics.covers("rack-3"));
+        CHECK(*metrics.value("rack-1", "realpower.nominal") == "1200");
+        CHECK(*metrics.number("rack-2", "realpower.nominal") == 800.0);
+        CHECK(std::isnan(*metrics.number("rack-1", "load.default")));
+        CHECK(!metrics.value("rack-4", "realpower.nominal"));
+        CHECK(!metrics.value("rack-3", "realpower.nominal"));
+    }
+
+    SECTION("Selected metrics")
+    {
+        fty::asset::MetricSnapshot metrics({"rack-1", "rack-2"}, {"realpower.nominal"});
+
+        CHECK(metrics.size() == 2);
+        CHECK(!metrics.value("rack-1", "load.default"));
+    }
+
+    SECTION("Nothing asked")
+    {
+        fty::asset::MetricSnapshot metrics(std::set<std::string>{});
+        CHECK(metrics.size() == 0);
+    }
+
+    SECTION("Unreadable metrics")
+    {
+        std::filesystem::remove_all(dir.path);
+        fty::asset::MetricSnapshot metrics({"rack-1", "rack-2"});
+        std::filesystem::create_directory(dir.path);
+
+        CHECK(metrics.size() == 0);
+        CHECK(!metrics.covers("rack-1"));
+        CHECK(!metrics.covers("rack-2"));
+    }
+}
+
+TEST_CASE("Metric snapshot benchmark", "[.][benchmark]")
+{
+    ShmDir dir;
+
+    static constexpr int ASSETS  = 5000;
+    static constexpr int METRICS = 10;
+    static constexpr int RACKS   = 1000;
+
+    for (int i = 0; i < ASSETS; ++i) {
+        for (int m = 0; m < METRICS; ++m) {
+            std::string name = m == 0 ? "realpower.nominal" : "metric." + std::to_string(m);
+            fty::shm::write_metric("rack-" + std::to_string(i), name, std::to_string(i * m), "W", 300);
+        }
+    }
+
+    std::set<std::string> racks;
+    for (int i = 0; i < RACKS; ++i) {
+        racks.insert("rack-" + std::to_string(i * (ASSETS / RACKS)));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& rack : racks) {
+        std::string value;
+        CHECK(fty::shm::read_metric_value(rack, "realpower.nominal", value) == 0);
+    }
+    auto perKey = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    fty::asset::MetricSnapshot metrics(racks, {"realpower.nominal"});
+    for (const auto& rack : racks) {
+        CHECK(metrics.value(rack, "realpower.nominal"));
+    }
+    auto snapshot = std::chrono::steady_clock::now() - start;
+
+    using std::chrono::milliseconds;
+    std::cout << ASSETS * METRICS << " metrics, " << RACKS << " racks: per key "
+              << std::chrono::duration_cast<milliseconds>(perKey).count() << " ms, snapshot "
+              << std::chrono::duration_cast<milliseconds>(snapshot).count() << " ms" << std::endl;
+}
@@ -0,0 +1,81 @@
+#include "asset/asset-computed.h"
+#include "asset/asset-db.h"
+#include <catch2/catch.hpp>
+#include <fty_asset_sql_trace.h>
+#include <test-db/sample-db.h>
+
+// Upper bounds on the statements run by the helpers, a loop over a query per asset shows up here first
+
+TEST_CASE("Queries / Counts")
+{
+    fty::SampleDb db(R"(
+        items:
+            - type : Datacenter
+              name : datacenter
+              items :
+                  - type  : Rack
+                    name  : rack1
+                    attrs :
+                        u_size : "42"
+                    items :
+                        - type  : Server
+                          name  : srv1
+                          attrs :
+                              u_size : "2"
+                        - type  : Epdu
+                          name  : epdu1
+                          attrs :
+                              outlet.count : "24"
+                  - type  : Rack
+                    name  : rack2
+                    attrs :
+                        u_size : "42"
+                    items :
+                        - type  : Epdu
+                          name  : epdu2
+                          attrs :
+                              outlet.count : "8"
+    )");
+
+    fty::sqltrace::setEnabled(true);
+
+    SECTION("nameToAssetId")
+    {
+        fty::sqltrace::Scope trace("test");
+        REQUIRE(trace.active());
+
+        auto id = fty::asset::db::nameToAssetId("rack1");
+        REQUIRE(id);
+        CHECK(trace.queries() == 1);
+        CHECK(trace.calls("FROM t_bios_asset_element WHERE name = ?") == 1);
+    }
+
+    SECTION("racks_computed")
+    {
+        fty::sqltrace::Scope trace("test");
+
+        RackComputedMap racks;
+        REQUIRE(racks_computed(db.idByName("datacenter"), racks) == 0);
+        CHECK(racks.size() == 2);
+        // one statement for the sizes, one for the outlets, whatever the number of racks
+        CHECK(trace.queries() <= 2);
+        CHECK(trace.repeated().empty());
+    }
+
+    SECTION("N+1")
+    {
+        uint64_t limit = fty::sqltrace::repeatLimit();
+        fty::sqltrace::setRepeatLimit(2);
+
+        fty::sqltrace::Scope trace("test");
+        for (const auto& name : {"rack1", "rack2", "srv1", "epdu1", "epdu2"}) {
+            int freeUSize = free_u_size(db.idByName(name));
+            (void)freeUSize;
+        }
+        CHECK(trace.queries() == 5);
+        REQUIRE(trace.repeated().size() == 1);
+        CHECK(trace.repeated()[0].calls == 5);
+
+        fty::sqltrace::setRepeatLimit(limit);
+    }
+}
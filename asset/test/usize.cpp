@@ -1,6 +1,8 @@
 #include "asset/asset-db.h"
 #include "asset/asset-manager.h"
+#include "asset/asset-rack-occupancy.h"
 #include "test-utils.h"
+#include <chrono>
 #include <test-db/sample-db.h>
 
 template <typename T>
@@ -21,6 +23,7 @@ struct Holder
         if (m_delete) {
             std::cerr << "delete " << m_el.name << std::endl;
             deleteAsset(m_el);
+            fty::asset::RackOccupancy::instance().remove(m_el.id);
         }
     }
 
@@ -127,4 +130,71 @@ TEST_CASE("USize")
         auto el  = placeAsset(*rack, 1, 9, true);
         auto el1 = placeAsset(*rack, 2, 10, false);
     }
+
+    SECTION("First fit")
+    {
+        auto& occupancy = fty::asset::RackOccupancy::instance();
+
+        auto el  = placeAsset(*rack, 2, 1, true);
+        auto el1 = placeAsset(*rack, 1, 4, true);
+        CHECK(*occupancy.findFirstFit(rack->id, 1) == 3);
+        CHECK(*occupancy.findFirstFit(rack->id, 6) == 5);
+        CHECK(*occupancy.findFirstFit(rack->id, 7) == 0);
+        CHECK(occupancy.check(rack->id, el1.m_el.id, 2, 3));
+        CHECK(!occupancy.check(rack->id, 0, 2, 3));
+    }
+}
+
+TEST_CASE("USize benchmark", "[.][benchmark]")
+{
+    static constexpr int racks   = 250;
+    static constexpr int devices = 10000;
+
+    std::string yaml =
+        "items:\n"
+        "    - type     : Datacenter\n"
+        "      name     : datacenter\n"
+        "      ext-name : Data Center\n"
+        "      items :\n"
+        "          - type     : Row\n"
+        "            name     : row\n"
+        "            items    :\n";
+    for (int i = 0; i < racks; ++i) {
+        yaml += "            - type : Rack\n";
+        yaml += "              name : rack" + std::to_string(i) + "\n";
+        yaml += "              attrs :\n";
+        yaml += "                  u_size: 42\n";
+    }
+    fty::SampleDb db(yaml);
+
+    std::vector<uint32_t> ids;
+    for (int i = 0; i < racks; ++i) {
+        ids.push_back(fty::asset::db::selectAssetElementWebByName("rack" + std::to_string(i))->id);
+    }
+
+    auto&                     occupancy = fty::asset::RackOccupancy::instance();
+    std::chrono::microseconds checks{0};
+
+    for (int i = 0; i < devices; ++i) {
+        uint32_t rackId = ids[size_t(i % racks)];
+        uint32_t loc    = uint32_t(i / racks) + 1;
+
+        auto start = std::chrono::steady_clock::now();
+        REQUIRE(fty::asset::tryToPlaceAsset(0, rackId, 1, loc));
+        checks += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+        fty::asset::db::AssetElement rack;
+        rack.id = rackId;
+
+        assets::Server server("srv" + std::to_string(i), rack);
+        server.setExtAttributes({{"u_size", "1"}, {"location_u_pos", std::to_string(loc)}});
+        occupancy.place(rackId, server.id, 1, loc);
+    }
+
+    // every rack is full up to 40U now
+    CHECK(*occupancy.findFirstFit(ids[0], 2) == 41);
+    CHECK(!fty::asset::tryToPlaceAsset(0, ids[0], 1, 40));
+
+    std::cerr << devices << " placement checks in " << racks << " racks: " << checks.count() / 1000 << " ms"
+              << std::endl;
 }
@@ -46,13 +46,45 @@ s_republish (mlm_client_t *client, int argn, int argc, char** argv)
     mlm_client_sendto (client, "asset-agent", "REPUBLISH", NULL, 1000, &msg);
 }
 
+// latency percentiles of the agent, as JSON on stdout
+static int
+s_stats (mlm_client_t *client)
+{
+    zmsg_t *msg = zmsg_new ();
+    if (mlm_client_sendto (client, "asset-agent", "STATS", NULL, 1000, &msg) != 0) {
+        log_error ("fty-asset-cli:\tCannot send STATS request");
+        return -1;
+    }
+
+    poller = zpoller_new (mlm_client_msgpipe (client), NULL);
+    int rv = -1;
+    if (zpoller_wait (poller, 5000)) {
+        zmsg_t *reply = mlm_client_recv (client);
+        char *status = zmsg_popstr (reply);
+        char *json = zmsg_popstr (reply);
+        if (status && streq (status, "OK") && json) {
+            puts (json);
+            rv = 0;
+        }
+        else
+            log_error ("fty-asset-cli:\tUnexpected STATS reply");
+        zstr_free (&json);
+        zstr_free (&status);
+        zmsg_destroy (&reply);
+    }
+    else
+        log_error ("fty-asset-cli:\tNo STATS reply from asset-agent");
+    zpoller_destroy (&poller);
+    return rv;
+}
+
 
 int main (int argc, char *argv [])
 {
     mlm_client_t *client = mlm_client_new ();
     assert (client);
 
-    [[maybe_unused]] int rv = mlm_client_connect (client, endpoint, 1000, "CLI");
+    int rv = mlm_client_connect (client, endpoint, 1000, "CLI");
     if ( rv == -1 ) {
         log_error ("agent-rt-cli:\tCannot connect to malamute on '%s'", endpoint);
         mlm_client_destroy (&client);
@@ -65,6 +97,13 @@ int main (int argc, char *argv [])
         {
             puts ("fty-asset-cli [options]");
             puts ("fty-asset-cli republish");
+            puts ("fty-asset-cli stats");
+            break;
+        }
+        else
+        if (streq (argv [argn], "stats"))
+        {
+            rv = s_stats (client);
             break;
         }
         else
@@ -81,5 +120,5 @@ int main (int argc, char *argv [])
 
     zclock_sleep (200);
     mlm_client_destroy (&client);
-    return 0;
+    return rv == -1 ? 1 : 0;
 }
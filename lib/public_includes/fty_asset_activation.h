@@ -0,0 +1,62 @@
+/*  =========================================================================
+    fty_asset_activation - Requests to the licensing activator
+
+    Copyright (C) 2016 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace fty::activation {
+
+static constexpr const char* COMMAND_IS_ASSET_ACTIVABLE   = "GET_IS_ASSET_ACTIVABLE";
+static constexpr const char* COMMAND_ACTIVATE_ASSET       = "ACTIVATE_ASSET";
+static constexpr const char* COMMAND_DEACTIVATE_ASSET     = "DEACTIVATE_ASSET";
+static constexpr const char* COMMAND_ARE_ASSETS_ACTIVABLE = "GET_ARE_ASSETS_ACTIVABLE";
+static constexpr const char* COMMAND_ACTIVATE_ASSETS      = "ACTIVATE_ASSETS";
+
+/// assets per batch exchange
+static constexpr size_t BATCH_SIZE = 100;
+
+/// One request/reply exchange: command frame followed by asset JSONs in, reply frames out.
+/// Batch commands are answered with one frame per asset, "true"/"false" or "OK"/error text, in request
+/// order. Every asset is judged as if the activable ones before it in the same exchange were already active.
+using Transport = std::function<std::vector<std::string>(const std::vector<std::string>& payload)>;
+
+/// replaces the exchange with the activator, an empty transport restores the default client
+void setTransport(Transport transport);
+
+/// single exchange through the current transport, throws on an ERROR reply
+std::vector<std::string> request(const std::vector<std::string>& payload);
+
+/// activability of every asset, assets that cannot be checked are reported as not activable
+std::vector<bool> areActivable(const std::vector<std::string>& assetsJson);
+
+/// activates every asset, returns an empty string for success or the error of that asset.
+/// A batch without a valid reply may have reached the activator, it is not sent again: each of its assets
+/// gets the error of the exchange.
+std::vector<std::string> activate(const std::vector<std::string>& assetsJson);
+
+/// exchanges made since the start of the process
+uint64_t exchanges();
+
+} // namespace fty::activation
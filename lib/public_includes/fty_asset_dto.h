@@ -326,6 +326,43 @@ public:
     void deserializeUI(const cxxtools::SerializationInfo& si);
 };
 
+/// Structural difference between two versions of the same asset.
+///
+/// Core fields keep their old and new value. Ext entries and links only keep the new state: the
+/// "set" lists hold added or changed entries (a link is changed when its attributes are), the
+/// "removed" lists what is gone. Parents list and ext "updated" flags are not compared.
+class AssetDiff
+{
+public:
+    AssetDiff() = default;
+    AssetDiff(const Asset& before, const Asset& after);
+
+    /// true if nothing changed, e.g. an update which wrote the same values
+    bool empty() const;
+
+    const std::string& internalName() const;
+
+    /// field name (as in Asset::serialize) -> (before, after)
+    const std::map<std::string, std::pair<std::string, std::string>>& core() const;
+    const Asset::ExtMap&                                              extSet() const;
+    const std::vector<std::string>&                                   extRemoved() const;
+    const std::vector<AssetLink>&                                     linksSet() const;
+    const std::vector<AssetLink>&                                     linksRemoved() const;
+
+    /// {"name", "changed", "previous", "ext", "ext_removed", "linked", "linked_removed"}, empty parts omitted
+    void serialize(cxxtools::SerializationInfo& si) const;
+
+private:
+    std::string                                                m_internalName;
+    std::map<std::string, std::pair<std::string, std::string>> m_core;
+    Asset::ExtMap                                              m_extSet;
+    std::vector<std::string>                                   m_extRemoved;
+    std::vector<AssetLink>                                     m_linksSet;
+    std::vector<AssetLink>                                     m_linksRemoved;
+};
+
+void operator<<=(cxxtools::SerializationInfo& si, const AssetDiff& diff);
+
 } // namespace fty
 
 //  Self test of this class
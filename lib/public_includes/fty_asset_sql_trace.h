@@ -0,0 +1,115 @@
+/*  =========================================================================
+    fty_asset_sql_trace - Statements run per request, with N+1 detection
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace fty::sqltrace {
+
+/// statement text with literals as ?, IN lists as (?) and whitespace collapsed
+std::string normalize(const std::string& sql);
+
+/// tracing of the process, on by default in debug builds or when FTY_ASSET_SQL_TRACE is set
+void setEnabled(bool enabled);
+bool enabled();
+
+/// a statement run more than limit times in one request is reported as a N+1 pattern (default 20)
+void     setRepeatLimit(uint64_t limit);
+uint64_t repeatLimit();
+
+struct Statement
+{
+    std::string sql; // normalized
+    uint64_t    calls = 0;
+    uint64_t    rows  = 0;
+    uint64_t    us    = 0;
+};
+
+/// Statements run on this thread while the scope lives, usually one request.
+///
+/// Scopes nest, a statement counts in every open scope of the thread. The outermost scope logs its statements at
+/// debug level when it ends, and a warning for every statement above the repeat limit. Without tracing a scope
+/// collects nothing and costs a thread-local read per statement.
+class Scope
+{
+public:
+    explicit Scope(const std::string& name);
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    bool active() const
+    {
+        return m_active;
+    }
+
+    /// all statements run so far
+    uint64_t queries() const;
+    /// runs of the statements containing fragment in their normalized text
+    uint64_t calls(const std::string& fragment) const;
+
+    /// most run first
+    std::vector<Statement> statements() const;
+    /// statements above the repeat limit
+    std::vector<Statement> repeated() const;
+
+    /// true while a scope of this thread collects
+    static bool tracing();
+
+private:
+    friend class Query;
+    void add(const std::string& sql, uint64_t rows, uint64_t us);
+
+    std::string                      m_name;
+    bool                             m_active = false;
+    Scope*                           m_parent = nullptr;
+    std::map<std::string, Statement> m_statements;
+};
+
+/// Times one statement, recorded when it goes out of scope. Does nothing when no scope collects or sql is empty.
+class Query
+{
+public:
+    explicit Query(const std::string& sql);
+    ~Query();
+
+    Query(const Query&) = delete;
+    Query& operator=(const Query&) = delete;
+
+    void rows(uint64_t rows)
+    {
+        m_rows = rows;
+    }
+
+private:
+    bool                                  m_tracing;
+    std::string                           m_sql;
+    uint64_t                              m_rows = 0;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+} // namespace fty::sqltrace
@@ -0,0 +1,116 @@
+/*  =========================================================================
+    fty_asset_stats - Latency histograms and counters of the agent
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace fty::stats {
+
+/// Latency histogram with HDR style log-linear buckets.
+///
+/// Values below 2^SubBits have a bucket each, every higher power of two is split in 2^SubBits buckets, so a
+/// percentile is at most 1/2^SubBits above the recorded value. record() is lock-free and may run on any thread;
+/// a summary taken while others record is not a point-in-time copy but never loses a recorded value.
+class Histogram
+{
+public:
+    static constexpr unsigned SubBits     = 5;
+    static constexpr uint64_t SubCount    = uint64_t(1) << SubBits;
+    static constexpr size_t   BucketCount = (64 - SubBits + 1) * SubCount;
+
+    struct Summary
+    {
+        uint64_t count = 0;
+        uint64_t sum   = 0;
+        uint64_t max   = 0;
+        uint64_t p50   = 0;
+        uint64_t p90   = 0;
+        uint64_t p99   = 0;
+    };
+
+    void record(uint64_t value);
+
+    uint64_t count() const
+    {
+        return m_count.load(std::memory_order_relaxed);
+    }
+
+    /// highest value of the bucket holding the q-quantile (0 < q <= 1), clamped to the maximum
+    uint64_t percentile(double q) const;
+
+    Summary summary() const;
+
+    static size_t   bucketOf(uint64_t value);
+    static uint64_t highestOf(size_t bucket);
+
+private:
+    std::array<std::atomic<uint64_t>, BucketCount> m_buckets{};
+    std::atomic<uint64_t>                          m_count{0};
+    std::atomic<uint64_t>                          m_sum{0};
+    std::atomic<uint64_t>                          m_max{0};
+};
+
+/// Statistics of one mailbox subject or storage call, latencies in microseconds
+struct Metric
+{
+    Histogram             latency;
+    Histogram             queueWait; // only filled where the waiting time of a request is known
+    std::atomic<uint64_t> bytesIn{0};
+    std::atomic<uint64_t> bytesOut{0};
+};
+
+/// metric of that name, created on first use; the reference stays valid for the life of the process
+Metric& metric(const std::string& name);
+
+/// every metric with count, p50/p90/p99/max/mean latency and byte counters, as a JSON object
+std::string toJson();
+
+/// Records the time from construction to destruction.
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(Histogram& histogram)
+        : m_histogram(histogram)
+        , m_start(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~ScopedTimer()
+    {
+        m_histogram.record(uint64_t(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_start)
+                .count()));
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Histogram&                            m_histogram;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+} // namespace fty::stats
@@ -0,0 +1,230 @@
+/*  =========================================================================
+    fty_asset_activation - Requests to the licensing activator
+
+    Copyright (C) 2016 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    fty_asset_activation - Requests to the licensing activator
+@discuss
+@end
+*/
+
+#include "fty_asset_activation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <fty_common_agents.h>
+#include <fty_common_mlm.h>
+#include <fty_log.h>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+#define AGENT_ASSET_ACTIVATOR "etn-licensing-credits"
+
+namespace fty::activation {
+
+enum class Support
+{
+    Unknown,
+    Batch,
+    Single
+};
+
+static std::mutex            s_lock;
+static Transport             s_transport;
+static std::atomic<uint64_t> s_exchanges{0};
+// batch support of the activator, latched by the first batch check and reset with the transport
+static std::atomic<Support> s_support{Support::Unknown};
+
+static std::vector<std::string> s_mlmExchange(const std::vector<std::string>& payload)
+{
+    // one client for the whole process, requests are serialized
+    static mlm::MlmSyncClient client(AGENT_FTY_ASSET, AGENT_ASSET_ACTIVATOR);
+    static std::mutex         clientLock;
+
+    std::lock_guard<std::mutex> lock(clientLock);
+    log_debug("Sending %s request to %s", payload[0].c_str(), AGENT_ASSET_ACTIVATOR);
+    return client.syncRequestWithReply(payload);
+}
+
+void setTransport(Transport transport)
+{
+    std::lock_guard<std::mutex> lock(s_lock);
+    s_transport = std::move(transport);
+    s_support   = Support::Unknown;
+}
+
+std::vector<std::string> request(const std::vector<std::string>& payload)
+{
+    Transport transport;
+    {
+        std::lock_guard<std::mutex> lock(s_lock);
+        transport = s_transport ? s_transport : s_mlmExchange;
+    }
+
+    ++s_exchanges;
+    std::vector<std::string> receivedFrames = transport(payload);
+
+    // check if the first frame we get is an error
+    if (receivedFrames.empty()) {
+        throw std::runtime_error("Empty reply");
+    }
+    if (receivedFrames[0] == "ERROR") {
+        if (receivedFrames.size() == 2) {
+            throw std::runtime_error(receivedFrames.at(1));
+        }
+        throw std::runtime_error("Missing data for error");
+    }
+    return receivedFrames;
+}
+
+// error of an activator without the batch commands, it did not act on the request
+static bool s_unsupported(const std::string& error)
+{
+    std::string lower(error);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) {
+        return char(std::tolower(c));
+    });
+    return lower.find("unknown command") != std::string::npos || lower.find("unsupported") != std::string::npos;
+}
+
+// frames of one batch exchange, throws unless there is one frame per asset
+static std::vector<std::string> s_batch(const char* command, std::vector<std::string>::const_iterator begin,
+    std::vector<std::string>::const_iterator end)
+{
+    std::vector<std::string> payload = {command};
+    payload.insert(payload.end(), begin, end);
+
+    auto frames = request(payload);
+    if (frames.size() != size_t(end - begin)) {
+        throw std::runtime_error(std::string(command) + " answered with " + std::to_string(frames.size()) +
+                                 " frames for " + std::to_string(end - begin) + " assets");
+    }
+    return frames;
+}
+
+// batch activability check, empty if this batch has to be checked with single requests.
+// The check does not change anything on the activator, so the first one is the probe: whatever it
+// gets, batch commands are used or not for the rest of the process.
+static std::vector<std::string> s_check(
+    std::vector<std::string>::const_iterator begin, std::vector<std::string>::const_iterator end)
+{
+    if (s_support == Support::Single) {
+        return {};
+    }
+
+    try {
+        auto frames = s_batch(COMMAND_ARE_ASSETS_ACTIVABLE, begin, end);
+        s_support   = Support::Batch;
+        return frames;
+    } catch (const std::exception& e) {
+        if (s_support == Support::Unknown) {
+            log_info("%s failed (%s), single requests from now on", COMMAND_ARE_ASSETS_ACTIVABLE, e.what());
+            s_support = Support::Single;
+        } else {
+            log_info("%s failed (%s), single requests for this batch", COMMAND_ARE_ASSETS_ACTIVABLE, e.what());
+        }
+    }
+    return {};
+}
+
+std::vector<bool> areActivable(const std::vector<std::string>& assetsJson)
+{
+    std::vector<bool> result;
+    result.reserve(assetsJson.size());
+
+    for (size_t i = 0; i < assetsJson.size(); i += BATCH_SIZE) {
+        auto begin  = assetsJson.begin() + long(i);
+        auto end    = assetsJson.begin() + long(std::min(assetsJson.size(), i + BATCH_SIZE));
+        auto frames = s_check(begin, end);
+
+        if (!frames.empty()) {
+            for (const auto& frame : frames) {
+                result.push_back(frame == "true");
+            }
+            continue;
+        }
+
+        // single checks do not see each other, the caller activates in between
+        for (auto it = begin; it != end; ++it) {
+            try {
+                result.push_back(request({COMMAND_IS_ASSET_ACTIVABLE, *it}).at(0) == "true");
+            } catch (const std::exception& e) {
+                log_info("Request failed: %s", e.what());
+                result.push_back(false);
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<std::string> activate(const std::vector<std::string>& assetsJson)
+{
+    std::vector<std::string> result;
+    result.reserve(assetsJson.size());
+
+    for (size_t i = 0; i < assetsJson.size(); i += BATCH_SIZE) {
+        auto begin = assetsJson.begin() + long(i);
+        auto end   = assetsJson.begin() + long(std::min(assetsJson.size(), i + BATCH_SIZE));
+
+        if (s_support == Support::Unknown) {
+            // probe with the check of one asset, never with an activation
+            s_check(begin, begin + 1);
+        }
+
+        if (s_support == Support::Batch) {
+            try {
+                for (const auto& frame : s_batch(COMMAND_ACTIVATE_ASSETS, begin, end)) {
+                    result.push_back(frame == "OK" ? "" : frame);
+                }
+                continue;
+            } catch (const std::exception& e) {
+                if (!s_unsupported(e.what())) {
+                    // the batch may have reached the activator, sending it again could activate twice
+                    log_error("%s failed: %s", COMMAND_ACTIVATE_ASSETS, e.what());
+                    std::string error = std::string(COMMAND_ACTIVATE_ASSETS) + " failed: " + e.what();
+                    result.insert(result.end(), size_t(end - begin), error);
+                    continue;
+                }
+                log_info("%s is not supported (%s), single requests from now on", COMMAND_ACTIVATE_ASSETS, e.what());
+                s_support = Support::Single;
+            }
+        }
+
+        for (auto it = begin; it != end; ++it) {
+            try {
+                request({COMMAND_ACTIVATE_ASSET, *it});
+                result.push_back("");
+            } catch (const std::exception& e) {
+                result.push_back(e.what());
+            }
+        }
+    }
+    return result;
+}
+
+uint64_t exchanges()
+{
+    return s_exchanges;
+}
+
+} // namespace fty::activation
@@ -929,6 +929,160 @@ void UIAsset::deserializeUI(const cxxtools::SerializationInfo& /*si*/)
 {
 }
 
+static constexpr const char* SI_ASSET_TAG      = "asset_tag";
+static constexpr const char* SI_CHANGED        = "changed";
+static constexpr const char* SI_PREVIOUS       = "previous";
+static constexpr const char* SI_EXT_REMOVED    = "ext_removed";
+static constexpr const char* SI_LINKED_REMOVED = "linked_removed";
+
+AssetDiff::AssetDiff(const Asset& before, const Asset& after)
+    : m_internalName(after.getInternalName())
+{
+    auto field = [this](const char* name, const std::string& b, const std::string& a) {
+        if (b != a) {
+            m_core.emplace(name, std::make_pair(b, a));
+        }
+    };
+
+    field(SI_STATUS, std::to_string(int(before.getAssetStatus())), std::to_string(int(after.getAssetStatus())));
+    field(SI_TYPE, before.getAssetType(), after.getAssetType());
+    field(SI_SUB_TYPE, before.getAssetSubtype(), after.getAssetSubtype());
+    field(SI_PRIORITY, std::to_string(before.getPriority()), std::to_string(after.getPriority()));
+    field(SI_PARENT, before.getParentIname(), after.getParentIname());
+    field(SI_ASSET_TAG, before.getAssetTag(), after.getAssetTag());
+    field(SI_SECONDARY_ID, before.getSecondaryID(), after.getSecondaryID());
+
+    // both maps are sorted, one merge walk
+    const Asset::ExtMap& b = before.getExt();
+    const Asset::ExtMap& a = after.getExt();
+
+    auto bi = b.begin();
+    auto ai = a.begin();
+    while (bi != b.end() || ai != a.end()) {
+        if (ai == a.end() || (bi != b.end() && bi->first < ai->first)) {
+            m_extRemoved.push_back(bi->first);
+            ++bi;
+        } else if (bi == b.end() || ai->first < bi->first) {
+            m_extSet.emplace(*ai);
+            ++ai;
+        } else {
+            if (bi->second != ai->second) {
+                m_extSet.emplace(*ai);
+            }
+            ++bi;
+            ++ai;
+        }
+    }
+
+    // few links per asset, quadratic is fine
+    const auto& bLinks = before.getLinkedAssets();
+    const auto& aLinks = after.getLinkedAssets();
+
+    for (const auto& l : aLinks) {
+        auto found = std::find(bLinks.begin(), bLinks.end(), l);
+        if (found == bLinks.end() || found->ext() != l.ext()) {
+            m_linksSet.push_back(l);
+        }
+    }
+    for (const auto& l : bLinks) {
+        if (std::find(aLinks.begin(), aLinks.end(), l) == aLinks.end()) {
+            m_linksRemoved.push_back(l);
+        }
+    }
+}
+
+bool AssetDiff::empty() const
+{
+    return m_core.empty() && m_extSet.empty() && m_extRemoved.empty() && m_linksSet.empty() &&
+           m_linksRemoved.empty();
+}
+
+const std::string& AssetDiff::internalName() const
+{
+    return m_internalName;
+}
+
+const std::map<std::string, std::pair<std::string, std::string>>& AssetDiff::core() const
+{
+    return m_core;
+}
+
+const Asset::ExtMap& AssetDiff::extSet() const
+{
+    return m_extSet;
+}
+
+const std::vector<std::string>& AssetDiff::extRemoved() const
+{
+    return m_extRemoved;
+}
+
+const std::vector<AssetLink>& AssetDiff::linksSet() const
+{
+    return m_linksSet;
+}
+
+const std::vector<AssetLink>& AssetDiff::linksRemoved() const
+{
+    return m_linksRemoved;
+}
+
+static void s_add_links(cxxtools::SerializationInfo& si, const char* name, const std::vector<AssetLink>& links)
+{
+    cxxtools::SerializationInfo& linked = si.addMember(name);
+    for (const auto& l : links) {
+        cxxtools::SerializationInfo& link = linked.addMember("");
+        link <<= l;
+        link.setCategory(cxxtools::SerializationInfo::Category::Object);
+    }
+    linked.setCategory(cxxtools::SerializationInfo::Category::Array);
+}
+
+void AssetDiff::serialize(cxxtools::SerializationInfo& si) const
+{
+    si.addMember(SI_NAME) <<= m_internalName;
+
+    if (!m_core.empty()) {
+        cxxtools::SerializationInfo& changed  = si.addMember(SI_CHANGED);
+        cxxtools::SerializationInfo& previous = si.addMember(SI_PREVIOUS);
+        for (const auto& c : m_core) {
+            // same types as the full notification
+            if (c.first == SI_STATUS || c.first == SI_PRIORITY) {
+                previous.addMember(c.first) <<= std::stoi(c.second.first);
+                changed.addMember(c.first) <<= std::stoi(c.second.second);
+            } else {
+                previous.addMember(c.first) <<= c.second.first;
+                changed.addMember(c.first) <<= c.second.second;
+            }
+        }
+        changed.setCategory(cxxtools::SerializationInfo::Category::Object);
+        previous.setCategory(cxxtools::SerializationInfo::Category::Object);
+    }
+
+    if (!m_extSet.empty()) {
+        cxxtools::SerializationInfo& ext = si.addMember(SI_EXT);
+        for (const auto& e : m_extSet) {
+            ext.addMember(e.first) <<= e.second;
+        }
+        ext.setCategory(cxxtools::SerializationInfo::Category::Object);
+    }
+    if (!m_extRemoved.empty()) {
+        si.addMember(SI_EXT_REMOVED) <<= m_extRemoved;
+    }
+
+    if (!m_linksSet.empty()) {
+        s_add_links(si, SI_LINKED, m_linksSet);
+    }
+    if (!m_linksRemoved.empty()) {
+        s_add_links(si, SI_LINKED_REMOVED, m_linksRemoved);
+    }
+}
+
+void operator<<=(cxxtools::SerializationInfo& si, const AssetDiff& diff)
+{
+    diff.serialize(si);
+}
+
 
 } // namespace fty
 
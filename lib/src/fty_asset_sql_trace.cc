@@ -0,0 +1,280 @@
+/*  =========================================================================
+    fty_asset_sql_trace - Statements run per request, with N+1 detection
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    fty_asset_sql_trace - Statements run per request, with N+1 detection
+@discuss
+@end
+*/
+
+#include "fty_asset_sql_trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <fty_log.h>
+
+namespace fty::sqltrace {
+
+#ifdef NDEBUG
+static std::atomic<bool> s_enabled{getenv("FTY_ASSET_SQL_TRACE") != nullptr};
+#else
+static std::atomic<bool> s_enabled{true};
+#endif
+static std::atomic<uint64_t> s_repeatLimit{20};
+
+// innermost open scope of the thread
+static thread_local Scope* s_current = nullptr;
+
+static bool s_word(char c)
+{
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.';
+}
+
+std::string normalize(const std::string& sql)
+{
+    std::string ret;
+    ret.reserve(sql.size());
+
+    for (size_t i = 0; i < sql.size();) {
+        char c = sql[i];
+
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            while (i < sql.size() && std::isspace(static_cast<unsigned char>(sql[i]))) {
+                ++i;
+            }
+            if (!ret.empty() && ret.back() != '(') {
+                ret += ' ';
+            }
+            continue;
+        }
+
+        if (c == '\'' || c == '"') {
+            // string literal, quotes doubled or escaped with a backslash
+            for (++i; i < sql.size(); ++i) {
+                if (sql[i] == '\\') {
+                    ++i;
+                } else if (sql[i] == c) {
+                    if (i + 1 < sql.size() && sql[i + 1] == c) {
+                        ++i;
+                    } else {
+                        break;
+                    }
+                }
+            }
+            ++i;
+            ret += '?';
+            continue;
+        }
+
+        if (c == ':' && i + 1 < sql.size() && s_word(sql[i + 1])) {
+            // host variable
+            for (++i; i < sql.size() && s_word(sql[i]); ++i) {
+            }
+            ret += '?';
+            continue;
+        }
+
+        if (std::isdigit(static_cast<unsigned char>(c)) && (ret.empty() || !s_word(ret.back()))) {
+            for (; i < sql.size() && s_word(sql[i]); ++i) {
+            }
+            ret += '?';
+            continue;
+        }
+
+        if (c == ')' && !ret.empty() && ret.back() == ' ') {
+            ret.pop_back();
+        }
+        ret += c;
+        ++i;
+    }
+
+    while (!ret.empty() && ret.back() == ' ') {
+        ret.pop_back();
+    }
+
+    // lists of values and batches of rows only differ in their length
+    for (const char* list : {"(?, ?", "(?,?"}) {
+        for (size_t pos = ret.find(list); pos != std::string::npos; pos = ret.find(list, pos + 1)) {
+            size_t end = ret.find(')', pos);
+            if (end == std::string::npos) {
+                break;
+            }
+            if (ret.find_first_not_of("?, ", pos + 1) == end) {
+                ret.replace(pos, end - pos + 1, "(?)");
+            }
+        }
+    }
+    for (size_t pos = ret.find("(?), (?)"); pos != std::string::npos; pos = ret.find("(?), (?)", pos)) {
+        ret.erase(pos + 3, 5);
+    }
+    for (size_t pos = ret.find("(?),(?)"); pos != std::string::npos; pos = ret.find("(?),(?)", pos)) {
+        ret.erase(pos + 3, 4);
+    }
+    return ret;
+}
+
+void setEnabled(bool enabled)
+{
+    s_enabled = enabled;
+}
+
+bool enabled()
+{
+    return s_enabled;
+}
+
+void setRepeatLimit(uint64_t limit)
+{
+    s_repeatLimit = limit;
+}
+
+uint64_t repeatLimit()
+{
+    return s_repeatLimit;
+}
+
+// =====================================================================================================================
+
+Scope::Scope(const std::string& name)
+{
+    if (!s_enabled) {
+        return;
+    }
+    m_name    = name;
+    m_active  = true;
+    m_parent  = s_current;
+    s_current = this;
+}
+
+Scope::~Scope()
+{
+    if (!m_active) {
+        return;
+    }
+    s_current = m_parent;
+    if (m_parent) {
+        return;
+    }
+
+    uint64_t queries = 0;
+    uint64_t us      = 0;
+    for (const auto& statement : statements()) {
+        queries += statement.calls;
+        us += statement.us;
+        log_debug("%s: %llu x %s, %llu rows, %llu us", m_name.c_str(),
+            static_cast<unsigned long long>(statement.calls), statement.sql.c_str(),
+            static_cast<unsigned long long>(statement.rows), static_cast<unsigned long long>(statement.us));
+    }
+    if (queries) {
+        log_debug("%s: %llu statements in %llu us", m_name.c_str(), static_cast<unsigned long long>(queries),
+            static_cast<unsigned long long>(us));
+    }
+    for (const auto& statement : repeated()) {
+        log_warning("%s: possible N+1 pattern, %llu x %s", m_name.c_str(),
+            static_cast<unsigned long long>(statement.calls), statement.sql.c_str());
+    }
+}
+
+bool Scope::tracing()
+{
+    return s_current != nullptr;
+}
+
+void Scope::add(const std::string& sql, uint64_t rows, uint64_t us)
+{
+    Statement& statement = m_statements[sql];
+    if (statement.sql.empty()) {
+        statement.sql = sql;
+    }
+    statement.calls++;
+    statement.rows += rows;
+    statement.us += us;
+}
+
+uint64_t Scope::queries() const
+{
+    uint64_t ret = 0;
+    for (const auto& statement : m_statements) {
+        ret += statement.second.calls;
+    }
+    return ret;
+}
+
+uint64_t Scope::calls(const std::string& fragment) const
+{
+    uint64_t ret = 0;
+    for (const auto& statement : m_statements) {
+        if (statement.first.find(fragment) != std::string::npos) {
+            ret += statement.second.calls;
+        }
+    }
+    return ret;
+}
+
+std::vector<Statement> Scope::statements() const
+{
+    std::vector<Statement> ret;
+    for (const auto& statement : m_statements) {
+        ret.push_back(statement.second);
+    }
+    std::stable_sort(ret.begin(), ret.end(), [](const Statement& l, const Statement& r) {
+        return l.calls > r.calls;
+    });
+    return ret;
+}
+
+std::vector<Statement> Scope::repeated() const
+{
+    std::vector<Statement> ret = statements();
+    uint64_t               limit = s_repeatLimit;
+    ret.erase(std::remove_if(ret.begin(), ret.end(), [limit](const Statement& statement) {
+        return statement.calls <= limit;
+    }), ret.end());
+    return ret;
+}
+
+// =====================================================================================================================
+
+Query::Query(const std::string& sql)
+    : m_tracing(s_current != nullptr && !sql.empty())
+{
+    if (m_tracing) {
+        m_sql   = normalize(sql);
+        m_start = std::chrono::steady_clock::now();
+    }
+}
+
+Query::~Query()
+{
+    if (!m_tracing) {
+        return;
+    }
+    uint64_t us = uint64_t(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_start).count());
+    for (Scope* scope = s_current; scope; scope = scope->m_parent) {
+        scope->add(m_sql, m_rows, us);
+    }
+}
+
+} // namespace fty::sqltrace
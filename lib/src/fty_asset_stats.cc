@@ -0,0 +1,159 @@
+/*  =========================================================================
+    fty_asset_stats - Latency histograms and counters of the agent
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    fty_asset_stats - Latency histograms and counters of the agent
+@discuss
+@end
+*/
+
+#include "fty_asset_stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cxxtools/jsonserializer.h>
+#include <cxxtools/serializationinfo.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+namespace fty::stats {
+
+size_t Histogram::bucketOf(uint64_t value)
+{
+    if (value < SubCount) {
+        return size_t(value);
+    }
+    // value >> shift is in [SubCount, 2 * SubCount)
+    unsigned shift = unsigned(63 - __builtin_clzll(value)) - SubBits;
+    return size_t((shift + 1) * SubCount + ((value >> shift) - SubCount));
+}
+
+uint64_t Histogram::highestOf(size_t bucket)
+{
+    if (bucket < SubCount) {
+        return bucket;
+    }
+    unsigned shift = unsigned(bucket / SubCount) - 1;
+    uint64_t lowest = (SubCount + bucket % SubCount) << shift;
+    return lowest + ((uint64_t(1) << shift) - 1);
+}
+
+void Histogram::record(uint64_t value)
+{
+    m_buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+
+    uint64_t max = m_max.load(std::memory_order_relaxed);
+    while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+}
+
+uint64_t Histogram::percentile(double q) const
+{
+    // the count of the buckets themselves, m_count may already include a value whose bucket is not visible yet
+    uint64_t total = 0;
+    for (const auto& bucket : m_buckets) {
+        total += bucket.load(std::memory_order_relaxed);
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    uint64_t rank = std::max<uint64_t>(1, uint64_t(std::ceil(q * double(total))));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BucketCount; ++i) {
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return std::min(highestOf(i), m_max.load(std::memory_order_relaxed));
+        }
+    }
+    return m_max.load(std::memory_order_relaxed);
+}
+
+Histogram::Summary Histogram::summary() const
+{
+    Summary ret;
+    ret.count = m_count.load(std::memory_order_relaxed);
+    ret.sum   = m_sum.load(std::memory_order_relaxed);
+    ret.max   = m_max.load(std::memory_order_relaxed);
+    ret.p50   = percentile(0.50);
+    ret.p90   = percentile(0.90);
+    ret.p99   = percentile(0.99);
+    return ret;
+}
+
+// =====================================================================================================================
+
+static std::mutex                                     s_lock;
+static std::map<std::string, std::unique_ptr<Metric>> s_metrics;
+
+Metric& metric(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(s_lock);
+
+    auto& entry = s_metrics[name];
+    if (!entry) {
+        entry = std::make_unique<Metric>();
+    }
+    return *entry;
+}
+
+static void s_serialize(cxxtools::SerializationInfo& si, const Histogram::Summary& summary)
+{
+    si.addMember("count") <<= summary.count;
+    si.addMember("p50") <<= summary.p50;
+    si.addMember("p90") <<= summary.p90;
+    si.addMember("p99") <<= summary.p99;
+    si.addMember("max") <<= summary.max;
+    si.addMember("mean") <<= (summary.count ? summary.sum / summary.count : uint64_t(0));
+}
+
+std::string toJson()
+{
+    cxxtools::SerializationInfo si;
+    si.setCategory(cxxtools::SerializationInfo::Object);
+
+    {
+        std::lock_guard<std::mutex> lock(s_lock);
+        for (const auto& entry : s_metrics) {
+            const Metric& stats = *entry.second;
+
+            cxxtools::SerializationInfo& member = si.addMember(entry.first);
+            s_serialize(member.addMember("latency_us"), stats.latency.summary());
+            if (stats.queueWait.count()) {
+                s_serialize(member.addMember("queue_wait_us"), stats.queueWait.summary());
+            }
+            member.addMember("bytes_in") <<= stats.bytesIn.load(std::memory_order_relaxed);
+            member.addMember("bytes_out") <<= stats.bytesOut.load(std::memory_order_relaxed);
+        }
+    }
+
+    std::ostringstream       output;
+    cxxtools::JsonSerializer serializer(output);
+    serializer.serialize(si);
+    return output.str();
+}
+
+} // namespace fty::stats
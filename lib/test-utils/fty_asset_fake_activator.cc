@@ -0,0 +1,88 @@
+/*  =========================================================================
+    fty_asset_fake_activator - In-process licensing activator for benchmarks and tests
+
+    Copyright (C) 2016 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    fty_asset_fake_activator - In-process licensing activator for benchmarks and tests
+@discuss
+@end
+*/
+
+#include "fty_asset_fake_activator.h"
+
+#include <algorithm>
+
+namespace fty::activation {
+
+FakeActivator::FakeActivator(size_t maxActive)
+    : m_maxActive(maxActive)
+{
+}
+
+Transport FakeActivator::transport()
+{
+    return [this](const std::vector<std::string>& payload) {
+        return reply(payload);
+    };
+}
+
+std::vector<std::string> FakeActivator::reply(const std::vector<std::string>& payload)
+{
+    const std::string& command = payload.at(0);
+    size_t             count   = payload.size() - 1;
+
+    if (command == COMMAND_IS_ASSET_ACTIVABLE) {
+        return {m_active < m_maxActive ? "true" : "false"};
+    }
+    if (command == COMMAND_ACTIVATE_ASSET || command == COMMAND_DEACTIVATE_ASSET) {
+        if (command == COMMAND_DEACTIVATE_ASSET) {
+            m_active -= std::min<size_t>(m_active, 1);
+            return {"OK"};
+        }
+        if (m_active >= m_maxActive) {
+            return {"ERROR", "Licensing limitation hit"};
+        }
+        ++m_active;
+        return {"OK"};
+    }
+
+    std::vector<std::string> frames;
+    if (command == COMMAND_ARE_ASSETS_ACTIVABLE) {
+        for (size_t i = 0; i < count; ++i) {
+            frames.push_back(m_active + i < m_maxActive ? "true" : "false");
+        }
+        return frames;
+    }
+    if (command == COMMAND_ACTIVATE_ASSETS) {
+        for (size_t i = 0; i < count; ++i) {
+            if (m_active < m_maxActive) {
+                ++m_active;
+                frames.push_back("OK");
+            } else {
+                frames.push_back("Licensing limitation hit");
+            }
+        }
+        return frames;
+    }
+    return {"ERROR", "Unknown command " + command};
+}
+
+} // namespace fty::activation
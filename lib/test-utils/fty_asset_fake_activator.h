@@ -0,0 +1,48 @@
+/*  =========================================================================
+    fty_asset_fake_activator - In-process licensing activator for benchmarks and tests
+
+    Copyright (C) 2016 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include "fty_asset_activation.h"
+
+namespace fty::activation {
+
+/// In-process stand-in for the activator, allows at most maxActive activations.
+class FakeActivator
+{
+public:
+    explicit FakeActivator(size_t maxActive);
+
+    Transport transport();
+
+    size_t active() const
+    {
+        return m_active;
+    }
+
+private:
+    std::vector<std::string> reply(const std::vector<std::string>& payload);
+
+    size_t m_maxActive;
+    size_t m_active = 0;
+};
+
+} // namespace fty::activation
@@ -0,0 +1,257 @@
+/*  =========================================================================
+    fty_asset_local_bus - In-process message bus for benchmarks and tests
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    fty_asset_local_bus - In-process message bus for benchmarks and tests
+@discuss
+@end
+*/
+
+#include "fty_asset_local_bus.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace fty {
+
+static std::string s_meta(const messagebus::Message& message, const std::string& key)
+{
+    auto it = message.metaData().find(key);
+    return it != message.metaData().end() ? it->second : std::string();
+}
+
+messagebus::MessageBus* LocalBroker::client(const std::string& clientName)
+{
+    return new LocalMessageBus(*this, clientName);
+}
+
+LocalBroker::Factory LocalBroker::factory()
+{
+    return [this](const std::string& /*endpoint*/, const std::string& clientName) {
+        return client(clientName);
+    };
+}
+
+void LocalBroker::receive(const void* owner, const std::string& queue, messagebus::MessageListener listener)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_queues[queue] = Listener{owner, std::move(listener)};
+}
+
+void LocalBroker::subscribe(const void* owner, const std::string& topic, messagebus::MessageListener listener)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_topics[topic].push_back(Listener{owner, std::move(listener)});
+}
+
+void LocalBroker::unsubscribe(const void* owner, const std::string& topic)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    auto it = m_topics.find(topic);
+    if (it == m_topics.end()) {
+        return;
+    }
+    auto& listeners = it->second;
+    listeners.erase(std::remove_if(listeners.begin(), listeners.end(), [owner](const Listener& listener) {
+        return listener.owner == owner;
+    }), listeners.end());
+}
+
+void LocalBroker::forget(const void* owner)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    for (auto it = m_queues.begin(); it != m_queues.end();) {
+        it = it->second.owner == owner ? m_queues.erase(it) : std::next(it);
+    }
+    for (auto& topic : m_topics) {
+        auto& listeners = topic.second;
+        listeners.erase(std::remove_if(listeners.begin(), listeners.end(), [owner](const Listener& listener) {
+            return listener.owner == owner;
+        }), listeners.end());
+    }
+}
+
+void LocalBroker::publish(const std::string& topic, const messagebus::Message& message)
+{
+    // listeners run without the lock, they may publish or reply themselves
+    std::vector<messagebus::MessageListener> listeners;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        auto it = m_topics.find(topic);
+        if (it != m_topics.end()) {
+            for (const auto& listener : it->second) {
+                listeners.push_back(listener.callback);
+            }
+        }
+    }
+
+    if (listeners.empty()) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    for (const auto& listener : listeners) {
+        listener(message);
+    }
+    m_delivered.fetch_add(listeners.size(), std::memory_order_relaxed);
+}
+
+void LocalBroker::send(const std::string& queue, const messagebus::Message& message)
+{
+    messagebus::MessageListener listener;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        auto it = m_queues.find(queue);
+        if (it != m_queues.end()) {
+            listener = it->second.callback;
+        }
+    }
+
+    if (!listener) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    listener(message);
+    m_delivered.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LocalBroker::reply(const std::string& queue, const messagebus::Message& message)
+{
+    std::string correlationId = s_meta(message, messagebus::Message::CORRELATION_ID);
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        // a pending request() takes its reply before any listener of the queue
+        auto it = m_pending.find(correlationId);
+        if (it != m_pending.end() && !it->second->done) {
+            it->second->reply = message;
+            it->second->done  = true;
+            m_replied.notify_all();
+            m_delivered.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    send(queue, message);
+}
+
+messagebus::Message LocalBroker::request(
+    const std::string& queue, const messagebus::Message& message, int timeoutSec)
+{
+    std::string correlationId = s_meta(message, messagebus::Message::CORRELATION_ID);
+    if (correlationId.empty()) {
+        throw messagebus::MessageBusException("Request without correlation id");
+    }
+
+    Pending pending;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_pending[correlationId] = &pending;
+    }
+
+    try {
+        send(queue, message);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_pending.erase(correlationId);
+        throw;
+    }
+
+    std::unique_lock<std::mutex> lock(m_lock);
+    m_replied.wait_for(lock, std::chrono::seconds(timeoutSec), [&pending]() {
+        return pending.done;
+    });
+    m_pending.erase(correlationId);
+
+    if (!pending.done) {
+        throw messagebus::MessageBusException("Request timed out");
+    }
+    return std::move(pending.reply);
+}
+
+// =====================================================================================================================
+
+LocalMessageBus::LocalMessageBus(LocalBroker& broker, const std::string& clientName)
+    : m_broker(broker)
+    , m_name(clientName)
+{
+}
+
+LocalMessageBus::~LocalMessageBus()
+{
+    m_broker.forget(this);
+}
+
+void LocalMessageBus::connect()
+{
+}
+
+void LocalMessageBus::publish(const std::string& topic, const messagebus::Message& message)
+{
+    m_broker.publish(topic, message);
+}
+
+void LocalMessageBus::subscribe(const std::string& topic, messagebus::MessageListener messageListener)
+{
+    m_broker.subscribe(this, topic, std::move(messageListener));
+}
+
+void LocalMessageBus::unsubscribe(const std::string& topic, messagebus::MessageListener /*messageListener*/)
+{
+    m_broker.unsubscribe(this, topic);
+}
+
+void LocalMessageBus::sendRequest(const std::string& requestQueue, const messagebus::Message& message)
+{
+    m_broker.send(requestQueue, message);
+}
+
+void LocalMessageBus::sendRequest(const std::string& requestQueue, const messagebus::Message& message,
+    messagebus::MessageListener messageListener)
+{
+    std::string replyTo = s_meta(message, messagebus::Message::REPLY_TO);
+    if (replyTo.empty()) {
+        throw messagebus::MessageBusException("Request without reply queue");
+    }
+    m_broker.receive(this, replyTo, std::move(messageListener));
+    m_broker.send(requestQueue, message);
+}
+
+void LocalMessageBus::sendReply(const std::string& replyQueue, const messagebus::Message& message)
+{
+    m_broker.reply(replyQueue, message);
+}
+
+void LocalMessageBus::receive(const std::string& queue, messagebus::MessageListener messageListener)
+{
+    m_broker.receive(this, queue, std::move(messageListener));
+}
+
+messagebus::Message LocalMessageBus::request(
+    const std::string& requestQueue, const messagebus::Message& message, int receiveTimeOut)
+{
+    return m_broker.request(requestQueue, message, receiveTimeOut);
+}
+
+} // namespace fty
@@ -0,0 +1,134 @@
+/*  =========================================================================
+    fty_asset_local_bus - In-process message bus for benchmarks and tests
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fty_common_messagebus.h>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace fty {
+
+/// In-process stand-in of the malamute broker for messagebus clients.
+///
+/// Delivery is synchronous and deterministic: publish, sendRequest and sendReply run the listeners on the calling
+/// thread before returning, subscribers of a topic in subscription order. Nothing is serialized or framed, a listener
+/// gets the one copy of the message its by-value signature asks for. A message for a queue nobody receives on, or a
+/// topic nobody subscribes to, is dropped and counted. The broker must outlive its clients.
+class LocalBroker
+{
+public:
+    /// same signature as messagebus::MlmMessageBus, the endpoint is ignored
+    using Factory = std::function<messagebus::MessageBus*(const std::string& endpoint, const std::string& clientName)>;
+
+    LocalBroker() = default;
+    LocalBroker(const LocalBroker&) = delete;
+    LocalBroker& operator=(const LocalBroker&) = delete;
+
+    /// new client, owned by the caller
+    messagebus::MessageBus* client(const std::string& clientName);
+    Factory                 factory();
+
+    uint64_t delivered() const
+    {
+        return m_delivered.load(std::memory_order_relaxed);
+    }
+
+    uint64_t dropped() const
+    {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    friend class LocalMessageBus;
+
+    struct Listener
+    {
+        const void*                 owner;
+        messagebus::MessageListener callback;
+    };
+
+    struct Pending
+    {
+        bool                done = false;
+        messagebus::Message reply;
+    };
+
+    void receive(const void* owner, const std::string& queue, messagebus::MessageListener listener);
+    void subscribe(const void* owner, const std::string& topic, messagebus::MessageListener listener);
+    void unsubscribe(const void* owner, const std::string& topic);
+    void forget(const void* owner);
+
+    void publish(const std::string& topic, const messagebus::Message& message);
+    void send(const std::string& queue, const messagebus::Message& message);
+    void reply(const std::string& queue, const messagebus::Message& message);
+    messagebus::Message request(const std::string& queue, const messagebus::Message& message, int timeoutSec);
+
+    std::mutex                                   m_lock;
+    std::condition_variable                      m_replied;
+    std::map<std::string, Listener>              m_queues;
+    std::map<std::string, std::vector<Listener>> m_topics;
+    std::map<std::string, Pending*>              m_pending; // requests waiting for a reply, by correlation id
+    std::atomic<uint64_t>                        m_delivered{0};
+    std::atomic<uint64_t>                        m_dropped{0};
+};
+
+/// Client of a LocalBroker, a drop-in for messagebus::MlmMessageBus
+class LocalMessageBus : public messagebus::MessageBus
+{
+public:
+    LocalMessageBus(LocalBroker& broker, const std::string& clientName);
+    ~LocalMessageBus() override;
+
+    void connect() override;
+
+    void publish(const std::string& topic, const messagebus::Message& message) override;
+    void subscribe(const std::string& topic, messagebus::MessageListener messageListener) override;
+    /// drops every subscription of this client to the topic, listeners cannot be compared
+    void unsubscribe(const std::string& topic, messagebus::MessageListener messageListener) override;
+
+    void sendRequest(const std::string& requestQueue, const messagebus::Message& message) override;
+    void sendRequest(const std::string& requestQueue, const messagebus::Message& message,
+        messagebus::MessageListener messageListener) override;
+    void sendReply(const std::string& replyQueue, const messagebus::Message& message) override;
+    void receive(const std::string& queue, messagebus::MessageListener messageListener) override;
+
+    /// the reply normally arrives before sendRequest returns, the timeout only matters for handlers replying later
+    messagebus::Message request(
+        const std::string& requestQueue, const messagebus::Message& message, int receiveTimeOut) override;
+
+    const std::string& name() const
+    {
+        return m_name;
+    }
+
+private:
+    LocalBroker& m_broker;
+    std::string  m_name;
+};
+
+} // namespace fty
@@ -18,6 +18,13 @@
 #include <catch2/catch.hpp>
 
 #include "fty_asset_dto.h"
+#include "fty_asset_fake_activator.h"
+#include "fty_asset_local_bus.h"
+#include "fty_asset_sql_trace.h"
+#include "fty_asset_stats.h"
+#include <memory>
+#include <stdexcept>
+#include <thread>
 
 using namespace fty;
 
@@ -69,3 +76,360 @@ TEST_CASE("Equality check - bad case")
     
 }
 
+
+TEST_CASE("Diff - no change")
+{
+    Asset asset;
+    asset.setInternalName("ups-1");
+    asset.setAssetStatus(AssetStatus::Active);
+    asset.setExtEntry("model", "9PX");
+    asset.addLink("epdu-2", "1", "2", 1, {});
+
+    Asset asset2 = asset;
+
+    REQUIRE(AssetDiff(asset, asset2).empty());
+}
+
+TEST_CASE("Diff - changed fields only")
+{
+    Asset before;
+    before.setInternalName("ups-1");
+    before.setAssetStatus(AssetStatus::Active);
+    before.setPriority(3);
+    before.setExtEntry("model", "9PX");
+    before.setExtEntry("status.operating", "online", true);
+    before.setExtEntry("location", "room 1");
+    before.addLink("epdu-2", "1", "2", 1, {});
+
+    Asset after = before;
+    after.setAssetStatus(AssetStatus::Nonactive);
+    after.setExtEntry("status.operating", "onbattery", true);
+    after.setExtEntry("serial_no", "ABC");
+    after.removeLink("epdu-2", "1", "2", 1);
+    after.addLink("epdu-3", "", "", 1, {});
+
+    Asset::ExtMap ext = after.getExt();
+    ext.erase("location");
+    after.setExtMap(ext);
+
+    AssetDiff diff(before, after);
+
+    REQUIRE(!diff.empty());
+    REQUIRE(diff.core().size() == 1);
+    REQUIRE(diff.core().at("status").second == std::to_string(int(AssetStatus::Nonactive)));
+    REQUIRE(diff.extSet().size() == 2);
+    REQUIRE(diff.extSet().at("status.operating").getValue() == "onbattery");
+    REQUIRE(diff.extSet().count("model") == 0);
+    REQUIRE(diff.extRemoved() == std::vector<std::string>{"location"});
+    REQUIRE(diff.linksSet().size() == 1);
+    REQUIRE(diff.linksSet()[0].sourceId() == "epdu-3");
+    REQUIRE(diff.linksRemoved().size() == 1);
+    REQUIRE(diff.linksRemoved()[0].sourceId() == "epdu-2");
+
+    cxxtools::SerializationInfo si;
+    si <<= diff;
+    REQUIRE(si.findMember("changed") != nullptr);
+    REQUIRE(si.findMember("ext_removed") != nullptr);
+    REQUIRE(si.findMember("linked") != nullptr);
+}
+
+TEST_CASE("Activation - batches")
+{
+    std::vector<std::string> assets(250, "{}");
+
+    // each exchange counts the assets before it in the same exchange
+    activation::FakeActivator check(50);
+    activation::setTransport(check.transport());
+
+    uint64_t before = activation::exchanges();
+    auto     checks = activation::areActivable(assets);
+    REQUIRE(activation::exchanges() - before == 3);
+    REQUIRE(checks.size() == 250);
+    REQUIRE(checks[49]);
+    REQUIRE(!checks[50]);
+
+    activation::FakeActivator fake(150);
+    activation::setTransport(fake.transport());
+
+    // a new transport is probed again, with the check of one asset
+    before       = activation::exchanges();
+    auto results = activation::activate(assets);
+    REQUIRE(activation::exchanges() - before == 4);
+    REQUIRE(results.size() == 250);
+    REQUIRE(results[149].empty());
+    REQUIRE(!results[150].empty());
+    REQUIRE(fake.active() == 150);
+
+    activation::setTransport({});
+}
+
+TEST_CASE("Activation - fallback to single requests")
+{
+    activation::FakeActivator fake(10);
+    // an activator without batch commands
+    activation::setTransport([&fake](const std::vector<std::string>& payload) -> std::vector<std::string> {
+        if (payload[0] == activation::COMMAND_ARE_ASSETS_ACTIVABLE ||
+            payload[0] == activation::COMMAND_ACTIVATE_ASSETS) {
+            return {"ERROR", "Unknown command"};
+        }
+        return fake.transport()(payload);
+    });
+
+    std::vector<std::string> assets(20, "{}");
+
+    uint64_t before  = activation::exchanges();
+    auto     results = activation::activate(assets);
+    REQUIRE(activation::exchanges() - before == 21);
+    REQUIRE(results[9].empty());
+    REQUIRE(!results[10].empty());
+
+    // the batch commands are not tried again
+    before  = activation::exchanges();
+    results = activation::activate(assets);
+    REQUIRE(activation::exchanges() - before == 20);
+
+    before      = activation::exchanges();
+    auto checks = activation::areActivable(assets);
+    REQUIRE(activation::exchanges() - before == 20);
+    REQUIRE(!checks[0]);
+
+    activation::setTransport({});
+}
+
+TEST_CASE("Activation - activator letting unknown commands time out is probed once")
+{
+    activation::FakeActivator fake(100);
+    activation::setTransport([&fake](const std::vector<std::string>& payload) -> std::vector<std::string> {
+        if (payload[0] == activation::COMMAND_ARE_ASSETS_ACTIVABLE ||
+            payload[0] == activation::COMMAND_ACTIVATE_ASSETS) {
+            throw std::runtime_error("Request timed out");
+        }
+        return fake.transport()(payload);
+    });
+
+    std::vector<std::string> assets(250, "{}");
+
+    uint64_t before = activation::exchanges();
+    auto     checks = activation::areActivable(assets);
+    REQUIRE(activation::exchanges() - before == 251);
+    REQUIRE(checks[249]);
+
+    before       = activation::exchanges();
+    auto results = activation::activate(assets);
+    REQUIRE(activation::exchanges() - before == 250);
+    REQUIRE(results[99].empty());
+    REQUIRE(!results[100].empty());
+    REQUIRE(fake.active() == 100);
+
+    activation::setTransport({});
+}
+
+TEST_CASE("Activation - failed batch is reported, never sent again")
+{
+    activation::FakeActivator fake(100);
+    bool                      lost = true;
+    // the activator acts on the first batch, its reply is lost
+    activation::setTransport([&](const std::vector<std::string>& payload) -> std::vector<std::string> {
+        auto frames = fake.transport()(payload);
+        if (payload[0] == activation::COMMAND_ACTIVATE_ASSETS && lost) {
+            lost = false;
+            throw std::runtime_error("Request timed out");
+        }
+        return frames;
+    });
+
+    std::vector<std::string> assets(20, "{}");
+
+    // probe, then the batch
+    uint64_t before  = activation::exchanges();
+    auto     results = activation::activate(assets);
+    REQUIRE(activation::exchanges() - before == 2);
+    REQUIRE(results.size() == 20);
+    for (const auto& result : results) {
+        REQUIRE(result == std::string(activation::COMMAND_ACTIVATE_ASSETS) + " failed: Request timed out");
+    }
+    REQUIRE(fake.active() == 20);
+
+    // batch commands are still used
+    before  = activation::exchanges();
+    results = activation::activate(assets);
+    REQUIRE(activation::exchanges() - before == 1);
+    REQUIRE(results[19].empty());
+    REQUIRE(fake.active() == 40);
+
+    activation::setTransport({});
+}
+
+TEST_CASE("Stats - histogram buckets")
+{
+    using stats::Histogram;
+
+    for (uint64_t value : {uint64_t(0), uint64_t(1), uint64_t(31), uint64_t(32), uint64_t(33), uint64_t(1000),
+             uint64_t(123456789), UINT64_MAX}) {
+        size_t bucket = Histogram::bucketOf(value);
+        REQUIRE(bucket < Histogram::BucketCount);
+        REQUIRE(Histogram::highestOf(bucket) >= value);
+        // at most 1/32 above the value
+        REQUIRE(Histogram::highestOf(bucket) - value <= value / Histogram::SubCount);
+    }
+    // small values are exact
+    REQUIRE(Histogram::highestOf(Histogram::bucketOf(17)) == 17);
+    REQUIRE(Histogram::bucketOf(UINT64_MAX) == Histogram::BucketCount - 1);
+}
+
+TEST_CASE("Stats - histogram percentiles")
+{
+    stats::Histogram histogram;
+    REQUIRE(histogram.percentile(0.5) == 0);
+
+    for (uint64_t value = 1; value <= 100000; ++value) {
+        histogram.record(value);
+    }
+
+    auto summary = histogram.summary();
+    REQUIRE(summary.count == 100000);
+    REQUIRE(summary.max == 100000);
+    REQUIRE(summary.sum == uint64_t(100000) * 100001 / 2);
+
+    // exact quantiles are 50000, 90000 and 99000
+    REQUIRE(summary.p50 >= 50000);
+    REQUIRE(summary.p50 <= 50000 + 50000 / 32);
+    REQUIRE(summary.p90 >= 90000);
+    REQUIRE(summary.p90 <= 90000 + 90000 / 32);
+    REQUIRE(summary.p99 >= 99000);
+    REQUIRE(summary.p99 <= 100000);
+    REQUIRE(histogram.percentile(1.0) == 100000);
+}
+
+TEST_CASE("Stats - concurrent recording")
+{
+    stats::Metric& metric = stats::metric("test.concurrent");
+    REQUIRE(&metric == &stats::metric("test.concurrent"));
+
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < 8; ++t) {
+        threads.emplace_back([&metric, t]() {
+            for (uint64_t i = 0; i < 100000; ++i) {
+                metric.latency.record(i % 1000 + t);
+                metric.bytesIn += 2;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    auto summary = metric.latency.summary();
+    REQUIRE(summary.count == 800000);
+    REQUIRE(summary.max == 999 + 7);
+    REQUIRE(metric.bytesIn == 1600000);
+
+    uint64_t sum = 0;
+    for (uint64_t t = 0; t < 8; ++t) {
+        sum += 100 * (999 * 1000 / 2 + 1000 * t);
+    }
+    REQUIRE(summary.sum == sum);
+
+    std::string json = stats::toJson();
+    REQUIRE(json.find("\"test.concurrent\"") != std::string::npos);
+    REQUIRE(json.find("\"p99\"") != std::string::npos);
+}
+
+TEST_CASE("SQL trace - normalize")
+{
+    using sqltrace::normalize;
+
+    REQUIRE(normalize("SELECT name FROM t_bios_asset_element\n    WHERE id_asset_element = 42") ==
+            "SELECT name FROM t_bios_asset_element WHERE id_asset_element = ?");
+    REQUIRE(normalize("SELECT a FROM t WHERE id IN ( 1, 2,3 ) AND x = 'it''s'") ==
+            "SELECT a FROM t WHERE id IN (?) AND x = ?");
+    REQUIRE(normalize("SELECT a FROM t1 WHERE id = :id AND b IN (:b0, :b1)") ==
+            "SELECT a FROM t1 WHERE id = ? AND b IN (?)");
+    // batches of any size are the same statement
+    REQUIRE(normalize("INSERT INTO t (a, b) VALUES (1, 'x'), (2, 'y')") ==
+            normalize("INSERT INTO t (a, b) VALUES (3, 'z')"));
+}
+
+TEST_CASE("SQL trace - scopes and N+1")
+{
+    sqltrace::setEnabled(true);
+    sqltrace::setRepeatLimit(3);
+
+    {
+        sqltrace::Query untraced("SELECT 1");
+    }
+
+    sqltrace::Scope outer("outer");
+    REQUIRE(outer.active());
+    {
+        sqltrace::Scope inner("inner");
+        for (int i = 0; i < 5; ++i) {
+            sqltrace::Query query("SELECT name FROM t WHERE id = " + std::to_string(i));
+            query.rows(1);
+        }
+        REQUIRE(inner.queries() == 5);
+        REQUIRE(inner.repeated().size() == 1);
+        REQUIRE(inner.repeated()[0].sql == "SELECT name FROM t WHERE id = ?");
+        REQUIRE(inner.repeated()[0].rows == 5);
+    }
+    {
+        sqltrace::Query query("SELECT id FROM t WHERE name IN ('a', 'b')");
+    }
+
+    // the outer scope sees the statements of the inner one, nothing from before it
+    REQUIRE(outer.queries() == 6);
+    REQUIRE(outer.calls("FROM t WHERE id") == 5);
+    REQUIRE(outer.calls("name IN") == 1);
+    REQUIRE(outer.statements()[0].calls == 5);
+
+    sqltrace::setRepeatLimit(20);
+}
+
+TEST_CASE("Local bus - request, reply and topics")
+{
+    LocalBroker                             broker;
+    std::unique_ptr<messagebus::MessageBus> server(broker.factory()("", "server"));
+    std::unique_ptr<messagebus::MessageBus> client(broker.client("client"));
+    std::unique_ptr<messagebus::MessageBus> listener(broker.client("listener"));
+
+    server->receive("QUEUE", [&](messagebus::Message msg) {
+        messagebus::Message reply;
+        reply.metaData()[messagebus::Message::CORRELATION_ID] = msg.metaData()[messagebus::Message::CORRELATION_ID];
+        reply.userData().push_back(msg.userData().front() + "-reply");
+        server->sendReply(msg.metaData()[messagebus::Message::REPLY_TO], reply);
+        server->publish("TOPIC", reply);
+    });
+
+    std::vector<std::string> published;
+    listener->subscribe("TOPIC", [&](messagebus::Message msg) {
+        published.push_back(msg.userData().front());
+    });
+
+    messagebus::Message request;
+    request.metaData()[messagebus::Message::CORRELATION_ID] = "1";
+    request.metaData()[messagebus::Message::REPLY_TO]       = "client";
+    request.userData().push_back("first");
+
+    // synchronous: the reply and the notification are there when request() returns
+    messagebus::Message reply = client->request("QUEUE", request, 1);
+    REQUIRE(reply.userData().front() == "first-reply");
+    REQUIRE(published == std::vector<std::string>{"first-reply"});
+
+    std::string async;
+    request.metaData()[messagebus::Message::CORRELATION_ID] = "2";
+    request.userData().front()                              = "second";
+    client->sendRequest("QUEUE", request, [&](messagebus::Message msg) {
+        async = msg.userData().front();
+    });
+    REQUIRE(async == "second-reply");
+    REQUIRE(published.size() == 2);
+
+    // nobody listens any more, the notification is dropped
+    listener.reset();
+    client->sendRequest("QUEUE", request);
+    REQUIRE(published.size() == 2);
+    REQUIRE(broker.dropped() == 1);
+
+    request.metaData()[messagebus::Message::CORRELATION_ID] = "3";
+    REQUIRE_THROWS_AS(client->request("NOBODY", request, 0), messagebus::MessageBusException);
+}
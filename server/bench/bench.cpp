@@ -0,0 +1,315 @@
+#include "asset-server.h"
+#include "asset/asset-db.h"
+#include "test-db/generator.h"
+#include "topology/db/topology2.h"
+#include "topology/persist/assettopology.h"
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <cxxtools/serializationinfo.h>
+#include <fty_asset_accessor.h>
+#include <fty_asset_fake_activator.h>
+#include <fty_asset_local_bus.h>
+#include <fty_common_db.h>
+#include <fty_common_db_dbpath.h>
+#include <fty_common_messagebus.h>
+#include <tntdb.h>
+#include <unistd.h>
+
+// Sizes are asset counts of the generated datacenter, see fty::GeneratorConfig::forAssets
+
+static bool prepare(benchmark::State& state, fty::Generated& data)
+{
+    auto ret = fty::Generator::dataset(uint64_t(state.range(0)));
+    if (!ret) {
+        state.SkipWithError(ret.error().c_str());
+        return false;
+    }
+    data = *ret;
+    return true;
+}
+
+static std::string iname(uint32_t id)
+{
+    tntdb::Connection conn = tntdb::connectCached(DBConn::url);
+    return conn.prepareCached("SELECT name FROM t_bios_asset_element WHERE id_asset_element = :id")
+        .set("id", id)
+        .selectValue()
+        .getString();
+}
+
+// =====================================================================================================================
+
+using Filters = std::map<std::string, std::vector<std::string>>;
+
+// LIST filters from broad to narrow, answered by SQL (0) or by the in-memory index (1)
+static void listAssets(benchmark::State& state)
+{
+    fty::Generated data;
+    if (!prepare(state, data)) {
+        return;
+    }
+
+    std::vector<Filters> filters = {
+        {{"id_type", {std::to_string(persist::type_to_typeid("device"))}}},
+        {{"id_subtype", {std::to_string(persist::subtype_to_subtypeid("epdu"))}}},
+        {{"id_subtype", {std::to_string(persist::subtype_to_subtypeid("ups"))}}, {"status", {"active"}}},
+        {{"id_parent", {std::to_string(data.racks.front())}}},
+    };
+    const Filters& filter = filters[size_t(state.range(1))];
+
+    fty::DB::setListIndexTtl(state.range(2) ? 60000 : 0);
+    size_t found = 0;
+    for (auto _ : state) {
+        found = fty::DB::getInstance().listAssets(filter).size();
+    }
+    fty::DB::setListIndexTtl(0);
+
+    state.counters["found"] = double(found);
+}
+BENCHMARK(listAssets)
+    ->ArgNames({"assets", "filter", "index"})
+    ->ArgsProduct({{10000}, {0, 1, 2, 3}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+
+// =====================================================================================================================
+
+// caches warmed from the snapshot (1) against an index built from the database (0), first LIST included
+static void startup(benchmark::State& state)
+{
+    fty::Generated data;
+    if (!prepare(state, data)) {
+        return;
+    }
+    bool fromSnapshot = state.range(1);
+
+    char path[] = "/tmp/fty-asset-bench-XXXXXX";
+    int  fd     = mkstemp(path);
+    if (fd < 0) {
+        state.SkipWithError("cannot create snapshot file");
+        return;
+    }
+    close(fd);
+
+    if (fromSnapshot) {
+        fty::DB::setSnapshot(path, 1000);
+        // nothing loaded yet, writes the first snapshot
+        fty::DB::validateSnapshot();
+    }
+
+    Filters filter = {{"id_type", {std::to_string(persist::type_to_typeid("device"))}}};
+    for (auto _ : state) {
+        state.PauseTiming();
+        fty::DB::setListIndexTtl(60000);
+        state.ResumeTiming();
+
+        if (fromSnapshot && !fty::DB::loadSnapshot()) {
+            state.SkipWithError("snapshot not loaded");
+            break;
+        }
+        benchmark::DoNotOptimize(fty::DB::getInstance().listAssets(filter));
+    }
+
+    fty::DB::setSnapshot({}, 0);
+    fty::DB::setListIndexTtl(0);
+    unlink(path);
+    state.counters["assets"] = double(data.assets);
+}
+BENCHMARK(startup)
+    ->ArgNames({"assets", "snapshot"})
+    ->ArgsProduct({{10000, 100000}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+// =====================================================================================================================
+
+static void topology2From(benchmark::State& state)
+{
+    fty::Generated data;
+    if (!prepare(state, data)) {
+        return;
+    }
+
+    std::string       from = iname(data.datacenters.front());
+    tntdb::Connection conn = tntdb::connectCached(DBConn::url);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(persist::topology2_from(conn, from).size());
+    }
+}
+BENCHMARK(topology2From)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+// legacy location topology of a datacenter down to the devices, as ASSET_MSG_GET_LOCATION_FROM walks it
+static void selectChilds(benchmark::State& state)
+{
+    fty::Generated data;
+    if (!prepare(state, data)) {
+        return;
+    }
+
+    for (auto _ : state) {
+        zframe_t* frame = select_childs(DBConn::url.c_str(), data.datacenters.front(),
+            persist::asset_type::DATACENTER, persist::asset_type::ROOM, true, 1, 7, 0);
+        if (!frame) {
+            state.SkipWithError("select_childs failed");
+            break;
+        }
+        zframe_destroy(&frame);
+    }
+}
+BENCHMARK(selectChilds)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+// =====================================================================================================================
+
+static void srrSave(benchmark::State& state)
+{
+    fty::Generated data;
+    if (!prepare(state, data)) {
+        return;
+    }
+
+    fty::AssetServer server;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(server.saveAssets());
+    }
+    state.counters["assets"] = double(data.assets);
+}
+BENCHMARK(srrSave)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+static void srrRestore(benchmark::State& state)
+{
+    fty::Generated data;
+    if (!prepare(state, data)) {
+        return;
+    }
+
+    fty::AssetServer               server;
+    cxxtools::SerializationInfo    si = server.saveAssets();
+    fty::activation::FakeActivator fake(data.assets);
+    fty::activation::setTransport(fake.transport());
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        fty::Generator::clear();
+        state.ResumeTiming();
+
+        server.restoreAssets(si, false);
+    }
+    fty::activation::setTransport({});
+    state.counters["assets"] = double(data.assets);
+
+    // restored assets have other ids than the generated ones
+    fty::Generator::clear();
+}
+BENCHMARK(srrRestore)->Arg(1000)->Unit(benchmark::kMillisecond)->Iterations(3);
+
+// =====================================================================================================================
+
+// the server answering on an in-process bus, requests run through the real handlers without a broker
+class LocalServer
+{
+public:
+    LocalServer()
+        : m_client(m_broker.client("bench"))
+    {
+        m_server.setMessageBusFactory(m_broker.factory());
+        m_server.createMailboxClientNg();
+        m_server.connectMailboxClientNg();
+        m_server.receiveMailboxClientNg(FTY_ASSET_MAILBOX);
+        m_server.createPublisherClientNg();
+        m_server.connectPublisherClientNg();
+    }
+
+    fty::LocalBroker& broker()
+    {
+        return m_broker;
+    }
+
+    messagebus::Message request(const std::string& subject, const std::string& data)
+    {
+        messagebus::Message msg;
+        msg.metaData()[messagebus::Message::SUBJECT]        = subject;
+        msg.metaData()[messagebus::Message::CORRELATION_ID] = std::to_string(++m_requests);
+        msg.metaData()[messagebus::Message::FROM]           = "bench";
+        msg.metaData()[messagebus::Message::TO]             = m_server.getAgentNameNg();
+        msg.metaData()[messagebus::Message::REPLY_TO]       = "bench";
+        msg.userData().push_back(data);
+        return m_client->request(FTY_ASSET_MAILBOX, msg, 5);
+    }
+
+private:
+    fty::LocalBroker                        m_broker; // outlives the clients of the server
+    fty::AssetServer                        m_server;
+    std::unique_ptr<messagebus::MessageBus> m_client;
+    uint64_t                                m_requests = 0;
+};
+
+// GET (0), LIST of a rack (1) and UPDATE (2) requests per second, 100 000 of them
+static void handlers(benchmark::State& state)
+{
+    fty::Generated data;
+    if (!prepare(state, data)) {
+        return;
+    }
+
+    LocalServer server;
+    std::string device = iname(data.devices.back());
+
+    // two versions of the asset, every UPDATE changes it and sends the notifications
+    std::vector<std::string> updates;
+    for (const char* description : {"bench a", "bench b"}) {
+        fty::AssetImpl asset(device);
+        asset.setExtEntry("description", description);
+        updates.push_back(fty::Asset::toJson(asset));
+    }
+
+    std::vector<std::pair<std::string, std::string>> requests = {
+        {FTY_ASSET_SUBJECT_GET, device},
+        {FTY_ASSET_SUBJECT_LIST, R"({"parent": [")" + iname(data.racks.front()) + R"("]})"},
+        {FTY_ASSET_SUBJECT_UPDATE, {}},
+    };
+    auto& request = requests[size_t(state.range(1))];
+
+    uint64_t i = 0;
+    for (auto _ : state) {
+        if (request.first == FTY_ASSET_SUBJECT_UPDATE) {
+            request.second = updates[i % 2];
+        }
+        messagebus::Message reply = server.request(request.first, request.second);
+        if (reply.metaData()[messagebus::Message::STATUS] != messagebus::STATUS_OK) {
+            state.SkipWithError(reply.userData().front().c_str());
+            break;
+        }
+        ++i;
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()));
+    state.counters["delivered"] = double(server.broker().delivered());
+}
+BENCHMARK(handlers)
+    ->ArgNames({"assets", "subject"})
+    ->ArgsProduct({{10000}, {0, 1, 2}})
+    ->Iterations(100000)
+    ->Unit(benchmark::kMicrosecond);
+
+// GET through fty::AssetAccessor, a bus client per request as in the agents using it
+static void accessorGet(benchmark::State& state)
+{
+    fty::Generated data;
+    if (!prepare(state, data)) {
+        return;
+    }
+
+    LocalServer server;
+    fty::AssetAccessor::setMessageBusFactory(server.broker().factory());
+    std::string device = iname(data.devices.back());
+
+    for (auto _ : state) {
+        auto asset = fty::AssetAccessor::getAsset(device);
+        if (!asset) {
+            state.SkipWithError(asset.error().c_str());
+            break;
+        }
+    }
+
+    fty::AssetAccessor::setMessageBusFactory(messagebus::MlmMessageBus);
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+BENCHMARK(accessorGet)->Arg(10000)->Iterations(100000)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,43 @@
+#include "test-db/test-db.h"
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <fty_common_db_dbpath.h>
+#include <fty_log.h>
+#include <iostream>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+    ManageFtyLog::setInstanceFtylog("server-bench", BENCH_LOGGER_CONF);
+
+    // JSON results to compare runs, unless the caller chose another output
+    std::vector<char*> args(argv, argv + argc);
+    std::string        out    = "--benchmark_out=fty-server-bench.json";
+    std::string        format = "--benchmark_out_format=json";
+
+    bool hasOut = false;
+    for (int i = 1; i < argc; ++i) {
+        hasOut |= strncmp(argv[i], "--benchmark_out=", 16) == 0;
+    }
+    if (!hasOut) {
+        args.push_back(out.data());
+        args.push_back(format.data());
+    }
+
+    int count = int(args.size());
+    benchmark::Initialize(&count, args.data());
+    if (benchmark::ReportUnrecognizedArguments(count, args.data())) {
+        return 1;
+    }
+
+    if (auto ret = fty::TestDb::init(); !ret) {
+        std::cerr << "cannot start test database: " << ret.error() << std::endl;
+        return 1;
+    }
+    // the server reads its url once at startup
+    DBConn::url = getenv("DBURL");
+
+    benchmark::RunSpecifiedBenchmarks();
+    fty::TestDb::destroy();
+    return 0;
+}
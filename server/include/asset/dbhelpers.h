@@ -86,6 +86,20 @@
                 const tntdb::Row&
                 )>& cb, bool test);
 
+// Selects parent relation of all assets in the DB (id, name, id_parent, id_type, id_subtype, status)
+ int
+    select_asset_tree (
+            std::function<void(
+                const tntdb::Row&
+                )>& cb, bool test);
+
+// Selects ext attributes of all assets in the DB (name, keytag, value, read_only)
+ int
+    select_all_ext_attributes (
+            std::function<void(
+                const tntdb::Row&
+                )>& cb, bool test);
+
 //////////////////////////////////////////////////////////////////////////////////
 
 // Inserts ext attributes from inventory message into DB
@@ -96,14 +110,35 @@
     bool read_only,
     bool test);
 
-// Inserts ext attributes from inventory message into DB if not present in the cache
+
+// One ext attribute row of a batched inventory write
+struct InventoryRow
+{
+    uint32_t    asset_id;
+    std::string keytag;
+    std::string value;
+    bool        read_only;
+};
+
+// Selects ids of given asset names in one query, unknown names are not reported
  int
-    process_insert_inventory
-    (const std::string& device_name,
-    zhash_t *ext_attributes,
-    bool read_only,
-    std::unordered_map<std::string,std::string> &map_cache,
-    bool test);
+    select_asset_ids_by_name
+    (const std::vector<std::string>& names,
+     std::unordered_map<std::string, uint32_t>& ids,
+     bool test);
+
+// Inserts ext attributes of several assets with multi-row upserts in one transaction
+ int
+    process_insert_inventory_batch
+    (const std::vector<InventoryRow>& rows,
+     bool test);
+
+// Writes missing uuid/create_ts ext attributes of given assets (all if empty) in one transaction
+ int
+    process_backfill_uuid_create_ts
+    (const std::vector<std::string>& assets,
+     std::vector<std::string>& names,
+     bool test);
 
 // Selects user-friendly name for given asset name
  int
@@ -22,15 +22,19 @@
 #include "asset-server.h"
 
 #include "asset/asset-utils.h"
+#include "change_journal.h"
 
 #include <algorithm>
 #include <fty_asset_dto.h>
+#include <fty_asset_sql_trace.h>
+#include <fty_asset_stats.h>
 #include <fty/convert.h>
 #include <sstream>
 #include <cstdlib>
 #include <ctime>
 #include <functional>
 #include <list>
+#include <set>
 
 #include <cxxtools/serializationinfo.h>
 
@@ -49,6 +53,7 @@ using namespace std::placeholders;
 // fwd declaration
 void send_create_or_update_asset(
     const fty::AssetServer& config, const std::string& asset_name, const char* operation, bool read_only);
+void send_asset_notification(const fty::AssetServer& server, const fty::Asset& asset, const char* operation);
 
 namespace fty {
 // ===========================================================================================================
@@ -86,12 +91,13 @@ AssetServer::AssetServer()
     , m_globalConfigurability(1)
     , m_mailboxClient(mlm_client_new(), &destroyMlmClient)
     , m_streamClient(mlm_client_new(), &destroyMlmClient)
+    , m_msgBusFactory(messagebus::MlmMessageBus)
 {
 }
 
 void AssetServer::createMailboxClientNg()
 {
-    m_assetMsgQueue.reset(messagebus::MlmMessageBus(m_mailboxEndpoint, m_agentNameNg));
+    m_assetMsgQueue.reset(m_msgBusFactory(m_mailboxEndpoint, m_agentNameNg));
     log_debug("New mailbox client registered to endpoint %s with name %s", m_mailboxEndpoint.c_str(),
         m_agentNameNg.c_str());
 }
@@ -116,33 +122,42 @@ void AssetServer::receiveMailboxClientNg(const std::string& queue)
 
 void AssetServer::createPublisherClientNg()
 {
-    m_publisherCreate.reset(messagebus::MlmMessageBus(m_mailboxEndpoint, m_agentNameNg + "-create"));
+    m_publisherCreate.reset(m_msgBusFactory(m_mailboxEndpoint, m_agentNameNg + "-create"));
     log_debug("New publisher client registered to endpoint %s with name %s", m_mailboxEndpoint.c_str(),
         (m_agentNameNg + "-create").c_str());
 
-    m_publisherUpdate.reset(messagebus::MlmMessageBus(m_mailboxEndpoint, m_agentNameNg + "-update"));
+    m_publisherUpdate.reset(m_msgBusFactory(m_mailboxEndpoint, m_agentNameNg + "-update"));
     log_debug("New publisher client registered to endpoint %s with name %s", m_mailboxEndpoint.c_str(),
         (m_agentNameNg + "-update").c_str());
 
-    m_publisherDelete.reset(messagebus::MlmMessageBus(m_mailboxEndpoint, m_agentNameNg + "-delete"));
+    m_publisherDelete.reset(m_msgBusFactory(m_mailboxEndpoint, m_agentNameNg + "-delete"));
     log_debug("New publisher client registered to endpoint %s with name %s", m_mailboxEndpoint.c_str(),
         (m_agentNameNg + "-delete").c_str());
 
 
     m_publisherCreateLight.reset(
-        messagebus::MlmMessageBus(m_mailboxEndpoint, m_agentNameNg + "-create-light"));
+        m_msgBusFactory(m_mailboxEndpoint, m_agentNameNg + "-create-light"));
     log_debug("New publisher client registered to endpoint %s with name %s", m_mailboxEndpoint.c_str(),
         (m_agentNameNg + "-create-light").c_str());
 
     m_publisherUpdateLight.reset(
-        messagebus::MlmMessageBus(m_mailboxEndpoint, m_agentNameNg + "-update-light"));
+        m_msgBusFactory(m_mailboxEndpoint, m_agentNameNg + "-update-light"));
     log_debug("New publisher client registered to endpoint %s with name %s", m_mailboxEndpoint.c_str(),
         (m_agentNameNg + "-update-light").c_str());
 
+    m_publisherUpdateDelta.reset(
+        m_msgBusFactory(m_mailboxEndpoint, m_agentNameNg + "-update-delta"));
+    log_debug("New publisher client registered to endpoint %s with name %s", m_mailboxEndpoint.c_str(),
+        (m_agentNameNg + "-update-delta").c_str());
+
     m_publisherDeleteLight.reset(
-        messagebus::MlmMessageBus(m_mailboxEndpoint, m_agentNameNg + "-delete-light"));
+        m_msgBusFactory(m_mailboxEndpoint, m_agentNameNg + "-delete-light"));
     log_debug("New publisher client registered to endpoint %s with name %s", m_mailboxEndpoint.c_str(),
         (m_agentNameNg + "-delete-light").c_str());
+
+    m_publisherDeleteList.reset(m_msgBusFactory(m_mailboxEndpoint, m_agentNameNg + "-delete-list"));
+    log_debug("New publisher client registered to endpoint %s with name %s", m_mailboxEndpoint.c_str(),
+        (m_agentNameNg + "-delete-list").c_str());
 }
 
 void AssetServer::resetPublisherClientNg()
@@ -152,7 +167,9 @@ void AssetServer::resetPublisherClientNg()
     m_publisherDelete.reset();
     m_publisherCreateLight.reset();
     m_publisherUpdateLight.reset();
+    m_publisherUpdateDelta.reset();
     m_publisherDeleteLight.reset();
+    m_publisherDeleteList.reset();
 }
 
 void AssetServer::connectPublisherClientNg()
@@ -162,7 +179,9 @@ void AssetServer::connectPublisherClientNg()
     m_publisherDelete->connect();
     m_publisherCreateLight->connect();
     m_publisherUpdateLight->connect();
+    m_publisherUpdateDelta->connect();
     m_publisherDeleteLight->connect();
+    m_publisherDeleteList->connect();
 }
 
 // new generation asset manipulation handler
@@ -171,30 +190,53 @@ void AssetServer::handleAssetManipulationReq(const messagebus::Message& msg)
     log_debug("Received new asset manipulation message with subject %s",
         msg.metaData().at(messagebus::Message::SUBJECT).c_str());
 
+    // shared by every instance, the handlers get the server of the call
     // clang-format off
-    static std::map<std::string, std::function<void(const messagebus::Message&)>> procMap = {
-        { FTY_ASSET_SUBJECT_CREATE,       [&](const messagebus::Message& message){ createAsset(message); } },
-        { FTY_ASSET_SUBJECT_UPDATE,       [&](const messagebus::Message& message){ updateAsset(message); } },
-        { FTY_ASSET_SUBJECT_DELETE,       [&](const messagebus::Message& message){ deleteAsset(message); } },
-        { FTY_ASSET_SUBJECT_GET,          [&](const messagebus::Message& message){ getAsset(message); } },
-        { FTY_ASSET_SUBJECT_GET_BY_UUID,  [&](const messagebus::Message& message){ getAsset(message, true); } },
-        { FTY_ASSET_SUBJECT_LIST,         [&](const messagebus::Message& message){ listAsset(message); } },
-        { FTY_ASSET_SUBJECT_GET_ID,       [&](const messagebus::Message& message){ getAssetID(message); } },
-        { FTY_ASSET_SUBJECT_GET_INAME,    [&](const messagebus::Message& message){ getAssetIname(message); } },
-        { FTY_ASSET_SUBJECT_STATUS_UPD,   [&](const messagebus::Message& message){ notifyStatusUpdate(message); } },
-        { FTY_ASSET_SUBJECT_NOTIFY,       [&](const messagebus::Message& message){ notifyAsset(message); } }
+    using Msg     = messagebus::Message;
+    using Handler = void (*)(AssetServer&, const Msg&);
+    static const std::map<std::string, Handler> procMap = {
+        { FTY_ASSET_SUBJECT_CREATE,       [](AssetServer& srv, const Msg& m){ srv.createAsset(m); } },
+        { FTY_ASSET_SUBJECT_UPDATE,       [](AssetServer& srv, const Msg& m){ srv.updateAsset(m); } },
+        { FTY_ASSET_SUBJECT_DELETE,       [](AssetServer& srv, const Msg& m){ srv.deleteAsset(m); } },
+        { FTY_ASSET_SUBJECT_GET,          [](AssetServer& srv, const Msg& m){ srv.getAsset(m); } },
+        { FTY_ASSET_SUBJECT_GET_BY_UUID,  [](AssetServer& srv, const Msg& m){ srv.getAsset(m, true); } },
+        { FTY_ASSET_SUBJECT_LIST,         [](AssetServer& srv, const Msg& m){ srv.listAsset(m); } },
+        { FTY_ASSET_SUBJECT_QUERY,        [](AssetServer& srv, const Msg& m){ srv.queryAsset(m); } },
+        { FTY_ASSET_SUBJECT_CHANGES_SINCE, [](AssetServer& srv, const Msg& m){ srv.changesSince(m); } },
+        { FTY_ASSET_SUBJECT_GET_ID,       [](AssetServer& srv, const Msg& m){ srv.getAssetID(m); } },
+        { FTY_ASSET_SUBJECT_GET_INAME,    [](AssetServer& srv, const Msg& m){ srv.getAssetIname(m); } },
+        { FTY_ASSET_SUBJECT_STATUS_UPD,   [](AssetServer& srv, const Msg& m){ srv.notifyStatusUpdate(m); } },
+        { FTY_ASSET_SUBJECT_NOTIFY,       [](AssetServer& srv, const Msg& m){ srv.notifyAsset(m); } },
+        { FTY_ASSET_SUBJECT_STATS,        [](AssetServer& srv, const Msg& m){ srv.getStats(m); } }
     };
     // clang-format on
 
     const std::string& messageSubject = value(msg.metaData(), messagebus::Message::SUBJECT);
 
-    if (procMap.find(messageSubject) != procMap.end()) {
-        procMap[messageSubject](msg);
+    auto handler = procMap.find(messageSubject);
+    if (handler != procMap.end()) {
+        fty::stats::Metric& metric = fty::stats::metric("ng." + messageSubject);
+        for (const auto& frame : msg.userData()) {
+            metric.bytesIn += frame.size();
+        }
+
+        fty::sqltrace::Scope    trace("ng." + messageSubject);
+        fty::stats::ScopedTimer timer(metric.latency);
+        handler->second(*this, msg);
     } else {
         log_warning("Handle asset manipulation - Unknown subject");
     }
 }
 
+void AssetServer::sendReply(const std::string& queue, const messagebus::Message& reply)
+{
+    fty::stats::Metric& metric = fty::stats::metric("ng." + value(reply.metaData(), messagebus::Message::SUBJECT));
+    for (const auto& frame : reply.userData()) {
+        metric.bytesOut += frame.size();
+    }
+    m_assetMsgQueue->sendReply(queue, reply);
+}
+
 void AssetServer::handleAssetSrrReq(const messagebus::Message& msg)
 {
     log_debug("Process SRR request");
@@ -335,19 +377,10 @@ void AssetServer::sendNotification(const messagebus::Message& msg) const
     const std::string& subject = msg.metaData().at(messagebus::Message::SUBJECT);
 
     if (subject == FTY_ASSET_SUBJECT_CREATED) {
-        m_publisherCreate->publish(FTY_ASSET_TOPIC_CREATED, msg);
-
-        // REMOVE as soon as old interface is not needed anymore
-        // old interface
         fty::Asset asset;
         fty::Asset::fromJson(msg.userData().back(), asset);
-        send_create_or_update_asset(
-            *this, asset.getInternalName(), "create", false /* read_only is not used */);
+        sendNotification(msg, asset);
     } else if (subject == FTY_ASSET_SUBJECT_UPDATED) {
-        m_publisherUpdate->publish(FTY_ASSET_TOPIC_UPDATED, msg);
-
-        // REMOVE as soon as old interface is not needed anymore
-        // old interface
         cxxtools::SerializationInfo si;
         JSON::readFromString(msg.userData().front(), si);
         const cxxtools::SerializationInfo& after = si.getMember("after");
@@ -355,23 +388,46 @@ void AssetServer::sendNotification(const messagebus::Message& msg) const
         fty::Asset asset;
         // old interface replies only with updated asset
         after >>= asset;
-
-        send_create_or_update_asset(
-            *this, asset.getInternalName(), "update", false /* read_only is not used */);
+        sendNotification(msg, asset);
     } else if (subject == FTY_ASSET_SUBJECT_DELETED) {
         m_publisherDelete->publish(FTY_ASSET_TOPIC_DELETED, msg);
     } else if (subject == FTY_ASSET_SUBJECT_CREATED_L) {
         m_publisherCreateLight->publish(FTY_ASSET_TOPIC_CREATED_L, msg);
     } else if (subject == FTY_ASSET_SUBJECT_UPDATED_L) {
         m_publisherUpdateLight->publish(FTY_ASSET_TOPIC_UPDATED_L, msg);
+    } else if (subject == FTY_ASSET_SUBJECT_UPDATED_DELTA) {
+        m_publisherUpdateDelta->publish(FTY_ASSET_TOPIC_UPDATED_DELTA, msg);
     } else if (subject == FTY_ASSET_SUBJECT_DELETED_L) {
         m_publisherDeleteLight->publish(FTY_ASSET_TOPIC_DELETED_L, msg);
+    } else if (subject == FTY_ASSET_SUBJECT_DELETED_LIST) {
+        m_publisherDeleteList->publish(FTY_ASSET_TOPIC_DELETED_LIST, msg);
+    }
+}
+
+void AssetServer::sendNotification(const messagebus::Message& msg, const Asset& asset) const
+{
+    const std::string& subject = msg.metaData().at(messagebus::Message::SUBJECT);
+
+    if (subject == FTY_ASSET_SUBJECT_CREATED) {
+        m_publisherCreate->publish(FTY_ASSET_TOPIC_CREATED, msg);
+
+        // REMOVE as soon as old interface is not needed anymore
+        // old interface
+        send_asset_notification(*this, asset, "create");
+    } else if (subject == FTY_ASSET_SUBJECT_UPDATED) {
+        m_publisherUpdate->publish(FTY_ASSET_TOPIC_UPDATED, msg);
+
+        // REMOVE as soon as old interface is not needed anymore
+        // old interface
+        send_asset_notification(*this, asset, "update");
+    } else {
+        sendNotification(msg);
     }
 }
 
 void AssetServer::initSrr(const std::string& queue)
 {
-    m_srrClient.reset(messagebus::MlmMessageBus(m_srrEndpoint, m_srrAgentName));
+    m_srrClient.reset(m_msgBusFactory(m_srrEndpoint, m_srrAgentName));
     log_debug("New publisher client registered to endpoint %s with name %s", m_srrEndpoint.c_str(),
         (m_srrAgentName).c_str());
 
@@ -444,12 +500,12 @@ void AssetServer::createAsset(const messagebus::Message& msg)
 
         // send response
         log_debug("sending response to %s", msg.metaData().find(messagebus::Message::FROM)->second.c_str());
-        m_assetMsgQueue->sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
+        sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
 
         // full notification
         messagebus::Message notification = assetutils::createMessage(FTY_ASSET_SUBJECT_CREATED, "",
             m_agentNameNg, "", messagebus::STATUS_OK, fty::Asset::toJson(asset));
-        sendNotification(notification);
+        sendNotification(notification, asset);
 
         // light notification
         messagebus::Message notification_l = assetutils::createMessage(FTY_ASSET_SUBJECT_CREATED_L, "",
@@ -467,7 +523,7 @@ void AssetServer::createAsset(const messagebus::Message& msg)
 
         // send response
         log_debug("sending response to %s", msg.metaData().find(messagebus::Message::FROM)->second.c_str());
-        m_assetMsgQueue->sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
+        sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
     }
 }
 
@@ -535,7 +591,7 @@ void AssetServer::updateAsset(const messagebus::Message& msg)
 
         // send response
         log_debug("sending response to %s", msg.metaData().find(messagebus::Message::FROM)->second.c_str());
-        m_assetMsgQueue->sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
+        sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
 
         notifyAssetUpdate(currentAsset, asset);
     } catch (const std::exception& e) {
@@ -548,7 +604,7 @@ void AssetServer::updateAsset(const messagebus::Message& msg)
 
         // send response
         log_debug("sending response to %s", msg.metaData().find(messagebus::Message::FROM)->second.c_str());
-        m_assetMsgQueue->sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
+        sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
     }
 }
 
@@ -593,27 +649,48 @@ void AssetServer::deleteAsset(const messagebus::Message& msg)
             value(msg.metaData(), messagebus::Message::FROM), messagebus::STATUS_OK,
             serializeDeleteStatus(deleted));
 
-        // send one notification for each asset deleted
-        for (const auto& status : deleted) {
-            if (status.second == "OK") {
-                // full notification
-                messagebus::Message notification = assetutils::createMessage(FTY_ASSET_SUBJECT_DELETED, "",
-                    m_agentNameNg, "", messagebus::STATUS_OK, fty::Asset::toJson(status.first));
-                sendNotification(notification);
-
-                // light notification
-                messagebus::Message notification_l = assetutils::createMessage(FTY_ASSET_SUBJECT_DELETED_L,
-                    "", m_agentNameNg, "", messagebus::STATUS_OK, status.first.getInternalName());
-                sendNotification(notification_l);
-            }
-        }
+        notifyDeleted(deleted, value(msg.metaData(), METADATA_BULK_NOTIFY) == "YES");
     } catch (const std::exception& e) {
         response = assetutils::createMessage(value(msg.metaData(), messagebus::Message::SUBJECT),
             value(msg.metaData(), messagebus::Message::CORRELATION_ID), m_agentNameNg,
             value(msg.metaData(), messagebus::Message::FROM), messagebus::STATUS_KO, e.what());
     }
 
-    m_assetMsgQueue->sendReply(value(msg.metaData(), messagebus::Message::REPLY_TO), response);
+    sendReply(value(msg.metaData(), messagebus::Message::REPLY_TO), response);
+}
+
+void AssetServer::notifyDeleted(const DeleteStatus& deleted, bool bulk) const
+{
+    // one notification for each asset deleted, subscribers of DELETED/DELETED_LIGHT see every deletion
+    messagebus::UserData assets;
+    for (const auto& status : deleted) {
+        if (status.second != "OK") {
+            continue;
+        }
+        // full notification
+        messagebus::Message notification = assetutils::createMessage(FTY_ASSET_SUBJECT_DELETED, "",
+            m_agentNameNg, "", messagebus::STATUS_OK, fty::Asset::toJson(status.first));
+        sendNotification(notification);
+
+        // light notification
+        messagebus::Message notification_l = assetutils::createMessage(FTY_ASSET_SUBJECT_DELETED_L, "",
+            m_agentNameNg, "", messagebus::STATUS_OK, status.first.getInternalName());
+        sendNotification(notification_l);
+
+        // and one for a chunk of deleted assets, for subscribers of DELETED_LIST
+        if (bulk) {
+            assets.push_back(fty::Asset::toJson(status.first));
+            if (assets.size() == FTY_ASSET_DELETED_LIST_MAX) {
+                sendNotification(assetutils::createMessage(
+                    FTY_ASSET_SUBJECT_DELETED_LIST, "", m_agentNameNg, "", messagebus::STATUS_OK, assets));
+                assets.clear();
+            }
+        }
+    }
+    if (!assets.empty()) {
+        sendNotification(assetutils::createMessage(
+            FTY_ASSET_SUBJECT_DELETED_LIST, "", m_agentNameNg, "", messagebus::STATUS_OK, assets));
+    }
 }
 
 void AssetServer::getAsset(const messagebus::Message& msg, bool getFromUuid)
@@ -643,7 +720,7 @@ void AssetServer::getAsset(const messagebus::Message& msg, bool getFromUuid)
 
         // send response
         log_debug("sending response to %s", msg.metaData().find(messagebus::Message::FROM)->second.c_str());
-        m_assetMsgQueue->sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
+        sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
     } catch (std::exception& e) {
         log_error(e.what());
         // create response (error)
@@ -654,10 +731,40 @@ void AssetServer::getAsset(const messagebus::Message& msg, bool getFromUuid)
 
         // send response
         log_debug("sending response to %s", msg.metaData().find(messagebus::Message::FROM)->second.c_str());
-        m_assetMsgQueue->sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
+        sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
     }
 }
 
+// list of inames, or of full assets if requested with ID_ONLY=false
+static cxxtools::SerializationInfo serializeAssetList(
+    const messagebus::Message& msg, const std::vector<std::string>& inameList)
+{
+    cxxtools::SerializationInfo si;
+
+    if (value(msg.metaData(), METADATA_ID_ONLY) != "false") {
+        si <<= inameList;
+    } else {
+        bool withParentsList = value(msg.metaData(), METADATA_WITH_PARENTS_LIST) == "true";
+
+        for (const auto& iname : inameList) {
+            try {
+                fty::AssetImpl asset(iname);
+                if (withParentsList) {
+                    asset.updateParentsList();
+                }
+                cxxtools::SerializationInfo& data = si.addMember("");
+                data <<= asset;
+                data.setCategory(cxxtools::SerializationInfo::Category::Object);
+            } catch (std::exception& e) {
+                log_error("Could not retrieve asset %s: %s", iname.c_str(), e.what());
+            }
+        }
+        si.setCategory(cxxtools::SerializationInfo::Category::Array);
+    }
+
+    return si;
+}
+
 void AssetServer::listAsset(const messagebus::Message& msg)
 {
     log_debug("subject LIST");
@@ -681,58 +788,129 @@ void AssetServer::listAsset(const messagebus::Message& msg)
             }
         }
 
-        bool idOnly = true;
-        if (value(msg.metaData(), METADATA_ID_ONLY) == "false") {
-            idOnly = false;
+        std::vector<std::string>    inameList = fty::AssetImpl::list(filters);
+        cxxtools::SerializationInfo si        = serializeAssetList(msg, inameList);
+
+        // create response (ok)
+        auto response = assetutils::createMessage(FTY_ASSET_SUBJECT_LIST,
+            msg.metaData().find(messagebus::Message::CORRELATION_ID)->second, m_agentNameNg,
+            msg.metaData().find(messagebus::Message::FROM)->second, messagebus::STATUS_OK,
+            JSON::writeToString(si, false));
+
+        // send response
+        log_debug("sending response to %s", msg.metaData().find(messagebus::Message::FROM)->second.c_str());
+        sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
+    } catch (std::exception& e) {
+        log_error(e.what());
+        // create response (error)
+        auto response = assetutils::createMessage(FTY_ASSET_SUBJECT_LIST,
+            msg.metaData().find(messagebus::Message::CORRELATION_ID)->second, m_agentNameNg,
+            msg.metaData().find(messagebus::Message::FROM)->second, messagebus::STATUS_KO,
+            std::string(e.what()));
+
+        // send response
+        log_debug("sending response to %s", msg.metaData().find(messagebus::Message::FROM)->second.c_str());
+        sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
+    }
+}
+
+void AssetServer::queryAsset(const messagebus::Message& msg)
+{
+    log_debug("subject QUERY");
+
+    try {
+        if (msg.userData().empty()) {
+            throw std::runtime_error("missing query");
         }
 
-        std::vector<std::string>    inameList = fty::AssetImpl::list(filters);
-        cxxtools::SerializationInfo si;
+        cxxtools::SerializationInfo siQuery;
+        JSON::readFromString(msg.userData().front(), siQuery);
 
-        if (idOnly) {
-            si <<= inameList;
-        } else {
-            bool withParentsList = value(msg.metaData(), METADATA_WITH_PARENTS_LIST) == "true";
-
-            for (const auto& iname : inameList) {
-                try {
-                    fty::AssetImpl asset(iname);
-                    if (withParentsList) {
-                        asset.updateParentsList();
-                    }
-                    cxxtools::SerializationInfo& data = si.addMember("");
-                    data <<= asset;
-                    data.setCategory(cxxtools::SerializationInfo::Category::Object);
-                } catch (std::exception& e) {
-                    log_error("Could not retrieve asset %s: %s", iname.c_str(), e.what());
-                }
-            }
-            si.setCategory(cxxtools::SerializationInfo::Category::Array);
+        AssetQuery query;
+        siQuery >>= query;
+
+        std::vector<std::string>    inameList = fty::AssetImpl::query(query);
+        cxxtools::SerializationInfo si        = serializeAssetList(msg, inameList);
+
+        // create response (ok)
+        auto response = assetutils::createMessage(FTY_ASSET_SUBJECT_QUERY,
+            msg.metaData().find(messagebus::Message::CORRELATION_ID)->second, m_agentNameNg,
+            msg.metaData().find(messagebus::Message::FROM)->second, messagebus::STATUS_OK,
+            JSON::writeToString(si, false));
+
+        // send response
+        log_debug("sending response to %s", msg.metaData().find(messagebus::Message::FROM)->second.c_str());
+        sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
+    } catch (std::exception& e) {
+        log_error(e.what());
+        // create response (error)
+        auto response = assetutils::createMessage(FTY_ASSET_SUBJECT_QUERY,
+            msg.metaData().find(messagebus::Message::CORRELATION_ID)->second, m_agentNameNg,
+            msg.metaData().find(messagebus::Message::FROM)->second, messagebus::STATUS_KO,
+            std::string(e.what()));
+
+        // send response
+        log_debug("sending response to %s", msg.metaData().find(messagebus::Message::FROM)->second.c_str());
+        sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
+    }
+}
+
+void AssetServer::changesSince(const messagebus::Message& msg)
+{
+    log_debug("subject CHANGES_SINCE");
+
+    try {
+        if (msg.userData().empty()) {
+            throw std::runtime_error("missing sequence number");
         }
+        uint64_t since = fty::convert<uint64_t>(msg.userData().front());
+
+        uint64_t              current = 0;
+        std::set<std::string> changed;
+        std::set<std::string> deleted;
+        bool resync = !fty::ChangeJournal::instance().changesSince(since, current, changed, deleted);
+
+        cxxtools::SerializationInfo si;
+        si.addMember("seq") <<= current;
+        si.addMember("resync") <<= resync;
+        si.addMember("changed") <<= std::vector<std::string>(changed.begin(), changed.end());
+        si.addMember("deleted") <<= std::vector<std::string>(deleted.begin(), deleted.end());
 
         // create response (ok)
-        auto response = assetutils::createMessage(FTY_ASSET_SUBJECT_LIST,
+        auto response = assetutils::createMessage(FTY_ASSET_SUBJECT_CHANGES_SINCE,
             msg.metaData().find(messagebus::Message::CORRELATION_ID)->second, m_agentNameNg,
             msg.metaData().find(messagebus::Message::FROM)->second, messagebus::STATUS_OK,
             JSON::writeToString(si, false));
 
         // send response
         log_debug("sending response to %s", msg.metaData().find(messagebus::Message::FROM)->second.c_str());
-        m_assetMsgQueue->sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
+        sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
     } catch (std::exception& e) {
         log_error(e.what());
         // create response (error)
-        auto response = assetutils::createMessage(FTY_ASSET_SUBJECT_LIST,
+        auto response = assetutils::createMessage(FTY_ASSET_SUBJECT_CHANGES_SINCE,
             msg.metaData().find(messagebus::Message::CORRELATION_ID)->second, m_agentNameNg,
             msg.metaData().find(messagebus::Message::FROM)->second, messagebus::STATUS_KO,
             std::string(e.what()));
 
         // send response
         log_debug("sending response to %s", msg.metaData().find(messagebus::Message::FROM)->second.c_str());
-        m_assetMsgQueue->sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
+        sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
     }
 }
 
+void AssetServer::getStats(const messagebus::Message& msg)
+{
+    log_debug("subject STATS");
+
+    auto response = assetutils::createMessage(FTY_ASSET_SUBJECT_STATS,
+        msg.metaData().find(messagebus::Message::CORRELATION_ID)->second, m_agentNameNg,
+        msg.metaData().find(messagebus::Message::FROM)->second, messagebus::STATUS_OK, fty::stats::toJson());
+
+    log_debug("sending response to %s", msg.metaData().find(messagebus::Message::FROM)->second.c_str());
+    sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
+}
+
 void AssetServer::getAssetID(const messagebus::Message& msg)
 {
     log_debug("subject GET_ID");
@@ -750,7 +928,7 @@ void AssetServer::getAssetID(const messagebus::Message& msg)
 
         // send response
         log_debug("sending response to %s", msg.metaData().find(messagebus::Message::FROM)->second.c_str());
-        m_assetMsgQueue->sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
+        sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
     } catch (std::exception& e) {
         log_error(e.what());
         // create response (error)
@@ -761,7 +939,7 @@ void AssetServer::getAssetID(const messagebus::Message& msg)
 
         // send response
         log_debug("sending response to %s", msg.metaData().find(messagebus::Message::FROM)->second.c_str());
-        m_assetMsgQueue->sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
+        sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
     }
 }
 
@@ -782,7 +960,7 @@ void AssetServer::getAssetIname(const messagebus::Message& msg)
 
         // send response
         log_debug("sending response to %s", msg.metaData().find(messagebus::Message::FROM)->second.c_str());
-        m_assetMsgQueue->sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
+        sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
     } catch (std::exception& e) {
         log_error(e.what());
         // create response (error)
@@ -793,7 +971,7 @@ void AssetServer::getAssetIname(const messagebus::Message& msg)
 
         // send response
         log_debug("sending response to %s", msg.metaData().find(messagebus::Message::FROM)->second.c_str());
-        m_assetMsgQueue->sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
+        sendReply(msg.metaData().find(messagebus::Message::REPLY_TO)->second, response);
     }
 }
 
@@ -863,7 +1041,7 @@ void AssetServer::notifyAsset(const messagebus::Message& msg)
         // full notification
         messagebus::Message notification = assetutils::createMessage(FTY_ASSET_SUBJECT_UPDATED, "",
             m_agentNameNg, "", messagebus::STATUS_OK, JSON::writeToString(si, false));
-        sendNotification(notification);
+        sendNotification(notification, newAsset);
 
         // light notification
         messagebus::Message notification_l = assetutils::createMessage(FTY_ASSET_SUBJECT_UPDATED_L, "",
@@ -876,9 +1054,14 @@ void AssetServer::notifyAsset(const messagebus::Message& msg)
     }
 }
 
-void AssetServer::notifyAssetUpdate(const Asset& before, const Asset& after)
+void AssetServer::notifyAssetUpdate(const Asset& before, const Asset& after) const
 {
     try {
+        AssetDiff diff(before, after);
+        if (diff.empty()) {
+            log_debug("Asset %s did not change, no notification", after.getInternalName().c_str());
+            return;
+        }
 
         cxxtools::SerializationInfo si;
 
@@ -903,13 +1086,21 @@ void AssetServer::notifyAssetUpdate(const Asset& before, const Asset& after)
         // full notification
         messagebus::Message notification = assetutils::createMessage(FTY_ASSET_SUBJECT_UPDATED, "",
             m_agentNameNg, "", messagebus::STATUS_OK, JSON::writeToString(si, false));
-        sendNotification(notification);
+        sendNotification(notification, after);
 
         // light notification
         messagebus::Message notification_l = assetutils::createMessage(FTY_ASSET_SUBJECT_UPDATED_L, "",
             m_agentNameNg, "", messagebus::STATUS_OK, after.getInternalName());
         sendNotification(notification_l);
 
+        // delta notification
+        cxxtools::SerializationInfo siDelta;
+        siDelta <<= diff;
+
+        messagebus::Message notification_d = assetutils::createMessage(FTY_ASSET_SUBJECT_UPDATED_DELTA, "",
+            m_agentNameNg, "", messagebus::STATUS_OK, JSON::writeToString(siDelta, false));
+        sendNotification(notification_d);
+
     } catch (std::exception& e) {
         log_error(e.what());
     }
@@ -1002,43 +1193,57 @@ void AssetServer::restoreAssets(const cxxtools::SerializationInfo& si, bool tryA
 
     buildRestoreTree(assetsToRestore);
 
+    // the activation is the licensing check: the activator counts the whole batch, or one asset after the
+    // other when it has no batch commands, while checks made before activating would not see each other
+    std::vector<AssetImpl*> toActivate;
     for (AssetImpl& a : assetsToRestore) {
         log_debug("Restoring asset %s...", a.getInternalName().c_str());
 
         try {
-            bool requestActivation = (a.getAssetStatus() == AssetStatus::Active);
-
-            if (requestActivation && !a.isActivable()) {
-                if (tryActivate) {
-                    a.setAssetStatus(fty::AssetStatus::Nonactive);
-                    requestActivation = false;
-                } else {
-                    throw std::runtime_error(
-                        "Licensing limitation hit - maximum amount of active power devices allowed in "
-                        "license reached.");
-                }
-            }
-
             // restore asset to db
             a.restore();
 
-            // activate asset
-            if (requestActivation) {
-                try {
-                    a.activate();
-                } catch (std::exception& e) {
-                    // if activation fails, delete asset
-                    AssetImpl::deleteList({a.getInternalName()}, false);
-                    throw std::runtime_error(e.what());
-                }
+            if (a.getAssetStatus() == AssetStatus::Active) {
+                toActivate.push_back(&a);
             }
         } catch (std::exception& e) {
             log_error(e.what());
         }
     }
 
+    // activate assets
+    std::set<AssetImpl*>     deleted;
+    std::vector<std::string> activated = AssetImpl::activateBatch(toActivate);
+    for (size_t i = 0; i < toActivate.size(); ++i) {
+        if (activated[i].empty()) {
+            continue;
+        }
+
+        AssetImpl& a = *toActivate[i];
+        if (tryActivate) {
+            // the asset is kept as nonactive, the update below stores the status
+            log_warning("Asset %s restored as nonactive: %s", a.getInternalName().c_str(), activated[i].c_str());
+            a.setAssetStatus(fty::AssetStatus::Nonactive);
+            continue;
+        }
+
+        // if activation fails, delete asset
+        log_error("Licensing limitation hit - maximum amount of active power devices allowed in license reached, "
+                  "asset %s is not restored: %s",
+            a.getInternalName().c_str(), activated[i].c_str());
+        try {
+            AssetImpl::deleteList({a.getInternalName()}, false);
+        } catch (std::exception& e) {
+            log_error(e.what());
+        }
+        deleted.insert(&a);
+    }
+
     // restore links
     for (AssetImpl& a : assetsToRestore) {
+        if (deleted.count(&a)) {
+            continue;
+        }
         try {
             // save links
             a.update();
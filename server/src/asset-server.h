@@ -22,6 +22,7 @@
 #pragma once
 #include "asset/asset.h"
 #include <fty_srr_dto.h>
+#include <functional>
 #include <memory>
 #include <mutex>
 
@@ -34,32 +35,45 @@ static constexpr const char* FTY_ASSET_SUBJECT_DELETE_LIST = "DELETE_LIST";
 static constexpr const char* FTY_ASSET_SUBJECT_GET         = "GET";
 static constexpr const char* FTY_ASSET_SUBJECT_GET_BY_UUID = "GET_BY_UUID";
 static constexpr const char* FTY_ASSET_SUBJECT_LIST        = "LIST";
+static constexpr const char* FTY_ASSET_SUBJECT_QUERY       = "QUERY";
+// inames changed/deleted after a sequence number, for clients that missed notifications
+static constexpr const char* FTY_ASSET_SUBJECT_CHANGES_SINCE = "CHANGES_SINCE";
 static constexpr const char* FTY_ASSET_SUBJECT_GET_ID      = "GET_ID";
 static constexpr const char* FTY_ASSET_SUBJECT_GET_INAME   = "GET_INAME";
 static constexpr const char* FTY_ASSET_SUBJECT_STATUS_UPD  = "STATUS_UPDATE";
 static constexpr const char* FTY_ASSET_SUBJECT_NOTIFY      = "NOTIFY";
+// latency percentiles and byte counters per subject and storage call, as JSON
+static constexpr const char* FTY_ASSET_SUBJECT_STATS       = "STATS";
 
 // new interface topics
 static constexpr const char* FTY_ASSET_TOPIC_CREATED   = "FTY.T.ASSET.CREATED";
 static constexpr const char* FTY_ASSET_TOPIC_CREATED_L = "FTY.T.ASSET_LIGHT.CREATED";
 static constexpr const char* FTY_ASSET_TOPIC_UPDATED   = "FTY.T.ASSET.UPDATED";
 static constexpr const char* FTY_ASSET_TOPIC_UPDATED_L = "FTY.T.ASSET_LIGHT.UPDATED";
+// only the changed fields, for subscribers which do not need full before/after assets
+static constexpr const char* FTY_ASSET_TOPIC_UPDATED_DELTA = "FTY.T.ASSET.UPDATED_DELTA";
 static constexpr const char* FTY_ASSET_TOPIC_DELETED   = "FTY.T.ASSET.DELETED";
 static constexpr const char* FTY_ASSET_TOPIC_DELETED_L = "FTY.T.ASSET_LIGHT.DELETED";
+static constexpr const char* FTY_ASSET_TOPIC_DELETED_LIST = "FTY.T.ASSET.DELETED_LIST";
 
 // new interface topic subjects
 static constexpr const char* FTY_ASSET_SUBJECT_CREATED   = "CREATED";
 static constexpr const char* FTY_ASSET_SUBJECT_CREATED_L = "CREATED_LIGHT";
 static constexpr const char* FTY_ASSET_SUBJECT_UPDATED   = "UPDATED";
 static constexpr const char* FTY_ASSET_SUBJECT_UPDATED_L = "UPDATED_LIGHT";
+static constexpr const char* FTY_ASSET_SUBJECT_UPDATED_DELTA = "UPDATED_DELTA";
 static constexpr const char* FTY_ASSET_SUBJECT_DELETED   = "DELETED";
 static constexpr const char* FTY_ASSET_SUBJECT_DELETED_L = "DELETED_LIGHT";
+// one frame per deleted asset, sent in addition to DELETED/DELETED_LIGHT when requested with BULK_NOTIFY
+static constexpr const char* FTY_ASSET_SUBJECT_DELETED_LIST = "DELETED_LIST";
+static constexpr const size_t FTY_ASSET_DELETED_LIST_MAX    = 256; // assets per message
 
 
 static constexpr const char* METADATA_TRY_ACTIVATE      = "TRY_ACTIVATE";
 static constexpr const char* METADATA_NO_ERROR_IF_EXIST = "NO_ERROR_IF_EXIST";
 static constexpr const char* METADATA_ID_ONLY           = "ID_ONLY";
 static constexpr const char* METADATA_WITH_PARENTS_LIST = "WITH_PARENTS_LIST";
+static constexpr const char* METADATA_BULK_NOTIFY       = "BULK_NOTIFY";
 
 // SRR
 static constexpr const char* SRR_ACTIVE_VERSION  = "1.0";
@@ -79,6 +93,9 @@ class AssetServer
 {
 public:
     using MsgBusPtr = std::unique_ptr<messagebus::MessageBus>;
+    /// creates the bus clients of the agent, same signature as messagebus::MlmMessageBus
+    using MsgBusFactory =
+        std::function<messagebus::MessageBus*(const std::string& endpoint, const std::string& clientName)>;
 
     AssetServer();
     ~AssetServer() = default;
@@ -174,6 +191,12 @@ public:
         m_srrAgentName = agentName;
     }
 
+    /// bus of the mailbox, publisher and SRR clients created afterwards, e.g. fty::LocalBroker in benchmarks
+    void setMessageBusFactory(const MsgBusFactory& factory)
+    {
+        m_msgBusFactory = factory;
+    }
+
     void createMailboxClientNg();
     void resetMailboxClientNg();
     void connectMailboxClientNg();
@@ -185,28 +208,36 @@ public:
 
     // notifications
     void sendNotification(const messagebus::Message&) const;
+    /// same, CREATED/UPDATED build the legacy ASSETS stream message from asset instead of the database
+    void sendNotification(const messagebus::Message&, const Asset& asset) const;
+    /// UPDATED, UPDATED_LIGHT and UPDATED_DELTA, nothing at all if the asset did not change
+    void notifyAssetUpdate(const Asset& before, const Asset& after) const;
+    /// DELETED and DELETED_LIGHT of each asset deleted OK, and DELETED_LIST chunks of them if bulk
+    void notifyDeleted(const DeleteStatus& deleted, bool bulk) const;
 
     // SRR
     void initSrr(const std::string& queue);
     void resetSrrClient();
 
+    cxxtools::SerializationInfo saveAssets(bool saveVirtualAssets = false);
+    void                        restoreAssets(const cxxtools::SerializationInfo& si, bool tryActivate = true);
+
 private:
     void createAsset(const messagebus::Message& msg);
     void updateAsset(const messagebus::Message& msg);
     void deleteAsset(const messagebus::Message& msg);
     void getAsset(const messagebus::Message& msg, bool getFromUuid = false);
     void listAsset(const messagebus::Message& msg);
+    void queryAsset(const messagebus::Message& msg);
+    void changesSince(const messagebus::Message& msg);
     void getAssetID(const messagebus::Message& msg);
     void getAssetIname(const messagebus::Message& msg);
     void notifyStatusUpdate(const messagebus::Message& msg);
     void notifyAsset(const messagebus::Message& msg);
+    void getStats(const messagebus::Message& msg);
 
-    // notifications
-    void notifyAssetUpdate(const Asset& before, const Asset& after);
-
-    // SRR
-    cxxtools::SerializationInfo saveAssets(bool saveVirtualAssets = false);
-    void                        restoreAssets(const cxxtools::SerializationInfo& si, bool tryActivate = true);
+    /// reply on the mailbox, counted in the statistics of the subject
+    void sendReply(const std::string& queue, const messagebus::Message& reply);
 
 private:
     static void destroyMlmClient(mlm_client_t* client);
@@ -225,14 +256,17 @@ private:
     MlmClientPtr m_streamClient;
 
     // new generation interface
-    std::string m_agentNameNg = "asset-agent-ng";
-    MsgBusPtr   m_assetMsgQueue;
-    MsgBusPtr   m_publisherCreate;
-    MsgBusPtr   m_publisherCreateLight;
-    MsgBusPtr   m_publisherUpdate;
-    MsgBusPtr   m_publisherUpdateLight;
-    MsgBusPtr   m_publisherDelete;
-    MsgBusPtr   m_publisherDeleteLight;
+    std::string   m_agentNameNg = "asset-agent-ng";
+    MsgBusFactory m_msgBusFactory;
+    MsgBusPtr     m_assetMsgQueue;
+    MsgBusPtr     m_publisherCreate;
+    MsgBusPtr     m_publisherCreateLight;
+    MsgBusPtr     m_publisherUpdate;
+    MsgBusPtr     m_publisherUpdateLight;
+    MsgBusPtr     m_publisherUpdateDelta;
+    MsgBusPtr     m_publisherDelete;
+    MsgBusPtr     m_publisherDeleteLight;
+    MsgBusPtr     m_publisherDeleteList;
 
     // topic handlers
     void handleAssetManipulationReq(const messagebus::Message& msg);
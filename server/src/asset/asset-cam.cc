@@ -23,6 +23,7 @@
 #include <fty_asset_dto.h>
 #include <fty_log.h>
 #include <fty_security_wallet.h>
+#include <memory>
 
 std::list<CredentialMapping> getCredentialMappings(const ExtMap& extMap)
 {
@@ -81,3 +82,40 @@ void deleteMappings(const std::string& assetInternalName)
         log_error("Asset mappings could not be removed: %s", e.what());
     }
 }
+
+void deleteMappings(const std::vector<std::string>& assetInternalNames)
+{
+    if (assetInternalNames.empty()) {
+        return;
+    }
+
+    std::unique_ptr<cam::Accessor> camAccessor;
+    try {
+        camAccessor.reset(new cam::Accessor(CAM_CLIENT_ID, CAM_TIMEOUT_MS, MALAMUTE_ENDPOINT));
+    } catch (std::exception& e) {
+        log_error("Asset mappings could not be removed: %s", e.what());
+        return;
+    }
+
+    // collect all mappings first, then remove them back to back on the same session
+    std::vector<cam::CredentialAssetMapping> mappings;
+    for (const auto& iname : assetInternalNames) {
+        try {
+            auto assetMappings = camAccessor->getAssetMappings(iname);
+            mappings.insert(mappings.end(), assetMappings.begin(), assetMappings.end());
+        } catch (std::exception& e) {
+            log_error("Asset mappings of %s could not be read: %s", iname.c_str(), e.what());
+        }
+    }
+
+    log_debug("Deleting %zu mappings of %zu assets", mappings.size(), assetInternalNames.size());
+
+    for (const auto& m : mappings) {
+        try {
+            camAccessor->removeMapping(m.m_assetId, m.m_serviceId, m.m_protocol);
+        } catch (std::exception& e) {
+            log_error("Asset mapping %s : %s of %s could not be removed: %s", m.m_serviceId.c_str(),
+                m.m_protocol.c_str(), m.m_assetId.c_str(), e.what());
+        }
+    }
+}
@@ -3,6 +3,7 @@
 #include <list>
 #include <map>
 #include <string>
+#include <vector>
 
 namespace fty {
     class ExtMapElement;
@@ -30,3 +31,5 @@ using ExtMap = std::map<std::string, fty::ExtMapElement>;
 std::list<CredentialMapping> getCredentialMappings(const ExtMap& extMap);
 void createMappings(const std::string& assetInternalName, const std::list<CredentialMapping>& credentialList);
 void deleteMappings(const std::string& assetInternalName);
+// one CAM session for the whole list
+void deleteMappings(const std::vector<std::string>& assetInternalNames);
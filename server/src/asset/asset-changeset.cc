@@ -0,0 +1,127 @@
+/*  =========================================================================
+    asset_asset_changeset - asset/asset-changeset
+
+    Copyright (C) 2016 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    asset_asset_changeset - asset/asset-changeset
+@discuss
+@end
+*/
+
+#include "asset-changeset.h"
+#include <algorithm>
+
+namespace fty {
+
+std::string linkKey(const AssetLink& link)
+{
+    std::string key;
+    key.reserve(link.sourceId().size() + link.srcOut().size() + link.destIn().size() + 8);
+    key.append(link.sourceId()).push_back('\0');
+    key.append(link.srcOut()).push_back('\0');
+    key.append(link.destIn()).push_back('\0');
+    key.append(std::to_string(link.linkType()));
+    return key;
+}
+
+bool AssetChangeSet::empty() const
+{
+    return !m_elementChanged && m_extUpserts.empty() && m_extRemovals.empty() && m_linkInserts.empty() &&
+           m_linkRemovals.empty();
+}
+
+void AssetChangeSet::diffElement(const Asset& stored, const Asset& asset)
+{
+    m_elementChanged = stored.getParentIname() != asset.getParentIname() ||
+                       stored.getAssetStatus() != asset.getAssetStatus() ||
+                       stored.getPriority() != asset.getPriority() || stored.getAssetTag() != asset.getAssetTag() ||
+                       stored.getSecondaryID() != asset.getSecondaryID();
+}
+
+void AssetChangeSet::diffExt(const StoredExtMap& stored, const Asset::ExtMap& ext)
+{
+    for (const auto& it : ext) {
+        // skip the none updated attribute
+        if (!it.second.wasUpdated()) {
+            continue;
+        }
+
+        auto found = stored.find(it.first);
+
+        if (it.second.getValue().empty()) {
+            // an empty value removes the attribute, if it exists
+            if (found != stored.end()) {
+                m_extRemovals.push_back(it.first);
+            }
+        } else if (found == stored.end() || found->second != it.second) {
+            m_extUpserts.push_back({it.first, it.second.getValue(), it.second.isReadOnly()});
+        }
+    }
+}
+
+void AssetChangeSet::diffLinks(const std::vector<StoredLink>& stored, const std::vector<AssetLink>& links)
+{
+    // index stored links, same link may be stored more than once
+    std::unordered_map<std::string, std::vector<size_t>> index;
+    index.reserve(stored.size());
+    for (size_t i = 0; i < stored.size(); ++i) {
+        index[linkKey(stored[i].link)].push_back(i);
+    }
+
+    std::vector<bool> required(stored.size(), false);
+
+    for (const auto& l : links) {
+        auto found = index.find(linkKey(l));
+
+        if (found != index.end() && !found->second.empty()) {
+            // link is required, do not remove
+            required[found->second.back()] = true;
+            found->second.pop_back();
+        } else {
+            m_linkInserts.push_back(l);
+        }
+    }
+
+    // remove links not present in DTO
+    for (size_t i = 0; i < stored.size(); ++i) {
+        if (!required[i]) {
+            m_linkRemovals.push_back(stored[i].id);
+        }
+    }
+}
+
+void AssetChangeSet::upsertExt(const std::string& key, const std::string& value, bool readOnly)
+{
+    m_extRemovals.erase(std::remove(m_extRemovals.begin(), m_extRemovals.end(), key), m_extRemovals.end());
+
+    auto found = std::find_if(m_extUpserts.begin(), m_extUpserts.end(), [&](const ExtChange& c) {
+        return c.key == key;
+    });
+
+    if (found != m_extUpserts.end()) {
+        found->value    = value;
+        found->readOnly = readOnly;
+    } else {
+        m_extUpserts.push_back({key, value, readOnly});
+    }
+}
+
+} // namespace fty
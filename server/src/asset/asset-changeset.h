@@ -0,0 +1,101 @@
+/*  =========================================================================
+    asset_asset_changeset - asset/asset-changeset
+
+    Copyright (C) 2016 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+#include "fty_asset_dto.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fty {
+
+/// ext attributes as currently stored, indexed by keytag
+using StoredExtMap = std::unordered_map<std::string, ExtMapElement>;
+
+/// link as currently stored, with its database index
+struct StoredLink
+{
+    uint32_t  id = 0;
+    AssetLink link;
+};
+
+/// Set of modifications needed to bring the stored state of an asset to the state of an Asset DTO.
+///
+/// The diff only follows the existing save strategy:
+/// - element row is written if any of parent, status, priority, tag or secondary ID differs
+/// - only ext attributes flagged as updated are considered, an empty value removes the attribute
+/// - links not present in the DTO are removed, links not present in the storage are added
+class AssetChangeSet
+{
+public:
+    struct ExtChange
+    {
+        std::string key;
+        std::string value;
+        bool        readOnly = false;
+    };
+
+    bool empty() const;
+
+    bool elementChanged() const
+    {
+        return m_elementChanged;
+    }
+
+    const std::vector<ExtChange>& extUpserts() const
+    {
+        return m_extUpserts;
+    }
+
+    const std::vector<std::string>& extRemovals() const
+    {
+        return m_extRemovals;
+    }
+
+    const std::vector<AssetLink>& linkInserts() const
+    {
+        return m_linkInserts;
+    }
+
+    const std::vector<uint32_t>& linkRemovals() const
+    {
+        return m_linkRemovals;
+    }
+
+    void diffElement(const Asset& stored, const Asset& asset);
+    void diffExt(const StoredExtMap& stored, const Asset::ExtMap& ext);
+    void diffLinks(const std::vector<StoredLink>& stored, const std::vector<AssetLink>& links);
+
+    /// force an ext attribute upsert (e.g. update timestamp), replaces any pending change on the same key
+    void upsertExt(const std::string& key, const std::string& value, bool readOnly);
+
+private:
+    bool                     m_elementChanged = false;
+    std::vector<ExtChange>   m_extUpserts;
+    std::vector<std::string> m_extRemovals;
+    std::vector<AssetLink>   m_linkInserts;
+    std::vector<uint32_t>    m_linkRemovals;
+};
+
+/// key used to index links in hashed lookups (source, src_out, dest_in and link type)
+std::string linkKey(const AssetLink& link);
+
+} // namespace fty
@@ -86,6 +86,38 @@ bool DBTest::isLastDataCenter(Asset& asset)
     return asset.getInternalName() == "dc-0";
 }
 
+AssetHierarchy DBTest::loadHierarchy()
+{
+    std::cout << "DBTest::loadHierarchy" << std::endl;
+    return {};
+}
+
+void DBTest::loadAssets(const std::map<uint32_t, Asset*>& assets)
+{
+    std::cout << "DBTest::loadAssets of " << assets.size() << " assets" << std::endl;
+    for (const auto& it : assets) {
+        loadAsset(it.second->getInternalName(), *it.second);
+        loadExtMap(*it.second);
+        loadLinkedAssets(*it.second);
+    }
+}
+
+std::set<uint32_t> DBTest::linkSources(const std::vector<uint32_t>& ids)
+{
+    std::cout << "DBTest::linkSources of " << ids.size() << " assets" << std::endl;
+    return {};
+}
+
+void DBTest::unlinkList(const std::vector<uint32_t>& ids)
+{
+    std::cout << "DBTest::unlinkList of " << ids.size() << " assets" << std::endl;
+}
+
+void DBTest::removeList(const std::vector<std::vector<uint32_t>>& byDepth)
+{
+    std::cout << "DBTest::removeList in " << byDepth.size() << " levels" << std::endl;
+}
+
 void DBTest::removeFromGroups(Asset& /*asset*/)
 {
     std::cout << "DBTest::removeFromGroups" << std::endl;
@@ -183,6 +215,38 @@ std::string DBTest::inameByUuid(const std::string& /*uuid*/)
     return "DC-1";
 }
 
+AssetChangeSet DBTest::computeChanges(const Asset& asset)
+{
+    std::cout << "DBTest::computeChanges" << std::endl;
+
+    Asset stored;
+    loadAsset(asset.getInternalName(), stored);
+    loadExtMap(stored);
+    loadLinkedAssets(stored);
+
+    StoredExtMap storedExt(stored.getExt().begin(), stored.getExt().end());
+
+    std::vector<StoredLink> storedLinks;
+    for (const auto& l : stored.getLinkedAssets()) {
+        storedLinks.push_back({static_cast<uint32_t>(storedLinks.size() + 1), l});
+    }
+
+    AssetChangeSet changes;
+    changes.diffElement(stored, asset);
+    changes.diffExt(storedExt, asset.getExt());
+    changes.diffLinks(storedLinks, asset.getLinkedAssets());
+
+    return changes;
+}
+
+void DBTest::applyChanges(Asset& /*asset*/, const AssetChangeSet& changes)
+{
+    std::cout << "DBTest::applyChanges (element: " << changes.elementChanged()
+              << ", ext upserts: " << changes.extUpserts().size() << ", ext removals: " << changes.extRemovals().size()
+              << ", link inserts: " << changes.linkInserts().size()
+              << ", link removals: " << changes.linkRemovals().size() << ")" << std::endl;
+}
+
 void DBTest::saveLinkedAssets(Asset& /*asset*/)
 {
     std::cout << "DBTest::saveLinkedAssets" << std::endl;
@@ -225,4 +289,22 @@ std::vector<std::string> DBTest::listAllAssets()
     return assetList;
 }
 
+std::vector<std::string> DBTest::queryAssets(const AssetQuery& query)
+{
+    std::cout << "DBTest::queryAssets" << std::endl;
+
+    for (const auto& p : query) {
+        std::cout << "Field: " << p.field << std::endl;
+        for (const auto& s : p.values) {
+            std::cout << "\tValue: " << s << std::endl;
+        }
+    }
+
+    std::vector<std::string> assetList;
+
+    assetList.push_back("asset-1");
+
+    return assetList;
+}
+
 } // namespace fty
@@ -56,6 +56,12 @@ public:
     void removeExtMap(Asset& asset) override;
     bool isLastDataCenter(Asset& asset) override;
 
+    AssetHierarchy     loadHierarchy() override;
+    void               loadAssets(const std::map<uint32_t, Asset*>& assets) override;
+    std::set<uint32_t> linkSources(const std::vector<uint32_t>& ids) override;
+    void               unlinkList(const std::vector<uint32_t>& ids) override;
+    void               removeList(const std::vector<std::vector<uint32_t>>& byDepth) override;
+
     void beginTransaction() override;
     void rollbackTransaction() override;
     void commitTransaction() override;
@@ -63,6 +69,9 @@ public:
     void update(Asset& asset) override;
     void insert(Asset& asset) override;
 
+    AssetChangeSet computeChanges(const Asset& asset) override;
+    void           applyChanges(Asset& asset, const AssetChangeSet& changes) override;
+
     void        saveLinkedAssets(Asset& asset) override;
     void        saveExtMap(Asset& asset) override;
     std::string inameById(uint32_t id) override;
@@ -70,6 +79,7 @@ public:
 
     std::vector<std::string> listAssets(std::map<std::string, std::vector<std::string>> filters) override;
     std::vector<std::string> listAllAssets() override;
+    std::vector<std::string> queryAssets(const AssetQuery& query) override;
 
 private:
     DBTest();
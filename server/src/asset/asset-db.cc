@@ -21,14 +21,20 @@
 
 #include "asset-db.h"
 #include "asset.h"
+#include "change_journal.h"
+#include "containment_index.h"
 #include <cstdlib>
+#include <fty_asset_stats.h>
 #include <fty_common_db_dbpath.h>
 #include <sstream>
 #include <tntdb.h>
 #include <map>
 #include <algorithm>
+#include <tuple>
+#include <unordered_map>
 
 #include <cassert>
+#include <chrono>
 
 #include "fty-lock.h"
 namespace fty {
@@ -41,19 +47,28 @@ DB::DB()
     // m_conn = tntdb::connectCached(DBConn::url);
 }
 
-DB& DB::getInstance()
+DB& DB::instance()
 {
     static DB m_instance;
+    return m_instance;
+}
+
+DB& DB::getInstance()
+{
+    DB& db = instance();
 
     // fetches connection from pool, if exists
     // creates a new connection otherwise
-    m_instance.m_conn = tntdb::connectCached(DBConn::url);
+    db.m_conn = tntdb::connectCached(DBConn::url);
 
-    return m_instance;
+    return db;
 }
 
 void DB::loadAsset(const std::string& nameId, Asset& asset)
 {
+    static auto&            stat = fty::stats::metric("db.loadAsset");
+    fty::stats::ScopedTimer timer(stat.latency);
+
     tntdb::Row row;
 
     // clang-format off
@@ -106,6 +121,9 @@ void DB::loadAsset(const std::string& nameId, Asset& asset)
 
 void DB::loadExtMap(Asset& asset)
 {
+    static auto&            stat = fty::stats::metric("db.loadExtMap");
+    fty::stats::ScopedTimer timer(stat.latency);
+
     auto assetID = getID(asset.getInternalName());
     if(!assetID) {
         throw std::runtime_error(assetID.error());
@@ -145,6 +163,9 @@ void DB::loadExtMap(Asset& asset)
 
 std::vector<std::string> DB::getChildren(const Asset& asset)
 {
+    static auto&            stat = fty::stats::metric("db.getChildren");
+    fty::stats::ScopedTimer timer(stat.latency);
+
     auto assetID = getID(asset.getInternalName());
     if(!assetID) {
         throw std::runtime_error(assetID.error());
@@ -184,6 +205,9 @@ std::vector<std::string> DB::getChildren(const Asset& asset)
 // returns fty::unexpected if internal name is not found, the integer ID otherwise
 fty::Expected<uint32_t> DB::getID(const std::string& internalName)
 {
+    static auto&            stat = fty::stats::metric("db.getID");
+    fty::stats::ScopedTimer timer(stat.latency);
+
     // clang-format off
     auto q = m_conn.prepareCached(R"(
         SELECT
@@ -315,7 +339,7 @@ uint32_t DB::getLinkID(const uint32_t destId, const AssetLink& l)
 
     assert(destId);
 
-    tntdb::Statement q;
+    TracedStatement q;
 
     std::stringstream qs;
 
@@ -556,6 +580,9 @@ void DB::saveLinkExtMap(const uint32_t linkID, const AssetLink& link)
 
 void DB::loadLinkedAssets(Asset& asset)
 {
+    static auto&            stat = fty::stats::metric("db.loadLinkedAssets");
+    fty::stats::ScopedTimer timer(stat.latency);
+
     auto assetID = getID(asset.getInternalName());
     if(!assetID) {
         throw std::runtime_error(assetID.error());
@@ -610,18 +637,12 @@ void DB::loadLinkedAssets(Asset& asset)
     asset.setLinkedAssets(links);
 }
 
-void DB::saveLinkedAssets(Asset& asset)
+std::vector<StoredLink> DB::loadStoredLinks(uint32_t assetId)
 {
-    auto assetID = getID(asset.getInternalName());
-
-    if (!assetID) {
-        throw std::runtime_error(assetID.error());
-    }
-
     // clang-format off
     auto q = m_conn.prepareCached(R"(
         SELECT
-            e.id_asset_element   AS srcId,
+            l.id_link            AS linkId,
             e.name               AS srcName,
             l.src_out            AS srcOut,
             l.dest_in            AS destIn,
@@ -634,7 +655,7 @@ void DB::saveLinkedAssets(Asset& asset)
              id_asset_device_dest = :assetId
     )");
     // clang-format on
-    q.set("assetId", *assetID);
+    q.set("assetId", assetId);
 
     tntdb::Result res;
     try {
@@ -646,10 +667,8 @@ void DB::saveLinkedAssets(Asset& asset)
         throw std::runtime_error("database error - " + std::string(e.what()));
     }
 
-    using Existing = std::pair<uint32_t, AssetLink>;
-
-    // get existings links from database
-    std::vector<Existing> toRemove;
+    std::vector<StoredLink> stored;
+    stored.reserve(res.size());
     for (const auto& row : res) {
         std::string tmpOut, tmpIn;
 
@@ -661,33 +680,179 @@ void DB::saveLinkedAssets(Asset& asset)
             row.getString("destIn", tmpIn);
         }
 
-        toRemove.emplace_back(row.getUnsigned32("srcId"),
-            AssetLink(row.getString("srcName"), tmpOut, tmpIn, row.getInt("linkType")));
+        stored.push_back(
+            {row.getUnsigned32("linkId"), AssetLink(row.getString("srcName"), tmpOut, tmpIn, row.getInt("linkType"))});
     }
 
-    // add new links
-    for (const AssetLink l : asset.getLinkedAssets()) {
-        // delete link from the list of links to remove
-        auto found = std::find_if(toRemove.begin(), toRemove.end(), [&](const Existing& e) {
-            return e.second == l;
-        });
+    return stored;
+}
 
-        if (found != toRemove.end()) {
-            // link is required, do not remove
-            toRemove.erase(found);
-        } else {
-            // save new link
-            saveLink(*assetID, l);
+void DB::applyLinkChanges(uint32_t assetId, const AssetChangeSet& changes)
+{
+    assert(assetId);
+
+    const auto& toRemove = changes.linkRemovals();
+    const auto& toInsert = changes.linkInserts();
+
+    if (!toRemove.empty()) {
+        std::stringstream ids;
+        for (size_t i = 0; i < toRemove.size(); ++i) {
+            ids << (i ? ", " : "") << ":id" << i;
+        }
+
+        // variable arity, do not pollute the statement cache
+        auto q_ext_attrib =
+            m_conn.prepare("DELETE FROM t_bios_asset_link_attributes WHERE id_link IN (" + ids.str() + ")");
+        auto q_link = m_conn.prepare("DELETE FROM t_bios_asset_link WHERE id_link IN (" + ids.str() + ")");
+
+        for (size_t i = 0; i < toRemove.size(); ++i) {
+            q_ext_attrib.set("id" + std::to_string(i), toRemove[i]);
+            q_link.set("id" + std::to_string(i), toRemove[i]);
+        }
+
+        try {
+            Lock lock(m_conn_lock);
+            q_ext_attrib.execute();
+            q_link.execute();
+
+        } catch (std::exception& e) {
+
+            throw std::runtime_error("database error - " + std::string(e.what()));
+        }
+    }
+
+    if (toInsert.empty()) {
+        return;
+    }
+
+    // resolve all link sources at once
+    std::unordered_map<std::string, uint32_t> srcIds;
+    {
+        std::vector<std::string> names;
+        for (const auto& l : toInsert) {
+            if (srcIds.emplace(l.sourceId(), 0).second) {
+                names.push_back(l.sourceId());
+            }
+        }
+
+        std::stringstream qs;
+        qs << "SELECT id_asset_element AS id, name AS name FROM t_bios_asset_element WHERE name IN (";
+        for (size_t i = 0; i < names.size(); ++i) {
+            qs << (i ? ", " : "") << ":name" << i;
+        }
+        qs << ")";
+
+        auto q = m_conn.prepare(qs.str());
+        for (size_t i = 0; i < names.size(); ++i) {
+            q.set("name" + std::to_string(i), names[i]);
+        }
+
+        try {
+            Lock lock(m_conn_lock);
+            for (const auto& row : q.select()) {
+                srcIds[row.getString("name")] = row.getUnsigned32("id");
+            }
+
+        } catch (std::exception& e) {
+
+            throw std::runtime_error("database error - " + std::string(e.what()));
+        }
+
+        for (const auto& name : names) {
+            if (srcIds[name] == 0) {
+                throw std::runtime_error("Internal name " + name + " not found");
+            }
         }
     }
 
-    // remove links not present in DTO
-    for (const auto& entry : toRemove) {
-        const AssetLink& l = entry.second;
+    std::stringstream qs;
+    qs << "INSERT INTO t_bios_asset_link"
+          " (id_asset_device_src, src_out, id_asset_device_dest, dest_in, id_asset_link_type) VALUES ";
+    for (size_t i = 0; i < toInsert.size(); ++i) {
+        qs << (i ? ", " : "") << "(:src" << i << ", :srcOut" << i << ", :dest, :destIn" << i << ", :linkType" << i
+           << ")";
+    }
+
+    auto q = m_conn.prepare(qs.str());
+    q.set("dest", assetId);
+    for (size_t i = 0; i < toInsert.size(); ++i) {
+        const auto& l   = toInsert[i];
+        std::string idx = std::to_string(i);
+
+        q.set("src" + idx, srcIds[l.sourceId()]);
+        l.srcOut().empty() ? q.setNull("srcOut" + idx) : q.set("srcOut" + idx, l.srcOut());
+        l.destIn().empty() ? q.setNull("destIn" + idx) : q.set("destIn" + idx, l.destIn());
+        q.set("linkType" + idx, l.linkType());
+    }
+
+    try {
+        Lock lock(m_conn_lock);
+        q.execute();
+
+    } catch (std::exception& e) {
+
+        throw std::runtime_error("database error - " + std::string(e.what()));
+    }
+
+    // link attributes of the new links, all links at once
+    std::vector<std::tuple<uint32_t, std::string, const ExtMapElement*>> attributes;
+    for (const auto& l : toInsert) {
+        if (l.ext().empty()) {
+            continue;
+        }
+        uint32_t linkId = getLinkID(assetId, l);
+        if (linkId == 0) {
+            throw std::runtime_error("Link from " + l.sourceId() + " not found");
+        }
+        for (const auto& it : l.ext()) {
+            if (it.second.wasUpdated() && !it.second.getValue().empty()) {
+                attributes.emplace_back(linkId, it.first, &it.second);
+            }
+        }
+    }
+
+    if (attributes.empty()) {
+        return;
+    }
+
+    std::stringstream qa;
+    qa << "INSERT INTO t_bios_asset_link_attributes (keytag, value, id_link, read_only) VALUES ";
+    for (size_t i = 0; i < attributes.size(); ++i) {
+        qa << (i ? ", " : "") << "(:key" << i << ", :value" << i << ", :linkId" << i << ", :readOnly" << i << ")";
+    }
+
+    auto q_ext_link = m_conn.prepare(qa.str());
+    for (size_t i = 0; i < attributes.size(); ++i) {
+        std::string idx = std::to_string(i);
+
+        q_ext_link.set("key" + idx, std::get<1>(attributes[i]));
+        q_ext_link.set("value" + idx, std::get<2>(attributes[i])->getValue());
+        q_ext_link.set("linkId" + idx, std::get<0>(attributes[i]));
+        q_ext_link.set("readOnly" + idx, std::get<2>(attributes[i])->isReadOnly());
+    }
+
+    try {
+        Lock lock(m_conn_lock);
+        q_ext_link.execute();
+
+    } catch (std::exception& e) {
+
+        throw std::runtime_error("database error - " + std::string(e.what()));
+    }
+}
+
+void DB::saveLinkedAssets(Asset& asset)
+{
+    auto assetID = getID(asset.getInternalName());
 
-        // remove all remaining links
-        removeLink(*assetID, l);
+    if (!assetID) {
+        throw std::runtime_error(assetID.error());
     }
+
+    AssetChangeSet changes;
+    changes.diffLinks(loadStoredLinks(*assetID), asset.getLinkedAssets());
+
+    applyLinkChanges(*assetID, changes);
 }
 
 bool DB::hasLinkedAssets(const Asset& asset)
@@ -870,134 +1035,240 @@ bool DB::isLastDataCenter(Asset& asset)
     return numDatacentersAfterDelete == 0;
 }
 
-void DB::removeFromGroups(Asset& asset)
+// builds a list of named placeholders ":<prefix>0, :<prefix>1, ..."
+static std::string placeholders(const std::string& prefix, size_t count)
 {
-    auto assetID = getID(asset.getInternalName());
-    if(!assetID) {
-        throw std::runtime_error(assetID.error());
+    std::stringstream qs;
+    for (size_t i = 0; i < count; ++i) {
+        qs << (i ? ", " : "") << ":" << prefix << i;
+    }
+    return qs.str();
+}
+
+static void bindIds(tntdb::Statement& q, const std::string& prefix, const std::vector<uint32_t>& ids)
+{
+    for (size_t i = 0; i < ids.size(); ++i) {
+        q.set(prefix + std::to_string(i), ids[i]);
     }
+}
+
+AssetHierarchy DB::loadHierarchy()
+{
+    static auto&            stat = fty::stats::metric("db.loadHierarchy");
+    fty::stats::ScopedTimer timer(stat.latency);
 
     // clang-format off
     auto q = m_conn.prepareCached(R"(
-        DELETE FROM
-            t_bios_asset_group_relation
-        WHERE
-            id_asset_element = :asset_id
+        SELECT
+            a.id_asset_element AS id,
+            a.name             AS name,
+            p.name             AS parentName,
+            t.name             AS type
+        FROM t_bios_asset_element AS a
+            INNER JOIN t_bios_asset_element_type AS t
+            ON a.id_type = t.id_asset_element_type
+            LEFT JOIN t_bios_asset_element AS p
+            ON a.id_parent = p.id_asset_element
     )");
     // clang-format on
-    q.set("asset_id", *assetID);
+
+    tntdb::Result res;
 
     try {
         Lock lock(m_conn_lock);
-        q.execute();
+        res = q.select();
 
     } catch (std::exception& e) {
 
         throw std::runtime_error("database error - " + std::string(e.what()));
     }
+
+    AssetHierarchy hierarchy;
+    hierarchy.reserve(res.size());
+    for (const auto& row : res) {
+        AssetNode node;
+        node.id   = row.getUnsigned32("id");
+        node.type = row.getString("type");
+        if (!row.isNull("parentName")) {
+            node.parent = row.getString("parentName");
+        }
+        hierarchy.emplace(row.getString("name"), std::move(node));
+    }
+
+    return hierarchy;
 }
 
-void DB::removeFromRelations(Asset& asset)
+void DB::loadAssets(const std::map<uint32_t, Asset*>& assets)
 {
-    auto assetID = getID(asset.getInternalName());
-    if(!assetID) {
-        throw std::runtime_error(assetID.error());
+    static auto&            stat = fty::stats::metric("db.loadAssets");
+    fty::stats::ScopedTimer timer(stat.latency);
+
+    if (assets.empty()) {
+        return;
     }
 
-    // clang-format off
-    auto q = m_conn.prepareCached(R"(
-        DELETE FROM
-            t_bios_monitor_asset_relation
-        WHERE
-            id_asset_element = :asset_id
-    )");
-    // clang-format on
-    q.set("asset_id", *assetID);
+    std::vector<uint32_t> ids;
+    ids.reserve(assets.size());
+    for (const auto& it : assets) {
+        ids.push_back(it.first);
+    }
+    const std::string in = placeholders("id", ids.size());
 
+    // variable arity, do not pollute the statement cache
+    auto q_asset = m_conn.prepare(R"(
+        SELECT
+            a.id_asset_element AS id,
+            a.name             AS name,
+            e.name             AS type,
+            d.name             AS subType,
+            p.name             AS parentName,
+            a.status           AS status,
+            a.priority         AS priority,
+            a.asset_tag        AS tag,
+            a.id_secondary     AS idSecondary
+        FROM t_bios_asset_element AS a
+            INNER JOIN t_bios_asset_device_type AS d
+            INNER JOIN t_bios_asset_element_type AS e
+            ON a.id_type = e.id_asset_element_type AND a.id_subtype = d.id_asset_device_type
+            LEFT JOIN t_bios_asset_element AS p
+            ON a.id_parent = p.id_asset_element
+        WHERE a.id_asset_element IN ()" + in + ")");
+    auto q_ext = m_conn.prepare("SELECT id_asset_element AS id, keytag, value, read_only"
+                                " FROM t_bios_asset_ext_attributes WHERE id_asset_element IN (" + in + ")");
+    auto q_link = m_conn.prepare(R"(
+        SELECT
+            l.id_link              AS linkId,
+            l.id_asset_device_dest AS id,
+            e.name                 AS name,
+            l.src_out              AS srcOut,
+            l.dest_in              AS destIn,
+            l.id_asset_link_type   AS linkType
+        FROM t_bios_asset_link AS l
+            INNER JOIN t_bios_asset_element AS e
+            ON l.id_asset_device_src = e.id_asset_element
+        WHERE l.id_asset_device_dest IN ()" + in + ")");
+    auto q_link_ext = m_conn.prepare("SELECT la.id_link AS linkId, la.keytag, la.value, la.read_only"
+                                     " FROM t_bios_asset_link_attributes AS la"
+                                     " INNER JOIN t_bios_asset_link AS l ON la.id_link = l.id_link"
+                                     " WHERE l.id_asset_device_dest IN (" + in + ")");
+    bindIds(q_asset, "id", ids);
+    bindIds(q_ext, "id", ids);
+    bindIds(q_link, "id", ids);
+    bindIds(q_link_ext, "id", ids);
+
+    tntdb::Result assetRes, extRes, linkRes, linkExtRes;
     try {
         Lock lock(m_conn_lock);
-        q.execute();
+        assetRes   = q_asset.select();
+        extRes     = q_ext.select();
+        linkRes    = q_link.select();
+        linkExtRes = q_link_ext.select();
 
     } catch (std::exception& e) {
 
-        throw std::runtime_error(std::string(e.what()));
+        throw std::runtime_error("database error - " + std::string(e.what()));
     }
-}
 
-void DB::removeAsset(Asset& asset)
-{
-    auto assetID = getID(asset.getInternalName());
-    if(!assetID) {
-        throw std::runtime_error(assetID.error());
+    for (const auto& row : assetRes) {
+        Asset& asset = *assets.at(row.getUnsigned32("id"));
+        asset.setInternalName(row.getString("name"));
+        asset.setAssetType(row.getString("type"));
+        asset.setAssetSubtype(row.getString("subType"));
+        if (!row.isNull("parentName")) {
+            asset.setParentIname(row.getString("parentName"));
+        }
+        asset.setAssetStatus(stringToAssetStatus(row.getString("status")));
+        asset.setPriority(row.getInt("priority"));
+        if (!row.isNull("tag")) {
+            asset.setAssetTag(row.getString("tag"));
+        }
+        if (!row.isNull("idSecondary")) {
+            asset.setSecondaryID(row.getString("idSecondary"));
+        }
+        asset.clearExtMap();
     }
 
-    // clang-format off
-    auto q = m_conn.prepareCached(R"(
-        DELETE FROM
-            t_bios_asset_element
-        WHERE
-            id_asset_element = :asset_id
-    )");
-    // clang-format on
-    q.set("asset_id", *assetID);
+    for (const auto& row : extRes) {
+        assets.at(row.getUnsigned32("id"))
+            ->setExtEntry(row.getString("keytag"), row.getString("value"), row.getBool("read_only"), true);
+    }
 
-    try {
-        Lock lock(m_conn_lock);
-        q.execute();
+    std::unordered_map<uint32_t, AssetLink::ExtMap> linkExt;
+    for (const auto& row : linkExtRes) {
+        linkExt[row.getUnsigned32("linkId")][row.getString("keytag")] =
+            ExtMapElement(row.getString("value"), row.getBool("read_only"), true);
+    }
 
-    } catch (std::exception& e) {
+    std::map<uint32_t, std::vector<AssetLink>> links;
+    for (const auto& row : linkRes) {
+        std::string srcOut, destIn;
+        // may be NULL
+        if (!row.isNull("srcOut")) {
+            row.getString("srcOut", srcOut);
+        }
+        if (!row.isNull("destIn")) {
+            row.getString("destIn", destIn);
+        }
 
-        throw std::runtime_error("database error - " + std::string(e.what()));
+        AssetLink l(row.getString("name"), srcOut, destIn, row.getInt("linkType"));
+        auto      ext = linkExt.find(row.getUnsigned32("linkId"));
+        if (ext != linkExt.end()) {
+            l.setExt(ext->second);
+        }
+        links[row.getUnsigned32("id")].push_back(l);
+    }
+    for (const auto& it : assets) {
+        auto found = links.find(it.first);
+        it.second->setLinkedAssets(found != links.end() ? found->second : std::vector<AssetLink>{});
     }
 }
 
-void DB::removeExtMap(Asset& asset)
+std::set<uint32_t> DB::linkSources(const std::vector<uint32_t>& ids)
 {
-    auto assetID = getID(asset.getInternalName());
-    if(!assetID) {
-        throw std::runtime_error(assetID.error());
+    std::set<uint32_t> sources;
+    if (ids.empty()) {
+        return sources;
     }
 
-    // clang-format off
-    auto q = m_conn.prepareCached(R"(
-        DELETE FROM
-            t_bios_asset_ext_attributes
-        WHERE
-            id_asset_element = :assetId
-    )");
-    // clang-format on
-    q.set("assetId", *assetID);
+    // variable arity, do not pollute the statement cache
+    auto q = m_conn.prepare("SELECT DISTINCT id_asset_device_src AS id FROM t_bios_asset_link"
+                            " WHERE id_asset_device_src IN (" + placeholders("id", ids.size()) + ")");
+    bindIds(q, "id", ids);
 
     try {
         Lock lock(m_conn_lock);
-        q.execute();
+        for (const auto& row : q.select()) {
+            sources.insert(row.getUnsigned32("id"));
+        }
 
     } catch (std::exception& e) {
 
         throw std::runtime_error("database error - " + std::string(e.what()));
     }
+
+    return sources;
 }
 
-void DB::clearGroup(Asset& asset)
+void DB::unlinkList(const std::vector<uint32_t>& ids)
 {
-    auto assetID = getID(asset.getInternalName());
-    if(!assetID) {
-        throw std::runtime_error(assetID.error());
+    if (ids.empty()) {
+        return;
     }
 
-    // clang-format off
-    auto q = m_conn.prepareCached(R"(
-        DELETE FROM
-            t_bios_asset_group_relation
-        WHERE
-            d_asset_group = :grp
-    )");
-    // clang-format on
-    q.set("grp", *assetID);
+    const std::string in = placeholders("id", ids.size());
+
+    auto q_ext_attrib = m_conn.prepare("DELETE la FROM t_bios_asset_link_attributes AS la"
+                                       " INNER JOIN t_bios_asset_link AS l ON la.id_link = l.id_link"
+                                       " WHERE l.id_asset_device_dest IN (" + in + ")");
+    auto q_link = m_conn.prepare("DELETE FROM t_bios_asset_link WHERE id_asset_device_dest IN (" + in + ")");
+
+    bindIds(q_ext_attrib, "id", ids);
+    bindIds(q_link, "id", ids);
 
     try {
         Lock lock(m_conn_lock);
-        q.execute();
+        q_ext_attrib.execute();
+        q_link.execute();
 
     } catch (std::exception& e) {
 
@@ -1005,29 +1276,269 @@ void DB::clearGroup(Asset& asset)
     }
 }
 
-void DB::beginTransaction()
+void DB::removeList(const std::vector<std::vector<uint32_t>>& byDepth)
 {
-    Lock lock(m_conn_lock);
-    m_conn.beginTransaction();
+    static auto&            stat = fty::stats::metric("db.removeList");
+    fty::stats::ScopedTimer timer(stat.latency);
 
-}
+    m_index.invalidate();
+    markAllChanged();
+    ContainmentIndex::instance().invalidate();
 
-void DB::rollbackTransaction()
-{
-    Lock lock(m_conn_lock);
-    m_conn.rollbackTransaction();
+    std::vector<uint32_t> ids;
+    for (const auto& level : byDepth) {
+        ids.insert(ids.end(), level.begin(), level.end());
+    }
+    if (ids.empty()) {
+        return;
+    }
 
-}
+    const std::string in = placeholders("id", ids.size());
 
-void DB::commitTransaction()
+    std::vector<TracedStatement> statements;
+    statements.push_back(m_conn.prepare(
+        "DELETE FROM t_bios_asset_ext_attributes WHERE id_asset_element IN (" + in + ")"));
+    statements.push_back(m_conn.prepare("DELETE FROM t_bios_asset_group_relation WHERE id_asset_element IN (" + in +
+                                        ") OR id_asset_group IN (" + in + ")"));
+    statements.push_back(m_conn.prepare(
+        "DELETE FROM t_bios_monitor_asset_relation WHERE id_asset_element IN (" + in + ")"));
+
+    // children before parents, one statement per depth level
+    for (const auto& level : byDepth) {
+        if (level.empty()) {
+            continue;
+        }
+        auto q = m_conn.prepare(
+            "DELETE FROM t_bios_asset_element WHERE id_asset_element IN (" + placeholders("el", level.size()) + ")");
+        bindIds(q, "el", level);
+        statements.push_back(q);
+    }
+
+    for (size_t i = 0; i < 3; ++i) {
+        bindIds(statements[i], "id", ids);
+    }
+
+    auto names = m_conn.prepare("SELECT name FROM t_bios_asset_element WHERE id_asset_element IN (" + in + ")");
+    bindIds(names, "id", ids);
+
+    std::vector<std::string> deleted;
+    try {
+        Lock lock(m_conn_lock);
+        for (const auto& row : names.select()) {
+            deleted.push_back(row.getString("name"));
+        }
+        for (auto& q : statements) {
+            q.execute();
+        }
+
+    } catch (std::exception& e) {
+
+        throw std::runtime_error("database error - " + std::string(e.what()));
+    }
+
+    for (const auto& name : deleted) {
+        journalDeleted(name);
+    }
+}
+
+void DB::removeFromGroups(Asset& asset)
+{
+    auto assetID = getID(asset.getInternalName());
+    if(!assetID) {
+        throw std::runtime_error(assetID.error());
+    }
+
+    // clang-format off
+    auto q = m_conn.prepareCached(R"(
+        DELETE FROM
+            t_bios_asset_group_relation
+        WHERE
+            id_asset_element = :asset_id
+    )");
+    // clang-format on
+    q.set("asset_id", *assetID);
+
+    try {
+        Lock lock(m_conn_lock);
+        q.execute();
+
+    } catch (std::exception& e) {
+
+        throw std::runtime_error("database error - " + std::string(e.what()));
+    }
+}
+
+void DB::removeFromRelations(Asset& asset)
+{
+    auto assetID = getID(asset.getInternalName());
+    if(!assetID) {
+        throw std::runtime_error(assetID.error());
+    }
+
+    // clang-format off
+    auto q = m_conn.prepareCached(R"(
+        DELETE FROM
+            t_bios_monitor_asset_relation
+        WHERE
+            id_asset_element = :asset_id
+    )");
+    // clang-format on
+    q.set("asset_id", *assetID);
+
+    try {
+        Lock lock(m_conn_lock);
+        q.execute();
+
+    } catch (std::exception& e) {
+
+        throw std::runtime_error(std::string(e.what()));
+    }
+}
+
+void DB::removeAsset(Asset& asset)
+{
+    m_index.invalidate();
+    assetChanged(asset.getInternalName());
+
+    auto assetID = getID(asset.getInternalName());
+    if(!assetID) {
+        throw std::runtime_error(assetID.error());
+    }
+
+    // clang-format off
+    auto q = m_conn.prepareCached(R"(
+        DELETE FROM
+            t_bios_asset_element
+        WHERE
+            id_asset_element = :asset_id
+    )");
+    // clang-format on
+    q.set("asset_id", *assetID);
+
+    try {
+        Lock lock(m_conn_lock);
+        q.execute();
+
+    } catch (std::exception& e) {
+
+        throw std::runtime_error("database error - " + std::string(e.what()));
+    }
+
+    ContainmentIndex::instance().update("delete", asset.getInternalName(), 0, "", "", "");
+    journalDeleted(asset.getInternalName());
+}
+
+void DB::removeExtMap(Asset& asset)
+{
+    assetChanged(asset.getInternalName());
+
+    auto assetID = getID(asset.getInternalName());
+    if(!assetID) {
+        throw std::runtime_error(assetID.error());
+    }
+
+    // clang-format off
+    auto q = m_conn.prepareCached(R"(
+        DELETE FROM
+            t_bios_asset_ext_attributes
+        WHERE
+            id_asset_element = :assetId
+    )");
+    // clang-format on
+    q.set("assetId", *assetID);
+
+    try {
+        Lock lock(m_conn_lock);
+        q.execute();
+
+    } catch (std::exception& e) {
+
+        throw std::runtime_error("database error - " + std::string(e.what()));
+    }
+}
+
+void DB::clearGroup(Asset& asset)
+{
+    auto assetID = getID(asset.getInternalName());
+    if(!assetID) {
+        throw std::runtime_error(assetID.error());
+    }
+
+    // clang-format off
+    auto q = m_conn.prepareCached(R"(
+        DELETE FROM
+            t_bios_asset_group_relation
+        WHERE
+            d_asset_group = :grp
+    )");
+    // clang-format on
+    q.set("grp", *assetID);
+
+    try {
+        Lock lock(m_conn_lock);
+        q.execute();
+
+    } catch (std::exception& e) {
+
+        throw std::runtime_error("database error - " + std::string(e.what()));
+    }
+}
+
+void DB::journalDeleted(const std::string& internalName)
+{
+    if (m_inTransaction) {
+        // journaled once committed, a rolled back delete must not reach clients
+        m_deleted.push_back(internalName);
+    } else {
+        ChangeJournal::instance().record(internalName, true);
+    }
+}
+
+void DB::beginTransaction()
 {
     Lock lock(m_conn_lock);
-    m_conn.commitTransaction();
+    m_conn.beginTransaction();
+    m_inTransaction = true;
+}
+
+void DB::rollbackTransaction()
+{
+    {
+        Lock lock(m_conn_lock);
+        m_conn.rollbackTransaction();
+        m_inTransaction = false;
+        m_deleted.clear();
+    }
 
+    // in-memory views may hold changes which were just undone
+    m_index.invalidate();
+    markAllChanged();
+    ContainmentIndex::instance().invalidate();
+}
+
+void DB::commitTransaction()
+{
+    std::vector<std::string> deleted;
+    {
+        Lock lock(m_conn_lock);
+        m_conn.commitTransaction();
+        m_inTransaction = false;
+        deleted.swap(m_deleted);
+    }
+
+    for (const auto& name : deleted) {
+        ChangeJournal::instance().record(name, true);
+    }
 }
 
 void DB::update(Asset& asset)
 {
+    static auto&            stat = fty::stats::metric("db.update");
+    fty::stats::ScopedTimer timer(stat.latency);
+
+    m_index.invalidate();
+    assetChanged(asset.getInternalName());
+
     if (asset.getInternalName().empty()) {
         log_error("Asset iname is empty");
         throw std::runtime_error("Asset iname is empty");
@@ -1115,10 +1626,19 @@ void DB::update(Asset& asset)
     catch (std::exception& e) {
         throw std::runtime_error("database error - " + std::string(e.what()));
     }
+
+    ContainmentIndex::instance().update("update", asset.getInternalName(), parentId, asset.getAssetType(),
+        asset.getAssetSubtype(), assetStatusToString(asset.getAssetStatus()));
 }
 
 void DB::insert(Asset& asset)
 {
+    static auto&            stat = fty::stats::metric("db.insert");
+    fty::stats::ScopedTimer timer(stat.latency);
+
+    m_index.invalidate();
+    assetChanged(asset.getInternalName());
+
     if (asset.getInternalName().empty()) {
         log_error("Asset iname is empty");
         throw std::runtime_error("Asset iname is empty");
@@ -1183,17 +1703,25 @@ void DB::insert(Asset& asset)
     if (asset.getSecondaryID().empty()) q.setNull("idSecondary");
     else q.set("idSecondary", asset.getSecondaryID());
 
+    uint32_t id = 0;
     try {
         Lock lock(m_conn_lock);
         q.execute();
+        id = static_cast<uint32_t>(m_conn.lastInsertId());
     }
     catch (std::exception& e) {
         throw std::runtime_error("database error - " + std::string(e.what()));
     }
+
+    ContainmentIndex::instance().add(id, asset.getInternalName(), parentId, asset.getAssetType(),
+        asset.getAssetSubtype(), assetStatusToString(fty::AssetStatus::Nonactive));
 }
 
 std::string DB::inameById(uint32_t id)
 {
+    static auto&            stat = fty::stats::metric("db.inameById");
+    fty::stats::ScopedTimer timer(stat.latency);
+
     std::string res;
 
     // clang-format off
@@ -1217,6 +1745,9 @@ std::string DB::inameById(uint32_t id)
 
 std::string DB::inameByUuid(const std::string& uuid)
 {
+    static auto&            stat = fty::stats::metric("db.inameByUuid");
+    fty::stats::ScopedTimer timer(stat.latency);
+
     std::string res;
     // clang-format off
     auto q = m_conn.prepareCached(R"(
@@ -1249,23 +1780,11 @@ std::string DB::inameByUuid(const std::string& uuid)
     return res;
 }
 
-void DB::saveExtMap(Asset& asset)
+StoredExtMap DB::loadStoredExtMap(uint32_t assetId)
 {
-    /*
-     * Here is the strategy to save the external attributes:
-     * 1. We insert, update or remove only the external attribute which has been modified.
-     * 2. An external attribute with a value set to empty string will be removed from the db
-     */
-
-    auto assetID = getID(asset.getInternalName());
-    if(!assetID) {
-        throw std::runtime_error(assetID.error());
-    }
-
     // clang-format off
     auto q = m_conn.prepareCached(R"(
         SELECT
-            id_asset_ext_attribute AS id,
             keytag                 AS akey,
             value                  AS avalue,
             read_only              AS readOnly
@@ -1274,7 +1793,7 @@ void DB::saveExtMap(Asset& asset)
              id_asset_element = : assetId
     )");
     // clang-format on
-    q.set("assetId", *assetID);
+    q.set("assetId", assetId);
 
     tntdb::Result res;
 
@@ -1287,178 +1806,722 @@ void DB::saveExtMap(Asset& asset)
         throw std::runtime_error("database error - " + std::string(e.what()));
     }
 
-    using ExternalAttributeInDB = std::tuple<uint32_t, std::string, std::string, bool>;
-
-    std::vector<ExternalAttributeInDB> existing;
+    StoredExtMap stored;
+    stored.reserve(res.size());
     for (const auto& row : res) {
-        existing.emplace_back(
-            row.getUnsigned32("id"), row.getString("akey"), row.getString("avalue"), row.getBool("readOnly"));
+        stored.emplace(row.getString("akey"), ExtMapElement(row.getString("avalue"), row.getBool("readOnly"), true));
     }
 
-    std::vector<ExternalAttributeInDB> toBeRemoved;
+    return stored;
+}
 
+void DB::applyExtChanges(uint32_t assetId, const AssetChangeSet& changes)
+{
+    const auto& toUpsert = changes.extUpserts();
+    const auto& toRemove = changes.extRemovals();
+
+    if (!toUpsert.empty()) {
+        std::stringstream qs;
+        qs << "INSERT INTO t_bios_asset_ext_attributes (keytag, value, id_asset_element, read_only) VALUES ";
+        for (size_t i = 0; i < toUpsert.size(); ++i) {
+            qs << (i ? ", " : "") << "(:key" << i << ", :value" << i << ", :assetId, :readOnly" << i << ")";
+        }
+        qs << " ON DUPLICATE KEY UPDATE value = VALUES(value), read_only = VALUES(read_only)";
 
-    for (const auto& it : asset.getExt()) {
+        // variable arity, do not pollute the statement cache
+        auto q = m_conn.prepare(qs.str());
+        q.set("assetId", assetId);
+        for (size_t i = 0; i < toUpsert.size(); ++i) {
+            std::string idx = std::to_string(i);
 
-        // skip the none updated attribute
-        if (!it.second.wasUpdated()) {
-            continue;
+            q.set("key" + idx, toUpsert[i].key);
+            q.set("value" + idx, toUpsert[i].value);
+            q.set("readOnly" + idx, toUpsert[i].readOnly);
         }
 
-        auto found = std::find_if(existing.begin(), existing.end(), [&](const ExternalAttributeInDB& e) {
-            return std::get<1>(e) == it.first;
-        });
+        try {
+            Lock lock(m_conn_lock);
+            q.execute();
 
+        } catch (std::exception& e) {
 
-        if (found == existing.end()) {
-            // The attribute do not exist in the database
-            // if it's not empty we insert it.
+            throw std::runtime_error("database error - " + std::string(e.what()));
+        }
+    }
 
-            if (!it.second.getValue().empty()) {
-                // clang-format off
-                auto q1 = m_conn.prepareCached(R"(
-                    INSERT INTO t_bios_asset_ext_attributes (keytag, value, id_asset_element, read_only)
-                    VALUES (:key, :value, :assetId, :readOnly)
-                )");
-                // clang-format on
-                q1.set("key", it.first);
-                q1.set("value", it.second.getValue());
-                q1.set("readOnly", it.second.isReadOnly());
-                q1.set("assetId", *assetID);
-                try {
-                    Lock lock(m_conn_lock);
-                    q1.execute();
+    if (!toRemove.empty()) {
+        std::stringstream qs;
+        qs << "DELETE FROM t_bios_asset_ext_attributes WHERE id_asset_element = :assetId AND keytag IN (";
+        for (size_t i = 0; i < toRemove.size(); ++i) {
+            qs << (i ? ", " : "") << ":key" << i;
+        }
+        qs << ")";
 
-                } catch (std::exception& e) {
+        auto q = m_conn.prepare(qs.str());
+        q.set("assetId", assetId);
+        for (size_t i = 0; i < toRemove.size(); ++i) {
+            q.set("key" + std::to_string(i), toRemove[i]);
+        }
 
-                    throw std::runtime_error("database error - " + std::string(e.what()));
-                }
-            }
+        try {
+            Lock lock(m_conn_lock);
+            q.execute();
 
-        } else {
-            // The attribute exist in the database
-            // if it's not empty we update it, else remove it.
+        } catch (std::exception& e) {
 
-            if (!it.second.getValue().empty()) {
-                // clang-format off
-                auto q1 = m_conn.prepareCached(R"(
-                    UPDATE t_bios_asset_ext_attributes
-                    SET
-                        value = :value,
-                        read_only = :readOnly
-                    WHERE id_asset_ext_attribute = :extId
-                )");
-                // clang-format on
-                q1.set("value", it.second.getValue());
-                q1.set("readOnly", it.second.isReadOnly());
-                q1.set("extId", std::get<0>(*found));
+            throw std::runtime_error("database error - " + std::string(e.what()));
+        }
+    }
+}
 
-                try {
-                    Lock lock(m_conn_lock);
-                    q1.execute();
+void DB::saveExtMap(Asset& asset)
+{
+    assetChanged(asset.getInternalName());
 
-                } catch (std::exception& e) {
+    /*
+     * Here is the strategy to save the external attributes:
+     * 1. We insert, update or remove only the external attribute which has been modified.
+     * 2. An external attribute with a value set to empty string will be removed from the db
+     */
 
-                    throw std::runtime_error("database error - " + std::string(e.what()));
-                }
-            } else {
-                toBeRemoved.push_back(*found);
-            }
-        }
+    auto assetID = getID(asset.getInternalName());
+    if(!assetID) {
+        throw std::runtime_error(assetID.error());
     }
 
-    for (const auto& toRem : toBeRemoved) {
+    AssetChangeSet changes;
+    changes.diffExt(loadStoredExtMap(*assetID), asset.getExt());
+
+    applyExtChanges(*assetID, changes);
+}
+
+AssetChangeSet DB::computeChanges(const Asset& asset)
+{
+    auto assetID = getID(asset.getInternalName());
+    if(!assetID) {
+        throw std::runtime_error(assetID.error());
+    }
+
+    Asset stored;
+    loadAsset(asset.getInternalName(), stored);
+
+    AssetChangeSet changes;
+    changes.diffElement(stored, asset);
+    changes.diffExt(loadStoredExtMap(*assetID), asset.getExt());
+    changes.diffLinks(loadStoredLinks(*assetID), asset.getLinkedAssets());
+
+    return changes;
+}
+
+void DB::applyChanges(Asset& asset, const AssetChangeSet& changes)
+{
+    assetChanged(asset.getInternalName());
+
+    if (changes.elementChanged()) {
+        update(asset);
+    }
+
+    if (changes.extUpserts().empty() && changes.extRemovals().empty() && changes.linkInserts().empty() &&
+        changes.linkRemovals().empty()) {
+        return;
+    }
+
+    auto assetID = getID(asset.getInternalName());
+    if(!assetID) {
+        throw std::runtime_error(assetID.error());
+    }
+
+    applyExtChanges(*assetID, changes);
+    applyLinkChanges(*assetID, changes);
+}
+
+void DB::setListIndexTtl(int64_t ttlMs)
+{
+    // no connection needed, may be called before the database is up
+    instance().m_index.setTtl(ttlMs);
+    instance().m_index.invalidate();
+}
+
+static int64_t monotonicMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::vector<std::string> DB::listFromIndex(const AssetFilterPlan& plan)
+{
+    int64_t now = monotonicMs();
+
+    if (!m_index.fresh(now)) {
         // clang-format off
-        auto q1 = m_conn.prepareCached(R"(
-            DELETE FROM t_bios_asset_ext_attributes
-            WHERE id_asset_ext_attribute = :extId
+        auto q = m_conn.prepareCached(R"(
+            SELECT
+                name          AS name,
+                status        AS status,
+                id_type       AS id_type,
+                id_subtype    AS id_subtype,
+                id_parent     AS id_parent
+            FROM t_bios_asset_element
+            ORDER BY id_asset_element
         )");
         // clang-format on
-        q1.set("extId", std::get<0>(toRem));
+
+        tntdb::Result res;
 
         try {
             Lock lock(m_conn_lock);
-            q1.execute();
+            res = q.select();
 
         } catch (std::exception& e) {
 
             throw std::runtime_error("database error - " + std::string(e.what()));
         }
+
+        std::vector<AssetIndex::Row> rows;
+        rows.reserve(res.size());
+        for (const auto& row : res) {
+            AssetIndex::Row r;
+            r.name    = row.getString("name");
+            r.status  = row.getString("status");
+            r.type    = row.getUnsigned32("id_type");
+            r.subtype = row.getUnsigned32("id_subtype");
+            if (!row.isNull("id_parent")) {
+                r.parent = row.getUnsigned32("id_parent");
+            }
+            rows.push_back(std::move(r));
+        }
+        m_index.rebuild(rows, now);
     }
+
+    return m_index.select(plan);
 }
 
-static void addFilter(
-    std::stringstream& qs, const std::string& filter, const std::vector<std::string>& values)
+std::vector<std::string> DB::listAssets(std::map<std::string, std::vector<std::string>> filters)
 {
-    auto value = values.begin();
-    qs << " ( ";
-    qs << filter << " = " << *value << " ";
+    static auto&            stat = fty::stats::metric("db.listAssets");
+    fty::stats::ScopedTimer timer(stat.latency);
+
+    std::vector<std::string> assetList;
+
+    AssetFilterPlan plan = AssetFilterPlan::compile(filters);
+
+    std::vector<std::string> names;
+
+    if (!plan.where().empty() && plan.indexable() && m_index.enabled()) {
+        names = listFromIndex(plan);
+    } else {
+        // the SQL only depends on the filter shape, the statement cache stays small
+        auto q = m_conn.prepareCached("SELECT name AS name FROM t_bios_asset_element" + plan.where());
+        plan.bind(q);
 
-    for (auto it = std::next(values.begin()); it != values.end(); it++) {
-        qs << " OR ";
-        qs << filter << " = " << *it << " ";
+        try {
+            Lock lock(m_conn_lock);
+            for (const auto& row : q.select()) {
+                names.push_back(row.getString("name"));
+            }
+
+        } catch (std::exception& e) {
+
+            throw std::runtime_error("database error - " + std::string(e.what()));
+        }
     }
-    qs << " ) ";
+
+    for (auto& assetName : names) {
+        // discard rackcontroller 0
+        if (assetName != RC0) {
+            assetList.emplace_back(std::move(assetName));
+        }
+    }
+
+    return assetList;
 }
 
-std::vector<std::string> DB::listAssets(std::map<std::string, std::vector<std::string>> filters)
+void DB::assetChanged(const std::string& internalName)
 {
-    std::vector<std::string> assetList;
+    ChangeJournal::instance().record(internalName, false);
+
+    DB&                         db = instance();
+    std::lock_guard<std::mutex> lock(db.m_columnsLock);
+    // a reload in progress may have read the asset before the change
+    if (db.m_columnsValid || db.m_columnsReloading) {
+        db.m_changed.insert(internalName);
+    }
+}
 
-    tntdb::Statement q;
+void DB::assetDeleted(const std::string& internalName)
+{
+    ChangeJournal::instance().record(internalName, true);
 
-    std::stringstream qs;
+    DB&                         db = instance();
+    std::lock_guard<std::mutex> lock(db.m_columnsLock);
+    // not found by the reload, so removed from the columns
+    if (db.m_columnsValid || db.m_columnsReloading) {
+        db.m_changed.insert(internalName);
+    }
+}
+
+void DB::markAllChanged()
+{
+    std::lock_guard<std::mutex> lock(m_columnsLock);
+    m_columnsValid = false;
+    ++m_columnsGeneration;
+}
+
+void DB::setQueryTtl(int64_t ttlMs)
+{
+    DB&                         db = instance();
+    std::lock_guard<std::mutex> lock(db.m_columnsLock);
+    db.m_queryTtlMs = ttlMs;
+}
+
+// empty names loads all assets
+void DB::loadColumns(AssetColumns& columns, const std::vector<std::string>& names)
+{
+    // clang-format off
+    std::string core = R"(
+        SELECT
+            a.name     AS name,
+            e.name     AS type,
+            d.name     AS subType,
+            a.status   AS status,
+            p.name     AS parentName,
+            a.priority AS priority
+        FROM t_bios_asset_element AS a
+            INNER JOIN t_bios_asset_device_type AS d
+            INNER JOIN t_bios_asset_element_type AS e
+            ON a.id_type = e.id_asset_element_type AND a.id_subtype = d.id_asset_device_type
+            LEFT JOIN t_bios_asset_element AS p
+            ON a.id_parent = p.id_asset_element
+    )";
+    std::string ext = R"(
+        SELECT
+            a.name   AS name,
+            x.keytag AS keytag,
+            x.value  AS value
+        FROM t_bios_asset_ext_attributes AS x
+            INNER JOIN t_bios_asset_element AS a
+            ON x.id_asset_element = a.id_asset_element
+    )";
+    // clang-format on
+
+    tntdb::Result resCore;
+    tntdb::Result resExt;
+
+    try {
+        // full reloads run outside of m_columnsLock, the connection is only used under its own lock
+        Lock            lock(m_conn_lock);
+        TracedStatement qCore;
+        TracedStatement qExt;
+
+        if (names.empty()) {
+            qCore = m_conn.prepareCached(core);
+            qExt  = m_conn.prepareCached(ext);
+        } else {
+            // variable arity, do not pollute the statement cache
+            const std::string in = " WHERE a.name IN (" + placeholders("name", names.size()) + ")";
+            qCore                = m_conn.prepare(core + in);
+            qExt                 = m_conn.prepare(ext + in);
+            for (size_t i = 0; i < names.size(); ++i) {
+                qCore.set("name" + std::to_string(i), names[i]);
+                qExt.set("name" + std::to_string(i), names[i]);
+            }
+        }
 
-    qs << " SELECT "
-          " name AS name "
-          " FROM t_bios_asset_element ";
+        resCore = qCore.select();
+        resExt  = qExt.select();
 
-    if (!filters.empty()) {
-        qs << " WHERE ";
+    } catch (std::exception& e) {
 
-        // first filter
-        auto it     = filters.begin();
-        auto filter = it->first;
-        auto values = it->second;
+        throw std::runtime_error("database error - " + std::string(e.what()));
+    }
 
-        addFilter(qs, filter, values);
+    std::unordered_map<std::string, uint32_t> rows;
+    rows.reserve(resCore.size());
 
-        // next filters
-        for (it = std::next(filters.begin()); it != filters.end(); it++) {
-            qs << " AND ";
-            filter = it->first;
-            values = it->second;
+    for (const auto& row : resCore) {
+        const std::string name = row.getString("name");
+        uint32_t          r    = columns.addAsset(name);
+        rows.emplace(name, r);
 
-            addFilter(qs, filter, values);
+        columns.set(r, "type", row.getString("type"));
+        columns.set(r, "subtype", row.getString("subType"));
+        columns.set(r, "status", row.getString("status"));
+        columns.set(r, "priority", std::to_string(row.getInt("priority")));
+        if (!row.isNull("parentName")) {
+            columns.set(r, "parent", row.getString("parentName"));
         }
     }
 
-    q = m_conn.prepareCached(qs.str().c_str());
+    for (const auto& row : resExt) {
+        auto found = rows.find(row.getString("name"));
+        if (found != rows.end()) {
+            columns.set(found->second, "ext." + row.getString("keytag"), row.getString("value"));
+        }
+    }
+}
 
-    tntdb::Result res;
+// full reload built aside, queries go on with the former columns meanwhile
+void DB::reloadColumns(bool wait)
+{
+    std::unique_lock<std::mutex> reload(m_columnsReloadLock, std::defer_lock);
+    if (wait) {
+        reload.lock();
+    } else if (!reload.try_lock()) {
+        // another query is reloading them
+        return;
+    }
 
+    int64_t  now = monotonicMs();
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(m_columnsLock);
+        if (wait && m_columnsValid) {
+            // reloaded by the query this one waited for
+            return;
+        }
+        generation         = m_columnsGeneration;
+        m_columnsReloading = true;
+        m_changed.clear();
+    }
+
+    AssetColumns columns;
     try {
-        Lock lock(m_conn_lock);
-        res = q.select();
+        loadColumns(columns, {});
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(m_columnsLock);
+        m_columnsReloading = false;
+        throw;
+    }
+
+    std::lock_guard<std::mutex> lock(m_columnsLock);
+    std::swap(m_columns, columns);
+    m_columnsReloading = false;
+    // invalidated during the reload, it may have read writes which were undone since
+    m_columnsValid   = generation == m_columnsGeneration;
+    m_columnsBuiltAt = now;
+}
 
-    } catch (std::exception& e) {
+std::vector<std::string> DB::queryAssets(const AssetQuery& query)
+{
+    static auto&            stat = fty::stats::metric("db.queryAssets");
+    fty::stats::ScopedTimer timer(stat.latency);
 
-        throw std::runtime_error("database error - " + std::string(e.what()));
+    std::unique_lock<std::mutex> lock(m_columnsLock);
+
+    if (!m_columnsValid || (m_queryTtlMs >= 0 && monotonicMs() - m_columnsBuiltAt >= m_queryTtlMs) ||
+        m_columns.deadRows() > m_columns.rows() / 2) {
+        do {
+            // without columns there is nothing to answer from, wait for the reload
+            bool wait = !m_columnsValid;
+            lock.unlock();
+            reloadColumns(wait);
+            lock.lock();
+        } while (!m_columnsValid);
     }
 
-    for (const auto& row : res) {
-        const std::string& assetName = row.getString("name");
+    try {
+        // assets changed since the last query or during the reload
+        if (!m_changed.empty()) {
+            std::vector<std::string> changed(m_changed.begin(), m_changed.end());
+            m_changed.clear();
+            for (const auto& name : changed) {
+                // deleted assets are not loaded again
+                m_columns.removeAsset(name);
+            }
+            for (size_t i = 0; i < changed.size(); i += 512) {
+                loadColumns(m_columns, std::vector<std::string>(changed.begin() + long(i),
+                                           changed.begin() + long(std::min(i + 512, changed.size()))));
+            }
+        }
+    } catch (...) {
+        m_columnsValid = false;
+        throw;
+    }
+
+    std::vector<std::string> assetList;
+    for (auto& assetName : m_columns.evaluate(query)) {
         // discard rackcontroller 0
         if (assetName != RC0) {
-            assetList.emplace_back(assetName);
+            assetList.emplace_back(std::move(assetName));
         }
     }
 
     return assetList;
 }
 
+void DB::setSnapshot(const std::string& path, uint64_t everyChanges)
+{
+    DB& db             = instance();
+    db.m_snapshotPath  = path;
+    db.m_snapshotEvery = everyChanges;
+}
+
+void DB::warmFrom(const AssetSnapshot& snapshot)
+{
+    int64_t now = monotonicMs();
+
+    std::vector<AssetIndex::Row> rows;
+    rows.reserve(snapshot.size());
+
+    std::lock_guard<std::mutex> lock(m_columnsLock);
+    m_changed.clear();
+    m_columns.clear();
+
+    for (size_t i = 0; i < snapshot.size(); ++i) {
+        AssetSnapshot::Element e = snapshot.element(i);
+
+        uint32_t r = m_columns.addAsset(e.name);
+        m_columns.set(r, "type", e.type);
+        m_columns.set(r, "subtype", e.subtype);
+        m_columns.set(r, "status", e.status);
+        m_columns.set(r, "priority", std::to_string(e.priority));
+        if (!e.parent.empty()) {
+            m_columns.set(r, "parent", e.parent);
+        }
+        for (const auto& x : e.ext) {
+            m_columns.set(r, "ext." + x.key, x.value);
+        }
+
+        AssetIndex::Row row;
+        row.name    = std::move(e.name);
+        row.status  = std::move(e.status);
+        row.type    = e.typeId;
+        row.subtype = e.subtypeId;
+        row.parent  = e.parentId;
+        rows.push_back(std::move(row));
+    }
+
+    m_columnsValid   = true;
+    m_columnsBuiltAt = now;
+    m_index.rebuild(rows, now);
+}
+
+bool DB::loadSnapshot()
+{
+    DB& db = instance();
+    if (db.m_snapshotPath.empty()) {
+        return false;
+    }
+
+    int64_t       start = monotonicMs();
+    AssetSnapshot snapshot;
+    if (!snapshot.open(db.m_snapshotPath)) {
+        log_info("No asset snapshot in %s, caches start cold", db.m_snapshotPath.c_str());
+        return false;
+    }
+
+    db.warmFrom(snapshot);
+    db.m_snapshotLoaded    = true;
+    db.m_snapshotChecksums = snapshot.checksums();
+    db.m_snapshotSeq       = ChangeJournal::instance().sequence();
+
+    log_info("Asset snapshot with %zu assets loaded in %lld ms", snapshot.size(),
+        static_cast<long long>(monotonicMs() - start));
+    return true;
+}
+
+// CHECKSUM TABLE changes with any write; InnoDB keeps no live checksum, so each call scans the whole table and is
+// only done when a snapshot is validated or written
+static AssetSnapshot::Checksums tableChecksums(tntdb::Connection& conn)
+{
+    static const char* tables[AssetSnapshot::TableCount] = {"t_bios_asset_element", "t_bios_asset_ext_attributes",
+        "t_bios_asset_link", "t_bios_asset_group_relation", "t_bios_asset_link_attributes"};
+
+    AssetSnapshot::Checksums checksums {};
+    for (size_t t = 0; t < AssetSnapshot::TableCount; ++t) {
+        tntdb::Row row = conn.selectRow(std::string("CHECKSUM TABLE ") + tables[t]);
+        checksums[t]   = row.isNull(1) ? 0 : row.getUnsigned64(1);
+    }
+    return checksums;
+}
+
+bool DB::validateSnapshot()
+{
+    DB& db = instance();
+    if (!db.m_snapshotLoaded) {
+        // nothing served from a snapshot, just write the first one
+        if (!db.m_snapshotPath.empty()) {
+            db.saveSnapshot();
+        }
+        return false;
+    }
+    db.m_snapshotLoaded = false;
+
+    try {
+        tntdb::Connection conn = tntdb::connect(DBConn::url);
+        if (tableChecksums(conn) == db.m_snapshotChecksums) {
+            log_info("Asset snapshot is up to date");
+            return true;
+        }
+    } catch (std::exception& e) {
+        log_error("Asset snapshot could not be validated: %s", e.what());
+    }
+
+    log_info("Asset snapshot is stale, caches are reloaded from database");
+    db.m_index.invalidate();
+    db.markAllChanged();
+    db.saveSnapshot();
+    return false;
+}
+
+void DB::saveSnapshotIfDue()
+{
+    DB& db = instance();
+    if (db.m_snapshotPath.empty() || ChangeJournal::instance().sequence() - db.m_snapshotSeq < db.m_snapshotEvery) {
+        return;
+    }
+    db.saveSnapshot();
+}
+
+bool DB::saveSnapshot()
+{
+    // clang-format off
+    static const char* elementsSql = R"(
+        SELECT
+            a.id_asset_element AS id,
+            a.name             AS name,
+            e.name             AS type,
+            d.name             AS subType,
+            a.status           AS status,
+            a.priority         AS priority,
+            a.id_type          AS id_type,
+            a.id_subtype       AS id_subtype,
+            a.id_parent        AS id_parent,
+            p.name             AS parentName
+        FROM t_bios_asset_element AS a
+            INNER JOIN t_bios_asset_device_type AS d
+            INNER JOIN t_bios_asset_element_type AS e
+            ON a.id_type = e.id_asset_element_type AND a.id_subtype = d.id_asset_device_type
+            LEFT JOIN t_bios_asset_element AS p
+            ON a.id_parent = p.id_asset_element
+        ORDER BY a.id_asset_element
+    )";
+    static const char* extSql = R"(
+        SELECT id_asset_element, keytag, value, read_only
+        FROM t_bios_asset_ext_attributes
+    )";
+    static const char* linksSql = R"(
+        SELECT
+            l.id_link              AS id,
+            l.id_asset_device_dest AS dest,
+            s.name                 AS source,
+            l.src_out              AS srcOut,
+            l.dest_in              AS destIn,
+            l.id_asset_link_type   AS type
+        FROM t_bios_asset_link AS l
+            INNER JOIN t_bios_asset_element AS s
+            ON l.id_asset_device_src = s.id_asset_element
+    )";
+    static const char* linkExtSql = R"(
+        SELECT id_link, keytag, value, read_only
+        FROM t_bios_asset_link_attributes
+    )";
+    static const char* groupsSql = R"(
+        SELECT
+            r.id_asset_element AS id,
+            g.name             AS name
+        FROM t_bios_asset_group_relation AS r
+            INNER JOIN t_bios_asset_element AS g
+            ON r.id_asset_group = g.id_asset_element
+    )";
+    // clang-format on
+
+    int64_t  start    = monotonicMs();
+    uint64_t sequence = ChangeJournal::instance().sequence();
+
+    std::vector<AssetSnapshot::Element> elements;
+    AssetSnapshot::Checksums            checksums;
+
+    try {
+        // own connection, a transaction running on m_conn must not leak into the snapshot
+        tntdb::Connection conn = tntdb::connect(DBConn::url);
+
+        checksums = tableChecksums(conn);
+
+        std::unordered_map<uint32_t, size_t> rows;
+        for (const auto& row : conn.select(elementsSql)) {
+            AssetSnapshot::Element e;
+            e.id        = row.getUnsigned32("id");
+            e.name      = row.getString("name");
+            e.type      = row.getString("type");
+            e.subtype   = row.getString("subType");
+            e.status    = row.getString("status");
+            e.priority  = row.getInt("priority");
+            e.typeId    = row.getUnsigned32("id_type");
+            e.subtypeId = row.getUnsigned32("id_subtype");
+            if (!row.isNull("id_parent")) {
+                e.parentId = row.getUnsigned32("id_parent");
+                e.parent   = row.getString("parentName");
+            }
+            rows.emplace(e.id, elements.size());
+            elements.push_back(std::move(e));
+        }
+        for (const auto& row : conn.select(extSql)) {
+            auto found = rows.find(row.getUnsigned32("id_asset_element"));
+            if (found != rows.end()) {
+                elements[found->second].ext.push_back(
+                    {row.getString("keytag"), row.getString("value"), row.getBool("read_only")});
+            }
+        }
+        // element and position of each link, for its attributes
+        std::unordered_map<uint32_t, std::pair<size_t, size_t>> links;
+        for (const auto& row : conn.select(linksSql)) {
+            auto found = rows.find(row.getUnsigned32("dest"));
+            if (found != rows.end()) {
+                AssetSnapshot::Link link;
+                link.source = row.getString("source");
+                link.type   = row.getUnsigned32("type");
+                // may be NULL
+                if (!row.isNull("srcOut")) {
+                    link.srcOut = row.getString("srcOut");
+                }
+                if (!row.isNull("destIn")) {
+                    link.destIn = row.getString("destIn");
+                }
+                auto& element = elements[found->second];
+                links.emplace(row.getUnsigned32("id"), std::make_pair(found->second, element.links.size()));
+                element.links.push_back(std::move(link));
+            }
+        }
+        for (const auto& row : conn.select(linkExtSql)) {
+            auto found = links.find(row.getUnsigned32("id_link"));
+            if (found != links.end()) {
+                elements[found->second.first].links[found->second.second].ext.push_back(
+                    {row.getString("keytag"), row.getString("value"), row.getBool("read_only")});
+            }
+        }
+        for (const auto& row : conn.select(groupsSql)) {
+            auto found = rows.find(row.getUnsigned32("id"));
+            if (found != rows.end()) {
+                elements[found->second].groups.push_back(row.getString("name"));
+            }
+        }
+
+        // a write in between would store checksums which do not match the data
+        if (tableChecksums(conn) != checksums) {
+            log_debug("Assets changed while writing the snapshot, retried later");
+            return false;
+        }
+    } catch (std::exception& e) {
+        log_error("Asset snapshot could not be read from database: %s", e.what());
+        return false;
+    }
+
+    if (!AssetSnapshot::write(m_snapshotPath, sequence, checksums, elements)) {
+        return false;
+    }
+    m_snapshotSeq = sequence;
+
+    log_info("Asset snapshot with %zu assets written in %lld ms", elements.size(),
+        static_cast<long long>(monotonicMs() - start));
+    return true;
+}
+
 std::vector<std::string> DB::listAllAssets()
 {
+    static auto&            stat = fty::stats::metric("db.listAllAssets");
+    fty::stats::ScopedTimer timer(stat.latency);
+
     std::vector<std::string> assetList;
 
     // clang-format off
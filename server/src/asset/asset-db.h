@@ -20,11 +20,16 @@
 */
 
 #pragma once
+#include "asset-filter.h"
+#include "asset-query.h"
+#include "asset-snapshot.h"
 #include "asset-storage.h"
+#include "sql_trace.h"
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <unordered_set>
 #include <tntdb.h>
 #include <vector>
 
@@ -61,6 +66,13 @@ public:
     void removeExtMap(Asset& asset);
     bool isLastDataCenter(Asset& asset);
 
+    AssetHierarchy     loadHierarchy();
+    /// loads assets keyed by id with their ext attributes and links, in four queries whatever their number
+    void               loadAssets(const std::map<uint32_t, Asset*>& assets);
+    std::set<uint32_t> linkSources(const std::vector<uint32_t>& ids);
+    void               unlinkList(const std::vector<uint32_t>& ids);
+    void               removeList(const std::vector<std::vector<uint32_t>>& byDepth);
+
     void beginTransaction();
     void rollbackTransaction();
     void commitTransaction();
@@ -68,6 +80,9 @@ public:
     void update(Asset& asset);
     void insert(Asset& asset);
 
+    AssetChangeSet computeChanges(const Asset& asset);
+    void           applyChanges(Asset& asset, const AssetChangeSet& changes);
+
     void        saveLinkedAssets(Asset& asset);
     void        saveExtMap(Asset& asset);
     std::string inameById(uint32_t id);
@@ -76,10 +91,71 @@ public:
     std::vector<std::string> listAssets(std::map<std::string, std::vector<std::string>> filters);
     std::vector<std::string> listAllAssets();
 
+    /// answer type/subtype/status/parent LIST filters from memory, rebuilt when older than ttlMs (0 disables)
+    static void setListIndexTtl(int64_t ttlMs);
+
+    std::vector<std::string> queryAssets(const AssetQuery& query);
+
+    /// journal a changed asset and reload it in the QUERY columns before the next query
+    static void assetChanged(const std::string& internalName);
+    /// journal an asset deleted by another process and drop it from the QUERY columns
+    static void assetDeleted(const std::string& internalName);
+    /// full reload of the QUERY columns when older than ttlMs, a safety net for writes which reach neither
+    /// this process nor the asset stream; negative (the default) disables it
+    static void setQueryTtl(int64_t ttlMs);
+
+    /// snapshot file and number of changes between two snapshots, empty path (the default) disables snapshots.
+    /// Validation and writes run on the calling thread and scan every asset table.
+    static void setSnapshot(const std::string& path, uint64_t everyChanges);
+    /// warm LIST index and QUERY columns from the snapshot, false if there is no usable snapshot
+    static bool loadSnapshot();
+    /// compare the loaded snapshot with the database, drops the warmed caches and rewrites it if stale
+    static bool validateSnapshot();
+    /// write a new snapshot once enough changes happened since the last one
+    static void saveSnapshotIfDue();
+
 private:
     DB();
-    std::mutex                m_conn_lock;
-    mutable tntdb::Connection m_conn;
+
+    static DB& instance();
+
+    std::vector<std::string> listFromIndex(const AssetFilterPlan& plan);
+    void                     loadColumns(AssetColumns& columns, const std::vector<std::string>& names);
+    void                     reloadColumns(bool wait);
+    void                     markAllChanged();
+    void                     warmFrom(const AssetSnapshot& snapshot);
+    bool                     saveSnapshot();
+    /// journal a deleted asset, held back until the running transaction commits
+    void                     journalDeleted(const std::string& internalName);
+
+    StoredExtMap            loadStoredExtMap(uint32_t assetId);
+    std::vector<StoredLink> loadStoredLinks(uint32_t assetId);
+    void                    applyExtChanges(uint32_t assetId, const AssetChangeSet& changes);
+    void                    applyLinkChanges(uint32_t assetId, const AssetChangeSet& changes);
+
+    std::mutex               m_conn_lock;
+    mutable TracedConnection m_conn;
+    AssetIndex               m_index;
+    bool                     m_inTransaction = false;
+    std::vector<std::string> m_deleted; // deleted in the running transaction
+
+    // QUERY columns, m_columnsLock guards all of them; full reloads are built aside under m_columnsReloadLock
+    std::mutex                      m_columnsLock;
+    std::mutex                      m_columnsReloadLock;
+    AssetColumns                    m_columns;
+    std::unordered_set<std::string> m_changed;
+    bool                            m_columnsValid      = false;
+    bool                            m_columnsReloading  = false;
+    uint64_t                        m_columnsGeneration = 0; // bumped by markAllChanged
+    int64_t                         m_columnsBuiltAt    = 0;
+    int64_t                         m_queryTtlMs        = -1;
+
+    // snapshot, only used from the main thread of the agent
+    std::string              m_snapshotPath;
+    uint64_t                 m_snapshotEvery  = 1000;
+    uint64_t                 m_snapshotSeq    = 0; // change sequence of the last snapshot
+    bool                     m_snapshotLoaded = false;
+    AssetSnapshot::Checksums m_snapshotChecksums {};
 };
 
 } // namespace fty
@@ -0,0 +1,221 @@
+/*  =========================================================================
+    asset_asset_filter - asset/asset-filter
+
+    Copyright (C) 2016 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    asset_asset_filter - asset/asset-filter
+@discuss
+@end
+*/
+
+#include "asset-filter.h"
+#include <algorithm>
+#include <iterator>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+namespace fty {
+
+struct FilterColumn
+{
+    const char* key;
+    bool        numeric;
+    bool        indexed;
+};
+
+// columns of t_bios_asset_element allowed in LIST filters
+static const FilterColumn filterColumns[] = {
+    {"status", false, true},
+    {"id_type", true, true},
+    {"id_subtype", true, true},
+    {"id_parent", true, true},
+    {"priority", true, false},
+};
+
+static const FilterColumn* findColumn(const std::string& key)
+{
+    for (const auto& c : filterColumns) {
+        if (key == c.key) {
+            return &c;
+        }
+    }
+    return nullptr;
+}
+
+static bool isNumber(const std::string& value)
+{
+    return !value.empty() && value.size() <= 10 && std::all_of(value.begin(), value.end(), [](char c) {
+        return c >= '0' && c <= '9';
+    });
+}
+
+AssetFilterPlan AssetFilterPlan::compile(const Filters& filters)
+{
+    AssetFilterPlan plan;
+
+    std::stringstream where;
+    std::stringstream shape;
+
+    // std::map, keys come in a stable order and so does the SQL
+    for (const auto& filter : filters) {
+        const FilterColumn* column = findColumn(filter.first);
+        if (!column) {
+            throw std::runtime_error("invalid filter " + filter.first);
+        }
+        if (filter.second.empty()) {
+            continue;
+        }
+
+        std::set<std::string> unique;
+        for (const auto& value : filter.second) {
+            if (column->numeric && !isNumber(value)) {
+                throw std::runtime_error("invalid value " + value + " for filter " + filter.first);
+            }
+            unique.insert(value);
+        }
+        auto& values = plan.m_filters[filter.first];
+        values.assign(unique.begin(), unique.end());
+
+        size_t padded = 1;
+        while (padded < values.size()) {
+            padded <<= 1;
+        }
+
+        where << (plan.m_params.empty() ? " WHERE " : " AND ") << filter.first << " IN (";
+        for (size_t i = 0; i < padded; ++i) {
+            std::string name = filter.first + "_" + std::to_string(i);
+            where << (i ? ", " : "") << ":" << name;
+            plan.m_params.push_back({name, values[std::min(i, values.size() - 1)], column->numeric});
+        }
+        where << ")";
+
+        shape << (shape.tellp() > 0 ? "," : "") << filter.first << ":" << padded;
+        plan.m_indexable = plan.m_indexable && column->indexed;
+    }
+
+    plan.m_where = where.str();
+    plan.m_shape = shape.str();
+
+    return plan;
+}
+
+void AssetFilterPlan::bind(tntdb::Statement& q) const
+{
+    for (const auto& p : m_params) {
+        if (p.numeric) {
+            q.set(p.name, static_cast<uint32_t>(std::stoul(p.value)));
+        } else {
+            q.set(p.name, p.value);
+        }
+    }
+}
+
+void AssetIndex::setTtl(int64_t ttlMs)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_ttlMs = ttlMs;
+}
+
+bool AssetIndex::fresh(int64_t now) const
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_ttlMs > 0 && m_builtAt >= 0 && now - m_builtAt < m_ttlMs;
+}
+
+void AssetIndex::invalidate()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_builtAt = -1;
+}
+
+void AssetIndex::rebuild(const std::vector<Row>& rows, int64_t now)
+{
+    std::unordered_map<std::string, Postings> postings;
+    std::vector<std::string>                  names;
+    names.reserve(rows.size());
+
+    for (const auto& row : rows) {
+        uint32_t n = static_cast<uint32_t>(names.size());
+        names.push_back(row.name);
+        postings["status"][row.status].push_back(n);
+        postings["id_type"][std::to_string(row.type)].push_back(n);
+        postings["id_subtype"][std::to_string(row.subtype)].push_back(n);
+        if (row.parent) {
+            postings["id_parent"][std::to_string(row.parent)].push_back(n);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_names    = std::move(names);
+    m_postings = std::move(postings);
+    m_builtAt  = now;
+}
+
+std::vector<std::string> AssetIndex::select(const AssetFilterPlan& plan) const
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    std::vector<uint32_t> result;
+    bool                  first = true;
+
+    for (const auto& filter : plan.filters()) {
+        // union of the values of one key
+        std::vector<uint32_t> matching;
+        auto                  column = m_postings.find(filter.first);
+        if (column != m_postings.end()) {
+            for (const auto& value : filter.second) {
+                auto found = column->second.find(value);
+                if (found != column->second.end()) {
+                    matching.insert(matching.end(), found->second.begin(), found->second.end());
+                }
+            }
+        }
+        std::sort(matching.begin(), matching.end());
+
+        // intersection of all keys
+        if (first) {
+            result = std::move(matching);
+            first  = false;
+        } else {
+            std::vector<uint32_t> both;
+            std::set_intersection(
+                result.begin(), result.end(), matching.begin(), matching.end(), std::back_inserter(both));
+            result = std::move(both);
+        }
+        if (result.empty()) {
+            break;
+        }
+    }
+
+    std::vector<std::string> names;
+    if (first) {
+        names = m_names;
+    } else {
+        names.reserve(result.size());
+        for (uint32_t n : result) {
+            names.push_back(m_names[n]);
+        }
+    }
+    return names;
+}
+
+} // namespace fty
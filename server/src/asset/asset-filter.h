@@ -0,0 +1,129 @@
+/*  =========================================================================
+    asset_asset_filter - asset/asset-filter
+
+    Copyright (C) 2016 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tntdb/statement.h>
+#include <unordered_map>
+#include <vector>
+
+namespace fty {
+
+/// LIST filters compiled to a WHERE clause with bound values.
+///
+/// Filter keys are checked against the columns of t_bios_asset_element which may be filtered on.
+/// Value lists are padded to the next power of two with their last value, so the generated SQL
+/// only depends on the shape of the filter (keys and padded sizes) and the number of cached
+/// statements stays small.
+class AssetFilterPlan
+{
+public:
+    using Filters = std::map<std::string, std::vector<std::string>>;
+
+    /// throws std::runtime_error on unknown key or invalid value
+    static AssetFilterPlan compile(const Filters& filters);
+
+    /// e.g. "id_type:4,status:1", empty without filter
+    const std::string& shape() const
+    {
+        return m_shape;
+    }
+
+    /// " WHERE ..." or empty without filter
+    const std::string& where() const
+    {
+        return m_where;
+    }
+
+    /// true if every key can be answered by the AssetIndex
+    bool indexable() const
+    {
+        return m_indexable;
+    }
+
+    void bind(tntdb::Statement& q) const;
+
+    /// validated values, duplicates removed
+    const Filters& filters() const
+    {
+        return m_filters;
+    }
+
+private:
+    struct Param
+    {
+        std::string name;
+        std::string value;
+        bool        numeric;
+    };
+
+    std::string        m_shape;
+    std::string        m_where;
+    bool               m_indexable = true;
+    std::vector<Param> m_params;
+    Filters            m_filters;
+};
+
+/// In-memory secondary index of t_bios_asset_element on type, subtype, status and parent.
+class AssetIndex
+{
+public:
+    struct Row
+    {
+        std::string name;
+        std::string status;
+        uint32_t    type    = 0;
+        uint32_t    subtype = 0;
+        uint32_t    parent  = 0;
+    };
+
+    /// 0 disables the index
+    void setTtl(int64_t ttlMs);
+
+    bool enabled() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_ttlMs > 0;
+    }
+
+    /// true if enabled and not older than the ttl
+    bool fresh(int64_t now) const;
+
+    void rebuild(const std::vector<Row>& rows, int64_t now);
+    void invalidate();
+
+    /// names matching all filters, in the order rows were given to rebuild()
+    std::vector<std::string> select(const AssetFilterPlan& plan) const;
+
+private:
+    using Postings = std::unordered_map<std::string, std::vector<uint32_t>>;
+
+    mutable std::mutex                        m_lock;
+    int64_t                                   m_ttlMs   = 0;
+    int64_t                                   m_builtAt = -1;
+    std::vector<std::string>                  m_names;
+    std::unordered_map<std::string, Postings> m_postings; // column -> value -> row numbers
+};
+
+} // namespace fty
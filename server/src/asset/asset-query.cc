@@ -0,0 +1,237 @@
+/*  =========================================================================
+    asset_asset_query - asset/asset-query
+
+    Copyright (C) 2016 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    asset_asset_query - asset/asset-query
+@discuss
+@end
+*/
+
+#include "asset-query.h"
+#include <algorithm>
+#include <cxxtools/serializationinfo.h>
+#include <stdexcept>
+
+namespace fty {
+
+static const char* EXT_PREFIX = "ext.";
+
+static const char* coreFields[] = {"name", "type", "subtype", "status", "parent", "priority"};
+
+static bool isCoreField(const std::string& field)
+{
+    for (const char* f : coreFields) {
+        if (field == f) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void operator>>=(const cxxtools::SerializationInfo& si, AssetQuery& query)
+{
+    const cxxtools::SerializationInfo& predicates = si.getMember("predicates");
+
+    for (const auto& p : predicates) {
+        QueryPredicate predicate;
+        std::string    op;
+
+        p.getMember("field") >>= predicate.field;
+        p.getMember("op") >>= op;
+        if (p.findMember("values") != NULL) {
+            p.getMember("values") >>= predicate.values;
+        }
+
+        if (!isCoreField(predicate.field) && predicate.field.compare(0, 4, EXT_PREFIX) != 0) {
+            throw std::runtime_error("invalid query field " + predicate.field);
+        }
+
+        if (op == "eq") {
+            predicate.op = QueryPredicate::Op::Equal;
+        } else if (op == "prefix") {
+            predicate.op = QueryPredicate::Op::Prefix;
+        } else if (op == "in") {
+            predicate.op = QueryPredicate::Op::In;
+        } else if (op == "exists") {
+            predicate.op = QueryPredicate::Op::Exists;
+        } else {
+            throw std::runtime_error("invalid query operator " + op);
+        }
+
+        if (predicate.op != QueryPredicate::Op::Exists && predicate.values.empty()) {
+            throw std::runtime_error("missing values for query field " + predicate.field);
+        }
+        if ((predicate.op == QueryPredicate::Op::Equal || predicate.op == QueryPredicate::Op::Prefix) &&
+            predicate.values.size() != 1) {
+            throw std::runtime_error("one value expected for query field " + predicate.field);
+        }
+
+        query.push_back(std::move(predicate));
+    }
+}
+
+static void setBit(std::vector<uint64_t>& bits, uint32_t n)
+{
+    bits[n >> 6] |= uint64_t(1) << (n & 63);
+}
+
+static bool testBit(const std::vector<uint64_t>& bits, uint32_t n)
+{
+    return (bits[n >> 6] >> (n & 63)) & 1;
+}
+
+void AssetColumns::clear()
+{
+    m_pool.clear();
+    m_interned.clear();
+    m_names.clear();
+    m_rows.clear();
+    m_live.clear();
+    m_columns.clear();
+}
+
+uint32_t AssetColumns::intern(const std::string& value)
+{
+    auto it = m_interned.find(value);
+    if (it == m_interned.end()) {
+        it = m_interned.emplace(value, static_cast<uint32_t>(m_pool.size())).first;
+        m_pool.push_back(value);
+    }
+    return it->second;
+}
+
+uint32_t AssetColumns::addAsset(const std::string& name)
+{
+    removeAsset(name);
+
+    uint32_t row = static_cast<uint32_t>(m_names.size());
+    m_names.push_back(name);
+    m_rows[name] = row;
+
+    m_live.resize((m_names.size() + 63) / 64, 0);
+    setBit(m_live, row);
+
+    set(row, "name", name);
+    return row;
+}
+
+void AssetColumns::removeAsset(const std::string& name)
+{
+    auto it = m_rows.find(name);
+    if (it != m_rows.end()) {
+        m_live[it->second >> 6] &= ~(uint64_t(1) << (it->second & 63));
+        m_rows.erase(it);
+    }
+}
+
+void AssetColumns::set(uint32_t row, const std::string& field, const std::string& value)
+{
+    Column& column = m_columns[field];
+    column.rows.push_back(row);
+    column.values.push_back(intern(value));
+}
+
+AssetColumns::Bitset AssetColumns::valueMask(const QueryPredicate& predicate) const
+{
+    Bitset mask((m_pool.size() + 63) / 64, 0);
+
+    switch (predicate.op) {
+        case QueryPredicate::Op::Exists:
+            std::fill(mask.begin(), mask.end(), ~uint64_t(0));
+            break;
+        case QueryPredicate::Op::Prefix: {
+            const std::string& prefix = predicate.values.front();
+            for (uint32_t v = 0; v < m_pool.size(); ++v) {
+                if (m_pool[v].compare(0, prefix.size(), prefix) == 0) {
+                    setBit(mask, v);
+                }
+            }
+            break;
+        }
+        case QueryPredicate::Op::Equal:
+        case QueryPredicate::Op::In:
+            for (const auto& value : predicate.values) {
+                auto found = m_interned.find(value);
+                if (found != m_interned.end()) {
+                    setBit(mask, found->second);
+                }
+            }
+            break;
+    }
+
+    return mask;
+}
+
+AssetColumns::Bitset AssetColumns::scan(const Column& column, const Bitset& mask) const
+{
+    Bitset result(m_live.size(), 0);
+
+    const uint32_t* rows   = column.rows.data();
+    const uint32_t* values = column.values.data();
+    const size_t    size   = column.values.size();
+
+    // branch free, the compiler may vectorize the mask lookups
+    for (size_t i = 0; i < size; ++i) {
+        uint64_t hit = (mask[values[i] >> 6] >> (values[i] & 63)) & 1;
+        result[rows[i] >> 6] |= hit << (rows[i] & 63);
+    }
+
+    return result;
+}
+
+std::vector<std::string> AssetColumns::evaluate(const AssetQuery& query) const
+{
+    Bitset result = m_live;
+
+    for (const auto& predicate : query) {
+        if (predicate.field.compare(0, 4, EXT_PREFIX) != 0 && !isCoreField(predicate.field)) {
+            throw std::runtime_error("invalid query field " + predicate.field);
+        }
+
+        auto column = m_columns.find(predicate.field);
+        if (column == m_columns.end()) {
+            // nobody has this attribute
+            return {};
+        }
+
+        Bitset matching = scan(column->second, valueMask(predicate));
+
+        bool any = false;
+        for (size_t w = 0; w < result.size(); ++w) {
+            result[w] &= matching[w];
+            any = any || result[w];
+        }
+        if (!any) {
+            return {};
+        }
+    }
+
+    std::vector<std::string> names;
+    for (uint32_t row = 0; row < m_names.size(); ++row) {
+        if (testBit(result, row)) {
+            names.push_back(m_names[row]);
+        }
+    }
+    return names;
+}
+
+} // namespace fty
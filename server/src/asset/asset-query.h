@@ -0,0 +1,111 @@
+/*  =========================================================================
+    asset_asset_query - asset/asset-query
+
+    Copyright (C) 2016 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cxxtools {
+class SerializationInfo;
+}
+
+namespace fty {
+
+/// One condition of a QUERY request.
+///
+/// field is one of name, type, subtype, status, parent, priority, or "ext.<keytag>" for ext attributes.
+struct QueryPredicate
+{
+    enum class Op
+    {
+        Equal,
+        Prefix,
+        In,
+        Exists
+    };
+
+    std::string              field;
+    Op                       op = Op::Equal;
+    std::vector<std::string> values;
+};
+
+/// all predicates must match
+using AssetQuery = std::vector<QueryPredicate>;
+
+/// {"predicates": [{"field": "ext.model", "op": "eq|prefix|in|exists", "values": ["..."]}, ...]}
+void operator>>=(const cxxtools::SerializationInfo& si, AssetQuery& query);
+
+/// Columnar copy of core fields and ext attributes, for QUERY.
+///
+/// Every field is a column of (row, interned value) pairs, rows are assets. A predicate turns into
+/// a mask over interned values, the column is scanned once against it into a bitset of rows, and
+/// bitsets of all predicates are intersected. Reloaded assets get a new row, the old one is only
+/// marked dead, the owner rebuilds everything once dead rows pile up.
+class AssetColumns
+{
+public:
+    void clear();
+
+    /// new row for this asset, replaces any previous one
+    uint32_t addAsset(const std::string& name);
+    void     removeAsset(const std::string& name);
+
+    void set(uint32_t row, const std::string& field, const std::string& value);
+
+    /// internal names of live rows matching all predicates, throws std::runtime_error on unknown core field
+    std::vector<std::string> evaluate(const AssetQuery& query) const;
+
+    size_t rows() const
+    {
+        return m_names.size();
+    }
+
+    size_t deadRows() const
+    {
+        return m_names.size() - m_rows.size();
+    }
+
+private:
+    using Bitset = std::vector<uint64_t>;
+
+    struct Column
+    {
+        std::vector<uint32_t> rows;
+        std::vector<uint32_t> values;
+    };
+
+    uint32_t intern(const std::string& value);
+    Bitset   valueMask(const QueryPredicate& predicate) const;
+    Bitset   scan(const Column& column, const Bitset& mask) const;
+
+    std::vector<std::string>                  m_pool;
+    std::unordered_map<std::string, uint32_t> m_interned;
+
+    std::vector<std::string>                  m_names; // by row, dead rows included
+    std::unordered_map<std::string, uint32_t> m_rows;  // live rows
+    Bitset                                    m_live;
+
+    std::unordered_map<std::string, Column> m_columns;
+};
+
+} // namespace fty
@@ -0,0 +1,423 @@
+/*  =========================================================================
+    asset_asset_snapshot - asset/asset-snapshot
+
+    Copyright (C) 2016 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    asset_asset_snapshot - asset/asset-snapshot
+@discuss
+@end
+*/
+
+#include "asset-snapshot.h"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fty_log.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace fty {
+
+static constexpr char     SNAPSHOT_MAGIC[8] = {'F', 'T', 'Y', 'A', 'S', 'N', 'A', 'P'};
+static constexpr uint32_t SNAPSHOT_VERSION  = 2;
+
+struct AssetSnapshot::Header
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t strings;
+    uint64_t sequence;
+    uint64_t checksums[TableCount];
+    uint32_t count[TableCount];
+    uint64_t offset[TableCount];
+    uint64_t stringOffsets;
+    uint64_t stringData;
+    uint64_t size;
+};
+
+namespace {
+
+    struct ElementRecord
+    {
+        uint32_t id;
+        uint32_t name;
+        uint32_t type;
+        uint32_t subtype;
+        uint32_t status;
+        uint32_t parent;
+        uint32_t typeId;
+        uint32_t subtypeId;
+        uint32_t parentId;
+        int32_t  priority;
+        uint32_t ext;
+        uint32_t extCount;
+        uint32_t links;
+        uint32_t linkCount;
+        uint32_t groups;
+        uint32_t groupCount;
+    };
+
+    struct ExtRecord
+    {
+        uint32_t key;
+        uint32_t value;
+        uint32_t readOnly;
+    };
+
+    struct LinkRecord
+    {
+        uint32_t source;
+        uint32_t srcOut;
+        uint32_t destIn;
+        uint32_t type;
+        uint32_t ext;
+        uint32_t extCount;
+    };
+
+    struct GroupRecord
+    {
+        uint32_t name;
+    };
+
+    const size_t RECORD_SIZE[AssetSnapshot::TableCount] = {
+        sizeof(ElementRecord), sizeof(ExtRecord), sizeof(LinkRecord), sizeof(GroupRecord), sizeof(ExtRecord)};
+
+    class StringPool
+    {
+    public:
+        StringPool()
+        {
+            // index 0 is the empty string, e.g. no parent
+            intern("");
+        }
+
+        uint32_t intern(const std::string& value)
+        {
+            auto found = m_index.find(value);
+            if (found != m_index.end()) {
+                return found->second;
+            }
+            uint32_t index = static_cast<uint32_t>(m_pool.size());
+            m_pool.push_back(value);
+            m_index.emplace(value, index);
+            return index;
+        }
+
+        const std::vector<std::string>& pool() const
+        {
+            return m_pool;
+        }
+
+    private:
+        std::vector<std::string>                  m_pool;
+        std::unordered_map<std::string, uint32_t> m_index;
+    };
+
+    size_t align8(size_t offset)
+    {
+        return (offset + 7) & ~size_t(7);
+    }
+
+    template <typename T>
+    void put(std::vector<char>& buffer, size_t offset, const std::vector<T>& records)
+    {
+        if (!records.empty()) {
+            std::memcpy(buffer.data() + offset, records.data(), records.size() * sizeof(T));
+        }
+    }
+
+} // namespace
+
+bool AssetSnapshot::write(const std::string& path, uint64_t sequence, const Checksums& checksums,
+    const std::vector<Element>& elements)
+{
+    StringPool                 strings;
+    std::vector<ElementRecord> elementRecords;
+    std::vector<ExtRecord>     extRecords;
+    std::vector<LinkRecord>    linkRecords;
+    std::vector<GroupRecord>   groupRecords;
+    std::vector<ExtRecord>     linkExtRecords;
+
+    elementRecords.reserve(elements.size());
+    for (const auto& e : elements) {
+        ElementRecord r;
+        r.id         = e.id;
+        r.name       = strings.intern(e.name);
+        r.type       = strings.intern(e.type);
+        r.subtype    = strings.intern(e.subtype);
+        r.status     = strings.intern(e.status);
+        r.parent     = strings.intern(e.parent);
+        r.typeId     = e.typeId;
+        r.subtypeId  = e.subtypeId;
+        r.parentId   = e.parentId;
+        r.priority   = e.priority;
+        r.ext        = static_cast<uint32_t>(extRecords.size());
+        r.extCount   = static_cast<uint32_t>(e.ext.size());
+        r.links      = static_cast<uint32_t>(linkRecords.size());
+        r.linkCount  = static_cast<uint32_t>(e.links.size());
+        r.groups     = static_cast<uint32_t>(groupRecords.size());
+        r.groupCount = static_cast<uint32_t>(e.groups.size());
+        elementRecords.push_back(r);
+
+        for (const auto& x : e.ext) {
+            extRecords.push_back({strings.intern(x.key), strings.intern(x.value), x.readOnly ? 1u : 0u});
+        }
+        for (const auto& l : e.links) {
+            linkRecords.push_back({strings.intern(l.source), strings.intern(l.srcOut), strings.intern(l.destIn), l.type,
+                static_cast<uint32_t>(linkExtRecords.size()), static_cast<uint32_t>(l.ext.size())});
+            for (const auto& x : l.ext) {
+                linkExtRecords.push_back({strings.intern(x.key), strings.intern(x.value), x.readOnly ? 1u : 0u});
+            }
+        }
+        for (const auto& g : e.groups) {
+            groupRecords.push_back({strings.intern(g)});
+        }
+    }
+
+    const auto& pool = strings.pool();
+
+    std::vector<uint32_t> stringOffsets;
+    stringOffsets.reserve(pool.size() + 1);
+    uint32_t dataSize = 0;
+    for (const auto& s : pool) {
+        stringOffsets.push_back(dataSize);
+        dataSize += static_cast<uint32_t>(s.size());
+    }
+    stringOffsets.push_back(dataSize);
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version  = SNAPSHOT_VERSION;
+    header.strings  = static_cast<uint32_t>(pool.size());
+    header.sequence = sequence;
+    for (size_t t = 0; t < TableCount; ++t) {
+        header.checksums[t] = checksums[t];
+    }
+    header.count[Elements]       = static_cast<uint32_t>(elementRecords.size());
+    header.count[ExtAttributes]  = static_cast<uint32_t>(extRecords.size());
+    header.count[Links]          = static_cast<uint32_t>(linkRecords.size());
+    header.count[Groups]         = static_cast<uint32_t>(groupRecords.size());
+    header.count[LinkAttributes] = static_cast<uint32_t>(linkExtRecords.size());
+
+    size_t offset        = align8(sizeof(Header));
+    header.stringOffsets = offset;
+    offset               = align8(offset + stringOffsets.size() * sizeof(uint32_t));
+    for (size_t t = 0; t < TableCount; ++t) {
+        header.offset[t] = offset;
+        offset           = align8(offset + header.count[t] * RECORD_SIZE[t]);
+    }
+    header.stringData = offset;
+    header.size       = offset + dataSize;
+
+    std::vector<char> buffer(header.size, 0);
+    std::memcpy(buffer.data(), &header, sizeof(header));
+    put(buffer, header.stringOffsets, stringOffsets);
+    put(buffer, header.offset[Elements], elementRecords);
+    put(buffer, header.offset[ExtAttributes], extRecords);
+    put(buffer, header.offset[Links], linkRecords);
+    put(buffer, header.offset[Groups], groupRecords);
+    put(buffer, header.offset[LinkAttributes], linkExtRecords);
+    for (size_t i = 0; i < pool.size(); ++i) {
+        std::memcpy(buffer.data() + header.stringData + stringOffsets[i], pool[i].data(), pool[i].size());
+    }
+
+    const std::string tmp = path + ".tmp";
+
+    FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) {
+        log_error("Asset snapshot %s could not be created", tmp.c_str());
+        return false;
+    }
+    bool ok = std::fwrite(buffer.data(), 1, buffer.size(), f) == buffer.size();
+    ok      = std::fflush(f) == 0 && ok;
+    ok      = fsync(fileno(f)) == 0 && ok;
+    ok      = std::fclose(f) == 0 && ok;
+
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        log_error("Asset snapshot %s could not be written", path.c_str());
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+AssetSnapshot::~AssetSnapshot()
+{
+    close();
+}
+
+bool AssetSnapshot::open(const std::string& path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(Header)) {
+        ::close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    // everything is read once to warm the caches
+    madvise(data, size_t(st.st_size), MADV_SEQUENTIAL);
+
+    m_data = static_cast<const char*>(data);
+    m_size = size_t(st.st_size);
+
+    // bounds of every table, so accessors need no checks
+    const Header* h  = header();
+    bool          ok = std::memcmp(h->magic, SNAPSHOT_MAGIC, sizeof(h->magic)) == 0 &&
+              h->version == SNAPSHOT_VERSION && h->size == m_size && h->stringData <= m_size &&
+              h->stringOffsets + (uint64_t(h->strings) + 1) * sizeof(uint32_t) <= m_size;
+    for (size_t t = 0; ok && t < TableCount; ++t) {
+        ok = h->offset[t] % 8 == 0 && h->offset[t] + uint64_t(h->count[t]) * RECORD_SIZE[t] <= m_size;
+    }
+
+    if (ok) {
+        auto     offsets  = reinterpret_cast<const uint32_t*>(m_data + h->stringOffsets);
+        uint64_t dataSize = m_size - h->stringData;
+        for (uint32_t i = 0; ok && i < h->strings; ++i) {
+            ok = offsets[i] <= offsets[i + 1] && offsets[i + 1] <= dataSize;
+        }
+    }
+
+    if (ok) {
+        auto elements = reinterpret_cast<const ElementRecord*>(m_data + h->offset[Elements]);
+        for (uint32_t i = 0; ok && i < h->count[Elements]; ++i) {
+            const ElementRecord& r = elements[i];
+            ok = uint64_t(r.ext) + r.extCount <= h->count[ExtAttributes] &&
+                 uint64_t(r.links) + r.linkCount <= h->count[Links] &&
+                 uint64_t(r.groups) + r.groupCount <= h->count[Groups] && r.name < h->strings &&
+                 r.type < h->strings && r.subtype < h->strings && r.status < h->strings && r.parent < h->strings;
+        }
+    }
+
+    if (ok) {
+        auto links = reinterpret_cast<const LinkRecord*>(m_data + h->offset[Links]);
+        for (uint32_t i = 0; ok && i < h->count[Links]; ++i) {
+            ok = uint64_t(links[i].ext) + links[i].extCount <= h->count[LinkAttributes];
+        }
+    }
+
+    if (!ok) {
+        log_warning("Asset snapshot %s is not valid, ignored", path.c_str());
+        close();
+    }
+    return ok;
+}
+
+void AssetSnapshot::close()
+{
+    if (m_data) {
+        munmap(const_cast<char*>(m_data), m_size);
+    }
+    m_data = nullptr;
+    m_size = 0;
+}
+
+const AssetSnapshot::Header* AssetSnapshot::header() const
+{
+    return reinterpret_cast<const Header*>(m_data);
+}
+
+std::string AssetSnapshot::string(uint32_t index) const
+{
+    const Header* h       = header();
+    auto          offsets = reinterpret_cast<const uint32_t*>(m_data + h->stringOffsets);
+    if (index >= h->strings) {
+        return {};
+    }
+    return std::string(m_data + h->stringData + offsets[index], offsets[index + 1] - offsets[index]);
+}
+
+uint64_t AssetSnapshot::sequence() const
+{
+    return header()->sequence;
+}
+
+AssetSnapshot::Checksums AssetSnapshot::checksums() const
+{
+    Checksums checksums;
+    for (size_t t = 0; t < TableCount; ++t) {
+        checksums[t] = header()->checksums[t];
+    }
+    return checksums;
+}
+
+size_t AssetSnapshot::size() const
+{
+    return m_data ? header()->count[Elements] : 0;
+}
+
+AssetSnapshot::Element AssetSnapshot::element(size_t index) const
+{
+    const Header* h = header();
+    const auto&   r = reinterpret_cast<const ElementRecord*>(m_data + h->offset[Elements])[index];
+
+    Element e;
+    e.id        = r.id;
+    e.name      = string(r.name);
+    e.type      = string(r.type);
+    e.subtype   = string(r.subtype);
+    e.status    = string(r.status);
+    e.parent    = string(r.parent);
+    e.typeId    = r.typeId;
+    e.subtypeId = r.subtypeId;
+    e.parentId  = r.parentId;
+    e.priority  = r.priority;
+
+    auto ext = reinterpret_cast<const ExtRecord*>(m_data + h->offset[ExtAttributes]) + r.ext;
+    for (uint32_t i = 0; i < r.extCount; ++i) {
+        e.ext.push_back({string(ext[i].key), string(ext[i].value), ext[i].readOnly != 0});
+    }
+    auto links    = reinterpret_cast<const LinkRecord*>(m_data + h->offset[Links]) + r.links;
+    auto linkExts = reinterpret_cast<const ExtRecord*>(m_data + h->offset[LinkAttributes]);
+    for (uint32_t i = 0; i < r.linkCount; ++i) {
+        Link link;
+        link.source = string(links[i].source);
+        link.srcOut = string(links[i].srcOut);
+        link.destIn = string(links[i].destIn);
+        link.type   = links[i].type;
+        for (uint32_t j = 0; j < links[i].extCount; ++j) {
+            const ExtRecord& x = linkExts[links[i].ext + j];
+            link.ext.push_back({string(x.key), string(x.value), x.readOnly != 0});
+        }
+        e.links.push_back(std::move(link));
+    }
+    auto groups = reinterpret_cast<const GroupRecord*>(m_data + h->offset[Groups]) + r.groups;
+    for (uint32_t i = 0; i < r.groupCount; ++i) {
+        e.groups.push_back(string(groups[i].name));
+    }
+    return e;
+}
+
+} // namespace fty
@@ -0,0 +1,125 @@
+/*  =========================================================================
+    asset_asset_snapshot - asset/asset-snapshot
+
+    Copyright (C) 2016 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fty {
+
+/// Binary copy of the asset model, read back with mmap at startup.
+///
+/// Layout: header, string offset table, string data, then fixed size records for elements, ext
+/// attributes, links, groups and link attributes. Strings are interned, records refer to them by
+/// index, every element refers to its own contiguous range of ext/link/group records and every link
+/// to its range of attributes. The file is written to a temporary name and renamed, a reader never
+/// sees a partial snapshot.
+class AssetSnapshot
+{
+public:
+    enum Table
+    {
+        Elements,
+        ExtAttributes,
+        Links,
+        Groups,
+        LinkAttributes,
+        TableCount
+    };
+
+    using Checksums = std::array<uint64_t, TableCount>;
+
+    struct ExtAttribute
+    {
+        std::string key;
+        std::string value;
+        bool        readOnly = false;
+    };
+
+    struct Link
+    {
+        std::string               source;
+        std::string               srcOut; // empty if NULL
+        std::string               destIn; // empty if NULL
+        uint32_t                  type = 0;
+        std::vector<ExtAttribute> ext;
+    };
+
+    struct Element
+    {
+        uint32_t    id = 0;
+        std::string name;
+        std::string type;
+        std::string subtype;
+        std::string status;
+        std::string parent;
+        uint32_t    typeId    = 0;
+        uint32_t    subtypeId = 0;
+        uint32_t    parentId  = 0;
+        int         priority  = 0;
+
+        std::vector<ExtAttribute> ext;
+        std::vector<Link>         links;
+        std::vector<std::string>  groups;
+    };
+
+    AssetSnapshot() = default;
+    ~AssetSnapshot();
+
+    AssetSnapshot(const AssetSnapshot&) = delete;
+    AssetSnapshot& operator=(const AssetSnapshot&) = delete;
+
+    /// atomically replaces path, returns false (and logs) on I/O error
+    static bool write(const std::string& path, uint64_t sequence, const Checksums& checksums,
+        const std::vector<Element>& elements);
+
+    /// maps path, returns false if missing, truncated or of another version
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const
+    {
+        return m_data != nullptr;
+    }
+
+    /// change sequence when written
+    uint64_t sequence() const;
+
+    /// per-table checksums of the database when written
+    Checksums checksums() const;
+
+    size_t  size() const;
+    Element element(size_t index) const;
+
+private:
+    struct Header;
+
+    const Header* header() const;
+    std::string   string(uint32_t index) const;
+
+    const char* m_data = nullptr;
+    size_t      m_size = 0;
+};
+
+} // namespace fty
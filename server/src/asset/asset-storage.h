@@ -20,9 +20,13 @@
 */
 
 #pragma once
+#include "asset-changeset.h"
+#include "asset-query.h"
 #include <fty/expected.h>
 #include <map>
+#include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace fty {
@@ -30,6 +34,17 @@ namespace fty {
 class Asset;
 class AssetLink;
 
+/// skeleton of an asset in the location tree
+struct AssetNode
+{
+    uint32_t    id = 0;
+    std::string parent;
+    std::string type;
+};
+
+/// all assets by internal name
+using AssetHierarchy = std::unordered_map<std::string, AssetNode>;
+
 class AssetStorage
 {
 public:
@@ -61,6 +76,13 @@ public:
     virtual void removeExtMap(Asset& asset)          = 0;
     virtual bool isLastDataCenter(Asset& asset)      = 0;
 
+    // batched deletion
+    virtual AssetHierarchy     loadHierarchy()                                               = 0;
+    virtual void               loadAssets(const std::map<uint32_t, Asset*>& assets)          = 0;
+    virtual std::set<uint32_t> linkSources(const std::vector<uint32_t>& ids)                 = 0;
+    virtual void               unlinkList(const std::vector<uint32_t>& ids)                  = 0;
+    virtual void               removeList(const std::vector<std::vector<uint32_t>>& byDepth) = 0;
+
     virtual void beginTransaction()    = 0;
     virtual void rollbackTransaction() = 0;
     virtual void commitTransaction()   = 0;
@@ -68,6 +90,9 @@ public:
     virtual void update(Asset& asset) = 0;
     virtual void insert(Asset& asset) = 0;
 
+    virtual AssetChangeSet computeChanges(const Asset& asset)                        = 0;
+    virtual void           applyChanges(Asset& asset, const AssetChangeSet& changes) = 0;
+
     virtual void        saveLinkedAssets(Asset& asset)       = 0;
     virtual void        saveExtMap(Asset& asset)             = 0;
     virtual std::string inameById(uint32_t id)               = 0;
@@ -75,6 +100,7 @@ public:
 
     virtual std::vector<std::string> listAssets(std::map<std::string, std::vector<std::string>> filters) = 0;
     virtual std::vector<std::string> listAllAssets()                                                     = 0;
+    virtual std::vector<std::string> queryAssets(const AssetQuery& query)                                = 0;
 };
 
 } // namespace fty
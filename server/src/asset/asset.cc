@@ -38,17 +38,18 @@
 #include <openssl/sha.h>
 #include <sstream>
 #include <time.h>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <uuid/uuid.h>
 #include <fty_common_agents.h>
-
-#define AGENT_ASSET_ACTIVATOR "etn-licensing-credits"
+#include <fty_asset_activation.h>
 
 #define MAX_CREATE_RETRY 10
 
-#define COMMAND_IS_ASSET_ACTIVABLE  "GET_IS_ASSET_ACTIVABLE"
-#define COMMAND_ACTIVATE_ASSET      "ACTIVATE_ASSET"
-#define COMMAND_DEACTIVATE_ASSET    "DEACTIVATE_ASSET"
+using fty::activation::COMMAND_IS_ASSET_ACTIVABLE;
+using fty::activation::COMMAND_ACTIVATE_ASSET;
+using fty::activation::COMMAND_DEACTIVATE_ASSET;
 
 namespace fty {
 
@@ -150,7 +151,7 @@ void operator>>=(const cxxtools::SerializationInfo& si, AssetFilters& filters)
             status >>= v;
 
             for (const std::string& val : v) {
-                filters["status"].push_back('"' + val + '"');
+                filters["status"].push_back(val);
             }
         }
     } catch (const std::exception& e) {
@@ -274,14 +275,18 @@ bool AssetImpl::hasLogicalAsset() const
     return getExt().find("logical_asset") != getExt().end();
 }
 
-bool AssetImpl::isVirtual() const
+static bool isVirtualType(const std::string& type)
 {
+    return ((type == TYPE_INFRA_SERVICE) || (type == TYPE_CLUSTER) || (type == TYPE_HYPERVISOR) ||
+            (type == TYPE_VIRTUAL_MACHINE) || (type == TYPE_STORAGE_SERVICE) ||
+            (type == TYPE_VAPP) || (type == TYPE_CONNECTOR) ||
+            (type == TYPE_SERVER) || (type == TYPE_PLANNER) ||
+            (type == TYPE_OPERATING_SYSTEM) || (type == TYPE_PLAN));
+}
 
-    return ((getAssetType() == TYPE_INFRA_SERVICE) || (getAssetType() == TYPE_CLUSTER) || (getAssetType() == TYPE_HYPERVISOR) ||
-            (getAssetType() == TYPE_VIRTUAL_MACHINE) || (getAssetType() == TYPE_STORAGE_SERVICE) ||
-            (getAssetType() == TYPE_VAPP) || (getAssetType() == TYPE_CONNECTOR) ||
-            (getAssetType() == TYPE_SERVER) || (getAssetType() == TYPE_PLANNER) ||
-            (getAssetType() == TYPE_OPERATING_SYSTEM) || (getAssetType() == TYPE_PLAN));
+bool AssetImpl::isVirtual() const
+{
+    return isVirtualType(getAssetType());
 }
 
 bool AssetImpl::hasLinkedAssets() const
@@ -439,17 +444,24 @@ void AssetImpl::create()
 
 void AssetImpl::update()
 {
+    if (!g_testMode && !m_storage.getID(getInternalName())) {
+        throw std::runtime_error("Update failed, asset does not exist.");
+    }
+
+    // diff against the stored state, nothing to write if the asset is unchanged
+    AssetChangeSet changes = m_storage.computeChanges(*this);
+    if (changes.empty()) {
+        log_debug("Asset %s is unchanged, skipping update", getInternalName().c_str());
+        return;
+    }
+
+    // set last update timestamp
+    setExtEntry(fty::EXT_UPDATE_TS, generateCurrentTimestamp(), true);
+    changes.upsertExt(fty::EXT_UPDATE_TS, getExtEntry(fty::EXT_UPDATE_TS), true);
+
     m_storage.beginTransaction();
     try {
-        if (!g_testMode && !m_storage.getID(getInternalName())) {
-            throw std::runtime_error("Update failed, asset does not exist.");
-        }
-        // set last update timestamp
-        setExtEntry(fty::EXT_UPDATE_TS, generateCurrentTimestamp(), true);
-
-        m_storage.update(*this);
-        m_storage.saveLinkedAssets(*this);
-        m_storage.saveExtMap(*this);
+        m_storage.applyChanges(*this, changes);
     } catch (const std::exception& e) {
         m_storage.rollbackTransaction();
         throw std::runtime_error(std::string(e.what()));
@@ -501,30 +513,11 @@ void AssetImpl::restore(bool restoreLinks)
 
 static std::vector<std::string> sendActivationReq(const std::string & command, const std::vector<std::string> & frames)
 {
-    mlm::MlmSyncClient client(AGENT_FTY_ASSET, AGENT_ASSET_ACTIVATOR);
-
-    log_debug("Sending %s request to %s", command.c_str(), AGENT_ASSET_ACTIVATOR);
-
     std::vector<std::string> payload = {command};
     std::copy(frames.begin(), frames.end(), back_inserter(payload));
 
-    std::vector<std::string> receivedFrames = client.syncRequestWithReply(payload);
-
-    //check if the first frame we get is an error
-    if(receivedFrames[0] == "ERROR")
-    {
-        //It's an error and we will throw directly the exceptions
-        if(receivedFrames.size() == 2)
-        {
-            throw std::runtime_error(receivedFrames.at(1));
-        }
-        else
-        {
-            throw std::runtime_error("Missing data for error");
-        }
-    }
-
-    return receivedFrames;
+    // throws directly on an error reply
+    return activation::request(payload);
 }
 
 bool AssetImpl::isActivable()
@@ -598,6 +591,45 @@ void AssetImpl::deactivate()
     }
 }
 
+std::vector<std::string> AssetImpl::activateBatch(const std::vector<AssetImpl*>& assets)
+{
+    std::vector<std::string> result(assets.size());
+    std::vector<std::string> devices;
+    std::vector<size_t>      index;
+
+    if (g_testMode) {
+        return result;
+    }
+
+    for (size_t i = 0; i < assets.size(); ++i) {
+        if (assets[i]->getAssetType() == TYPE_DEVICE) {
+            devices.push_back(Asset::toFullAsset(*assets[i]).toJson());
+            index.push_back(i);
+        }
+    }
+
+    auto activated = activation::activate(devices);
+    for (size_t i = 0; i < index.size(); ++i) {
+        result[index[i]] = activated[i];
+        if (!activated[i].empty()) {
+            log_error("Asset %s activation failed: %s", assets[index[i]]->m_internalName.c_str(), activated[i].c_str());
+        }
+    }
+
+    for (size_t i = 0; i < assets.size(); ++i) {
+        if (!result[i].empty()) {
+            continue;
+        }
+        try {
+            assets[i]->setAssetStatus(fty::AssetStatus::Active);
+            assets[i]->m_storage.update(*assets[i]);
+        } catch (const std::exception& e) {
+            result[i] = e.what();
+        }
+    }
+    return result;
+}
+
 void AssetImpl::unlinkAll()
 {
     m_storage.unlinkAll(*this);
@@ -787,6 +819,11 @@ std::vector<std::string> AssetImpl::list(const AssetFilters& filters)
     return getStorage().listAssets(filters);
 }
 
+std::vector<std::string> AssetImpl::query(const AssetQuery& query)
+{
+    return getStorage().queryAssets(query);
+}
+
 std::vector<std::string> AssetImpl::listAll()
 {
     return getStorage().listAllAssets();
@@ -799,127 +836,274 @@ void AssetImpl::load()
     m_storage.loadLinkedAssets(*this);
 }
 
-static void addSubTree(const std::string& internalName, std::vector<AssetImpl>& toDel)
+// depth of an asset in the location tree, memoized
+static int depthOf(
+    const std::string& iname, const AssetHierarchy& hierarchy, std::unordered_map<std::string, int>& depths)
 {
-    std::vector<std::pair<AssetImpl, int>> stack;
+    auto cached = depths.find(iname);
+    if (cached != depths.end()) {
+        return cached->second;
+    }
 
-    AssetImpl a(internalName);
+    // walk up to the first known ancestor, bounded in case of a corrupted tree
+    std::vector<std::string> path;
+    std::string              ptr  = iname;
+    int                      base = -1;
+    while (path.size() < hierarchy.size() + 1) {
+        auto known = depths.find(ptr);
+        if (known != depths.end()) {
+            base = known->second;
+            break;
+        }
+        path.push_back(ptr);
+        auto node = hierarchy.find(ptr);
+        if (node == hierarchy.end() || node->second.parent.empty()) {
+            break;
+        }
+        ptr = node->second.parent;
+    }
 
-    AssetImpl& ref = a;
+    for (auto it = path.rbegin(); it != path.rend(); ++it) {
+        depths[*it] = ++base;
+    }
+    return depths[iname];
+}
 
-    bool         end  = false;
-    unsigned int next = 0;
+DeleteStatus AssetImpl::deleteList(const std::vector<std::string>& assets, bool recursive, bool deleteVirtualAssets, bool removeLastDC)
+{
+    AssetStorage& storage = getStorage();
 
-    while (!end) {
-        std::vector<std::string> children = getChildren(ref);
+    // whole location tree in one query, the planner works in memory from here
+    AssetHierarchy hierarchy = storage.loadHierarchy();
 
-        if (next < children.size()) {
-            stack.push_back(std::make_pair(ref, next + 1));
+    std::unordered_map<std::string, std::vector<std::string>> children;
+    for (const auto& node : hierarchy) {
+        if (!node.second.parent.empty()) {
+            children[node.second.parent].push_back(node.first);
+        }
+    }
 
-            ref  = children[next];
-            next = 0;
+    // planned from the hierarchy alone, the assets are loaded all at once below
+    std::vector<std::string>        plan;
+    std::unordered_set<std::string> planned;
 
-            auto found = std::find_if(toDel.begin(), toDel.end(), [&](const AssetImpl& assetImpl) {
-                return assetImpl.getInternalName() == ref.getInternalName();
-            });
-            if (found == toDel.end()) {
-                toDel.push_back(ref);
+    for (const std::string& iname : assets) {
+        if (planned.count(iname)) {
+            continue;
+        }
+        auto node = hierarchy.find(iname);
+        if (node == hierarchy.end()) {
+            log_warning("Error while loading asset %s. Asset not found", iname.c_str());
+            continue;
+        }
+        if (isVirtualType(node->second.type) && !deleteVirtualAssets) {
+            log_info("Asset %s is virtual, skipping delete...", iname.c_str());
+            continue;
+        }
+        planned.insert(iname);
+        plan.push_back(iname);
+
+        if (!recursive) {
+            continue;
+        }
+
+        std::vector<std::string> stack = {iname};
+        while (!stack.empty()) {
+            std::string parent = stack.back();
+            stack.pop_back();
+
+            auto found = children.find(parent);
+            if (found == children.end()) {
+                continue;
             }
-        } else {
-            if (stack.empty()) {
-                end = true;
-            } else {
-                ref  = stack.back().first;
-                next = static_cast<unsigned int>(stack.back().second);
-                stack.pop_back();
+            for (const auto& child : found->second) {
+                if (planned.insert(child).second) {
+                    plan.push_back(child);
+                    stack.push_back(child);
+                }
             }
         }
     }
-}
 
-DeleteStatus AssetImpl::deleteList(const std::vector<std::string>& assets, bool recursive, bool deleteVirtualAssets, bool removeLastDC)
-{
-    std::vector<AssetImpl> toDel;
+    std::vector<AssetImpl> toDel(plan.size());
+    try {
+        std::map<uint32_t, Asset*> byId;
+        for (size_t i = 0; i < plan.size(); ++i) {
+            toDel[i].setInternalName(plan[i]);
+            byId.emplace(hierarchy.at(plan[i]).id, &toDel[i]);
+        }
+        storage.loadAssets(byId);
+    } catch (std::exception& e) {
+        log_error("Assets could not be loaded: %s", e.what());
+
+        // nothing is deleted, each planned asset reports why
+        DeleteStatus failed;
+        for (const AssetImpl& d : toDel) {
+            failed.push_back({d, "Assets could not be loaded: " + std::string(e.what())});
+        }
+        return failed;
+    }
 
-    DeleteStatus deleted;
+    // sort by deletion order, deepest first
+    std::unordered_map<std::string, int> depths;
+    std::vector<std::pair<int, size_t>>  order;
+    order.reserve(toDel.size());
+    for (size_t i = 0; i < toDel.size(); ++i) {
+        order.emplace_back(depthOf(toDel[i].getInternalName(), hierarchy, depths), i);
+    }
+    std::stable_sort(order.begin(), order.end(), [](const std::pair<int, size_t>& l, const std::pair<int, size_t>& r) {
+        return l.first > r.first;
+    });
 
-    for (const std::string& iname : assets) {
-        try {
-            AssetImpl a(iname);
-            if(a.isVirtual() && !deleteVirtualAssets) {
-                log_info("Asset %s is virtual, skipping delete...", a.getInternalName().c_str());
-                continue;
+    auto idOf = [&](const std::string& iname) -> uint32_t {
+        auto node = hierarchy.find(iname);
+        return node != hierarchy.end() ? node->second.id : 0;
+    };
+
+    std::vector<uint32_t> ids;
+    ids.reserve(order.size());
+    for (const auto& o : order) {
+        ids.push_back(idOf(toDel[o.second].getInternalName()));
+    }
+
+    DeleteStatus                    deleted;
+    std::vector<std::string>        errors(toDel.size());
+    std::unordered_set<std::string> removed;
+
+    try {
+        // remove all links
+        storage.unlinkList(ids);
+        std::set<uint32_t> sources = storage.linkSources(ids);
+
+        int dcCount = 0;
+        for (const auto& node : hierarchy) {
+            if (node.second.type == TYPE_DATACENTER) {
+                dcCount++;
             }
-            toDel.push_back(a);
+        }
 
-            if (recursive) {
-                addSubTree(iname, toDel);
+        // validate in deletion order, children are always checked before their parent
+        std::vector<std::vector<uint32_t>> byDepth;
+        std::vector<size_t>                accepted;
+        int                                lastDepth = -1;
+        for (size_t k = 0; k < order.size(); ++k) {
+            AssetImpl&         d     = toDel[order[k].second];
+            const std::string& iname = d.getInternalName();
+            std::string&       error = errors[order[k].second];
+
+            if (RC0 == iname) {
+                error = "cannot delete RC-0";
+            } else if (sources.count(ids[k])) {
+                error = "it the source of a link";
+            } else {
+                auto found = children.find(iname);
+                if (found != children.end()) {
+                    for (const auto& child : found->second) {
+                        if (!removed.count(child)) {
+                            error = "it has at least one child";
+                            break;
+                        }
+                    }
+                }
             }
-        } catch (std::exception& e) {
-            log_warning("Error while loading asset %s. %s", iname.c_str(), e.what());
-        }
-    }
-
-    auto isAnyParent = [&](const AssetImpl& l, const AssetImpl& r) {
-        std::vector<std::pair<std::string, int>> lTree;
-        auto                                     ptr = l;
-        // path to root of L
-        int distL = 0;
-        while (ptr.getParentIname() != "") {
-            lTree.push_back(std::make_pair(ptr.getInternalName(), distL));
-            std::string parentIname = ptr.getParentIname();
-            ptr                     = AssetImpl(parentIname);
-            distL++;
-        }
-
-        int distR = 0;
-        ptr       = r;
-        while (ptr.getParentIname() != "") {
-            // look for LCA, if exists
-            auto found = std::find_if(lTree.begin(), lTree.end(), [&](const std::pair<std::string, int>& p) {
-                return p.first == ptr.getInternalName();
-            });
-            if (found != lTree.end()) {
-                distL = found->second; // distance of L from LCA
-                break;
+
+            bool isDC = d.getAssetType() == TYPE_DATACENTER;
+            bool isLocation = isAnyOf(d.getAssetType(), TYPE_DATACENTER, TYPE_ROW, TYPE_ROOM, TYPE_RACK);
+            if (error.empty() && !removeLastDC && isLocation && dcCount - (isDC ? 1 : 0) <= 0) {
+                error = "cannot delete last datacenter";
             }
 
-            ptr = AssetImpl(ptr.getParentIname());
-            distR++;
-        }
-        // farthest node from LCA gets deleted first
-        return distL > distR;
-    };
+            if (!error.empty()) {
+                log_error("Asset could not be removed: %s", error.c_str());
+                error = "Asset could not be removed: " + error;
+                continue;
+            }
 
-    // sort by deletion order
-    std::sort(toDel.begin(), toDel.end(), [&](const AssetImpl& l, const AssetImpl& r) {
-        return isAnyParent(l, r);
-    });
+            if (isDC) {
+                dcCount--;
+            }
+            removed.insert(iname);
+            accepted.push_back(order[k].second);
 
-    // remove all links
-    for (auto& a : toDel) {
-        a.unlinkAll();
-    }
+            if (order[k].first != lastDepth) {
+                byDepth.emplace_back();
+                lastDepth = order[k].first;
+            }
+            byDepth.back().push_back(ids[k]);
+        }
 
-    for (auto& d : toDel) {
-        // after deleting assets, children list may change -> reload
-        d.load();
+        // deactivate assets, all or none
+        std::vector<AssetImpl*> deactivated;
+        auto                    reactivate = [&deactivated]() {
+            for (auto* a : deactivated) {
+                try {
+                    a->activate();
+                } catch (const std::exception& err) {
+                    log_error("Asset %s could not be activated again: %s", a->getInternalName().c_str(), err.what());
+                }
+            }
+        };
+        try {
+            for (size_t i : accepted) {
+                if (toDel[i].getAssetStatus() == AssetStatus::Active) {
+                    toDel[i].deactivate();
+                    deactivated.push_back(&toDel[i]);
+                }
+            }
+        } catch (const std::exception&) {
+            reactivate();
+            throw;
+        }
 
+        storage.beginTransaction();
         try {
-            d.remove(removeLastDC);
+            storage.removeList(byDepth);
+            storage.commitTransaction();
+            log_debug("%zu assets removed", accepted.size());
+        } catch (const std::exception& e) {
+            storage.rollbackTransaction();
+            log_warning("Batch delete failed (%s), removing assets one by one", e.what());
+
+            reactivate();
+            for (size_t i : accepted) {
+                try {
+                    toDel[i].load();
+                    toDel[i].remove(removeLastDC);
+                } catch (const std::exception& err) {
+                    log_error("Asset could not be removed: %s", err.what());
+                    errors[i] = err.what();
+                    removed.erase(toDel[i].getInternalName());
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        log_error("Assets could not be removed: %s", e.what());
+        for (auto& error : errors) {
+            if (error.empty()) {
+                error = "Asset could not be removed: " + std::string(e.what());
+            }
+        }
+        removed.clear();
+    }
+
+    for (const auto& o : order) {
+        const AssetImpl& d = toDel[o.second];
+        if (removed.count(d.getInternalName())) {
             deleted.push_back({d, "OK"});
+        } else {
+            deleted.push_back({d, errors[o.second]});
+        }
+    }
 
-            // remove CAM mappings
-            try {
-                deleteMappings(d.getInternalName());
-            } catch (const std::exception& e) {
-                log_error("Failed to update CAM: %s", e.what());
-            }
-        } catch (std::exception& e) {
-            log_error("Asset could not be removed: %s", e.what());
-            deleted.push_back({d, "Asset could not be removed: " + std::string(e.what())});
+    // remove CAM mappings, once the database is settled
+    std::vector<std::string> inames;
+    inames.reserve(deleted.size());
+    for (const auto& d : deleted) {
+        if (d.second == "OK") {
+            inames.push_back(d.first.getInternalName());
         }
     }
+    deleteMappings(inames);
 
     return deleted;
 }
@@ -21,6 +21,7 @@
 
 #pragma once
 
+#include "asset-query.h"
 #include "fty_asset_dto.h"
 #include <map>
 #include <string>
@@ -63,6 +64,10 @@ public:
     void deactivate();
     void unlinkAll();
 
+    // activates and stores the assets, one activator exchange per activation::BATCH_SIZE devices,
+    // returns an empty string for success or the error of that asset
+    static std::vector<std::string> activateBatch(const std::vector<AssetImpl*>& assets);
+
     void updateParentsList();
 
     static void assetToSrr(const AssetImpl& asset, cxxtools::SerializationInfo& si);
@@ -70,6 +75,7 @@ public:
 
     static std::vector<std::string> list(const AssetFilters& filters);
     static std::vector<std::string> listAll();
+    static std::vector<std::string> query(const AssetQuery& query);
 
     static DeleteStatus deleteList(
         const std::vector<std::string>& assets, bool recursive, bool deleteVirtualAssets = true, bool removeLastDC = false);
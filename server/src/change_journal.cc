@@ -0,0 +1,158 @@
+/*  =========================================================================
+    change_journal - Asset change sequence and bounded journal
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    change_journal - Asset change sequence and bounded journal
+@discuss
+@end
+*/
+
+#include "change_journal.h"
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <fty_log.h>
+
+namespace fty {
+
+// sequence numbers reserved per write of the state file
+static constexpr uint64_t SEQ_BLOCK = 1000;
+
+ChangeJournal& ChangeJournal::instance()
+{
+    static ChangeJournal journal;
+    return journal;
+}
+
+void ChangeJournal::setup(const std::string& stateFile, size_t maxEntries)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_stateFile  = stateFile;
+    m_maxEntries = maxEntries;
+    m_loaded     = false;
+}
+
+void ChangeJournal::load()
+{
+    uint64_t stored = 0;
+
+    std::ifstream in(m_stateFile);
+    if (in >> stored) {
+        m_seq = stored;
+    } else {
+        // no usable state, the clock still keeps numbers increasing across restarts
+        m_seq = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        log_warning("Change sequence state %s not readable, starting at %" PRIu64, m_stateFile.c_str(), m_seq);
+    }
+
+    // whatever happened before the restart is unknown
+    m_first    = m_seq;
+    m_reserved = m_seq;
+    m_entries.clear();
+    m_loaded = true;
+}
+
+void ChangeJournal::reserve()
+{
+    uint64_t    mark = m_seq + SEQ_BLOCK;
+    std::string tmp  = m_stateFile + ".tmp";
+
+    std::ofstream out(tmp, std::ios::trunc);
+    out << mark << std::endl;
+    out.close();
+
+    if (!out || std::rename(tmp.c_str(), m_stateFile.c_str()) != 0) {
+        log_error("Change sequence state %s could not be written", m_stateFile.c_str());
+    }
+    // go on in memory anyway, the clock based start covers a lost state file
+    m_reserved = mark;
+}
+
+uint64_t ChangeJournal::record(const std::string& iname, bool deleted)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    if (!m_loaded) {
+        load();
+    }
+    if (m_seq + 1 > m_reserved) {
+        reserve();
+    }
+
+    ++m_seq;
+    if (!m_entries.empty() && m_entries.back().iname == iname && m_entries.back().deleted == deleted) {
+        // same asset again, e.g. element and ext attributes of one update
+        m_entries.back().seq = m_seq;
+    } else {
+        m_entries.push_back({m_seq, iname, deleted});
+    }
+
+    while (m_entries.size() > m_maxEntries) {
+        m_first = m_entries.front().seq;
+        m_entries.pop_front();
+    }
+
+    return m_seq;
+}
+
+uint64_t ChangeJournal::sequence()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    if (!m_loaded) {
+        load();
+    }
+    return m_seq;
+}
+
+bool ChangeJournal::changesSince(
+    uint64_t since, uint64_t& current, std::set<std::string>& changed, std::set<std::string>& deleted)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    if (!m_loaded) {
+        load();
+    }
+
+    current = m_seq;
+    if (since < m_first || since > m_seq) {
+        return false;
+    }
+
+    // last state of each asset wins
+    for (auto it = m_entries.rbegin(); it != m_entries.rend() && it->seq > since; ++it) {
+        if (changed.count(it->iname) || deleted.count(it->iname)) {
+            continue;
+        }
+        if (it->deleted) {
+            deleted.insert(it->iname);
+        } else {
+            changed.insert(it->iname);
+        }
+    }
+    return true;
+}
+
+} // namespace fty
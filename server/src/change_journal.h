@@ -0,0 +1,77 @@
+/*  =========================================================================
+    change_journal - Asset change sequence and bounded journal
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <string>
+
+namespace fty {
+
+/// Monotonic sequence bumped by every asset change, with the last changes kept in memory.
+///
+/// The sequence survives restarts: a high-water mark is written to a state file once per block
+/// of sequence numbers, and numbering restarts after the stored mark. The journal itself is not
+/// persisted, so a client behind the start of the journal must resync.
+class ChangeJournal
+{
+public:
+    static ChangeJournal& instance();
+
+    /// state file and journal size, call before the first change
+    void setup(const std::string& stateFile, size_t maxEntries);
+
+    /// returns the sequence number of this change
+    uint64_t record(const std::string& iname, bool deleted);
+
+    uint64_t sequence();
+
+    /// compact changes after since, returns false if the client must resync
+    bool changesSince(uint64_t since, uint64_t& current, std::set<std::string>& changed,
+        std::set<std::string>& deleted);
+
+private:
+    struct Entry
+    {
+        uint64_t    seq;
+        std::string iname;
+        bool        deleted;
+    };
+
+    ChangeJournal() = default;
+
+    void load();
+    void reserve();
+
+    std::mutex        m_lock;
+    bool              m_loaded     = false;
+    std::string       m_stateFile  = "/var/lib/fty/fty-asset/change-seq";
+    size_t            m_maxEntries = 10000;
+    uint64_t          m_seq        = 0;
+    uint64_t          m_reserved   = 0; // high-water mark stored in the state file
+    uint64_t          m_first      = 0; // changes after this one are all in the journal
+    std::deque<Entry> m_entries;
+};
+
+} // namespace fty
@@ -0,0 +1,339 @@
+/*  =========================================================================
+    containment_index - In-memory index of the location tree
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    containment_index - In-memory index of the location tree
+@discuss
+@end
+*/
+
+#include "containment_index.h"
+#include "asset/dbhelpers.h"
+
+#include <fty_common_db.h>
+#include <fty_log.h>
+
+namespace fty {
+
+ContainmentIndex& ContainmentIndex::instance()
+{
+    static ContainmentIndex index;
+    return index;
+}
+
+void ContainmentIndex::invalidate()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_loaded      = false;
+    m_labelsValid = false;
+    m_nodes.clear();
+    m_ids.clear();
+    m_labels.clear();
+    m_walk.clear();
+}
+
+bool ContainmentIndex::update(const std::string& operation, const std::string& name, uint32_t parent,
+    const std::string& type, const std::string& subtype, const std::string& status)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    if (!m_loaded) {
+        // nothing to keep in sync yet
+        return true;
+    }
+
+    auto id = m_ids.find(name);
+
+    if (operation == "delete") {
+        if (id != m_ids.end()) {
+            m_nodes.erase(id->second);
+            m_ids.erase(id);
+            m_labelsValid = false;
+        }
+        return true;
+    }
+
+    if (operation != "create" && operation != "update") {
+        return true;
+    }
+
+    if (id == m_ids.end() || (parent != 0 && m_nodes.find(parent) == m_nodes.end())) {
+        // new asset, its id is not part of the message
+        m_loaded = false;
+        return false;
+    }
+
+    Node& node = m_nodes[id->second];
+    if (node.parent != parent) {
+        node.parent   = parent;
+        m_labelsValid = false;
+    }
+    if (!type.empty()) {
+        node.type = persist::type_to_typeid(type);
+    }
+    if (!subtype.empty()) {
+        node.subtype = persist::subtype_to_subtypeid(subtype);
+    }
+    if (!status.empty()) {
+        node.status = status;
+    }
+    return true;
+}
+
+void ContainmentIndex::add(uint32_t id, const std::string& name, uint32_t parent, const std::string& type,
+    const std::string& subtype, const std::string& status)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    if (!m_loaded) {
+        return;
+    }
+
+    Node node;
+    node.id      = id;
+    node.name    = name;
+    node.parent  = parent;
+    node.type    = persist::type_to_typeid(type);
+    node.subtype = persist::subtype_to_subtypeid(subtype);
+    node.status  = status;
+
+    m_ids[name] = id;
+    m_nodes[id] = std::move(node);
+    m_labelsValid = false;
+}
+
+bool ContainmentIndex::parents(
+    const std::string& name, uint32_t& parentId, std::vector<std::string>& names, bool test)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    // labels are not needed for the chain
+    if (test || (!m_loaded && load() != 0)) {
+        return false;
+    }
+
+    auto id = m_ids.find(name);
+    if (id == m_ids.end()) {
+        return false;
+    }
+
+    parentId = m_nodes[id->second].parent;
+
+    // bounded, a parent cycle must not hang the caller
+    uint32_t current = parentId;
+    while (current != 0 && names.size() < m_nodes.size()) {
+        auto node = m_nodes.find(current);
+        if (node == m_nodes.end()) {
+            break;
+        }
+        names.push_back(node->second.name);
+        current = node->second.parent;
+    }
+    return true;
+}
+
+int ContainmentIndex::load()
+{
+    std::unordered_map<uint32_t, Node>        nodes;
+    std::unordered_map<std::string, uint32_t> ids;
+
+    std::function<void(const tntdb::Row&)> cb = [&nodes, &ids](const tntdb::Row& row) {
+        Node node;
+        row["id"].get(node.id);
+        row["name"].get(node.name);
+        row["id_parent"].get(node.parent);
+        row["id_type"].get(node.type);
+        row["id_subtype"].get(node.subtype);
+        row["status"].get(node.status);
+        ids.emplace(node.name, node.id);
+        nodes.emplace(node.id, std::move(node));
+    };
+
+    int rv = select_asset_tree(cb, false);
+    if (rv != 0) {
+        log_error("Containment index could not be loaded");
+        return -1;
+    }
+
+    m_nodes       = std::move(nodes);
+    m_ids         = std::move(ids);
+    m_loaded      = true;
+    m_labelsValid = false;
+
+    log_debug("Containment index loaded with %zu assets", m_nodes.size());
+    return 0;
+}
+
+void ContainmentIndex::relabel()
+{
+    std::unordered_map<uint32_t, std::vector<uint32_t>> children;
+    std::vector<uint32_t>                               roots;
+
+    for (const auto& node : m_nodes) {
+        if (node.second.parent != 0 && m_nodes.count(node.second.parent)) {
+            children[node.second.parent].push_back(node.first);
+        } else {
+            roots.push_back(node.first);
+        }
+    }
+
+    m_labels.clear();
+    m_walk.clear();
+    m_walk.reserve(m_nodes.size());
+
+    // iterative pre-order walk, post is set when the last descendant was visited
+    std::vector<std::pair<uint32_t, size_t>> stack;
+    for (uint32_t root : roots) {
+        m_labels[root].pre = static_cast<uint32_t>(m_walk.size());
+        m_walk.push_back(root);
+        stack.emplace_back(root, 0);
+
+        while (!stack.empty()) {
+            auto&       top  = stack.back();
+            const auto& kids = children[top.first];
+            if (top.second < kids.size()) {
+                uint32_t child = kids[top.second++];
+                m_labels[child].pre = static_cast<uint32_t>(m_walk.size());
+                m_walk.push_back(child);
+                stack.emplace_back(child, 0);
+            } else {
+                m_labels[top.first].post = static_cast<uint32_t>(m_walk.size() - 1);
+                stack.pop_back();
+            }
+        }
+    }
+
+    // nodes of a parent cycle are not reachable and keep no label
+    m_labelsValid = true;
+}
+
+int ContainmentIndex::ensure(bool test)
+{
+    if (test) {
+        return -1;
+    }
+    if (!m_loaded && load() != 0) {
+        return -1;
+    }
+    if (!m_labelsValid) {
+        relabel();
+    }
+    return 0;
+}
+
+bool ContainmentIndex::contains(uint32_t container, uint32_t asset, bool test)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    if (ensure(test) != 0) {
+        return false;
+    }
+
+    auto c = m_labels.find(container);
+    auto a = m_labels.find(asset);
+    if (c == m_labels.end() || a == m_labels.end() || c->second.pre == UINT32_MAX || a->second.pre == UINT32_MAX) {
+        return false;
+    }
+    return c->second.pre < a->second.pre && a->second.pre <= c->second.post;
+}
+
+int ContainmentIndex::collect(uint32_t container, std::vector<Node>& nodes)
+{
+    auto label = m_labels.find(container);
+    if (label == m_labels.end() || label->second.pre == UINT32_MAX) {
+        return -2;
+    }
+
+    for (uint32_t i = label->second.pre + 1; i <= label->second.post; ++i) {
+        nodes.push_back(m_nodes[m_walk[i]]);
+    }
+    return 0;
+}
+
+int ContainmentIndex::nodesIn(uint32_t container, std::vector<Node>& nodes, bool test)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    if (ensure(test) != 0) {
+        return -1;
+    }
+    return collect(container, nodes);
+}
+
+int ContainmentIndex::nodesIn(const std::string& container, std::vector<Node>& nodes, bool test)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    if (ensure(test) != 0) {
+        return -1;
+    }
+
+    auto id = m_ids.find(container);
+    if (id == m_ids.end()) {
+        return -2;
+    }
+    return collect(id->second, nodes);
+}
+
+int ContainmentIndex::assetsIn(const std::string& container, const std::set<std::string>& filter,
+    std::vector<std::string>& assets, bool test)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    if (ensure(test) != 0) {
+        return -1;
+    }
+
+    auto id = m_ids.find(container);
+    if (id == m_ids.end()) {
+        return -2;
+    }
+    const Label& label = m_labels[id->second];
+    if (label.pre == UINT32_MAX) {
+        return -2;
+    }
+
+    // filter holds type or subtype names, compare ids in the scan
+    std::set<uint16_t> types;
+    std::set<uint16_t> subtypes;
+    for (const auto& f : filter) {
+        uint16_t type    = persist::type_to_typeid(f);
+        uint16_t subtype = persist::subtype_to_subtypeid(f);
+        // 0 is the id of unknown names
+        if (type != 0) {
+            types.insert(type);
+        }
+        if (subtype != 0) {
+            subtypes.insert(subtype);
+        }
+    }
+
+    for (uint32_t i = label.pre + 1; i <= label.post; ++i) {
+        const Node& node = m_nodes[m_walk[i]];
+        if (filter.empty() || types.count(node.type) || subtypes.count(node.subtype)) {
+            assets.push_back(node.name);
+        }
+    }
+    return 0;
+}
+
+} // namespace fty
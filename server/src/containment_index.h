@@ -0,0 +1,105 @@
+/*  =========================================================================
+    containment_index - In-memory index of the location tree
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fty {
+
+/// Parent/child relation of all assets, labelled by an Euler tour.
+///
+/// Every node gets the position of its first visit (pre) and of its last descendant (post) in a
+/// pre-order walk, so the sub tree of a node is the contiguous range ]pre, post] of the walk and
+/// "is X inside Y" is two comparisons. Parent changes only update the node, labels are recomputed
+/// in memory before the next read.
+class ContainmentIndex
+{
+public:
+    struct Node
+    {
+        uint32_t    id      = 0;
+        std::string name;
+        uint32_t    parent  = 0;
+        uint16_t    type    = 0;
+        uint16_t    subtype = 0;
+        std::string status;
+    };
+
+    static ContainmentIndex& instance();
+
+    /// drop everything, next read reloads from database
+    void invalidate();
+
+    /// apply a create/update/delete of an asset, returns false if the index must be reloaded instead
+    /// empty type, subtype or status are left as they are
+    bool update(const std::string& operation, const std::string& name, uint32_t parent, const std::string& type,
+        const std::string& subtype, const std::string& status);
+
+    /// new asset with its database id, ignored until the index is loaded
+    void add(uint32_t id, const std::string& name, uint32_t parent, const std::string& type,
+        const std::string& subtype, const std::string& status);
+
+    /// id of the direct parent and names of all parents, direct parent first
+    /// returns false if the asset is unknown or the index cannot be loaded
+    bool parents(const std::string& name, uint32_t& parentId, std::vector<std::string>& names, bool test);
+
+    /// true if asset is somewhere below container
+    bool contains(uint32_t container, uint32_t asset, bool test);
+
+    /// inames below container whose type or subtype is in filter (all if empty)
+    /// returns 0 on success, -1 on database error, -2 if container does not exist
+    int assetsIn(const std::string& container, const std::set<std::string>& filter,
+        std::vector<std::string>& assets, bool test);
+
+    /// all nodes below container, same return codes as assetsIn
+    int nodesIn(uint32_t container, std::vector<Node>& nodes, bool test);
+    int nodesIn(const std::string& container, std::vector<Node>& nodes, bool test);
+
+private:
+    struct Label
+    {
+        uint32_t pre  = UINT32_MAX;
+        uint32_t post = 0;
+    };
+
+    ContainmentIndex() = default;
+
+    int  ensure(bool test);
+    int  load();
+    void relabel();
+    int  collect(uint32_t container, std::vector<Node>& nodes);
+
+    std::mutex                                m_lock;
+    bool                                      m_loaded      = false;
+    bool                                      m_labelsValid = false;
+    std::unordered_map<uint32_t, Node>        m_nodes;
+    std::unordered_map<std::string, uint32_t> m_ids;
+    std::unordered_map<uint32_t, Label>       m_labels;
+    std::vector<uint32_t>                     m_walk; // ids in pre-order
+};
+
+} // namespace fty
@@ -28,12 +28,17 @@
 
 
 #include "asset/dbhelpers.h"
+#include "containment_index.h"
 
 #include "fty_proto.h"
 #include "fty_asset_dto.h"
 #include "fty_asset_server.h"
+#include "sql_trace.h"
+#include <fty_common.h>
 #include <fty_log.h>
 #include <cxxtools/jsonserializer.h>
+#include <algorithm>
+#include <ctime>
 
 #define INPUT_POWER_CHAIN     1
 #define AGENT_ASSET_ACTIVATOR "etn-licensing-credits"
@@ -57,9 +62,8 @@ int select_assets_by_container(const std::string& container_name, const std::set
 {
     if (test)
         return 0;
-    tntdb::Connection conn = tntdb::connectCached(DBConn::url);
-    [[maybe_unused]] int rv = DBAssets::select_assets_by_container_name_filter(conn, container_name, filter, assets);
-    return rv;
+    // served from memory, the index reloads itself from database when needed
+    return fty::ContainmentIndex::instance().assetsIn(container_name, filter, assets, test);
 }
 
 /**
@@ -77,8 +81,8 @@ int select_asset_element_basic(
 {
     if (test)
         return 0;
-    tntdb::Connection conn = tntdb::connectCached(DBConn::url);
-    int               rv   = DBAssets::select_asset_element_basic_cb(conn, asset_name, cb);
+    fty::TracedConnection conn = tntdb::connectCached(DBConn::url);
+    int                   rv   = DBAssets::select_asset_element_basic_cb(conn, asset_name, cb);
     return rv;
 }
 
@@ -96,8 +100,8 @@ int select_ext_attributes(uint32_t asset_id, std::function<void(const tntdb::Row
 {
     if (test)
         return 0;
-    tntdb::Connection conn = tntdb::connectCached(DBConn::url);
-    int               rv   = DBAssets::select_ext_attributes_cb(conn, asset_id, cb);
+    fty::TracedConnection conn = tntdb::connectCached(DBConn::url);
+    int                   rv   = DBAssets::select_ext_attributes_cb(conn, asset_id, cb);
     return rv;
 }
 
@@ -115,8 +119,8 @@ int select_asset_element_super_parent(uint32_t id, std::function<void(const tntd
 {
     if (test)
         return 0;
-    tntdb::Connection conn = tntdb::connectCached(DBConn::url);
-    int               rv   = DBAssets::select_asset_element_super_parent(conn, id, cb);
+    fty::TracedConnection conn = tntdb::connectCached(DBConn::url);
+    int                   rv   = DBAssets::select_asset_element_super_parent(conn, id, cb);
     return rv;
 }
 
@@ -131,8 +135,8 @@ int select_assets_by_filter(const std::set<std::string>& filter, std::vector<std
     if (test)
         return 0;
 
-    tntdb::Connection conn = tntdb::connectCached(DBConn::url);
-    int               rv   = DBAssets::select_assets_by_filter(conn, filter, assets);
+    fty::TracedConnection conn = tntdb::connectCached(DBConn::url);
+    int                   rv   = DBAssets::select_assets_by_filter(conn, filter, assets);
     return rv;
 }
 
@@ -149,11 +153,62 @@ int select_assets(std::function<void(const tntdb::Row&)>& cb, bool test)
 {
     if (test)
         return 0;
-    tntdb::Connection conn = tntdb::connectCached(DBConn::url);
-    int               rv   = DBAssets::select_assets_cb(conn, cb);
+    fty::TracedConnection conn = tntdb::connectCached(DBConn::url);
+    int                   rv   = DBAssets::select_assets_cb(conn, cb);
     return rv;
 }
 
+/**
+ *  \brief Selects ext attributes of all assets in the DB in one query
+ *
+ *  \param[in] cb - function to call on each row (name, keytag, value, read_only)
+ *  \param[in] test - unit tests indicator
+ *
+ *  \return  0 - in case of success
+ *          -1 - in case of some unexpected error
+ */
+int select_asset_tree(std::function<void(const tntdb::Row&)>& cb, bool test)
+{
+    if (test)
+        return 0;
+    try {
+        fty::TracedConnection conn = tntdb::connectCached(DBConn::url);
+        auto                  st   = conn.prepareCached(
+            " SELECT id_asset_element AS id, name, id_parent, id_type, id_subtype, status"
+            " FROM t_bios_asset_element");
+
+        for (const auto& row : st.select()) {
+            cb(row);
+        }
+    } catch (const std::exception& e) {
+        log_error("DB: cannot select asset tree, %s", e.what());
+        return -1;
+    }
+    return 0;
+}
+
+int select_all_ext_attributes(std::function<void(const tntdb::Row&)>& cb, bool test)
+{
+    if (test)
+        return 0;
+    try {
+        fty::TracedConnection conn = tntdb::connectCached(DBConn::url);
+        auto                  st   = conn.prepareCached(
+            " SELECT a.name, e.keytag, e.value, e.read_only"
+            " FROM t_bios_asset_ext_attributes AS e"
+            " INNER JOIN t_bios_asset_element AS a"
+            "   ON a.id_asset_element = e.id_asset_element");
+
+        for (const auto& row : st.select()) {
+            cb(row);
+        }
+    } catch (const std::exception& e) {
+        log_error("DB: cannot select ext attributes, %s", e.what());
+        return -1;
+    }
+    return 0;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 #define SQL_EXT_ATT_INVENTORY                                                                                \
@@ -184,7 +239,7 @@ int process_insert_inventory(
 {
     if (test)
         return 0;
-    tntdb::Connection conn;
+    fty::TracedConnection conn;
     try {
         conn = tntdb::connectCached(DBConn::url);
     } catch (const std::exception& e) {
@@ -193,7 +248,7 @@ int process_insert_inventory(
     }
 
     tntdb::Transaction trans(conn);
-    tntdb::Statement   st = conn.prepareCached(SQL_EXT_ATT_INVENTORY);
+    auto               st = conn.prepareCached(SQL_EXT_ATT_INVENTORY);
 
     for (void* it = zhash_first(ext_attributes); it != NULL; it = zhash_next(ext_attributes)) {
 
@@ -226,64 +281,196 @@ int process_insert_inventory(
 }
 
 /**
- *  \brief Inserts ext attributes from inventory message into DB only
- *         if the new value is different from the cache map
- *         This method is not thread safe.
+ *  \brief Selects ids of given asset names in one query
  *
- *  \param[in] device_name - iname of assets
- *  \param[in] ext_attributes - recent ext attributes for this asset
- *  \param[in] read_only - whether to insert ext attributes as readonly
+ *  \param[in] names - inames of assets
+ *  \param[out] ids - iname to id map, unknown names are not added
  *  \param[in] test - unit tests indicator
- *  \param[in] map_cache -  cache map
  *
  *  \return  0 - in case of success
  *          -1 - in case of some unexpected error
  */
-int process_insert_inventory(const std::string& device_name, zhash_t* ext_attributes, bool readonly,
-    std::unordered_map<std::string, std::string>& map_cache, bool test)
+int select_asset_ids_by_name(
+    const std::vector<std::string>& names, std::unordered_map<std::string, uint32_t>& ids, bool test)
 {
-    if (test)
+    if (test || names.empty())
         return 0;
-    tntdb::Connection conn;
+
+    std::stringstream qs;
+    qs << "SELECT id_asset_element, name FROM t_bios_asset_element WHERE name IN (";
+    for (size_t i = 0; i < names.size(); ++i) {
+        qs << (i ? ", " : "") << ":name" << i;
+    }
+    qs << ")";
+
     try {
-        conn = tntdb::connectCached(DBConn::url);
+        fty::TracedConnection conn = tntdb::connectCached(DBConn::url);
+        // variable arity, do not pollute the statement cache
+        auto st = conn.prepare(qs.str());
+        for (size_t i = 0; i < names.size(); ++i) {
+            st.set("name" + std::to_string(i), names[i]);
+        }
+
+        for (const auto& row : st.select()) {
+            ids[row.getString(1)] = row.getUnsigned32(0);
+        }
     } catch (const std::exception& e) {
-        log_error("DB: cannot connect, %s", e.what());
+        log_error("DB: cannot select asset ids, %s", e.what());
         return -1;
     }
+    return 0;
+}
 
-    tntdb::Transaction trans(conn);
-    tntdb::Statement   st = conn.prepareCached(SQL_EXT_ATT_INVENTORY);
+// rows per upsert statement, keeps statements well below max_allowed_packet
+static constexpr size_t INVENTORY_UPSERT_ROWS = 256;
 
-    for (void* it = zhash_first(ext_attributes); it != NULL; it = zhash_next(ext_attributes)) {
-        const char* value     = static_cast<const char*>(it);
-        const char* keytag    = zhash_cursor(ext_attributes);
-        bool        readonlyV = readonly;
-        if (strcmp(keytag, "name") == 0 || strcmp(keytag, "description") == 0)
-            readonlyV = false;
+static std::string s_inventory_upsert_query(size_t rows)
+{
+    std::stringstream qs;
+    qs << "INSERT INTO t_bios_asset_ext_attributes (keytag, value, id_asset_element, read_only) VALUES ";
+    for (size_t i = 0; i < rows; ++i) {
+        qs << (i ? ", " : "") << "(:keytag" << i << ", :value" << i << ", :id" << i << ", :readonly" << i << ")";
+    }
+    qs << " ON DUPLICATE KEY UPDATE value = VALUES (value), read_only = VALUES (read_only)";
+    return qs.str();
+}
 
-        std::string cache_key = device_name;
-        cache_key.append(":").append(keytag).append(readonlyV ? "1" : "0");
-        auto el = map_cache.find(cache_key);
-        if (el != map_cache.end() && el->second == value)
-            continue;
-        try {
-            st.set("keytag", keytag)
-                .set("value", value)
-                .set("device_name", device_name)
-                .set("readonly", readonlyV)
-                .execute();
-            map_cache[cache_key] = value;
-        } catch (const std::exception& e) {
-            log_warning("%s:\texception on updating %s {%s, %s}\n\t%s", "", device_name.c_str(), keytag,
-                value, e.what());
-            continue;
+/**
+ *  \brief Inserts ext attributes of several assets into DB,
+ *         using multi-row upserts inside one transaction
+ *
+ *  \param[in] rows - ext attributes to write, asset ids must be resolved
+ *  \param[in] test - unit tests indicator
+ *
+ *  \return  0 - in case of success
+ *          -1 - in case of some unexpected error
+ */
+int process_insert_inventory_batch(const std::vector<InventoryRow>& rows, bool test)
+{
+    if (test || rows.empty())
+        return 0;
+
+    try {
+        fty::TracedConnection conn = tntdb::connectCached(DBConn::url);
+        tntdb::Transaction    trans(conn);
+
+        for (size_t begin = 0; begin < rows.size(); begin += INVENTORY_UPSERT_ROWS) {
+            size_t count = std::min(INVENTORY_UPSERT_ROWS, rows.size() - begin);
+
+            // only full chunks have a stable shape worth caching
+            tntdb::Statement st = count == INVENTORY_UPSERT_ROWS
+                ? conn.prepareCached(s_inventory_upsert_query(count))
+                : conn.prepare(s_inventory_upsert_query(count));
+
+            for (size_t i = 0; i < count; ++i) {
+                const InventoryRow& row = rows[begin + i];
+                std::string         idx = std::to_string(i);
+
+                st.set("keytag" + idx, row.keytag)
+                    .set("value" + idx, row.value)
+                    .set("id" + idx, row.asset_id)
+                    .set("readonly" + idx, row.read_only);
+            }
+            st.execute();
         }
-    }
 
-    trans.commit();
+        trans.commit();
+    } catch (const std::exception& e) {
+        log_error("DB: cannot write %zu inventory rows, %s", rows.size(), e.what());
+        return -1;
+    }
     return 0;
 }
+
+/**
+ *  \brief Writes uuid and create_ts ext attributes of the assets which miss them,
+ *         found with one query and written in one batched transaction
+ *
+ *  uuid is calculated from manufacturer, model and serial number when all are known,
+ *  random otherwise, create_ts is the current time. Both are read-only.
+ *
+ *  \param[in] assets - inames of assets to check, empty for all assets
+ *  \param[out] names - inames of updated assets
+ *  \param[in] test - unit tests indicator
+ *
+ *  \return  0 - in case of success
+ *          -1 - in case of some unexpected error
+ */
+int process_backfill_uuid_create_ts(const std::vector<std::string>& assets, std::vector<std::string>& names, bool test)
+{
+    if (test)
+        return 0;
+
+    std::vector<InventoryRow> rows;
+
+    std::stringstream qs;
+    qs << " SELECT a.id_asset_element AS id, a.name AS name,"
+          "   MAX(CASE WHEN e.keytag = 'uuid' THEN e.value END) AS uuid,"
+          "   MAX(CASE WHEN e.keytag = 'create_ts' THEN e.value END) AS create_ts,"
+          "   MAX(CASE WHEN e.keytag = 'manufacturer' THEN e.value END) AS manufacturer,"
+          "   MAX(CASE WHEN e.keytag = 'model' THEN e.value END) AS model,"
+          "   MAX(CASE WHEN e.keytag = 'serial_no' THEN e.value END) AS serial_no"
+          " FROM t_bios_asset_element AS a"
+          " LEFT JOIN t_bios_asset_ext_attributes AS e"
+          "   ON e.id_asset_element = a.id_asset_element"
+          "   AND e.keytag IN ('uuid', 'create_ts', 'manufacturer', 'model', 'serial_no')";
+    if (!assets.empty()) {
+        qs << " WHERE a.name IN (";
+        for (size_t i = 0; i < assets.size(); ++i) {
+            qs << (i ? ", " : "") << ":name" << i;
+        }
+        qs << ")";
+    }
+    qs << " GROUP BY a.id_asset_element, a.name"
+          " HAVING uuid IS NULL OR create_ts IS NULL";
+
+    try {
+        fty::TracedConnection conn = tntdb::connectCached(DBConn::url);
+        // variable arity for given assets, do not pollute the statement cache
+        auto st = assets.empty() ? conn.prepareCached(qs.str()) : conn.prepare(qs.str());
+        for (size_t i = 0; i < assets.size(); ++i) {
+            st.set("name" + std::to_string(i), assets[i]);
+        }
+
+        tntdb::Result res = st.select();
+        if (res.empty())
+            return 0;
+
+        std::time_t timestamp = std::time(NULL);
+        char        create_ts[100];
+        std::strftime(create_ts, sizeof(create_ts), "%FT%T%z", std::localtime(&timestamp));
+
+        fty_uuid_t* uuid = fty_uuid_new();
+
+        for (const auto& row : res) {
+            uint32_t id = row.getUnsigned32("id");
+            names.push_back(row.getString("name"));
+
+            if (row.isNull("uuid")) {
+                const char* value = NULL;
+                if (!row.isNull("manufacturer") && !row.isNull("model") && !row.isNull("serial_no")) {
+                    value = fty_uuid_calculate(uuid, row.getString("manufacturer").c_str(),
+                        row.getString("model").c_str(), row.getString("serial_no").c_str());
+                } else {
+                    value = fty_uuid_generate(uuid);
+                }
+                rows.push_back({id, "uuid", value, true});
+            }
+            if (row.isNull("create_ts")) {
+                rows.push_back({id, "create_ts", create_ts, true});
+            }
+        }
+
+        fty_uuid_destroy(&uuid);
+    } catch (const std::exception& e) {
+        log_error("DB: cannot select assets without uuid or create_ts, %s", e.what());
+        return -1;
+    }
+
+    log_info("DB: backfilling uuid/create_ts of %zu assets", names.size());
+    return process_insert_inventory_batch(rows, test);
+}
+
 /**
  *  \brief Selects user-friendly name for given asset name
  *
@@ -305,8 +492,8 @@ int select_ename_from_iname(std::string& iname, std::string& ename, bool test)
     }
     try {
 
-        tntdb::Connection conn = tntdb::connectCached(DBConn::url);
-        tntdb::Statement  st   = conn.prepareCached(
+        fty::TracedConnection conn = tntdb::connectCached(DBConn::url);
+        auto                  st   = conn.prepareCached(
             "SELECT e.value FROM  t_bios_asset_ext_attributes AS e "
             "INNER JOIN t_bios_asset_element AS a "
             "ON a.id_asset_element = e.id_asset_element "
@@ -345,7 +532,7 @@ int get_active_power_devices(bool test)
         }
         return count;
     }
-    tntdb::Connection conn = tntdb::connectCached(DBConn::url);
+    fty::TracedConnection conn = tntdb::connectCached(DBConn::url);
     return DBAssets::get_active_power_devices(conn);
 }
 
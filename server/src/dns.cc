@@ -34,6 +34,8 @@
 #include <netinet/ip.h>
 #include <arpa/inet.h>
 #include <ifaddrs.h>
+#include <algorithm>
+#include <atomic>
 #include <cstdio>
 #include <cstring>
 
@@ -182,6 +184,99 @@ std::map<std::string,std::set<std::string>> local_addresses()
     return result;
 }
 
+//  --------------------------------------------------------------------------
+//  Asynchronous resolver
+
+DnsResolver::DnsResolver(size_t threads, Backend backend, std::chrono::seconds ttl,
+    std::chrono::seconds negativeTtl)
+    : m_backend(std::move(backend))
+    , m_ttl(ttl)
+    , m_negativeTtl(negativeTtl)
+{
+    if (!m_backend) {
+        m_backend = [](const std::string& ip) {
+            return ip_to_name(ip.c_str());
+        };
+    }
+
+    m_front = zsys_create_pipe(&m_back);
+    assert(m_front && m_back);
+
+    for (size_t i = 0; i < std::max<size_t>(threads, 1); ++i) {
+        m_threads.emplace_back(&DnsResolver::worker, this);
+    }
+}
+
+DnsResolver::~DnsResolver()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    // a lookup in progress is waited for, getnameinfo cannot be cancelled
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+    zsock_destroy(&m_back);
+    zsock_destroy(&m_front);
+}
+
+bool DnsResolver::lookup(const std::string& ip, std::string& name)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    auto it = m_cache.find(ip);
+    if (it != m_cache.end() && it->second.expires > std::chrono::steady_clock::now()) {
+        name = it->second.name;
+        return true;
+    }
+
+    if (m_pending.insert(ip).second) {
+        m_queue.push_back(ip);
+        m_wake.notify_one();
+    }
+    return false;
+}
+
+zsock_t* DnsResolver::completions()
+{
+    return m_front;
+}
+
+void DnsResolver::worker()
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    while (true) {
+        m_wake.wait(lock, [this]() {
+            return m_stop || !m_queue.empty();
+        });
+        if (m_stop) {
+            return;
+        }
+
+        std::string ip = m_queue.front();
+        m_queue.pop_front();
+
+        lock.unlock();
+        std::string name = m_backend(ip);
+        lock.lock();
+
+        auto ttl    = name.empty() ? m_negativeTtl : m_ttl;
+        m_cache[ip] = {name, std::chrono::steady_clock::now() + ttl};
+        m_pending.erase(ip);
+
+        // not under m_lock, a full pipe must not block lookup()
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> send(m_sendLock);
+            zstr_sendx(m_back, ip.c_str(), name.c_str(), NULL);
+        }
+        lock.lock();
+    }
+}
+
 //  --------------------------------------------------------------------------
 //  Self test of this class
 
@@ -199,6 +294,51 @@ dns_test (bool /*verbose*/)
         assert (found == 1);
     }
     assert (! ip_to_name("127.0.0.1").empty ());
+
+    // resolver with a slow fake backend, no network needed
+    {
+        std::atomic<int> calls{0};
+        auto backend = [&calls](const std::string& ip) -> std::string {
+            ++calls;
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            return ip == "10.0.0.1" ? "rc-1.example.com" : "";
+        };
+
+        DnsResolver resolver(2, backend, std::chrono::seconds(60), std::chrono::seconds(0));
+        std::string name;
+
+        int64_t start = zclock_mono();
+        for (int i = 0; i < 5; ++i) {
+            bool found = resolver.lookup("10.0.0.1", name);
+            assert (!found);
+        }
+        bool found = resolver.lookup("10.0.0.2", name);
+        assert (!found);
+        // nothing waits for the backend
+        assert (zclock_mono() - start < 100);
+
+        zpoller_t *poller = zpoller_new (resolver.completions(), NULL);
+        for (int i = 0; i < 2; ++i) {
+            void *which = zpoller_wait (poller, 2000);
+            assert (which == resolver.completions());
+            char *ip = NULL, *resolved = NULL;
+            zstr_recvx (resolver.completions(), &ip, &resolved, NULL);
+            assert (streq (ip, "10.0.0.1") ? streq (resolved, "rc-1.example.com") : streq (resolved, ""));
+            zstr_free (&ip);
+            zstr_free (&resolved);
+        }
+        zpoller_destroy (&poller);
+
+        // identical addresses shared one lookup
+        assert (calls == 2);
+
+        // positive result is cached, the negative one expired at once
+        found = resolver.lookup("10.0.0.1", name);
+        assert (found);
+        assert (name == "rc-1.example.com");
+        found = resolver.lookup("10.0.0.2", name);
+        assert (!found);
+    }
     /*
     auto i = local_addresses ();
     for (const auto it : i) {
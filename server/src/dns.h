@@ -21,9 +21,18 @@
 
 #pragma once
 
+#include <czmq.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <string>
 #include <set>
 #include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 //  @interface
 
@@ -45,3 +54,55 @@
  void
     dns_test (bool verbose);
 
+//  @end
+
+/// Reverse lookups on worker threads, with a cache of names and of failed lookups.
+///
+/// lookup() never blocks: it answers from the cache or queues the address and returns false.
+/// An address asked again while its lookup runs is not queued twice. Every finished lookup
+/// sends two frames, address and name (empty if not found), on the completions() socket, so
+/// an actor polls it together with its other sockets and asks again from the cache.
+class DnsResolver
+{
+public:
+    using Backend = std::function<std::string(const std::string& ip)>;
+
+    /// backend defaults to ip_to_name
+    DnsResolver(size_t threads, Backend backend = {}, std::chrono::seconds ttl = std::chrono::hours(1),
+        std::chrono::seconds negativeTtl = std::chrono::minutes(5));
+    ~DnsResolver();
+
+    DnsResolver(const DnsResolver&) = delete;
+    DnsResolver& operator=(const DnsResolver&) = delete;
+
+    /// true and the cached name (empty for a failed lookup), false if the lookup is pending
+    bool lookup(const std::string& ip, std::string& name);
+
+    zsock_t* completions();
+
+private:
+    struct Entry
+    {
+        std::string                           name;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    void worker();
+
+    Backend              m_backend;
+    std::chrono::seconds m_ttl;
+    std::chrono::seconds m_negativeTtl;
+
+    std::mutex                   m_lock;
+    std::condition_variable      m_wake;
+    bool                         m_stop = false;
+    std::deque<std::string>      m_queue;
+    std::set<std::string>        m_pending; // queued or running
+    std::map<std::string, Entry> m_cache;
+    std::vector<std::thread>     m_threads;
+
+    std::mutex m_sendLock; // workers share the sending end
+    zsock_t*   m_front = nullptr;
+    zsock_t*   m_back  = nullptr;
+};
+
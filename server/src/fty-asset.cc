@@ -34,6 +34,8 @@
 #include "fty_asset_autoupdate.h"
 #include "fty_asset_server.h"
 #include "fty_asset_inventory.h"
+#include "asset/asset-db.h"
+#include "change_journal.h"
 
 #define DEFAULT_LOG_CONFIG "/etc/fty/ftylog.cfg"
 
@@ -44,6 +46,20 @@ s_autoupdate_timer (zloop_t * /*loop*/, int /*timer_id*/, void *output)
     return 0;
 }
 
+static int
+s_snapshot_validate_timer (zloop_t * /*loop*/, int /*timer_id*/, void * /*output*/)
+{
+    fty::DB::validateSnapshot ();
+    return 0;
+}
+
+static int
+s_snapshot_timer (zloop_t * /*loop*/, int /*timer_id*/, void * /*output*/)
+{
+    fty::DB::saveSnapshotIfDue ();
+    return 0;
+}
+
 static int
 s_repeat_assets_timer (zloop_t * /*loop*/, int /*timer_id*/, void *output)
 {
@@ -80,6 +96,34 @@ int main (int argc, char *argv [])
     if (verbose)
         ManageFtyLog::getInstanceFtylog()->setVeboseMode();
 
+    // change sequence for CHANGES_SINCE, set up before any actor can record a change
+    char *change_seq_file = getenv("FTY_ASSET_CHANGE_SEQ_FILE");
+    char *change_journal_size = getenv("FTY_ASSET_CHANGE_JOURNAL_SIZE");
+    fty::ChangeJournal::instance().setup (
+        change_seq_file ? change_seq_file : "/var/lib/fty/fty-asset/change-seq",
+        change_journal_size ? std::stoul (change_journal_size) : 10000);
+
+    // serve LIST filters from an in-memory index, refreshed at most every FTY_ASSET_LIST_INDEX_TTL ms
+    char *list_index_ttl = getenv("FTY_ASSET_LIST_INDEX_TTL");
+    if (list_index_ttl) {
+        fty::DB::setListIndexTtl (std::stoll (list_index_ttl));
+    }
+    // QUERY columns follow the writes of this agent and the asset stream, FTY_ASSET_QUERY_TTL (ms) adds a periodic
+    // full reload for writes reaching neither, off by default
+    char *query_ttl = getenv("FTY_ASSET_QUERY_TTL");
+    if (query_ttl) {
+        fty::DB::setQueryTtl (std::stoll (query_ttl));
+    }
+
+    // snapshot of the asset model, warms the caches above before the first request
+    // off unless FTY_ASSET_SNAPSHOT_FILE is set: validating and writing it reads every asset table on the main loop
+    char *snapshot_file = getenv("FTY_ASSET_SNAPSHOT_FILE");
+    char *snapshot_changes = getenv("FTY_ASSET_SNAPSHOT_CHANGES");
+    fty::DB::setSnapshot (
+        snapshot_file ? snapshot_file : "",
+        snapshot_changes ? std::stoull (snapshot_changes) : 1000);
+    fty::DB::loadSnapshot ();
+
     zactor_t *asset_server = zactor_new (fty_asset_server, static_cast<void*>( const_cast<char*>("asset-agent")));
     zstr_sendx (asset_server, "CONNECTSTREAM", endpoint, NULL);
     zsock_wait (asset_server);
@@ -109,6 +153,8 @@ int main (int argc, char *argv [])
     zstr_sendx (inventory_server, "CONNECT", endpoint, NULL);
     zsock_wait (inventory_server);
     zstr_sendx (inventory_server, "CONSUMER", "ASSETS", ".*", NULL);
+    zsock_wait (inventory_server);
+    zstr_sendx (inventory_server, "WARMUP", NULL);
 
     // create regular event for autoupdate agent
     zloop_t *loop = zloop_new();
@@ -116,6 +162,10 @@ int main (int argc, char *argv [])
     zloop_timer (loop, 5*60*1000, 0, s_autoupdate_timer, autoupdate_server);
     // every repeat_interval_s
     zloop_timer (loop, static_cast<size_t>(repeat_interval_s * 1000), 0, s_repeat_assets_timer, asset_server);
+    // check the snapshot against the database once all agents serve requests
+    zloop_timer (loop, 1000, 1, s_snapshot_validate_timer, NULL);
+    // once a minute, written only after FTY_ASSET_SNAPSHOT_CHANGES changes
+    zloop_timer (loop, 60*1000, 0, s_snapshot_timer, NULL);
     zloop_start (loop);
     // zloop_start takes ownership of this thread! and waits for interrupt!
     zloop_destroy (&loop);
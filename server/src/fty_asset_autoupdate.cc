@@ -45,6 +45,8 @@ struct _fty_asset_autoupdate_t {
     char *asset_agent_name = NULL;
     std::vector<std::string> rcs;
     bool verbose;
+    DnsResolver *resolver = NULL;
+    bool rc_pending;        // RC lookup waits for names of local addresses
 };
 
 
@@ -60,6 +62,7 @@ fty_asset_autoupdate_destroy (fty_asset_autoupdate_t **self_p)
         zstr_free (&self->name);
         zstr_free (&self->asset_agent_name);
         mlm_client_destroy (&self->client);
+        delete self->resolver;
         free (self);
         *self_p = NULL;
     }
@@ -76,6 +79,8 @@ fty_asset_autoupdate_new (void)
     self->client = mlm_client_new ();
     if (self->client) {
         self->verbose = false;
+        self->resolver = new DnsResolver (2);
+        self->rc_pending = false;
     }
     else {
         fty_asset_autoupdate_destroy (&self);
@@ -177,9 +182,15 @@ autoupdate_update_rc_information (fty_asset_autoupdate_t *self)
     // there are more rc, test if one of my dns names == rc name
     // resolve dns names of all IP addresses on all interfaces
     // compare resolved name with list of RCs
+    // names not resolved yet are looked up in the background, we are called again when they come
+    self->rc_pending = false;
     for (const auto &interface: local_addresses ()) {
         for (const auto &ip: interface.second) {
-            std::string name = ip_to_name (ip.c_str());
+            std::string name;
+            if ( !self->resolver->lookup (ip, name) ) {
+                self->rc_pending = true;
+                continue;
+            }
             if ( name.empty () ) {
                 continue;
             }
@@ -196,6 +207,7 @@ autoupdate_update_rc_information (fty_asset_autoupdate_t *self)
                 if ( icase_streq (rc.c_str (), hostname.c_str ()) ||
                      icase_streq (rc.c_str (), name.c_str ())) {
                     // asset name == hostname this is me
+                    self->rc_pending = false;
                     autoupdate_update_rc_self (self, rc);
                     return;
                 }
@@ -271,7 +283,7 @@ fty_asset_autoupdate_server (zsock_t *pipe, void *args)
     self->name = strdup (static_cast<char*>(args));
     assert (self->name);
 
-    zpoller_t *poller = zpoller_new (pipe, mlm_client_msgpipe(self->client), NULL);
+    zpoller_t *poller = zpoller_new (pipe, mlm_client_msgpipe(self->client), self->resolver->completions (), NULL);
     assert (poller);
 
     // Signal need to be send as it is required by "actor_new"
@@ -357,6 +369,17 @@ fty_asset_autoupdate_server (zsock_t *pipe, void *args)
             autoupdate_handle_message (self, zmessage);
             zmsg_destroy (&zmessage);
         }
+        if (which == self->resolver->completions ()) {
+            char *ip = NULL, *name = NULL;
+            zstr_recvx (self->resolver->completions (), &ip, &name, NULL);
+            if ( self->verbose )
+                log_debug ("%s:\tResolved ip='%s', dns_name='%s'", self->name, ip, name);
+            zstr_free (&ip);
+            zstr_free (&name);
+            // names are in the cache now
+            if (self->rc_pending)
+                autoupdate_update_rc_information (self);
+        }
     }
  exit:
     log_info ("%s:\tended", self->name);
@@ -30,18 +30,54 @@
 
 #include <malamute.h>
 
-#include <unordered_map>
+#include <cinttypes>
 #include <string>
 #include <vector>
 
 #include "dns.h"
+#include "inventory_batch.h"
+#include "inventory_cache.h"
 #include "fty_log.h"
 #include "fty_proto.h"
 #include "asset/dbhelpers.h"
+#include "asset/asset-db.h"
 
 
 //  Structure of our class
 
+//  Queue changed keytags of an inventory message into the write-behind batch
+static void
+s_queue_inventory (fty::InventoryBatch &batch, const std::string &device_name, zhash_t *ext_attributes,
+    bool readonly, fty::InventoryCache &cache)
+{
+    for (void* it = zhash_first(ext_attributes); it != NULL; it = zhash_next(ext_attributes)) {
+        const char* value     = static_cast<const char*>(it);
+        const char* keytag    = zhash_cursor(ext_attributes);
+        bool        readonlyV = readonly;
+        if (strcmp(keytag, "name") == 0 || strcmp(keytag, "description") == 0)
+            readonlyV = false;
+
+        if (cache.contains (device_name, keytag, readonlyV, value))
+            continue;
+
+        batch.add (device_name, keytag, value, readonlyV);
+    }
+}
+
+//  Write pending inventory, cache is updated only with rows which made it to the DB
+static void
+s_flush_inventory (fty::InventoryBatch &batch, fty::InventoryCache &cache, bool test)
+{
+    int rv = batch.flush (test, [&cache, test](const std::string& device, const std::string& keytag,
+                                     const std::string& value, bool readonly) {
+        cache.update (device, keytag, readonly, value);
+        if (!test)
+            fty::DB::assetChanged (device);
+    });
+    if (rv != 0)
+        log_error ("Could not insert inventory data into DB");
+}
+
 void
 fty_asset_inventory_server (zsock_t *pipe, void *args)
 {
@@ -49,16 +85,23 @@ fty_asset_inventory_server (zsock_t *pipe, void *args)
     mlm_client_t *client = mlm_client_new ();
     zpoller_t *poller = zpoller_new (pipe, mlm_client_msgpipe (client), NULL);
     bool test = false;
-    std::unordered_map<std::string, std::string> ext_map_cache;
+    fty::InventoryCache ext_map_cache;
+    fty::InventoryBatch batch;
 
     zsock_signal (pipe, 0);
     log_info ("%s:\tStarted", name);
 
     while (!zsys_interrupted)
     {
-        void *which = zpoller_wait (poller, -1);
-        if (!which)
+        void *which = zpoller_wait (poller, batch.timeout (zclock_mono ()));
+        if (!which) {
+            if (zpoller_terminated (poller))
+                break;
+            // flush window elapsed
+            if (batch.timeout (zclock_mono ()) == 0)
+                s_flush_inventory (batch, ext_map_cache, test);
             continue;
+        }
         else
         if (which == pipe) {
             zmsg_t *msg = zmsg_recv (pipe);
@@ -105,6 +148,53 @@ fty_asset_inventory_server (zsock_t *pipe, void *args)
                 zsock_signal (pipe, 0);
             }
             else
+            if (streq (cmd, "BATCH")) {
+                // BATCH/flush interval ms/max pending rows
+                char* interval = zmsg_popstr (msg);
+                char* rows = zmsg_popstr (msg);
+                if (interval)
+                    batch.setFlushInterval (atoll (interval));
+                if (rows)
+                    batch.setMaxRows (static_cast<size_t> (atoll (rows)));
+                zstr_free (&rows);
+                zstr_free (&interval);
+                zsock_signal (pipe, 0);
+            }
+            else
+            if (streq (cmd, "CACHE_LIMIT")) {
+                // CACHE_LIMIT/max cached keytags, 0 = unbounded
+                char* limit = zmsg_popstr (msg);
+                if (limit)
+                    ext_map_cache.setMaxEntries (static_cast<size_t> (atoll (limit)));
+                zstr_free (&limit);
+                zsock_signal (pipe, 0);
+            }
+            else
+            if (streq (cmd, "WARMUP")) {
+                // prime the cache with stored values, first burst after restart then writes only changes
+                ext_map_cache.warmUp (test);
+            }
+            else
+            if (streq (cmd, "FLUSH")) {
+                s_flush_inventory (batch, ext_map_cache, test);
+                zsock_signal (pipe, 0);
+            }
+            else
+            if (streq (cmd, "STATS")) {
+                const auto& stats = batch.stats ();
+                uint64_t avg_batch = stats.flushes ? stats.rows / stats.flushes : 0;
+                uint64_t avg_latency = stats.flushes ? stats.totalLatencyUs / stats.flushes : 0;
+                zstr_sendx (pipe,
+                    std::to_string (stats.flushes).c_str (),
+                    std::to_string (stats.failures).c_str (),
+                    std::to_string (stats.rows).c_str (),
+                    std::to_string (avg_batch).c_str (),
+                    std::to_string (stats.maxBatch).c_str (),
+                    std::to_string (avg_latency).c_str (),
+                    std::to_string (stats.maxLatencyUs).c_str (),
+                    NULL);
+            }
+            else
             {
                 log_info ("%s:\tUnhandled command %s", name, cmd);
             }
@@ -125,23 +215,27 @@ fty_asset_inventory_server (zsock_t *pipe, void *args)
 
             if (streq (operation, "inventory")) {
                 zhash_t *ext = fty_proto_ext (proto);
-                [[maybe_unused]] int rv = process_insert_inventory (device_name, ext, true, ext_map_cache, test);
-                if (rv != 0)
-                    log_error ("Could not insert inventory data into DB");
+                s_queue_inventory (batch, device_name, ext, true, ext_map_cache);
+                if (batch.full ())
+                    s_flush_inventory (batch, ext_map_cache, test);
             } else if (streq (operation, "delete")) {
-                //  Vacuum the cache
-                //  The keys are formatted as asset_name:keytag[01]
-                device_name.append(":");
-                for (auto it = ext_map_cache.begin(); it != ext_map_cache.end(); )
-                    if (it->first.compare(0, device_name.size(), device_name) == 0)
-                        it = ext_map_cache.erase(it);
-                    else
-                        ++it;
+                batch.forget (device_name);
+                ext_map_cache.evict (device_name);
             }
             fty_proto_destroy (&proto);
         }
+
+        // steady traffic never lets the poller time out, the flush interval holds anyway
+        if (batch.timeout (zclock_mono ()) == 0)
+            s_flush_inventory (batch, ext_map_cache, test);
     }
 
+    // flush on shutdown, do not lose the last window
+    s_flush_inventory (batch, ext_map_cache, test);
+    const auto& stats = batch.stats ();
+    log_info ("%s:\tInventory writes: %" PRIu64 " flushes, %" PRIu64 " rows, max batch %" PRIu64
+        ", max latency %" PRIu64 " us", name, stats.flushes, stats.rows, stats.maxBatch, stats.maxLatencyUs);
+
     mlm_client_destroy (&client);
     zpoller_destroy (&poller);
     zstr_free (&name);
@@ -194,6 +288,102 @@ fty_asset_inventory_test (bool /*verbose*/)
         log_info ("fty-asset-server-test:Test #2: OK");
     }
 
+    // Test #3: inventory is written behind, on explicit flush
+    {
+        log_debug ("fty-asset-server-test:Test #3");
+        zhash_t *ext = zhash_new ();
+        zhash_autofree (ext);
+        zhash_insert (ext, "model", const_cast<char*>("ePDU"));
+        zhash_insert (ext, "serial_no", const_cast<char*>("1234"));
+        zmsg_t *msg = fty_proto_encode_asset (
+                NULL,
+                "MyDC",
+                "inventory",
+                ext);
+        [[maybe_unused]] int rv = mlm_client_send (ui, "inventory@dc-1", &msg);
+        assert (rv == 0);
+        zhash_destroy (&ext);
+        zclock_sleep (200);
+
+        zstr_sendx (inventory_server, "FLUSH", NULL);
+        zsock_wait (inventory_server);
+
+        zstr_sendx (inventory_server, "STATS", NULL);
+        zmsg_t *reply = zmsg_recv (inventory_server);
+        assert (reply && zmsg_size (reply) == 7);
+        char *flushes = zmsg_popstr (reply);
+        char *failures = zmsg_popstr (reply);
+        char *rows = zmsg_popstr (reply);
+        assert (streq (flushes, "1"));
+        assert (streq (failures, "0"));
+        assert (streq (rows, "2"));
+        zstr_free (&rows);
+        zstr_free (&failures);
+        zstr_free (&flushes);
+        zmsg_destroy (&reply);
+        log_info ("fty-asset-server-test:Test #3: OK");
+    }
+
+    // Test #4: unchanged inventory is deduplicated by the cache, nothing to flush
+    {
+        log_debug ("fty-asset-server-test:Test #4");
+        zhash_t *ext = zhash_new ();
+        zhash_autofree (ext);
+        zhash_insert (ext, "model", const_cast<char*>("ePDU"));
+        zmsg_t *msg = fty_proto_encode_asset (
+                NULL,
+                "MyDC",
+                "inventory",
+                ext);
+        [[maybe_unused]] int rv = mlm_client_send (ui, "inventory@dc-1", &msg);
+        assert (rv == 0);
+        zhash_destroy (&ext);
+        zclock_sleep (200);
+
+        zstr_sendx (inventory_server, "FLUSH", NULL);
+        zsock_wait (inventory_server);
+
+        zstr_sendx (inventory_server, "STATS", NULL);
+        zmsg_t *reply = zmsg_recv (inventory_server);
+        char *flushes = zmsg_popstr (reply);
+        assert (streq (flushes, "1"));
+        zstr_free (&flushes);
+        zmsg_destroy (&reply);
+        log_info ("fty-asset-server-test:Test #4: OK");
+    }
+
+    // Test #5: messages arriving faster than the flush interval are still flushed within it
+    {
+        log_debug ("fty-asset-server-test:Test #5");
+        zstr_sendx (inventory_server, "BATCH", "100", "1000", NULL);
+        zsock_wait (inventory_server);
+
+        for (int i = 0; i < 15; ++i) {
+            zhash_t *ext = zhash_new ();
+            zhash_autofree (ext);
+            std::string serial = "serial-" + std::to_string (i);
+            zhash_insert (ext, "serial_no", const_cast<char*>(serial.c_str ()));
+            zmsg_t *msg = fty_proto_encode_asset (
+                    NULL,
+                    "MyDC",
+                    "inventory",
+                    ext);
+            [[maybe_unused]] int rv = mlm_client_send (ui, "inventory@dc-1", &msg);
+            assert (rv == 0);
+            zhash_destroy (&ext);
+            zclock_sleep (40);
+        }
+
+        // 600 ms of traffic without a pause, the interval flushed several times
+        zstr_sendx (inventory_server, "STATS", NULL);
+        zmsg_t *reply = zmsg_recv (inventory_server);
+        char *flushes = zmsg_popstr (reply);
+        assert (atoi (flushes) >= 1 + 3);
+        zstr_free (&flushes);
+        zmsg_destroy (&reply);
+        log_info ("fty-asset-server-test:Test #5: OK");
+    }
+
     zactor_destroy (&inventory_server);
     mlm_client_destroy (&ui);
     zactor_destroy (&server);
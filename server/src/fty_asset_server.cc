@@ -191,14 +191,25 @@
 */
 #include "fty_asset_server.h"
 #include "fty_asset_autoupdate.h"
+#include "fty_asset_local_bus.h"
 
 #include "asset-server.h"
+#include "asset/asset-db.h"
 #include "asset/asset-utils.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <ctime>
+#include <deque>
+#include <map>
+#include <optional>
+#include <set>
 #include <string>
 
 #include <fty_asset_dto.h>
+#include <fty_asset_sql_trace.h>
+#include <fty_asset_stats.h>
 #include <fty_common.h>
 #include <fty_common_db_uptime.h>
 #include <fty_common_messagebus.h>
@@ -214,6 +225,8 @@
 
 #include "fty_proto.h"
 #include "total_power.h"
+#include "containment_index.h"
+#include "mailbox_workers.h"
 #include "asset/dbhelpers.h"
 
 #include "topology_processor.h"
@@ -224,6 +237,25 @@
 
 bool g_testMode = false;
 
+// subjects of the legacy mailbox with statistics, other names come from the sender and are not counted
+static const std::set<std::string> s_stats_subjects = {"TOPOLOGY", "ASSETS_IN_CONTAINER", "ASSETS",
+    "ENAME_FROM_INAME", "REPUBLISH", "ASSET_MANIPULATION", "ASSET_DETAIL", "STATS"};
+
+// sender of the mailbox request handled on the actor, held back requests run after others came in
+static std::string s_actor_sender;
+
+// reply to the sender of the request being handled, counted in the statistics of the subject
+// on a worker, the reply goes back to the actor which sends it
+static int s_reply(const fty::AssetServer& server, const char* subject, zmsg_t** reply)
+{
+    fty::stats::metric(std::string("legacy.") + subject).bytesOut += zmsg_content_size(*reply);
+    if (fty::MailboxWorkers::onWorker()) {
+        return fty::MailboxWorkers::reply(subject, reply);
+    }
+    mlm_client_t* client = const_cast<mlm_client_t*>(server.getMailboxClient());
+    return mlm_client_sendto(client, s_actor_sender.c_str(), subject, NULL, 5000, reply);
+}
+
 // =============================================================================
 // TOPOLOGY/POWER command processing (completed reply)
 // bmsg request asset-agent TOPOLOGY REQUEST <uuid> POWER <assetID>
@@ -502,9 +534,7 @@ static void s_handle_subject_topology(const fty::AssetServer& server, zmsg_t* ms
         }
 
         // send reply
-        int r = mlm_client_sendto(const_cast<mlm_client_t*>(server.getMailboxClient()),
-            mlm_client_sender(const_cast<mlm_client_t*>(server.getMailboxClient())), "TOPOLOGY", NULL, 5000,
-            &reply);
+        int r = s_reply(server, "TOPOLOGY", &reply);
         if (r != 0) {
             log_error("%s:\tTOPOLOGY %s: cannot send response message", command, client_name.c_str());
         }
@@ -569,9 +599,7 @@ static void s_handle_subject_assets_in_container(const fty::AssetServer& server,
     }
 
     // send the reply
-    rv = mlm_client_sendto(const_cast<mlm_client_t*>(server.getMailboxClient()),
-        mlm_client_sender(const_cast<mlm_client_t*>(server.getMailboxClient())), "ASSETS_IN_CONTAINER", NULL,
-        5000, &reply);
+    rv = s_reply(server, "ASSETS_IN_CONTAINER", &reply);
 
     if (rv == -1) {
         log_error("%s:\tASSETS_IN_CONTAINER: mlm_client_sendto failed", client_name.c_str());
@@ -591,9 +619,7 @@ static void s_handle_subject_ename_from_iname(const fty::AssetServer& server, zm
         log_error("%s:\tENAME_FROM_INAME: incoming message have less than 1 frame", client_name.c_str());
         zmsg_addstr(reply, "ERROR");
         zmsg_addstr(reply, "MISSING_INAME");
-        mlm_client_sendto(const_cast<mlm_client_t*>(server.getMailboxClient()),
-            mlm_client_sender(const_cast<mlm_client_t*>(server.getMailboxClient())), "ENAME_FROM_INAME", NULL,
-            5000, &reply);
+        s_reply(server, "ENAME_FROM_INAME", &reply);
         zmsg_destroy(&reply);
         return;
     }
@@ -613,9 +639,7 @@ static void s_handle_subject_ename_from_iname(const fty::AssetServer& server, zm
         zmsg_addstr(reply, ename.c_str());
     }
 
-    [[maybe_unused]] int rv = mlm_client_sendto(const_cast<mlm_client_t*>(server.getMailboxClient()),
-        mlm_client_sender(const_cast<mlm_client_t*>(server.getMailboxClient())), "ENAME_FROM_INAME", NULL,
-        5000, &reply);
+    [[maybe_unused]] int rv = s_reply(server, "ENAME_FROM_INAME", &reply);
 
     if (rv == -1) {
         log_error("%s:\tENAME_FROM_INAME: mlm_client_sendto failed", client_name.c_str());
@@ -636,9 +660,7 @@ static void s_handle_subject_assets(const fty::AssetServer& server, zmsg_t* msg)
         zmsg_addstr(reply, "0");
         zmsg_addstr(reply, "ERROR");
         zmsg_addstr(reply, "MISSING_COMMAND");
-        mlm_client_sendto(const_cast<mlm_client_t*>(server.getMailboxClient()),
-            mlm_client_sender(const_cast<mlm_client_t*>(server.getMailboxClient())), "ASSETS", NULL, 5000,
-            &reply);
+        s_reply(server, "ASSETS", &reply);
         zmsg_destroy(&reply);
         return;
     }
@@ -651,9 +673,7 @@ static void s_handle_subject_assets(const fty::AssetServer& server, zmsg_t* msg)
             zmsg_addstr(reply, uuid);
         zmsg_addstr(reply, "ERROR");
         zmsg_addstr(reply, "BAD_COMMAND");
-        mlm_client_sendto(const_cast<mlm_client_t*>(server.getMailboxClient()),
-            mlm_client_sender(const_cast<mlm_client_t*>(server.getMailboxClient())), "ASSETS", NULL, 5000,
-            &reply);
+        s_reply(server, "ASSETS", &reply);
         zstr_free(&c_command);
         zstr_free(&uuid);
         zmsg_destroy(&reply);
@@ -691,9 +711,7 @@ static void s_handle_subject_assets(const fty::AssetServer& server, zmsg_t* msg)
     }
 
     // send the reply
-    rv = mlm_client_sendto(const_cast<mlm_client_t*>(server.getMailboxClient()),
-        mlm_client_sender(const_cast<mlm_client_t*>(server.getMailboxClient())), "ASSETS", NULL, 5000,
-        &reply);
+    rv = s_reply(server, "ASSETS", &reply);
 
     if (rv == -1) {
         log_error("%s:\tASSETS: mlm_client_sendto failed", client_name.c_str());
@@ -775,56 +793,6 @@ static zmsg_t* s_publish_create_or_update_asset_msg(const std::string& client_na
         return NULL;
     }
 
-    // create uuid ext attribute if missing
-    if (!zhash_lookup(ext, "uuid")) {
-        const char* serial = static_cast<const char*>(zhash_lookup(ext, "serial_no"));
-        const char* model  = static_cast<const char*>(zhash_lookup(ext, "model"));
-        const char* mfr    = static_cast<const char*>(zhash_lookup(ext, "manufacturer"));
-        const char* type   = static_cast<const char*>(zhash_lookup(aux, "type"));
-        if (!type)
-            type = "";
-
-        fty_uuid_t* uuid = fty_uuid_new();
-        zhash_t* ext_new = zhash_new();
-
-        if (serial && model && mfr) {
-            // we have all information => create uuid
-            const char* uuid_new = fty_uuid_calculate(uuid, mfr, model, serial);
-            zhash_insert(ext, "uuid", static_cast<void*>( const_cast<char*>(uuid_new)));
-            zhash_insert(ext_new, "uuid", static_cast<void*>( const_cast<char*>(uuid_new)));
-
-            process_insert_inventory(asset_name.c_str(), ext_new, true, test_mode);
-        }
-        else {
-            // generate random uuid and save it
-            const char* uuid_new = fty_uuid_generate(uuid);
-            zhash_insert(ext, "uuid", static_cast<void*>( const_cast<char*>(uuid_new)));
-            zhash_insert(ext_new, "uuid", static_cast<void*>( const_cast<char*>(uuid_new)));
-
-            process_insert_inventory(asset_name.c_str(), ext_new, true, test_mode);
-        }
-
-        fty_uuid_destroy(&uuid);
-        zhash_destroy(&ext_new);
-    }
-
-    // create timestamp ext attribute if missing
-    if (!zhash_lookup(ext, "create_ts")) {
-        zhash_t* ext_new = zhash_new();
-
-        std::time_t timestamp = std::time(NULL);
-        char        mbstr[100];
-
-        std::strftime(mbstr, sizeof(mbstr), "%FT%T%z", std::localtime(&timestamp));
-
-        zhash_insert(ext, "create_ts", static_cast<void*>( const_cast<char*>(mbstr)));
-        zhash_insert(ext_new, "create_ts", static_cast<void*>( const_cast<char*>(mbstr)));
-
-        process_insert_inventory(asset_name.c_str(), ext_new, true, test_mode);
-
-        zhash_destroy(&ext_new);
-    }
-
     std::function<void(const tntdb::Row&)> cb3 = [aux](const tntdb::Row& row) {
         for (const auto& name :
             {"parent_name1", "parent_name2", "parent_name3", "parent_name4", "parent_name5", "parent_name6",
@@ -881,6 +849,87 @@ void send_create_or_update_asset(
     }
 }
 
+// same message as s_publish_create_or_update_asset_msg, built from an asset which was just written
+// returns NULL if the parent chain is not known, the caller falls back to the database
+static zmsg_t* s_encode_asset_msg(
+    const fty::AssetServer& server, const fty::Asset& asset, const char* operation, std::string& subject)
+{
+    const std::string& asset_name = asset.getInternalName();
+
+    uint32_t                 parent_id = 0;
+    std::vector<std::string> parents;
+    if (!fty::ContainmentIndex::instance().parents(asset_name, parent_id, parents, server.getTestMode())) {
+        return NULL;
+    }
+    // index lags behind the write, let the database answer
+    if ((parents.empty() ? std::string() : parents.front()) != asset.getParentIname()) {
+        return NULL;
+    }
+
+    zhash_t* aux = zhash_new();
+    zhash_t* ext = zhash_new();
+    if (!(aux && ext)) {
+        log_error("%s:\tMemory allocation failed", server.getAgentName().c_str());
+        zhash_destroy(&aux);
+        zhash_destroy(&ext);
+        return NULL;
+    }
+    zhash_autofree(aux);
+    zhash_autofree(ext);
+
+    zhash_insert(aux, "priority", const_cast<char*>(std::to_string(asset.getPriority()).c_str()));
+    zhash_insert(aux, "type", const_cast<char*>(asset.getAssetType().c_str()));
+    zhash_insert(aux, "subtype", const_cast<char*>(asset.getAssetSubtype().c_str()));
+    zhash_insert(aux, "parent", const_cast<char*>(std::to_string(parent_id).c_str()));
+    zhash_insert(aux, "status", const_cast<char*>(fty::assetStatusToString(asset.getAssetStatus()).c_str()));
+
+    // additional aux items (requiered by uptime), the active upses of the datacenter as DBUptime::get_dc_upses
+    if (asset.getAssetType() == "datacenter") {
+        std::vector<fty::ContainmentIndex::Node> nodes;
+        if (fty::ContainmentIndex::instance().nodesIn(asset_name, nodes, server.getTestMode()) != 0) {
+            log_error("Cannot read upses for dc with id = %s", asset_name.c_str());
+        }
+        int ups = 0;
+        for (const auto& node : nodes) {
+            if (node.subtype == persist::asset_subtype::UPS && node.status == "active") {
+                zhash_insert(aux, ("ups" + std::to_string(ups++)).c_str(), const_cast<char*>(node.name.c_str()));
+            }
+        }
+    }
+
+    for (size_t i = 0; i < parents.size() && i < 10; ++i) {
+        zhash_insert(aux, ("parent_name." + std::to_string(i + 1)).c_str(), const_cast<char*>(parents[i].c_str()));
+    }
+
+    for (const auto& e : asset.getExt()) {
+        zhash_insert(ext, e.first.c_str(), const_cast<char*>(e.second.getValue().c_str()));
+    }
+
+    subject = asset.getAssetType() + "." + asset.getAssetSubtype() + "@" + asset_name;
+    log_debug("notifying ASSETS %s %s ..", operation, subject.c_str());
+
+    zmsg_t* msg = fty_proto_encode_asset(aux, asset_name.c_str(), operation, ext);
+
+    zhash_destroy(&ext);
+    zhash_destroy(&aux);
+
+    return msg;
+}
+
+void send_asset_notification(const fty::AssetServer& server, const fty::Asset& asset, const char* operation)
+{
+    std::string subject;
+    zmsg_t*     msg = s_encode_asset_msg(server, asset, operation, subject);
+    if (NULL == msg) {
+        send_create_or_update_asset(server, asset.getInternalName(), operation, false);
+        return;
+    }
+    if (0 != mlm_client_send(const_cast<mlm_client_t*>(server.getStreamClient()), subject.c_str(), &msg)) {
+        log_info("%s:\tmlm_client_send not sending message for asset '%s'", server.getAgentName().c_str(),
+            asset.getInternalName().c_str());
+    }
+}
+
 static void s_sendto_create_or_update_asset(const fty::AssetServer& server, const std::string& asset_name,
     const char* operation, const char* address, const char* uuid)
 {
@@ -918,9 +967,7 @@ static void s_handle_subject_asset_detail(const fty::AssetServer& server, zmsg_t
             zmsg_addstr(reply, uuid);
         zmsg_addstr(reply, "ERROR");
         zmsg_addstr(reply, "BAD_COMMAND");
-        mlm_client_sendto(const_cast<mlm_client_t*>(server.getMailboxClient()),
-            mlm_client_sender(const_cast<mlm_client_t*>(server.getMailboxClient())), "ASSET_DETAIL", NULL,
-            5000, &reply);
+        s_reply(server, "ASSET_DETAIL", &reply);
         zstr_free(&uuid);
         zstr_free(&c_command);
         zmsg_destroy(&reply);
@@ -931,8 +978,7 @@ static void s_handle_subject_asset_detail(const fty::AssetServer& server, zmsg_t
     // select an asset and publish it through mailbox
     char* uuid       = zmsg_popstr(zmessage);
     char* asset_name = zmsg_popstr(zmessage);
-    s_sendto_create_or_update_asset(server, asset_name, FTY_PROTO_ASSET_OP_UPDATE,
-        mlm_client_sender(const_cast<mlm_client_t*>(server.getMailboxClient())), uuid);
+    s_sendto_create_or_update_asset(server, asset_name, FTY_PROTO_ASSET_OP_UPDATE, s_actor_sender, uuid);
     zstr_free(&asset_name);
     zstr_free(&uuid);
 }
@@ -956,9 +1002,7 @@ static void s_handle_subject_asset_manipulation(const fty::AssetServer& server,
     } else {
         zmsg_addstr(reply, "ERROR");
         zmsg_addstr(reply, "BAD_COMMAND");
-        mlm_client_sendto(const_cast<mlm_client_t*>(server.getMailboxClient()),
-            mlm_client_sender(const_cast<mlm_client_t*>(server.getMailboxClient())), "ASSET_MANIPULATION",
-            NULL, 5000, &reply);
+        s_reply(server, "ASSET_MANIPULATION", &reply);
         zstr_free(&read_only_s);
         zmsg_destroy(&reply);
         return;
@@ -1028,7 +1072,7 @@ static void s_handle_subject_asset_manipulation(const fty::AssetServer& server,
 
             auto notification = fty::assetutils::createMessage(FTY_ASSET_SUBJECT_CREATED, "",
                 server.getAgentNameNg(), "", messagebus::STATUS_OK, fty::Asset::toJson(asset));
-            server.sendNotification(notification);
+            server.sendNotification(notification, asset);
         } else if (streq(operation, "update")) {
             fty::AssetImpl currentAsset(asset.getInternalName());
             // on update, add link info from current asset:
@@ -1073,30 +1117,7 @@ static void s_handle_subject_asset_manipulation(const fty::AssetServer& server,
             zmsg_addstr(reply, "OK");
             zmsg_addstr(reply, asset.getInternalName().c_str());
 
-            cxxtools::SerializationInfo si;
-
-            // before update
-            cxxtools::SerializationInfo tmpSi;
-
-            tmpSi <<= currentAsset;
-
-            cxxtools::SerializationInfo& before = si.addMember("");
-            before.setCategory(cxxtools::SerializationInfo::Category::Object);
-            before = tmpSi;
-            before.setName("before");
-
-            // after update
-            tmpSi.clear();
-            tmpSi <<= asset;
-
-            cxxtools::SerializationInfo& after = si.addMember("");
-            after.setCategory(cxxtools::SerializationInfo::Category::Object);
-            after = tmpSi;
-            after.setName("after");
-
-            auto notification = fty::assetutils::createMessage(FTY_ASSET_SUBJECT_UPDATED, "",
-                server.getAgentNameNg(), "", messagebus::STATUS_OK, JSON::writeToString(si, false));
-            server.sendNotification(notification);
+            server.notifyAssetUpdate(currentAsset, asset);
         } else {
             // unknown op
             log_error("%s:\tASSET_MANIPULATION: asset operation %s is not implemented", client_name.c_str(),
@@ -1111,14 +1132,51 @@ static void s_handle_subject_asset_manipulation(const fty::AssetServer& server,
         zmsg_addstr(reply, e.what());
     }
 
-    mlm_client_sendto(const_cast<mlm_client_t*>(server.getMailboxClient()),
-        mlm_client_sender(const_cast<mlm_client_t*>(server.getMailboxClient())), "ASSET_MANIPULATION", NULL,
-        5000, &reply);
+    s_reply(server, "ASSET_MANIPULATION", &reply);
 
     fty_proto_destroy(&proto);
     zmsg_destroy(&reply);
 }
 
+// keep the containment index in sync with asset changes published by anyone
+static void s_update_containment(fty_proto_t* msg)
+{
+    const char* parent  = fty_proto_aux_string(msg, "parent", "0");
+    const char* type    = fty_proto_aux_string(msg, "type", "");
+    const char* subtype = fty_proto_aux_string(msg, "subtype", "");
+    const char* status  = fty_proto_aux_string(msg, "status", "");
+
+    uint32_t parent_id = 0;
+    try {
+        parent_id = static_cast<uint32_t>(std::stoul(parent));
+    } catch (...) {
+        parent_id = 0;
+    }
+
+    if (!fty::ContainmentIndex::instance().update(
+            fty_proto_operation(msg), fty_proto_name(msg), parent_id, type, subtype, status)) {
+        log_debug("Containment index reloads on next request, %s is new", fty_proto_name(msg));
+    }
+}
+
+// writes of other processes only show up on the stream, the own ones went through fty::DB already
+static void s_record_change(const fty::AssetServer& server, fty_proto_t* msg)
+{
+    const char* sender = mlm_client_sender(const_cast<mlm_client_t*>(server.getStreamClient()));
+    if (sender && server.getAgentName() + "-stream" == sender) {
+        return;
+    }
+
+    const char* operation = fty_proto_operation(msg);
+
+    // journaled, and reloaded in the QUERY columns
+    if (streq(operation, FTY_PROTO_ASSET_OP_CREATE) || streq(operation, FTY_PROTO_ASSET_OP_UPDATE)) {
+        fty::DB::assetChanged (fty_proto_name(msg));
+    } else if (streq(operation, FTY_PROTO_ASSET_OP_DELETE)) {
+        fty::DB::assetDeleted (fty_proto_name(msg));
+    }
+}
+
 static void s_update_topology(const fty::AssetServer& server, fty_proto_t* msg)
 {
     assert (msg);
@@ -1144,6 +1202,20 @@ static void s_update_topology(const fty::AssetServer& server, fty_proto_t* msg)
     }
 }
 
+// publishing stays read-only, missing uuid/create_ts are written here in one go.
+// All assets are checked at startup and on the REPEAT_ALL timer only, REPUBLISH follows every create or
+// update batch of the new interface and checks the requested assets.
+static void s_backfill(const fty::AssetServer& server, const std::set<std::string>& assets)
+{
+    std::vector<std::string> backfilled;
+    if (process_backfill_uuid_create_ts({assets.begin(), assets.end()}, backfilled, server.getTestMode()) != 0) {
+        log_warning("%s:\tCannot backfill uuid/create_ts", server.getAgentName().c_str());
+    }
+    for (const auto& name : backfilled) {
+        fty::DB::assetChanged(name);
+    }
+}
+
 static void s_repeat_all(const fty::AssetServer& server, const std::set<std::string>& assets_to_publish)
 {
     std::vector<std::string>               asset_names;
@@ -1186,6 +1258,100 @@ void handle_incoming_limitations(fty::AssetServer& server, fty_proto_t* metric)
     }
 }
 
+// read-only subjects served by the worker pool, the others change assets or publish and stay on the actor
+static const std::map<std::string, void (*)(const fty::AssetServer&, zmsg_t*)> s_worker_subjects = {
+    {"TOPOLOGY", s_handle_subject_topology},
+    {"ASSETS_IN_CONTAINER", s_handle_subject_assets_in_container},
+    {"ASSETS", s_handle_subject_assets},
+};
+
+static const size_t s_worker_count = 4;
+static const size_t s_worker_queue = 64;
+
+// selftest only, delay of every request served by the pool
+static std::atomic<int> s_test_worker_delay_ms{0};
+
+// mailbox request held back until the pool is done with the earlier requests of its sender
+struct HeldRequest
+{
+    std::string                           subject;
+    zmsg_t*                               msg;
+    uint64_t                              waited;
+    std::chrono::steady_clock::time_point since;
+};
+
+static void s_handle_mailbox_request(const fty::AssetServer& server, fty::MailboxWorkers& workers,
+    const std::string& sender, const std::string& subject, zmsg_t** zmessage_p, uint64_t waited)
+{
+    zmsg_t* zmessage = *zmessage_p;
+    *zmessage_p      = NULL;
+
+    auto offloaded = s_worker_subjects.find(subject);
+    if (offloaded != s_worker_subjects.end()) {
+        fty::stats::Metric& metric = fty::stats::metric("legacy." + subject);
+        metric.bytesIn += zmsg_content_size(zmessage);
+
+        auto handler  = offloaded->second;
+        auto enqueued = std::chrono::steady_clock::now();
+        workers.submit(sender, &zmessage, [&server, &metric, subject, handler, waited, enqueued](zmsg_t* msg) {
+            fty::sqltrace::Scope trace("legacy." + subject);
+            metric.queueWait.record(waited + uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(
+                                                 std::chrono::steady_clock::now() - enqueued).count()));
+            fty::stats::ScopedTimer timer(metric.latency);
+            if (int delay = s_test_worker_delay_ms) {
+                zclock_sleep(delay);
+            }
+            handler(server, msg);
+        });
+        return;
+    }
+
+    s_actor_sender = sender;
+
+    fty::sqltrace::Scope                   trace("legacy." + subject);
+    std::optional<fty::stats::ScopedTimer> timer;
+    if (s_stats_subjects.count(subject)) {
+        fty::stats::Metric& metric = fty::stats::metric("legacy." + subject);
+        metric.bytesIn += zmsg_content_size(zmessage);
+        metric.queueWait.record(waited);
+        timer.emplace(metric.latency);
+    }
+
+    if (subject == "ENAME_FROM_INAME") {
+        s_handle_subject_ename_from_iname(server, zmessage);
+    } else if (subject == "REPUBLISH") {
+        zmsg_print(zmessage);
+        log_trace("REPUBLISH received from '%s'", sender.c_str());
+        char* asset = zmsg_popstr(zmessage);
+        if (!asset || streq(asset, "$all")) {
+            s_repeat_all(server);
+        } else {
+            std::set<std::string> assets_to_publish;
+            while (asset) {
+                assets_to_publish.insert(asset);
+                zstr_free(&asset);
+                asset = zmsg_popstr(zmessage);
+            }
+            s_backfill(server, assets_to_publish);
+            s_repeat_all(server, assets_to_publish);
+        }
+        zstr_free(&asset);
+    } else if (subject == "ASSET_MANIPULATION") {
+        s_handle_subject_asset_manipulation(server, &zmessage);
+    } else if (subject == "ASSET_DETAIL") {
+        s_handle_subject_asset_detail(server, &zmessage);
+    } else if (subject == "STATS") {
+        zmsg_t* reply = zmsg_new();
+        zmsg_addstr(reply, "OK");
+        zmsg_addstr(reply, fty::stats::toJson().c_str());
+        s_reply(server, "STATS", &reply);
+        zmsg_destroy(&reply);
+    } else {
+        log_info("%s:\tUnexpected subject '%s'", server.getAgentName().c_str(), subject.c_str());
+    }
+    zmsg_destroy(&zmessage);
+}
+
 void fty_asset_server(zsock_t* pipe, void* args)
 {
     assert (pipe);
@@ -1198,9 +1364,14 @@ void fty_asset_server(zsock_t* pipe, void* args)
     server.setAgentNameNg(server.getAgentName() + "-ng");
     server.setSrrAgentName(server.getAgentName() + "-srr");
 
+    // destroyed before the server, queued requests still use it
+    fty::MailboxWorkers workers(s_worker_count, s_worker_queue);
+    // requests held back by sender, see s_handle_mailbox_request
+    std::map<std::string, std::deque<HeldRequest>> held;
+
     zpoller_t* poller =
         zpoller_new(pipe, mlm_client_msgpipe(const_cast<mlm_client_t*>(server.getMailboxClient())),
-            mlm_client_msgpipe(const_cast<mlm_client_t*>(server.getStreamClient())), NULL);
+            mlm_client_msgpipe(const_cast<mlm_client_t*>(server.getStreamClient())), workers.replies(), NULL);
 
     assert (poller);
 
@@ -1211,14 +1382,22 @@ void fty_asset_server(zsock_t* pipe, void* args)
     // set-up SRR
     server.initSrr(FTY_ASSET_SRR_QUEUE);
 
+    // a request already waiting when the actor comes back to the poller came in while the previous event was
+    // handled, so it waited at most since that event started; a request found by a blocking wait did not wait
+    zsock_t* mailbox    = mlm_client_msgpipe(const_cast<mlm_client_t*>(server.getMailboxClient()));
+    auto     eventStart = std::chrono::steady_clock::now();
+
     while (!zsys_interrupted) {
 
-        void* which = zpoller_wait(poller, -1);
+        bool  queued = (zsock_events(mailbox) & ZMQ_POLLIN) != 0;
+        void* which  = zpoller_wait(poller, -1);
         if (!which) {
             // cannot expire as waiting until infinity
             // so it is interrupted
             break; // while
         }
+        auto previousStart = eventStart;
+        eventStart         = std::chrono::steady_clock::now();
 
         if (which == pipe) {
             zmsg_t* msg = zmsg_recv(pipe);
@@ -1290,6 +1469,7 @@ void fty_asset_server(zsock_t* pipe, void* args)
                 zstr_free(&endpoint);
                 zsock_signal(pipe, 0);
             } else if (streq(cmd, "REPEAT_ALL")) {
+                s_backfill(server, {});
                 s_repeat_all(server);
                 log_debug("%s:\tREPEAT_ALL end", server.getAgentName().c_str());
             } else {
@@ -1308,39 +1488,20 @@ void fty_asset_server(zsock_t* pipe, void* args)
                 continue;
             }
             std::string subject = mlm_client_subject(const_cast<mlm_client_t*>(server.getMailboxClient()));
-            if (subject == "TOPOLOGY") {
-                s_handle_subject_topology(server, zmessage);
-            } else if (subject == "ASSETS_IN_CONTAINER") {
-                s_handle_subject_assets_in_container(server, zmessage);
-            } else if (subject == "ASSETS") {
-                s_handle_subject_assets(server, zmessage);
-            } else if (subject == "ENAME_FROM_INAME") {
-                s_handle_subject_ename_from_iname(server, zmessage);
-            } else if (subject == "REPUBLISH") {
-                zmsg_print(zmessage);
-                log_trace("REPUBLISH received from '%s'",
-                    mlm_client_sender(const_cast<mlm_client_t*>(server.getMailboxClient())));
-                char* asset = zmsg_popstr(zmessage);
-                if (!asset || streq(asset, "$all")) {
-                    s_repeat_all(server);
-                } else {
-                    std::set<std::string> assets_to_publish;
-                    while (asset) {
-                        assets_to_publish.insert(asset);
-                        zstr_free(&asset);
-                        asset = zmsg_popstr(zmessage);
-                    }
-                    s_repeat_all(server, assets_to_publish);
-                }
-                zstr_free(&asset);
-            } else if (subject == "ASSET_MANIPULATION") {
-                s_handle_subject_asset_manipulation(server, &zmessage);
-            } else if (subject == "ASSET_DETAIL") {
-                s_handle_subject_asset_detail(server, &zmessage);
-            } else {
-                log_info("%s:\tUnexpected subject '%s'", server.getAgentName().c_str(), subject.c_str());
+            uint64_t    waited  = queued ? uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(
+                                                  eventStart - previousStart).count())
+                                         : 0;
+
+            std::string sender = mlm_client_sender(const_cast<mlm_client_t*>(server.getMailboxClient()));
+
+            // replies of one sender leave in request order: while the pool serves a sender, the requests the
+            // actor would serve itself are held back, and the later ones of that sender queue behind them
+            auto found = held.find(sender);
+            if (found != held.end() || (!s_worker_subjects.count(subject) && workers.busy(sender))) {
+                held[sender].push_back(HeldRequest{subject, zmessage, waited, std::chrono::steady_clock::now()});
+                continue;
             }
-            zmsg_destroy(&zmessage);
+            s_handle_mailbox_request(server, workers, sender, subject, &zmessage, waited);
         } else if (which == mlm_client_msgpipe(const_cast<mlm_client_t*>(server.getStreamClient()))) {
             zmsg_t* zmessage = mlm_client_recv(const_cast<mlm_client_t*>(server.getStreamClient()));
             if (zmessage == NULL) {
@@ -1349,6 +1510,8 @@ void fty_asset_server(zsock_t* pipe, void* args)
             if (fty_proto_is(zmessage)) {
                 fty_proto_t* bmsg = fty_proto_decode(&zmessage);
                 if (fty_proto_id(bmsg) == FTY_PROTO_ASSET) {
+                    s_update_containment(bmsg);
+                    s_record_change(server, bmsg);
                     s_update_topology(server, bmsg);
                 } else if (fty_proto_id(bmsg) == FTY_PROTO_METRIC) {
                     handle_incoming_limitations(server, bmsg);
@@ -1356,12 +1519,41 @@ void fty_asset_server(zsock_t* pipe, void* args)
                 fty_proto_destroy(&bmsg);
             }
             zmsg_destroy(&zmessage);
+        } else if (which == workers.replies()) {
+            std::string sender, subject;
+            zmsg_t*     reply = workers.recv(sender, subject);
+            if (reply &&
+                mlm_client_sendto(const_cast<mlm_client_t*>(server.getMailboxClient()), sender.c_str(),
+                    subject.c_str(), NULL, 5000, &reply) != 0) {
+                log_error("%s:\t%s: mlm_client_sendto %s failed", server.getAgentName().c_str(), subject.c_str(),
+                    sender.c_str());
+            }
+            zmsg_destroy(&reply);
+
+            // the pool is done with this sender, its held back requests go on in order until one goes to the pool
+            auto found = held.find(sender);
+            while (found != held.end() && !workers.busy(sender)) {
+                HeldRequest request = found->second.front();
+                found->second.pop_front();
+                if (found->second.empty()) {
+                    held.erase(found);
+                    found = held.end();
+                }
+                uint64_t waited = request.waited + uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(
+                                                       std::chrono::steady_clock::now() - request.since).count());
+                s_handle_mailbox_request(server, workers, sender, request.subject, &request.msg, waited);
+            }
         } else {
             // DO NOTHING for now
         }
     }
 
     log_info("%s:\tended", server.getAgentName().c_str());
+    for (auto& requests : held) {
+        for (auto& request : requests.second) {
+            zmsg_destroy(&request.msg);
+        }
+    }
     // TODO:  save info to persistence before I die
     zpoller_destroy(&poller);
 }
@@ -2007,6 +2199,213 @@ void fty_asset_server_test(bool /*verbose*/)
         zclock_sleep(200);
     }
 
+    // Test #16: a slow TOPOLOGY request on the worker pool does not delay a small GET of another sender,
+    // replies of one sender keep their order
+    {
+        log_debug("fty-asset-server-test:Test #16");
+        fty::MailboxWorkers workers(2, 4);
+
+        auto request = [](const char* command) {
+            zmsg_t* msg = zmsg_new();
+            zmsg_addstr(msg, command);
+            return msg;
+        };
+        auto handler = [](const char* subject, int delayMs) {
+            return [subject, delayMs](zmsg_t* msg) {
+                zclock_sleep(delayMs);
+                zmsg_t* reply = zmsg_dup(msg);
+                [[maybe_unused]] int rv = fty::MailboxWorkers::reply(subject, &reply);
+                assert (rv == 0);
+            };
+        };
+
+        // senders hashed on different workers
+        std::string slowSender = "slow-ui", fastSender = "fast-ui";
+        for (int i = 0; std::hash<std::string>{}(slowSender) % 2 == std::hash<std::string>{}(fastSender) % 2; ++i) {
+            fastSender = "fast-ui-" + std::to_string(i);
+        }
+
+        int64_t start = zclock_mono();
+        zmsg_t* msg   = request("POWER");
+        workers.submit(slowSender, &msg, handler("TOPOLOGY", 1000));
+        msg = request("SECOND");
+        workers.submit(slowSender, &msg, handler("TOPOLOGY", 0));
+        msg = request("GET");
+        workers.submit(fastSender, &msg, handler("ASSETS", 0));
+        assert (msg == NULL);
+        assert (!fty::MailboxWorkers::onWorker());
+        assert (workers.busy(slowSender));
+
+        std::vector<std::string> order;
+        while (order.size() < 3 || workers.busy(slowSender) || workers.busy(fastSender)) {
+            std::string sender, subject;
+            zmsg_t*     reply = workers.recv(sender, subject);
+            if (!reply) {
+                // end of a request, behind its reply
+                assert (subject.empty());
+                assert (std::count(order.begin(), order.end(), sender == fastSender ? "GET" : "POWER") == 1);
+                continue;
+            }
+            char* command = zmsg_popstr(reply);
+            if (order.empty()) {
+                assert (sender == fastSender);
+                assert (subject == "ASSETS");
+                assert (streq(command, "GET"));
+                assert (zclock_mono() - start < 500);
+            } else {
+                assert (sender == slowSender);
+                assert (subject == "TOPOLOGY");
+            }
+            order.push_back(command);
+            zstr_free(&command);
+            zmsg_destroy(&reply);
+        }
+        assert ((order == std::vector<std::string>{"GET", "POWER", "SECOND"}));
+        log_info("fty-asset-server-test:Test #16: OK");
+    }
+
+    // Test #17: a delete is notified on the full and the light topic
+    {
+        log_debug("fty-asset-server-test:Test #17");
+        fty::LocalBroker broker; // outlives the clients of the server
+        fty::AssetServer ngServer;
+        ngServer.setMessageBusFactory(broker.factory());
+        ngServer.createPublisherClientNg();
+        ngServer.connectPublisherClientNg();
+
+        std::vector<std::string>                full, light;
+        std::unique_ptr<messagebus::MessageBus> subscriber(broker.client("test-subscriber"));
+        subscriber->subscribe(FTY_ASSET_TOPIC_DELETED, [&full](messagebus::Message msg) {
+            fty::Asset asset;
+            fty::Asset::fromJson(msg.userData().front(), asset);
+            full.push_back(asset.getInternalName());
+        });
+        subscriber->subscribe(FTY_ASSET_TOPIC_DELETED_L, [&light](messagebus::Message msg) {
+            assert (msg.metaData()[messagebus::Message::SUBJECT] == FTY_ASSET_SUBJECT_DELETED_L);
+            light.push_back(msg.userData().front());
+        });
+
+        fty::Asset deletedAsset, failedAsset;
+        deletedAsset.setInternalName("rack-17");
+        failedAsset.setInternalName("rack-18");
+        ngServer.notifyDeleted({{deletedAsset, "OK"}, {failedAsset, "Asset has children"}}, false);
+
+        assert ((full == std::vector<std::string>{"rack-17"}));
+        assert ((light == std::vector<std::string>{"rack-17"}));
+        log_info("fty-asset-server-test:Test #17: OK");
+    }
+
+    // Test #18: BULK_NOTIFY adds DELETED_LIST chunks, per asset notifications are still sent
+    {
+        log_debug("fty-asset-server-test:Test #18");
+        fty::LocalBroker broker;
+        fty::AssetServer ngServer;
+        ngServer.setMessageBusFactory(broker.factory());
+        ngServer.createPublisherClientNg();
+        ngServer.connectPublisherClientNg();
+
+        size_t                                  full = 0, light = 0;
+        std::vector<size_t>                     lists;
+        std::unique_ptr<messagebus::MessageBus> subscriber(broker.client("test-subscriber"));
+        subscriber->subscribe(FTY_ASSET_TOPIC_DELETED, [&full](messagebus::Message) {
+            ++full;
+        });
+        subscriber->subscribe(FTY_ASSET_TOPIC_DELETED_L, [&light](messagebus::Message) {
+            ++light;
+        });
+        subscriber->subscribe(FTY_ASSET_TOPIC_DELETED_LIST, [&lists](messagebus::Message msg) {
+            lists.push_back(msg.userData().size());
+        });
+
+        fty::DeleteStatus deleted;
+        for (size_t i = 0; i < FTY_ASSET_DELETED_LIST_MAX + 44; ++i) {
+            fty::Asset asset;
+            asset.setInternalName("device-" + std::to_string(i));
+            deleted.emplace_back(asset, "OK");
+        }
+
+        ngServer.notifyDeleted(deleted, false);
+        assert (full == deleted.size());
+        assert (light == deleted.size());
+        assert (lists.empty());
+
+        full = light = 0;
+        ngServer.notifyDeleted(deleted, true);
+        assert (full == deleted.size());
+        assert (light == deleted.size());
+        assert ((lists == std::vector<size_t>{FTY_ASSET_DELETED_LIST_MAX, 44}));
+        log_info("fty-asset-server-test:Test #18: OK");
+    }
+
+    // Test #19: through the actor, a slow TOPOLOGY request does not delay the GET of another sender, the GET
+    // its own sender sends next is answered after it
+    {
+        log_debug("fty-asset-server-test:Test #19");
+        mlm_client_t* other = mlm_client_new();
+        mlm_client_connect(other, endpoint.c_str(), 5000, (client_name + "-other").c_str());
+
+        auto topology = []() {
+            zmsg_t* msg = zmsg_new();
+            zmsg_addstr(msg, "REQUEST");
+            zmsg_addstr(msg, "UUID-19-POWER");
+            zmsg_addstr(msg, "POWER");
+            zmsg_addstr(msg, asset_name);
+            return msg;
+        };
+        auto detail = [](const char* uuid) {
+            zmsg_t* msg = zmsg_new();
+            zmsg_addstr(msg, "GET");
+            zmsg_addstr(msg, uuid);
+            zmsg_addstr(msg, asset_name);
+            return msg;
+        };
+        // first frame of the next mailbox reply, stream messages are skipped
+        auto recv = [](mlm_client_t* client, std::string& subject) {
+            while (true) {
+                zmsg_t* reply = mlm_client_recv(client);
+                assert (reply);
+                if (streq(mlm_client_command(client), "MAILBOX DELIVER")) {
+                    subject     = mlm_client_subject(client);
+                    char*       str = zmsg_popstr(reply);
+                    std::string first(str ? str : "");
+                    zstr_free(&str);
+                    zmsg_destroy(&reply);
+                    return first;
+                }
+                zmsg_destroy(&reply);
+            }
+        };
+
+        s_test_worker_delay_ms = 1000;
+        int64_t start          = zclock_mono();
+
+        zmsg_t*              msg = topology();
+        [[maybe_unused]] int rv  = mlm_client_sendto(ui, asset_server_test_name.c_str(), "TOPOLOGY", NULL, 5000, &msg);
+        assert (rv == 0);
+        msg = detail("UUID-19-UI");
+        rv  = mlm_client_sendto(ui, asset_server_test_name.c_str(), "ASSET_DETAIL", NULL, 5000, &msg);
+        assert (rv == 0);
+        msg = detail("UUID-19-OTHER");
+        rv  = mlm_client_sendto(other, asset_server_test_name.c_str(), "ASSET_DETAIL", NULL, 5000, &msg);
+        assert (rv == 0);
+
+        std::string subject;
+        std::string first = recv(other, subject);
+        assert (first == "UUID-19-OTHER");
+        assert (zclock_mono() - start < 500);
+
+        first = recv(ui, subject);
+        assert (subject == "TOPOLOGY");
+        assert (first == "UUID-19-POWER");
+        assert (zclock_mono() - start >= 1000);
+        first = recv(ui, subject);
+        assert (first == "UUID-19-UI");
+
+        s_test_worker_delay_ms = 0;
+        mlm_client_destroy(&other);
+        log_info("fty-asset-server-test:Test #19: OK");
+    }
+
     zactor_destroy(&autoupdate_server);
     zactor_destroy(&asset_server);
     mlm_client_destroy(&ui);
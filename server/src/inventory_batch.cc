@@ -0,0 +1,168 @@
+/*  =========================================================================
+    inventory_batch - Write-behind stage of the inventory server
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    inventory_batch - Write-behind stage of the inventory server
+@discuss
+@end
+*/
+
+#include "inventory_batch.h"
+#include "asset/dbhelpers.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <czmq.h>
+#include <fty_log.h>
+#include <vector>
+
+namespace fty {
+
+InventoryBatch::InventoryBatch(int64_t flushIntervalMs, size_t maxRows)
+    : m_flushIntervalMs(flushIntervalMs)
+    , m_maxRows(maxRows)
+{
+}
+
+void InventoryBatch::setFlushInterval(int64_t flushIntervalMs)
+{
+    m_flushIntervalMs = flushIntervalMs;
+}
+
+void InventoryBatch::setMaxRows(size_t maxRows)
+{
+    m_maxRows = maxRows;
+}
+
+void InventoryBatch::add(const std::string& device, const std::string& keytag, const std::string& value, bool readonly)
+{
+    if (m_rows == 0) {
+        m_firstPending = zclock_mono();
+    }
+
+    auto& keytags = m_pending[device];
+    auto  it      = keytags.find(keytag);
+    if (it == keytags.end()) {
+        keytags.emplace(keytag, Pending{value, readonly});
+        ++m_rows;
+    } else {
+        it->second = Pending{value, readonly};
+    }
+}
+
+void InventoryBatch::forget(const std::string& device)
+{
+    auto it = m_pending.find(device);
+    if (it != m_pending.end()) {
+        m_rows -= it->second.size();
+        m_pending.erase(it);
+    }
+    m_ids.erase(device);
+}
+
+int InventoryBatch::timeout(int64_t now) const
+{
+    if (m_rows == 0) {
+        return -1;
+    }
+    int64_t left = m_firstPending + m_flushIntervalMs - now;
+    return left > 0 ? static_cast<int>(left) : 0;
+}
+
+int InventoryBatch::flush(bool test, const WrittenCb& written)
+{
+    if (m_rows == 0) {
+        return 0;
+    }
+
+    int64_t start = zclock_usecs();
+
+    // resolve ids of devices seen for the first time
+    std::vector<std::string> unresolved;
+    for (const auto& device : m_pending) {
+        if (m_ids.find(device.first) == m_ids.end()) {
+            unresolved.push_back(device.first);
+        }
+    }
+    if (select_asset_ids_by_name(unresolved, m_ids, test) != 0) {
+        // keep rows pending, retry after another flush interval
+        m_firstPending = zclock_mono();
+        ++m_stats.failures;
+        return -1;
+    }
+
+    std::vector<InventoryRow> rows;
+    rows.reserve(m_rows);
+    for (const auto& device : m_pending) {
+        auto id = m_ids.find(device.first);
+        if (id == m_ids.end()) {
+            if (!test) {
+                log_warning("Inventory of unknown asset %s dropped", device.first.c_str());
+                continue;
+            }
+            id = m_ids.emplace(device.first, 0).first;
+        }
+        for (const auto& keytag : device.second) {
+            rows.push_back({id->second, keytag.first, keytag.second.value, keytag.second.readonly});
+        }
+    }
+
+    int rv = process_insert_inventory_batch(rows, test);
+    if (rv != 0) {
+        // ids may be stale (asset deleted and re-created), resolve them again on retry
+        for (const auto& device : m_pending) {
+            m_ids.erase(device.first);
+        }
+        m_firstPending = zclock_mono();
+        ++m_stats.failures;
+        return rv;
+    }
+
+    if (written) {
+        for (const auto& device : m_pending) {
+            if (m_ids.find(device.first) == m_ids.end()) {
+                continue;
+            }
+            for (const auto& keytag : device.second) {
+                written(device.first, keytag.first, keytag.second.value, keytag.second.readonly);
+            }
+        }
+    }
+
+    uint64_t latency = static_cast<uint64_t>(zclock_usecs() - start);
+    ++m_stats.flushes;
+    m_stats.rows += rows.size();
+    m_stats.maxBatch = std::max<uint64_t>(m_stats.maxBatch, rows.size());
+    m_stats.lastLatencyUs = latency;
+    m_stats.maxLatencyUs  = std::max(m_stats.maxLatencyUs, latency);
+    m_stats.totalLatencyUs += latency;
+
+    log_debug("Inventory flush: %zu rows of %zu devices written in %" PRIu64 " us", rows.size(), m_pending.size(),
+        latency);
+
+    m_pending.clear();
+    m_rows = 0;
+
+    return 0;
+}
+
+} // namespace fty
@@ -0,0 +1,103 @@
+/*  =========================================================================
+    inventory_batch - Write-behind stage of the inventory server
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+namespace fty {
+
+/// Coalesces inventory ext attributes across messages and writes them in one transaction per flush.
+///
+/// A flush is due when the oldest pending row waited for the flush interval, or when the number of
+/// pending rows reaches the size limit. Later values of the same device keytag replace pending ones.
+class InventoryBatch
+{
+public:
+    struct Stats
+    {
+        uint64_t flushes        = 0;
+        uint64_t failures       = 0;
+        uint64_t rows           = 0;
+        uint64_t maxBatch       = 0;
+        uint64_t lastLatencyUs  = 0;
+        uint64_t maxLatencyUs   = 0;
+        uint64_t totalLatencyUs = 0;
+    };
+
+    /// called for every row successfully written to the database
+    using WrittenCb = std::function<void(
+        const std::string& device, const std::string& keytag, const std::string& value, bool readonly)>;
+
+    InventoryBatch(int64_t flushIntervalMs = 500, size_t maxRows = 2000);
+
+    void setFlushInterval(int64_t flushIntervalMs);
+    void setMaxRows(size_t maxRows);
+
+    void add(const std::string& device, const std::string& keytag, const std::string& value, bool readonly);
+
+    /// drop pending rows and resolved id of a deleted device
+    void forget(const std::string& device);
+
+    bool empty() const
+    {
+        return m_rows == 0;
+    }
+
+    bool full() const
+    {
+        return m_rows >= m_maxRows;
+    }
+
+    /// ms until the next flush is due, -1 if nothing is pending
+    int timeout(int64_t now) const;
+
+    /// write all pending rows, returns 0 on success, -1 on database error
+    int flush(bool test, const WrittenCb& written = nullptr);
+
+    const Stats& stats() const
+    {
+        return m_stats;
+    }
+
+private:
+    struct Pending
+    {
+        std::string value;
+        bool        readonly;
+    };
+
+    // device -> keytag -> pending value
+    std::unordered_map<std::string, std::unordered_map<std::string, Pending>> m_pending;
+    // device -> id_asset_element, resolved once per device
+    std::unordered_map<std::string, uint32_t> m_ids;
+
+    int64_t m_flushIntervalMs;
+    size_t  m_maxRows;
+    size_t  m_rows         = 0;
+    int64_t m_firstPending = 0;
+    Stats   m_stats;
+};
+
+} // namespace fty
@@ -0,0 +1,149 @@
+/*  =========================================================================
+    inventory_cache - Dedup cache of the inventory server
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    inventory_cache - Dedup cache of the inventory server
+@discuss
+@end
+*/
+
+#include "inventory_cache.h"
+#include "asset/dbhelpers.h"
+
+#include <fty_log.h>
+
+namespace fty {
+
+InventoryCache::InventoryCache(size_t maxEntries)
+    : m_maxEntries(maxEntries)
+{
+}
+
+void InventoryCache::setMaxEntries(size_t maxEntries)
+{
+    m_maxEntries = maxEntries;
+    shrink();
+}
+
+uint32_t InventoryCache::keytagId(const std::string& keytag, bool readonly)
+{
+    // keytags are a small set shared by all assets, intern them once
+    auto it = m_keytags.find(keytag);
+    if (it == m_keytags.end()) {
+        it = m_keytags.emplace(keytag, static_cast<uint32_t>(m_keytags.size())).first;
+    }
+    return (it->second << 1) | (readonly ? 1u : 0u);
+}
+
+uint64_t InventoryCache::hash(const std::string& value)
+{
+    // FNV-1a, stable and cheap for short inventory values
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned char c : value) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+bool InventoryCache::contains(
+    const std::string& asset, const std::string& keytag, bool readonly, const std::string& value)
+{
+    auto it = m_assets.find(asset);
+    if (it == m_assets.end()) {
+        return false;
+    }
+
+    // touch
+    m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+
+    auto found = it->second.values.find(keytagId(keytag, readonly));
+    return found != it->second.values.end() && found->second == hash(value);
+}
+
+void InventoryCache::update(const std::string& asset, const std::string& keytag, bool readonly, const std::string& value)
+{
+    auto it = m_assets.find(asset);
+    if (it == m_assets.end()) {
+        m_lru.push_front(asset);
+        it = m_assets.emplace(asset, AssetEntry()).first;
+        it->second.lru = m_lru.begin();
+    } else {
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+    }
+
+    if (it->second.values.insert_or_assign(keytagId(keytag, readonly), hash(value)).second) {
+        ++m_entries;
+        shrink();
+    }
+}
+
+void InventoryCache::evict(const std::string& asset)
+{
+    auto it = m_assets.find(asset);
+    if (it != m_assets.end()) {
+        m_entries -= it->second.values.size();
+        m_lru.erase(it->second.lru);
+        m_assets.erase(it);
+    }
+}
+
+void InventoryCache::clear()
+{
+    m_assets.clear();
+    m_lru.clear();
+    m_entries = 0;
+}
+
+void InventoryCache::shrink()
+{
+    if (m_maxEntries == 0) {
+        return;
+    }
+    // never evict the most recently used asset, it is the one being written
+    while (m_entries > m_maxEntries && m_lru.size() > 1) {
+        evict(m_lru.back());
+    }
+}
+
+int InventoryCache::warmUp(bool test)
+{
+    if (test) {
+        return 0;
+    }
+
+    std::function<void(const tntdb::Row&)> cb = [this](const tntdb::Row& row) {
+        update(row.getString("name"), row.getString("keytag"), row.getBool("read_only"), row.getString("value"));
+    };
+
+    int rv = select_all_ext_attributes(cb, test);
+    if (rv != 0) {
+        log_error("Inventory cache warm-up failed");
+        clear();
+        return rv;
+    }
+
+    log_info("Inventory cache warmed up with %zu attributes of %zu assets", m_entries, m_assets.size());
+    return 0;
+}
+
+} // namespace fty
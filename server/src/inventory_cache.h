@@ -0,0 +1,87 @@
+/*  =========================================================================
+    inventory_cache - Dedup cache of the inventory server
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+namespace fty {
+
+/// Last values written by the inventory server, to skip writes of unchanged ext attributes.
+///
+/// Two levels: asset name -> table of (interned keytag id, read only flag) -> value hash.
+/// Dropping an asset is a single erase. When a limit is set, least recently used assets are
+/// evicted once the number of cached keytags exceeds it.
+class InventoryCache
+{
+public:
+    /// maxEntries = 0 means unbounded
+    explicit InventoryCache(size_t maxEntries = 0);
+
+    void setMaxEntries(size_t maxEntries);
+
+    /// true if the same value was already written for this asset keytag
+    bool contains(const std::string& asset, const std::string& keytag, bool readonly, const std::string& value);
+
+    void update(const std::string& asset, const std::string& keytag, bool readonly, const std::string& value);
+
+    void evict(const std::string& asset);
+
+    void clear();
+
+    /// load all ext attributes currently stored, returns 0 on success, -1 on database error
+    int warmUp(bool test);
+
+    size_t assets() const
+    {
+        return m_assets.size();
+    }
+
+    size_t entries() const
+    {
+        return m_entries;
+    }
+
+private:
+    using LruList = std::list<std::string>;
+
+    struct AssetEntry
+    {
+        // (keytag id << 1 | read only) -> value hash
+        std::unordered_map<uint32_t, uint64_t> values;
+        LruList::iterator                      lru;
+    };
+
+    uint32_t        keytagId(const std::string& keytag, bool readonly);
+    static uint64_t hash(const std::string& value);
+    void            shrink();
+
+    std::unordered_map<std::string, uint32_t>   m_keytags;
+    std::unordered_map<std::string, AssetEntry> m_assets;
+    LruList                                     m_lru;
+    size_t                                      m_entries = 0;
+    size_t                                      m_maxEntries;
+};
+
+} // namespace fty
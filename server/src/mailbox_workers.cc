@@ -0,0 +1,175 @@
+/*  =========================================================================
+    mailbox_workers - Worker pool of the legacy mailbox requests
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    mailbox_workers - Worker pool of the legacy mailbox requests
+@discuss
+@end
+*/
+
+#include "mailbox_workers.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fty_log.h>
+
+namespace fty {
+
+namespace {
+    // request handled on this thread
+    struct Current
+    {
+        zsock_t*           push;
+        const std::string* sender;
+    };
+
+    thread_local Current* t_current = nullptr;
+} // namespace
+
+MailboxWorkers::MailboxWorkers(size_t workers, size_t queueSize)
+    : m_queueSize(std::max<size_t>(queueSize, 1))
+{
+    m_endpoint = "inproc://mailbox-workers-" + std::to_string(reinterpret_cast<uintptr_t>(this));
+    m_replies  = zsock_new(ZMQ_PULL);
+    // replies are bounded by the queued requests, a worker must never block on them
+    zsock_set_rcvhwm(m_replies, 0);
+    zsock_bind(m_replies, "%s", m_endpoint.c_str());
+
+    for (size_t i = 0; i < std::max<size_t>(workers, 1); ++i) {
+        m_workers.emplace_back(new Worker);
+    }
+    for (auto& worker : m_workers) {
+        Worker& ref    = *worker;
+        worker->thread = std::thread([this, &ref]() {
+            run(ref);
+        });
+    }
+}
+
+MailboxWorkers::~MailboxWorkers()
+{
+    for (auto& worker : m_workers) {
+        std::lock_guard<std::mutex> lock(worker->lock);
+        m_stop = true;
+        worker->ready.notify_all();
+    }
+    for (auto& worker : m_workers) {
+        worker->thread.join();
+    }
+    zsock_destroy(&m_replies);
+}
+
+void MailboxWorkers::submit(const std::string& sender, zmsg_t** msg, Handler handler)
+{
+    Worker& worker = *m_workers[std::hash<std::string>{}(sender) % m_workers.size()];
+
+    std::unique_lock<std::mutex> lock(worker.lock);
+    worker.room.wait(lock, [&]() {
+        return worker.jobs.size() < m_queueSize;
+    });
+    worker.jobs.push_back(Job{sender, *msg, std::move(handler)});
+    *msg = nullptr;
+    worker.ready.notify_one();
+    ++m_inFlight[sender];
+}
+
+zmsg_t* MailboxWorkers::recv(std::string& sender, std::string& subject)
+{
+    zmsg_t* msg = zmsg_recv(m_replies);
+    if (!msg) {
+        return nullptr;
+    }
+    char* str = zmsg_popstr(msg);
+    sender    = str ? str : "";
+    zstr_free(&str);
+    str     = zmsg_popstr(msg);
+    subject = str ? str : "";
+    zstr_free(&str);
+
+    if (subject.empty()) {
+        // end of a request
+        auto found = m_inFlight.find(sender);
+        if (found != m_inFlight.end() && --found->second == 0) {
+            m_inFlight.erase(found);
+        }
+        zmsg_destroy(&msg);
+    }
+    return msg;
+}
+
+bool MailboxWorkers::onWorker()
+{
+    return t_current != nullptr;
+}
+
+int MailboxWorkers::reply(const char* subject, zmsg_t** reply)
+{
+    if (!t_current || !reply || !*reply) {
+        return -1;
+    }
+    zmsg_pushstr(*reply, subject);
+    zmsg_pushstr(*reply, t_current->sender->c_str());
+    return zmsg_send(reply, t_current->push);
+}
+
+void MailboxWorkers::run(Worker& worker)
+{
+    zsock_t* push = zsock_new(ZMQ_PUSH);
+    zsock_set_sndhwm(push, 0);
+    zsock_connect(push, "%s", m_endpoint.c_str());
+
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(worker.lock);
+            worker.ready.wait(lock, [&]() {
+                return m_stop || !worker.jobs.empty();
+            });
+            if (worker.jobs.empty()) {
+                break;
+            }
+            job = std::move(worker.jobs.front());
+            worker.jobs.pop_front();
+            worker.room.notify_one();
+        }
+
+        Current current{push, &job.sender};
+        t_current = &current;
+        try {
+            job.handler(job.msg);
+        } catch (const std::exception& e) {
+            log_error("Mailbox request of %s failed: %s", job.sender.c_str(), e.what());
+        }
+        t_current = nullptr;
+        zmsg_destroy(&job.msg);
+
+        // behind the reply on the same pipe
+        zmsg_t* done = zmsg_new();
+        zmsg_addstr(done, job.sender.c_str());
+        zmsg_addstr(done, "");
+        zmsg_send(&done, push);
+    }
+
+    zsock_destroy(&push);
+}
+
+} // namespace fty
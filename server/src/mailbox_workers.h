@@ -0,0 +1,116 @@
+/*  =========================================================================
+    mailbox_workers - Worker pool of the legacy mailbox requests
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <czmq.h>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace fty {
+
+/// Threads serving read-only legacy mailbox requests off the fty_asset_server actor.
+///
+/// A request goes to the worker picked by its sender, so the requests of one sender run one after the other and
+/// their replies leave in request order, while a slow request only delays the senders sharing its worker. Each
+/// worker queue is bounded, submit() blocks the actor while the queue of the sender is full.
+///
+/// Handlers reply with reply(), which queues the message with its sender on an inproc pipe. The actor polls
+/// replies() and sends them with its mlm client, which stays used by that one thread. Database connections come
+/// from tntdb::connectCached, which hands each busy worker a connection of its own.
+///
+/// The end of each request follows its reply on the pipe. Until then busy() reports the sender, so the actor can
+/// hold back the requests of that sender it serves itself and keep the order of all its replies. submit(), recv()
+/// and busy() are used from one thread.
+class MailboxWorkers
+{
+public:
+    /// handles one request, the message stays owned by the pool
+    using Handler = std::function<void(zmsg_t* msg)>;
+
+    MailboxWorkers(size_t workers = 4, size_t queueSize = 64);
+    /// finishes the queued requests, replies not read yet are dropped
+    ~MailboxWorkers();
+
+    MailboxWorkers(const MailboxWorkers&) = delete;
+    MailboxWorkers& operator=(const MailboxWorkers&) = delete;
+
+    /// queue the request of sender, takes ownership of msg
+    void submit(const std::string& sender, zmsg_t** msg, Handler handler);
+
+    /// socket to poll for replies
+    zsock_t* replies() const
+    {
+        return m_replies;
+    }
+
+    /// next reply with its recipient and subject, NULL on error or at the end of a request, which comes with
+    /// its sender and an empty subject
+    zmsg_t* recv(std::string& sender, std::string& subject);
+
+    /// true while requests of sender are queued or running, up to the recv() of their end
+    bool busy(const std::string& sender) const
+    {
+        return m_inFlight.count(sender) != 0;
+    }
+
+    /// true while a handler runs on the calling thread
+    static bool onWorker();
+
+    /// queue the reply of the request handled on the calling thread, takes ownership of reply
+    /// returns 0 on success, -1 outside of a handler or if the pipe refused it
+    static int reply(const char* subject, zmsg_t** reply);
+
+private:
+    struct Job
+    {
+        std::string sender;
+        zmsg_t*     msg = nullptr;
+        Handler     handler;
+    };
+
+    struct Worker
+    {
+        std::mutex              lock;
+        std::condition_variable ready;
+        std::condition_variable room;
+        std::deque<Job>         jobs;
+        std::thread             thread;
+    };
+
+    void run(Worker& worker);
+
+    std::string                             m_endpoint;
+    zsock_t*                                m_replies = nullptr;
+    size_t                                  m_queueSize;
+    bool                                    m_stop = false; // guarded by the lock of each worker
+    std::vector<std::unique_ptr<Worker>>    m_workers;
+    std::unordered_map<std::string, size_t> m_inFlight; // requests by sender, submit() and recv() side only
+};
+
+} // namespace fty
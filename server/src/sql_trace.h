@@ -0,0 +1,149 @@
+/*  =========================================================================
+    sql_trace - tntdb connection recording its statements in the SQL trace
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <fty_asset_sql_trace.h>
+#include <string>
+#include <tntdb.h>
+
+namespace fty {
+
+/// Statement recording its runs in the SQL trace of the thread.
+///
+/// A drop-in for tntdb::Statement: set() chains keep the tracing type, and a copy into a plain
+/// tntdb::Statement still works but is not traced. The text is only kept when a trace scope was open at
+/// prepare time.
+class TracedStatement : public tntdb::Statement
+{
+public:
+    TracedStatement() = default;
+
+    TracedStatement(const tntdb::Statement& statement, const std::string& sql)
+        : tntdb::Statement(statement)
+        , m_sql(sqltrace::Scope::tracing() ? sql : std::string())
+    {
+    }
+
+    template <typename T>
+    TracedStatement& set(const std::string& col, const T& data)
+    {
+        tntdb::Statement::set(col, data);
+        return *this;
+    }
+
+    TracedStatement& setNull(const std::string& col)
+    {
+        tntdb::Statement::setNull(col);
+        return *this;
+    }
+
+    auto execute()
+    {
+        sqltrace::Query query(m_sql);
+        auto            rows = tntdb::Statement::execute();
+        query.rows(rows);
+        return rows;
+    }
+
+    tntdb::Result select()
+    {
+        sqltrace::Query query(m_sql);
+        tntdb::Result   result = tntdb::Statement::select();
+        query.rows(result.size());
+        return result;
+    }
+
+    tntdb::Row selectRow()
+    {
+        sqltrace::Query query(m_sql);
+        tntdb::Row      row = tntdb::Statement::selectRow();
+        query.rows(1);
+        return row;
+    }
+
+    tntdb::Value selectValue()
+    {
+        sqltrace::Query query(m_sql);
+        tntdb::Value    value = tntdb::Statement::selectValue();
+        query.rows(1);
+        return value;
+    }
+
+private:
+    std::string m_sql;
+};
+
+/// Connection handing out TracedStatement, passes anywhere a tntdb::Connection is expected
+class TracedConnection : public tntdb::Connection
+{
+public:
+    TracedConnection() = default;
+
+    TracedConnection(const tntdb::Connection& conn)
+        : tntdb::Connection(conn)
+    {
+    }
+
+    TracedStatement prepare(const std::string& sql)
+    {
+        return TracedStatement(tntdb::Connection::prepare(sql), sql);
+    }
+
+    TracedStatement prepareCached(const std::string& sql)
+    {
+        return TracedStatement(tntdb::Connection::prepareCached(sql), sql);
+    }
+
+    auto execute(const std::string& sql)
+    {
+        sqltrace::Query query(sql);
+        auto            rows = tntdb::Connection::execute(sql);
+        query.rows(rows);
+        return rows;
+    }
+
+    tntdb::Result select(const std::string& sql)
+    {
+        sqltrace::Query query(sql);
+        tntdb::Result   result = tntdb::Connection::select(sql);
+        query.rows(result.size());
+        return result;
+    }
+
+    tntdb::Row selectRow(const std::string& sql)
+    {
+        sqltrace::Query query(sql);
+        tntdb::Row      row = tntdb::Connection::selectRow(sql);
+        query.rows(1);
+        return row;
+    }
+
+    tntdb::Value selectValue(const std::string& sql)
+    {
+        sqltrace::Query query(sql);
+        tntdb::Value    value = tntdb::Connection::selectValue(sql);
+        query.rows(1);
+        return value;
+    }
+};
+
+} // namespace fty
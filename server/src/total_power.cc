@@ -29,6 +29,7 @@
 #include "total_power.h"
 
 #include "asset/dbhelpers.h"
+#include "containment_index.h"
 #include <tntdb/connect.h>
 #include <tntdb/result.h>
 #include <tntdb/error.h>
@@ -317,31 +318,19 @@ static int
 {
     // at the beginning clear
     powerDevices.clear();
-    // select all devices in the container
+    // select all devices in the container, from the containment index
     std::map <uint32_t, ShortAssetInfo> container_devices{};
-    std::function<void(const tntdb::Row&)> func = \
-                [&container_devices](const tntdb::Row& row)
-                {
-                    uint16_t type_id = 0;
-                    row["type_id"].get(type_id);
-
-                    if ( type_id == persist::asset_type::DEVICE ) {
-                        std::string device_name = "";
-                        row["name"].get(device_name);
-
-                        uint32_t asset_id = 0;
-                        row["asset_id"].get(asset_id);
-
-                        uint16_t subtype_id = 0;
-                        row["subtype_id"].get(subtype_id);
-
-                        container_devices.emplace (asset_id,
-                                ShortAssetInfo(asset_id, device_name,
-                                    subtype_id));
-                    }
-                };
-
-    auto rv = DBAssets::select_assets_by_container (conn, assetId, func);
+    std::vector <fty::ContainmentIndex::Node> nodes;
+    auto rv = fty::ContainmentIndex::instance ().nodesIn (assetId, nodes, false);
+    // unknown asset, like the database query it simply has no devices
+    if ( rv == -2 )
+        rv = 0;
+    for ( const auto &node : nodes ) {
+        if ( node.type == persist::asset_type::DEVICE ) {
+            container_devices.emplace (node.id,
+                    ShortAssetInfo (node.id, node.name, node.subtype));
+        }
+    }
 
     // here would be placed names of devices to summ up
     if ( rv != 0 ) {
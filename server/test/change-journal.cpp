@@ -0,0 +1,169 @@
+#include "change_journal.h"
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+// journal with its state file in a temporary directory, removed when the test ends
+struct Journal
+{
+    Journal(size_t maxEntries, const std::string& state = "")
+    {
+        std::string tmpl = (std::filesystem::temp_directory_path() / "fty-asset-journal-XXXXXX").string();
+        dir              = mkdtemp(tmpl.data());
+        path             = dir + "/change-seq";
+        if (!state.empty()) {
+            std::ofstream(path) << state << std::endl;
+        }
+        fty::ChangeJournal::instance().setup(path, maxEntries);
+    }
+
+    ~Journal()
+    {
+        std::filesystem::remove_all(dir);
+    }
+
+    uint64_t stored() const
+    {
+        uint64_t      mark = 0;
+        std::ifstream in(path);
+        in >> mark;
+        return mark;
+    }
+
+    // reads the state file again, as after a restart
+    void restart(size_t maxEntries) const
+    {
+        fty::ChangeJournal::instance().setup(path, maxEntries);
+    }
+
+    std::string dir;
+    std::string path;
+};
+
+struct Changes
+{
+    bool                  ok      = false;
+    uint64_t              current = 0;
+    std::set<std::string> changed;
+    std::set<std::string> deleted;
+};
+
+static Changes changesSince(uint64_t since)
+{
+    Changes changes;
+    changes.ok = fty::ChangeJournal::instance().changesSince(since, changes.current, changes.changed, changes.deleted);
+    return changes;
+}
+
+TEST_CASE("Change journal / Sequence survives restarts")
+{
+    Journal journal(10, "41");
+    auto&   changes = fty::ChangeJournal::instance();
+
+    CHECK(changes.sequence() == 41);
+    CHECK(changes.record("ups-1", false) == 42);
+    CHECK(changes.record("ups-2", false) == 43);
+    // a block is reserved ahead, not written per change
+    CHECK(journal.stored() == 1041);
+
+    journal.restart(10);
+    CHECK(changes.sequence() == 1041);
+    CHECK(changes.record("ups-1", false) == 1042);
+    CHECK(journal.stored() == 2041);
+
+    // nothing is known before the restart
+    CHECK(!changesSince(43).ok);
+    auto after = changesSince(1041);
+    REQUIRE(after.ok);
+    CHECK(after.changed == std::set<std::string>{"ups-1"});
+}
+
+TEST_CASE("Change journal / Unreadable state starts from the clock")
+{
+    Journal journal(10, "garbage");
+    auto&   changes = fty::ChangeJournal::instance();
+
+    uint64_t start = changes.sequence();
+    CHECK(start > 1000000000000000ull);
+    CHECK(changes.record("ups-1", false) == start + 1);
+    CHECK(journal.stored() == start + 1000);
+}
+
+TEST_CASE("Change journal / Last state of each asset wins")
+{
+    Journal journal(10, "0");
+    auto&   changes = fty::ChangeJournal::instance();
+
+    changes.record("ups-1", false);
+    changes.record("epdu-2", false);
+    uint64_t middle = changes.record("feed-3", false);
+    changes.record("ups-1", true);
+    changes.record("epdu-2", false);
+    changes.record("rack-4", true);
+    changes.record("rack-4", false);
+
+    auto all = changesSince(0);
+    REQUIRE(all.ok);
+    CHECK(all.current == changes.sequence());
+    CHECK(all.changed == std::set<std::string>{"epdu-2", "feed-3", "rack-4"});
+    CHECK(all.deleted == std::set<std::string>{"ups-1"});
+
+    auto tail = changesSince(middle);
+    REQUIRE(tail.ok);
+    CHECK(tail.changed == std::set<std::string>{"epdu-2", "rack-4"});
+    CHECK(tail.deleted == std::set<std::string>{"ups-1"});
+
+    auto none = changesSince(changes.sequence());
+    REQUIRE(none.ok);
+    CHECK(none.changed.empty());
+    CHECK(none.deleted.empty());
+
+    // ahead of the journal, e.g. a client of another agent instance
+    CHECK(!changesSince(changes.sequence() + 1).ok);
+}
+
+TEST_CASE("Change journal / Repeated changes of one asset take one entry")
+{
+    Journal journal(2, "0");
+    auto&   changes = fty::ChangeJournal::instance();
+
+    changes.record("ups-1", false);
+    changes.record("ups-1", false);
+    changes.record("ups-1", false);
+    uint64_t last = changes.record("ups-1", false);
+    CHECK(last == 4);
+
+    // still in the journal of two entries
+    auto all = changesSince(0);
+    REQUIRE(all.ok);
+    CHECK(all.changed == std::set<std::string>{"ups-1"});
+
+    CHECK(changesSince(3).changed == std::set<std::string>{"ups-1"});
+    CHECK(changesSince(last).changed.empty());
+}
+
+TEST_CASE("Change journal / Evicted changes require a resync")
+{
+    Journal journal(3, "0");
+    auto&   changes = fty::ChangeJournal::instance();
+
+    changes.record("asset-1", false);
+    uint64_t second = changes.record("asset-2", false);
+    changes.record("asset-3", false);
+    REQUIRE(changesSince(0).ok);
+
+    changes.record("asset-4", true);
+    changes.record("asset-5", false);
+
+    // asset-1 and asset-2 were evicted, a client behind them misses changes
+    auto behind = changesSince(0);
+    CHECK(!behind.ok);
+    CHECK(behind.current == 5);
+    CHECK(!changesSince(second - 1).ok);
+
+    auto kept = changesSince(second);
+    REQUIRE(kept.ok);
+    CHECK(kept.changed == std::set<std::string>{"asset-3", "asset-5"});
+    CHECK(kept.deleted == std::set<std::string>{"asset-4"});
+}
@@ -0,0 +1,296 @@
+#include "containment_index.h"
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <fty_common_asset_types.h>
+#include <fty_common_db_asset.h>
+#include <fty_common_db_dbpath.h>
+#include <test-db/sample-db.h>
+#include <tntdb.h>
+
+// Former container queries, kept as the reference for the index
+
+static std::vector<std::string> legacyAssetsIn(const std::string& container, const std::set<std::string>& filter)
+{
+    tntdb::Connection        conn = tntdb::connect(DBConn::url);
+    std::vector<std::string> assets;
+    REQUIRE(DBAssets::select_assets_by_container_name_filter(conn, container, filter, assets) == 0);
+    std::sort(assets.begin(), assets.end());
+    return assets;
+}
+
+static std::vector<std::string> legacyNodesIn(uint32_t container)
+{
+    tntdb::Connection        conn = tntdb::connect(DBConn::url);
+    std::vector<std::string> names;
+
+    std::function<void(const tntdb::Row&)> cb = [&names](const tntdb::Row& row) {
+        names.push_back(row.getString("name"));
+    };
+    REQUIRE(DBAssets::select_assets_by_container(conn, container, cb) == 0);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+// one parent after the other, direct parent first
+static std::vector<std::string> legacyParents(uint32_t id)
+{
+    tntdb::Connection        conn = tntdb::connect(DBConn::url);
+    std::vector<std::string> names;
+
+    auto st = conn.prepare(
+        "SELECT p.id_asset_element AS id, p.name AS name FROM t_bios_asset_element AS a"
+        " INNER JOIN t_bios_asset_element AS p ON a.id_parent = p.id_asset_element"
+        " WHERE a.id_asset_element = :id");
+
+    while (true) {
+        auto res = st.set("id", id).select();
+        if (res.empty()) {
+            break;
+        }
+        names.push_back(res.getRow(0).getString("name"));
+        id = res.getRow(0).getUnsigned32("id");
+    }
+    return names;
+}
+
+static std::vector<std::string> assetsIn(const std::string& container, const std::set<std::string>& filter = {})
+{
+    std::vector<std::string> assets;
+    REQUIRE(fty::ContainmentIndex::instance().assetsIn(container, filter, assets, false) == 0);
+    std::sort(assets.begin(), assets.end());
+    return assets;
+}
+
+static std::vector<std::string> nodesIn(uint32_t container)
+{
+    std::vector<fty::ContainmentIndex::Node> nodes;
+    REQUIRE(fty::ContainmentIndex::instance().nodesIn(container, nodes, false) == 0);
+
+    std::vector<std::string> names;
+    for (const auto& node : nodes) {
+        names.push_back(node.name);
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+// status of asset as seen below container, empty if it is not there
+static std::string status(const std::string& container, const std::string& name)
+{
+    std::vector<fty::ContainmentIndex::Node> nodes;
+    REQUIRE(fty::ContainmentIndex::instance().nodesIn(container, nodes, false) == 0);
+
+    auto node = std::find_if(nodes.begin(), nodes.end(), [&name](const fty::ContainmentIndex::Node& n) {
+        return n.name == name;
+    });
+    return node == nodes.end() ? std::string() : node->status;
+}
+
+static std::vector<std::string> parents(const std::string& name, uint32_t* parentId = nullptr)
+{
+    uint32_t                 id = 0;
+    std::vector<std::string> names;
+    REQUIRE(fty::ContainmentIndex::instance().parents(name, id, names, false));
+    if (parentId) {
+        *parentId = id;
+    }
+    return names;
+}
+
+static const char* sample = R"(
+    items:
+        - type : Datacenter
+          name : datacenter-1
+          items :
+              - type : Room
+                name : room-1
+                items :
+                    - type : Row
+                      name : row-1
+                      items :
+                          - type : Rack
+                            name : rack-1
+                            items :
+                                - type : Ups
+                                  name : ups-1
+                                - type : Epdu
+                                  name : epdu-1
+                                - type : Server
+                                  name : server-1
+              - type : Rack
+                name : rack-2
+                items :
+                    - type : Epdu
+                      name : epdu-2
+        - type : Datacenter
+          name : datacenter-2
+          items :
+              - type : Feed
+                name : feed-1
+)";
+
+TEST_CASE("Containment index / Containers answer like the former queries")
+{
+    fty::SampleDb db(sample);
+    auto&         index = fty::ContainmentIndex::instance();
+    index.invalidate();
+
+    const std::vector<std::set<std::string>> filters = {
+        {},
+        {"device"},
+        {"rack"},
+        {"ups", "epdu"},
+        {"row", "server"},
+        {"sts"},
+    };
+
+    for (const char* container : {"datacenter-1", "room-1", "row-1", "rack-1", "rack-2", "datacenter-2", "ups-1"}) {
+        for (const auto& filter : filters) {
+            INFO(container << " filtered by " << filter.size() << " names");
+            CHECK(assetsIn(container, filter) == legacyAssetsIn(container, filter));
+        }
+        CHECK(nodesIn(db.idByName(container)) == legacyNodesIn(db.idByName(container)));
+    }
+
+    CHECK(assetsIn("room-1", {"ups", "epdu"}) == std::vector<std::string>{"epdu-1", "ups-1"});
+
+    CHECK(index.contains(db.idByName("datacenter-1"), db.idByName("ups-1"), false));
+    CHECK(index.contains(db.idByName("room-1"), db.idByName("rack-1"), false));
+    CHECK(!index.contains(db.idByName("rack-2"), db.idByName("ups-1"), false));
+    CHECK(!index.contains(db.idByName("datacenter-2"), db.idByName("ups-1"), false));
+    // not inside itself
+    CHECK(!index.contains(db.idByName("rack-1"), db.idByName("rack-1"), false));
+
+    std::vector<std::string> none;
+    CHECK(index.assetsIn("no-such-asset", {}, none, false) == -2);
+    CHECK(none.empty());
+
+    std::vector<fty::ContainmentIndex::Node> nodes;
+    CHECK(index.nodesIn("no-such-asset", nodes, false) == -2);
+    CHECK(nodes.empty());
+
+    // test mode never reads the database
+    CHECK(index.assetsIn("rack-1", {}, none, true) == -1);
+}
+
+TEST_CASE("Containment index / Parent chains")
+{
+    fty::SampleDb db(sample);
+    auto&         index = fty::ContainmentIndex::instance();
+    index.invalidate();
+
+    for (const char* name : {"ups-1", "server-1", "rack-1", "epdu-2", "feed-1", "datacenter-1"}) {
+        INFO(name);
+        CHECK(parents(name) == legacyParents(db.idByName(name)));
+    }
+
+    uint32_t parentId = 0;
+    CHECK(parents("ups-1", &parentId) == std::vector<std::string>{"rack-1", "row-1", "room-1", "datacenter-1"});
+    CHECK(parentId == db.idByName("rack-1"));
+
+    CHECK(parents("datacenter-1", &parentId).empty());
+    CHECK(parentId == 0);
+
+    uint32_t                 id = 0;
+    std::vector<std::string> names;
+    CHECK(!index.parents("no-such-asset", id, names, false));
+    CHECK(!index.parents("ups-1", id, names, true));
+}
+
+TEST_CASE("Containment index / Updates and removals")
+{
+    fty::SampleDb db(sample);
+    auto&         index = fty::ContainmentIndex::instance();
+    index.invalidate();
+
+    // loads the index
+    REQUIRE(assetsIn("rack-2") == std::vector<std::string>{"epdu-2"});
+
+    SECTION("moved asset")
+    {
+        REQUIRE(index.update("update", "rack-1", db.idByName("datacenter-2"), "", "", ""));
+
+        CHECK(parents("ups-1") == std::vector<std::string>{"rack-1", "datacenter-2"});
+        CHECK(assetsIn("datacenter-2", {"device"}) ==
+              std::vector<std::string>{"epdu-1", "feed-1", "server-1", "ups-1"});
+        CHECK(assetsIn("room-1") == std::vector<std::string>{"epdu-2", "rack-2", "row-1"});
+        CHECK(index.contains(db.idByName("datacenter-2"), db.idByName("server-1"), false));
+        CHECK(!index.contains(db.idByName("datacenter-1"), db.idByName("server-1"), false));
+
+        // changed type only, the tree stays
+        REQUIRE(index.update("update", "server-1", db.idByName("rack-1"), "device", "pdu", ""));
+        CHECK(assetsIn("rack-1", {"pdu"}) == std::vector<std::string>{"server-1"});
+        CHECK(assetsIn("rack-1", {"server"}).empty());
+    }
+
+    SECTION("removed assets")
+    {
+        REQUIRE(index.update("delete", "epdu-2", 0, "", "", ""));
+        CHECK(assetsIn("rack-2").empty());
+        CHECK(assetsIn("datacenter-1", {"epdu"}) == std::vector<std::string>{"epdu-1"});
+
+        uint32_t                 id = 0;
+        std::vector<std::string> names;
+        CHECK(!index.parents("epdu-2", id, names, false));
+
+        // children of a removed container become roots until the next reload
+        REQUIRE(index.update("delete", "row-1", 0, "", "", ""));
+        CHECK(assetsIn("room-1") == std::vector<std::string>{"rack-2"});
+        CHECK(parents("ups-1") == std::vector<std::string>{"rack-1"});
+        CHECK(!index.contains(db.idByName("datacenter-1"), db.idByName("ups-1"), false));
+
+        // deleting an unknown asset is a no-op
+        CHECK(index.update("delete", "no-such-asset", 0, "", "", ""));
+    }
+
+    SECTION("added asset")
+    {
+        index.add(999999, "ups-new", db.idByName("rack-2"), "device", "ups", "nonactive");
+        CHECK(assetsIn("rack-2", {"ups"}) == std::vector<std::string>{"ups-new"});
+        CHECK(parents("ups-new") == std::vector<std::string>{"rack-2", "room-1", "datacenter-1"});
+        CHECK(index.contains(db.idByName("datacenter-1"), 999999, false));
+        CHECK(status("datacenter-1", "ups-new") == "nonactive");
+    }
+
+    SECTION("changed status")
+    {
+        REQUIRE(status("rack-1", "ups-1") == "active");
+        REQUIRE(index.update("update", "ups-1", db.idByName("rack-1"), "", "", "nonactive"));
+        CHECK(status("rack-1", "ups-1") == "nonactive");
+        CHECK(status("datacenter-1", "ups-1") == "nonactive");
+
+        // no status in the message, the former one stays
+        REQUIRE(index.update("update", "ups-1", db.idByName("rack-1"), "", "", ""));
+        CHECK(status("rack-1", "ups-1") == "nonactive");
+    }
+
+    SECTION("unknown assets reload the index from database")
+    {
+        REQUIRE(index.update("update", "rack-2", db.idByName("datacenter-2"), "", "", ""));
+        CHECK(parents("epdu-2") == std::vector<std::string>{"rack-2", "datacenter-2"});
+
+        // its id is not part of the message, the database has the truth
+        CHECK(!index.update("create", "not-loaded", db.idByName("rack-2"), "device", "ups", ""));
+        CHECK(parents("epdu-2") == std::vector<std::string>{"rack-2", "room-1", "datacenter-1"});
+
+        // so has a parent the index does not know
+        CHECK(!index.update("update", "ups-1", 999999, "", "", ""));
+        CHECK(parents("ups-1") == legacyParents(db.idByName("ups-1")));
+    }
+
+    SECTION("parent cycle")
+    {
+        // rack-1 below its own ups, only possible through a broken stream
+        REQUIRE(index.update("update", "rack-1", db.idByName("ups-1"), "", "", ""));
+
+        // the walk stops, whatever it went through
+        auto chain = parents("ups-1");
+        REQUIRE(!chain.empty());
+        CHECK(chain.front() == "rack-1");
+        CHECK(!index.contains(db.idByName("datacenter-1"), db.idByName("ups-1"), false));
+        CHECK(!index.contains(db.idByName("rack-1"), db.idByName("ups-1"), false));
+        CHECK(assetsIn("row-1").empty());
+    }
+
+    index.invalidate();
+}
@@ -0,0 +1,127 @@
+#include "asset/asset-db.h"
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <fty_common_asset_types.h>
+#include <fty_common_db_dbpath.h>
+#include <sstream>
+#include <test-db/sample-db.h>
+#include <tntdb.h>
+
+using Filters = std::map<std::string, std::vector<std::string>>;
+
+// Former LIST query, values written into the SQL text, kept as the reference for the compiled plan
+static std::vector<std::string> legacyList(const Filters& filters)
+{
+    std::stringstream qs;
+    qs << " SELECT name AS name FROM t_bios_asset_element ";
+
+    const char* glue = " WHERE ";
+    for (const auto& filter : filters) {
+        qs << glue << " ( ";
+        for (auto it = filter.second.begin(); it != filter.second.end(); ++it) {
+            // callers quoted the status values themselves
+            const std::string value = filter.first == "status" ? "'" + *it + "'" : *it;
+            qs << (it == filter.second.begin() ? "" : " OR ") << filter.first << " = " << value << " ";
+        }
+        qs << " ) ";
+        glue = " AND ";
+    }
+
+    tntdb::Connection        conn = tntdb::connect(DBConn::url);
+    std::vector<std::string> names;
+    for (const auto& row : conn.prepare(qs.str()).select()) {
+        std::string name = row.getString("name");
+        if (name != "rackcontroller-0") {
+            names.push_back(name);
+        }
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+static std::vector<std::string> list(const Filters& filters)
+{
+    auto names = fty::DB::getInstance().listAssets(filters);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+TEST_CASE("List / Compiled filters answer like the former query")
+{
+    fty::SampleDb db(R"(
+        items:
+          - type     : Datacenter
+            name     : datacenter
+            ext-name : Washington DC
+            items:
+              - type : Feed
+                name : feed
+              - type : Rack
+                name : rack-1
+                items:
+                  - type : Ups
+                    name : ups-1
+                  - type : Epdu
+                    name : epdu-1
+                  - type : Server
+                    name : server-1
+              - type : Rack
+                name : rack-2
+                items:
+                  - type : Ups
+                    name : ups-2
+                  - type : Epdu
+                    name : epdu-2
+    )");
+
+    {
+        tntdb::Connection conn = tntdb::connect(DBConn::url);
+        conn.prepare("UPDATE t_bios_asset_element SET status = 'nonactive', priority = 3 WHERE id_asset_element IN "
+                     "(:ups, :epdu)")
+            .set("ups", db.idByName("ups-2"))
+            .set("epdu", db.idByName("epdu-1"))
+            .execute();
+    }
+
+    const std::string device = std::to_string(persist::type_to_typeid("device"));
+    const std::string rack   = std::to_string(persist::type_to_typeid("rack"));
+    const std::string ups    = std::to_string(persist::subtype_to_subtypeid("ups"));
+    const std::string epdu   = std::to_string(persist::subtype_to_subtypeid("epdu"));
+    const std::string rack1  = std::to_string(db.idByName("rack-1"));
+    const std::string rack2  = std::to_string(db.idByName("rack-2"));
+    const std::string dc     = std::to_string(db.idByName("datacenter"));
+
+    std::vector<Filters> filters = {
+        {{"status", {"nonactive"}}},
+        {{"id_type", {rack}}},
+        {{"id_type", {device, rack}}},
+        {{"id_subtype", {ups, epdu}}, {"status", {"active"}}},
+        {{"id_parent", {rack1}}},
+        {{"id_parent", {rack1, rack2, dc}}, {"id_type", {device}}},
+        {{"id_parent", {rack2}}, {"id_subtype", {epdu}}, {"status", {"active", "nonactive"}}},
+        {{"priority", {"3"}}},
+        {{"priority", {"1"}}, {"id_parent", {rack1}}},
+        // no match
+        {{"id_parent", {dc}}, {"id_subtype", {ups}}},
+    };
+
+    for (int64_t ttl : {0, 60000}) {
+        // SQL, then the in-memory index for all but priority
+        fty::DB::setListIndexTtl(ttl);
+
+        for (const auto& filter : filters) {
+            auto expected = legacyList(filter);
+            INFO("index ttl " << ttl << ", " << fty::AssetFilterPlan::compile(filter).shape());
+            CHECK(list(filter) == expected);
+        }
+    }
+    CHECK(list({{"id_parent", {rack1}}}) == std::vector<std::string>{"epdu-1", "server-1", "ups-1"});
+
+    fty::DB::setListIndexTtl(0);
+}
+
+TEST_CASE("List / Invalid filters are rejected")
+{
+    CHECK_THROWS_AS(list({{"name", {"ups-1"}}}), std::runtime_error);
+    CHECK_THROWS_AS(list({{"id_type", {"1 OR 1=1"}}}), std::runtime_error);
+}
@@ -0,0 +1,35 @@
+#define CATCH_CONFIG_RUNNER
+
+#include "test-db/test-db.h"
+#include <catch2/catch.hpp>
+#include <fty_common_db_dbpath.h>
+#include <fty_log.h>
+#include <iostream>
+
+int main(int argc, char* argv[])
+{
+    Catch::Session session;
+
+    int returnCode = session.applyCommandLine(argc, argv);
+    if (returnCode != 0) {
+        return returnCode;
+    }
+
+    Catch::ConfigData data = session.configData();
+    if (data.listReporters || data.listTestNamesOnly) {
+        return session.run();
+    }
+
+    ManageFtyLog::setInstanceFtylog("server-db-test", TEST_LOGGER_CONF);
+
+    if (auto ret = fty::TestDb::init(); !ret) {
+        std::cerr << "cannot start test database: " << ret.error() << std::endl;
+        return 1;
+    }
+    // the server reads its url once at startup
+    DBConn::url = getenv("DBURL");
+
+    int result = session.run(argc, argv);
+    fty::TestDb::destroy();
+    return result;
+}
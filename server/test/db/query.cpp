@@ -0,0 +1,134 @@
+#include "asset/asset-db.h"
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <fty_common_db_dbpath.h>
+#include <test-db/sample-db.h>
+#include <tntdb.h>
+
+using Op = fty::QueryPredicate::Op;
+
+static std::vector<std::string> query(const fty::AssetQuery& q)
+{
+    auto names = fty::DB::getInstance().queryAssets(q);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+static fty::QueryPredicate predicate(const std::string& field, Op op, const std::vector<std::string>& values = {})
+{
+    fty::QueryPredicate predicate;
+    predicate.field  = field;
+    predicate.op     = op;
+    predicate.values = values;
+    return predicate;
+}
+
+static void execute(const std::string& sql, uint32_t id)
+{
+    tntdb::Connection conn = tntdb::connect(DBConn::url);
+    conn.prepare(sql).set("id", id).execute();
+}
+
+TEST_CASE("Query / Database rows map to columns")
+{
+    fty::SampleDb db(R"(
+        items:
+            - type     : Datacenter
+              name     : datacenter
+              ext-name : Washington DC
+              items :
+                  - type  : Rack
+                    name  : rack-1
+                    attrs :
+                        u_size : "42"
+                    items :
+                        - type  : Ups
+                          name  : ups-1
+                          attrs :
+                              model : "9PX 6kVA"
+                        - type  : Epdu
+                          name  : epdu-1
+                          attrs :
+                              model : "EPDU G3"
+                  - type  : Rack
+                    name  : rack-2
+                    items :
+                        - type  : Server
+                          name  : server-1
+    )");
+
+    // full reload on every query, whatever the other tests left in the columns
+    fty::DB::setQueryTtl(0);
+
+    CHECK(query({predicate("type", Op::Equal, {"rack"})}) == std::vector<std::string>{"rack-1", "rack-2"});
+    CHECK(query({predicate("subtype", Op::In, {"ups", "epdu"})}) == std::vector<std::string>{"epdu-1", "ups-1"});
+    CHECK(query({predicate("parent", Op::Equal, {"rack-1"})}) == std::vector<std::string>{"epdu-1", "ups-1"});
+    CHECK(query({predicate("parent", Op::Equal, {"datacenter"}), predicate("status", Op::Equal, {"active"})}) ==
+          std::vector<std::string>{"rack-1", "rack-2"});
+    CHECK(query({predicate("name", Op::Equal, {"server-1"}), predicate("priority", Op::Equal, {"1"})}) ==
+          std::vector<std::string>{"server-1"});
+    // ext attributes are prefixed, the ext name is the "name" attribute
+    CHECK(query({predicate("ext.name", Op::Equal, {"Washington DC"})}) == std::vector<std::string>{"datacenter"});
+    CHECK(query({predicate("ext.model", Op::Prefix, {"9PX"})}) == std::vector<std::string>{"ups-1"});
+    CHECK(query({predicate("ext.u_size", Op::Exists), predicate("type", Op::Equal, {"rack"})}) ==
+          std::vector<std::string>{"rack-1"});
+    // a root has no parent column
+    CHECK(query({predicate("parent", Op::Exists), predicate("name", Op::Equal, {"datacenter"})}).empty());
+}
+
+TEST_CASE("Query / Changed assets are reloaded")
+{
+    fty::SampleDb db(R"(
+        items:
+            - type     : Datacenter
+              name     : datacenter
+              items :
+                  - type  : Rack
+                    name  : rack-1
+                    items :
+                        - type  : Ups
+                          name  : ups-1
+                          attrs :
+                              model : "9PX 6kVA"
+                  - type  : Rack
+                    name  : rack-2
+                    items :
+                        - type  : Epdu
+                          name  : epdu-1
+    )");
+
+    fty::DB::setQueryTtl(0);
+    REQUIRE(query({predicate("parent", Op::Equal, {"rack-1"})}) == std::vector<std::string>{"ups-1"});
+
+    // from now on only the assets reported as changed are read again
+    fty::DB::setQueryTtl(-1);
+
+    execute("UPDATE t_bios_asset_element SET id_parent = (SELECT id_asset_element FROM (SELECT id_asset_element "
+            "FROM t_bios_asset_element WHERE name = 'rack-2') AS r), status = 'nonactive' "
+            "WHERE id_asset_element = :id",
+        db.idByName("ups-1"));
+    execute("DELETE FROM t_bios_asset_ext_attributes WHERE id_asset_element = :id", db.idByName("ups-1"));
+
+    // not reported yet, the columns keep the former state
+    CHECK(query({predicate("parent", Op::Equal, {"rack-1"})}) == std::vector<std::string>{"ups-1"});
+
+    fty::DB::assetChanged("ups-1");
+    CHECK(query({predicate("parent", Op::Equal, {"rack-1"})}).empty());
+    CHECK(query({predicate("parent", Op::Equal, {"rack-2"})}) == std::vector<std::string>{"epdu-1", "ups-1"});
+    CHECK(query({predicate("status", Op::Equal, {"nonactive"})}) == std::vector<std::string>{"ups-1"});
+    CHECK(query({predicate("ext.model", Op::Exists)}).empty());
+
+    // deleted assets are not loaded again
+    execute("DELETE FROM t_bios_asset_element WHERE id_asset_element = :id", db.idByName("epdu-1"));
+    fty::DB::assetChanged("epdu-1");
+    CHECK(query({predicate("parent", Op::Equal, {"rack-2"})}) == std::vector<std::string>{"ups-1"});
+    CHECK(query({predicate("name", Op::Equal, {"epdu-1"})}).empty());
+
+    // as reported by the stream for the writes of other processes
+    execute("DELETE FROM t_bios_asset_element WHERE id_asset_element = :id", db.idByName("ups-1"));
+    CHECK(query({predicate("parent", Op::Equal, {"rack-2"})}) == std::vector<std::string>{"ups-1"});
+    fty::DB::assetDeleted("ups-1");
+    CHECK(query({predicate("parent", Op::Equal, {"rack-2"})}).empty());
+
+    fty::DB::setQueryTtl(0);
+}
@@ -0,0 +1,67 @@
+#include "asset-server.h"
+#include "asset/asset.h"
+#include <catch2/catch.hpp>
+#include <cxxtools/serializationinfo.h>
+#include <fty_asset_fake_activator.h>
+#include <fty_common_db_dbpath.h>
+#include <test-db/sample-db.h>
+#include <tntdb.h>
+
+// status of the asset in database, empty if it does not exist
+static std::string status(const std::string& name)
+{
+    tntdb::Connection conn = tntdb::connect(DBConn::url);
+
+    auto res = conn.prepare("SELECT status FROM t_bios_asset_element WHERE name = :name").set("name", name).select();
+    return res.empty() ? std::string() : res.getRow(0).getString("status");
+}
+
+TEST_CASE("SRR / Restore over the licensing limit")
+{
+    cxxtools::SerializationInfo si;
+    {
+        fty::SampleDb db(R"(
+            items:
+                - type : Datacenter
+                  name : datacenter-1
+                  items :
+                      - type : Ups
+                        name : ups-1
+                      - type : Ups
+                        name : ups-2
+                      - type : Ups
+                        name : ups-3
+        )");
+        si = fty::AssetServer().saveAssets();
+    }
+    REQUIRE(status("ups-1").empty());
+
+    // room for one more active device only
+    fty::activation::FakeActivator fake(1);
+    fty::activation::setTransport(fake.transport());
+
+    SECTION("without activation attempt, refused assets are not restored")
+    {
+        fty::AssetServer().restoreAssets(si, false);
+
+        CHECK(status("datacenter-1") == "active");
+        CHECK(status("ups-1") == "active");
+        CHECK(status("ups-2").empty());
+        CHECK(status("ups-3").empty());
+    }
+
+    SECTION("with activation attempt, refused assets are restored as nonactive")
+    {
+        fty::AssetServer().restoreAssets(si, true);
+
+        CHECK(status("ups-1") == "active");
+        CHECK(status("ups-2") == "nonactive");
+        CHECK(status("ups-3") == "nonactive");
+        CHECK(fake.active() == 1);
+    }
+
+    // deactivation goes through the fake as well
+    fty::AssetImpl::deleteList({"datacenter-1"}, true, true, true);
+    CHECK(status("datacenter-1").empty());
+    fty::activation::setTransport({});
+}
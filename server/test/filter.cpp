@@ -0,0 +1,160 @@
+#include "asset/asset-filter.h"
+#include <algorithm>
+#include <catch2/catch.hpp>
+
+using Filters = fty::AssetFilterPlan::Filters;
+
+// Former LIST semantics, values of one key OR-ed and keys AND-ed, kept as the reference for the index
+static std::vector<std::string> reference(const std::vector<fty::AssetIndex::Row>& rows, const Filters& filters)
+{
+    auto column = [](const fty::AssetIndex::Row& row, const std::string& key) {
+        if (key == "status") {
+            return row.status;
+        } else if (key == "id_type") {
+            return std::to_string(row.type);
+        } else if (key == "id_subtype") {
+            return std::to_string(row.subtype);
+        }
+        // NULL parent never matches
+        return row.parent ? std::to_string(row.parent) : std::string();
+    };
+
+    std::vector<std::string> names;
+    for (const auto& row : rows) {
+        bool match = true;
+        for (const auto& filter : filters) {
+            if (filter.second.empty()) {
+                continue;
+            }
+            const std::string value = column(row, filter.first);
+            match = match && std::find(filter.second.begin(), filter.second.end(), value) != filter.second.end();
+        }
+        if (match) {
+            names.push_back(row.name);
+        }
+    }
+    return names;
+}
+
+static std::vector<fty::AssetIndex::Row> sampleRows()
+{
+    static const char* statuses[] = {"active", "nonactive"};
+
+    std::vector<fty::AssetIndex::Row> rows;
+    for (uint32_t i = 0; i < 200; ++i) {
+        fty::AssetIndex::Row row;
+        row.name    = "asset-" + std::to_string(i);
+        row.status  = statuses[i % 7 == 0];
+        row.type    = 1 + i % 3;
+        row.subtype = 1 + i % 5;
+        // the first ten are roots, the others are spread over them
+        row.parent = i < 10 ? 0 : 1 + i % 10;
+        rows.push_back(std::move(row));
+    }
+    return rows;
+}
+
+TEST_CASE("Asset filter / Compiled plan")
+{
+    SECTION("no filter")
+    {
+        auto plan = fty::AssetFilterPlan::compile({});
+        CHECK(plan.where().empty());
+        CHECK(plan.shape().empty());
+        CHECK(plan.filters().empty());
+    }
+
+    SECTION("values are bound and padded to the next power of two")
+    {
+        auto plan = fty::AssetFilterPlan::compile({{"status", {"active"}}, {"id_type", {"6", "5", "6", "4"}}});
+        CHECK(plan.shape() == "id_type:4,status:1");
+        CHECK(plan.where() == " WHERE id_type IN (:id_type_0, :id_type_1, :id_type_2, :id_type_3)"
+                              " AND status IN (:status_0)");
+        CHECK(plan.indexable());
+        // duplicates removed, the padding is not a value
+        CHECK(plan.filters().at("id_type") == std::vector<std::string>{"4", "5", "6"});
+    }
+
+    SECTION("shape does not depend on the values")
+    {
+        auto a = fty::AssetFilterPlan::compile({{"id_parent", {"1", "2", "3"}}});
+        auto b = fty::AssetFilterPlan::compile({{"id_parent", {"7", "8", "9", "10"}}});
+        CHECK(a.shape() == b.shape());
+        CHECK(a.where() == b.where());
+    }
+
+    SECTION("empty value lists are ignored")
+    {
+        auto plan = fty::AssetFilterPlan::compile({{"status", {}}, {"id_subtype", {"1"}}});
+        CHECK(plan.shape() == "id_subtype:1");
+        CHECK(plan.filters().count("status") == 0);
+    }
+
+    SECTION("priority is answered by SQL only")
+    {
+        CHECK(!fty::AssetFilterPlan::compile({{"priority", {"1"}}}).indexable());
+        CHECK(!fty::AssetFilterPlan::compile({{"priority", {"1"}}, {"status", {"active"}}}).indexable());
+    }
+
+    SECTION("invalid filters")
+    {
+        CHECK_THROWS_AS(fty::AssetFilterPlan::compile({{"name", {"ups-1"}}}), std::runtime_error);
+        CHECK_THROWS_AS(fty::AssetFilterPlan::compile({{"id_type", {"1 OR 1=1"}}}), std::runtime_error);
+        CHECK_THROWS_AS(fty::AssetFilterPlan::compile({{"id_parent", {"-1"}}}), std::runtime_error);
+        CHECK_THROWS_AS(fty::AssetFilterPlan::compile({{"priority", {"12345678901"}}}), std::runtime_error);
+    }
+}
+
+TEST_CASE("Asset filter / Index answers like the former query")
+{
+    auto            rows = sampleRows();
+    fty::AssetIndex index;
+    index.rebuild(rows, 0);
+
+    std::vector<Filters> filters = {
+        {{"status", {"nonactive"}}},
+        {{"id_type", {"2"}}},
+        {{"id_type", {"1", "3"}}},
+        {{"id_subtype", {"5", "1", "5"}}},
+        {{"id_parent", {"4"}}},
+        {{"id_parent", {"1", "2", "3"}}, {"status", {"active"}}},
+        {{"id_type", {"2"}}, {"id_subtype", {"3", "4"}}, {"status", {"active", "nonactive"}}},
+        {{"id_type", {"1"}}, {"id_subtype", {"1"}}, {"id_parent", {"10"}}, {"status", {"nonactive"}}},
+        // no match
+        {{"status", {"retired"}}},
+        {{"id_type", {"2"}}, {"id_parent", {"99"}}},
+    };
+
+    for (const auto& filter : filters) {
+        auto plan = fty::AssetFilterPlan::compile(filter);
+        REQUIRE(plan.indexable());
+        INFO(plan.shape());
+        CHECK(index.select(plan) == reference(rows, plan.filters()));
+    }
+
+    // without filter everything, in the order of the rows
+    CHECK(index.select(fty::AssetFilterPlan::compile({})) == reference(rows, {}));
+}
+
+TEST_CASE("Asset filter / Index freshness")
+{
+    fty::AssetIndex index;
+    CHECK(!index.enabled());
+
+    index.rebuild(sampleRows(), 1000);
+    CHECK(!index.fresh(1000));
+
+    index.setTtl(500);
+    CHECK(index.enabled());
+    CHECK(index.fresh(1000));
+    CHECK(index.fresh(1499));
+    CHECK(!index.fresh(1500));
+
+    index.rebuild({}, 2000);
+    CHECK(index.fresh(2000));
+    CHECK(index.select(fty::AssetFilterPlan::compile({{"status", {"active"}}})).empty());
+
+    // writes through DB invalidate until the next rebuild
+    index.invalidate();
+    CHECK(!index.fresh(2000));
+}
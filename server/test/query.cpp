@@ -0,0 +1,213 @@
+#include "asset/asset-query.h"
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <cxxtools/jsondeserializer.h>
+#include <cxxtools/serializationinfo.h>
+#include <map>
+#include <sstream>
+
+// asset as seen by QUERY, field -> value
+struct Sample
+{
+    std::string                        name;
+    std::map<std::string, std::string> fields;
+};
+
+// Straight evaluation of each predicate on each asset, kept as the reference for the columns
+static std::vector<std::string> reference(const std::vector<Sample>& assets, const fty::AssetQuery& query)
+{
+    std::vector<std::string> names;
+    for (const auto& asset : assets) {
+        bool match = true;
+        for (const auto& predicate : query) {
+            auto field = asset.fields.find(predicate.field);
+            if (field == asset.fields.end()) {
+                match = false;
+                break;
+            }
+            const std::string& value = field->second;
+            switch (predicate.op) {
+                case fty::QueryPredicate::Op::Exists:
+                    break;
+                case fty::QueryPredicate::Op::Prefix:
+                    match = value.compare(0, predicate.values[0].size(), predicate.values[0]) == 0;
+                    break;
+                case fty::QueryPredicate::Op::Equal:
+                case fty::QueryPredicate::Op::In:
+                    match = std::find(predicate.values.begin(), predicate.values.end(), value) !=
+                            predicate.values.end();
+                    break;
+            }
+            if (!match) {
+                break;
+            }
+        }
+        if (match) {
+            names.push_back(asset.name);
+        }
+    }
+    return names;
+}
+
+// more than 64 rows and interned values, bitsets span several words
+static std::vector<Sample> sampleAssets()
+{
+    static const char* subtypes[] = {"ups", "epdu", "pdu", "server", "feed"};
+
+    std::vector<Sample> assets;
+    for (int i = 0; i < 150; ++i) {
+        Sample asset;
+        asset.name = "device-" + std::to_string(i);
+
+        asset.fields["name"]     = asset.name;
+        asset.fields["type"]     = "device";
+        asset.fields["subtype"]  = subtypes[i % 5];
+        asset.fields["status"]   = i % 4 ? "active" : "nonactive";
+        asset.fields["priority"] = std::to_string(1 + i % 5);
+        asset.fields["parent"]   = "rack-" + std::to_string(i % 12);
+        if (i % 3) {
+            asset.fields["ext.model"] = (i % 2 ? "9PX " : "5PX ") + std::to_string(i % 6);
+        }
+        if (i % 10 == 0) {
+            asset.fields["ext.serial_no"] = "SN" + std::to_string(i);
+        }
+        assets.push_back(std::move(asset));
+    }
+    return assets;
+}
+
+static void load(fty::AssetColumns& columns, const std::vector<Sample>& assets)
+{
+    for (const auto& asset : assets) {
+        uint32_t row = columns.addAsset(asset.name);
+        for (const auto& field : asset.fields) {
+            // name is set by addAsset
+            if (field.first != "name") {
+                columns.set(row, field.first, field.second);
+            }
+        }
+    }
+}
+
+static fty::QueryPredicate predicate(
+    const std::string& field, fty::QueryPredicate::Op op, const std::vector<std::string>& values = {})
+{
+    fty::QueryPredicate predicate;
+    predicate.field  = field;
+    predicate.op     = op;
+    predicate.values = values;
+    return predicate;
+}
+
+static fty::AssetQuery parse(const std::string& json)
+{
+    cxxtools::SerializationInfo si;
+    std::istringstream          input(json);
+    cxxtools::JsonDeserializer  deserializer(input);
+    deserializer.deserialize(si);
+
+    fty::AssetQuery query;
+    si >>= query;
+    return query;
+}
+
+using Op = fty::QueryPredicate::Op;
+
+TEST_CASE("Asset columns / Queries answer like a plain scan")
+{
+    auto              assets = sampleAssets();
+    fty::AssetColumns columns;
+    load(columns, assets);
+    REQUIRE(columns.rows() == assets.size());
+    CHECK(columns.deadRows() == 0);
+
+    std::vector<fty::AssetQuery> queries = {
+        {},
+        {predicate("subtype", Op::Equal, {"ups"})},
+        {predicate("status", Op::Equal, {"nonactive"}), predicate("subtype", Op::In, {"epdu", "pdu"})},
+        {predicate("ext.model", Op::Prefix, {"9PX"})},
+        {predicate("ext.model", Op::Exists)},
+        {predicate("ext.serial_no", Op::Exists), predicate("priority", Op::In, {"1", "2"})},
+        {predicate("parent", Op::Equal, {"rack-7"}), predicate("ext.model", Op::Exists)},
+        {predicate("name", Op::Prefix, {"device-1"}), predicate("status", Op::Equal, {"active"})},
+        {predicate("name", Op::In, {"device-3", "device-140", "device-999"})},
+        // values nobody has
+        {predicate("subtype", Op::Equal, {"sts"})},
+        {predicate("ext.model", Op::Prefix, {"11PX"})},
+        {predicate("ext.unknown", Op::Exists)},
+        {predicate("subtype", Op::Equal, {"ups"}), predicate("subtype", Op::Equal, {"epdu"})},
+    };
+
+    for (size_t i = 0; i < queries.size(); ++i) {
+        INFO("query #" << i);
+        CHECK(columns.evaluate(queries[i]) == reference(assets, queries[i]));
+    }
+
+    CHECK_THROWS_AS(columns.evaluate({predicate("color", Op::Exists)}), std::runtime_error);
+}
+
+TEST_CASE("Asset columns / Reloaded and removed assets")
+{
+    auto              assets = sampleAssets();
+    fty::AssetColumns columns;
+    load(columns, assets);
+
+    fty::AssetQuery ups = {predicate("subtype", Op::Equal, {"ups"})};
+
+    // device-0 becomes an epdu and loses its serial number
+    Sample& reloaded                 = assets[0];
+    reloaded.fields["subtype"]       = "epdu";
+    reloaded.fields["ext.model"]     = "EPDU G3";
+    reloaded.fields.erase("ext.serial_no");
+    load(columns, {reloaded});
+
+    // device-5 is deleted
+    columns.removeAsset("device-5");
+    assets.erase(assets.begin() + 5);
+
+    CHECK(columns.rows() == 151);
+    CHECK(columns.deadRows() == 2);
+
+    // the reloaded asset now comes last, as its new row
+    std::rotate(assets.begin(), assets.begin() + 1, assets.end());
+
+    CHECK(columns.evaluate(ups) == reference(assets, ups));
+    CHECK(columns.evaluate({predicate("name", Op::Equal, {"device-5"})}).empty());
+    CHECK(columns.evaluate({predicate("ext.model", Op::Equal, {"EPDU G3"})}) ==
+          std::vector<std::string>{"device-0"});
+    CHECK(columns.evaluate({predicate("ext.serial_no", Op::Exists)}) ==
+          reference(assets, {predicate("ext.serial_no", Op::Exists)}));
+
+    columns.clear();
+    CHECK(columns.rows() == 0);
+    CHECK(columns.evaluate({}).empty());
+}
+
+TEST_CASE("Asset columns / Query requests")
+{
+    auto query = parse(R"({"predicates": [
+        {"field": "ext.model", "op": "prefix", "values": ["9PX"]},
+        {"field": "subtype", "op": "in", "values": ["ups", "epdu"]},
+        {"field": "status", "op": "eq", "values": ["active"]},
+        {"field": "ext.serial_no", "op": "exists"}
+    ]})");
+
+    REQUIRE(query.size() == 4);
+    CHECK(query[0].field == "ext.model");
+    CHECK(query[0].op == Op::Prefix);
+    CHECK(query[0].values == std::vector<std::string>{"9PX"});
+    CHECK(query[1].op == Op::In);
+    CHECK(query[1].values == std::vector<std::string>{"ups", "epdu"});
+    CHECK(query[2].op == Op::Equal);
+    CHECK(query[3].op == Op::Exists);
+    CHECK(query[3].values.empty());
+
+    CHECK(parse(R"({"predicates": []})").empty());
+
+    // unknown field or operator, missing or extra values
+    CHECK_THROWS(parse(R"({"predicates": [{"field": "color", "op": "eq", "values": ["red"]}]})"));
+    CHECK_THROWS(parse(R"({"predicates": [{"field": "name", "op": "like", "values": ["ups"]}]})"));
+    CHECK_THROWS(parse(R"({"predicates": [{"field": "name", "op": "in"}]})"));
+    CHECK_THROWS(parse(R"({"predicates": [{"field": "name", "op": "eq", "values": ["a", "b"]}]})"));
+    CHECK_THROWS(parse(R"({"query": []})"));
+}
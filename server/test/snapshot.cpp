@@ -0,0 +1,178 @@
+#include "asset/asset-snapshot.h"
+#include <catch2/catch.hpp>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+// snapshot file in its own temporary directory, removed when the test ends
+struct SnapshotFile
+{
+    SnapshotFile()
+    {
+        std::string tmpl = (std::filesystem::temp_directory_path() / "fty-asset-snapshot-XXXXXX").string();
+        dir              = mkdtemp(tmpl.data());
+        path             = dir + "/snapshot";
+    }
+
+    ~SnapshotFile()
+    {
+        std::filesystem::remove_all(dir);
+    }
+
+    // overwrites bytes at offset
+    void patch(size_t offset, const std::string& bytes) const
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(std::streamoff(offset));
+        file.write(bytes.data(), std::streamsize(bytes.size()));
+    }
+
+    std::string dir;
+    std::string path;
+};
+
+static std::vector<fty::AssetSnapshot::Element> sampleElements()
+{
+    fty::AssetSnapshot::Element dc;
+    dc.id       = 1;
+    dc.name     = "datacenter-3";
+    dc.type     = "datacenter";
+    dc.subtype  = "N_A";
+    dc.status   = "active";
+    dc.typeId   = 2;
+    dc.priority = 1;
+    dc.ext      = {{"name", "DC 1", false}, {"uuid", "a-b-c", true}};
+    dc.groups   = {"group-7"};
+
+    fty::AssetSnapshot::Element ups;
+    ups.id        = 5;
+    ups.name      = "ups-5";
+    ups.type      = "device";
+    ups.subtype   = "ups";
+    ups.status    = "nonactive";
+    ups.parent    = "datacenter-3";
+    ups.typeId    = 6;
+    ups.subtypeId = 1;
+    ups.parentId  = 1;
+    ups.priority  = 3;
+    ups.links     = {
+        {"epdu-6", "1", "B", 1, {{"power", "16A", false}, {"label", "main", true}}},
+        {"feed-8", "", "", 1, {}},
+    };
+
+    return {dc, ups};
+}
+
+TEST_CASE("Asset snapshot / Round trip")
+{
+    SnapshotFile file;
+
+    fty::AssetSnapshot::Checksums checksums = {11, 12, 13, 14, 15};
+    auto                          elements  = sampleElements();
+    REQUIRE(fty::AssetSnapshot::write(file.path, 42, checksums, elements));
+
+    fty::AssetSnapshot snapshot;
+    REQUIRE(snapshot.open(file.path));
+    CHECK(snapshot.sequence() == 42);
+    CHECK(snapshot.checksums() == checksums);
+    REQUIRE(snapshot.size() == 2);
+
+    auto dc = snapshot.element(0);
+    CHECK(dc.id == 1);
+    CHECK(dc.name == "datacenter-3");
+    CHECK(dc.type == "datacenter");
+    CHECK(dc.parent.empty());
+    CHECK(dc.parentId == 0);
+    REQUIRE(dc.ext.size() == 2);
+    CHECK(dc.ext[1].key == "uuid");
+    CHECK(dc.ext[1].value == "a-b-c");
+    CHECK(dc.ext[1].readOnly);
+    CHECK(dc.groups == std::vector<std::string>{"group-7"});
+    CHECK(dc.links.empty());
+
+    auto ups = snapshot.element(1);
+    CHECK(ups.id == 5);
+    CHECK(ups.subtype == "ups");
+    CHECK(ups.status == "nonactive");
+    CHECK(ups.parent == "datacenter-3");
+    CHECK(ups.typeId == 6);
+    CHECK(ups.subtypeId == 1);
+    CHECK(ups.parentId == 1);
+    CHECK(ups.priority == 3);
+    CHECK(ups.ext.empty());
+    CHECK(ups.groups.empty());
+
+    REQUIRE(ups.links.size() == 2);
+    CHECK(ups.links[0].source == "epdu-6");
+    CHECK(ups.links[0].srcOut == "1");
+    CHECK(ups.links[0].destIn == "B");
+    CHECK(ups.links[0].type == 1);
+    REQUIRE(ups.links[0].ext.size() == 2);
+    CHECK(ups.links[0].ext[0].key == "power");
+    CHECK(ups.links[0].ext[0].value == "16A");
+    CHECK(!ups.links[0].ext[0].readOnly);
+    CHECK(ups.links[0].ext[1].readOnly);
+    CHECK(ups.links[1].source == "feed-8");
+    CHECK(ups.links[1].srcOut.empty());
+    CHECK(ups.links[1].destIn.empty());
+    CHECK(ups.links[1].ext.empty());
+
+    // replaced atomically, the mapped copy stays readable
+    REQUIRE(fty::AssetSnapshot::write(file.path, 43, checksums, {}));
+    CHECK(snapshot.element(1).name == "ups-5");
+
+    fty::AssetSnapshot empty;
+    REQUIRE(empty.open(file.path));
+    CHECK(empty.sequence() == 43);
+    CHECK(empty.size() == 0);
+}
+
+TEST_CASE("Asset snapshot / Damaged files are rejected")
+{
+    SnapshotFile file;
+    REQUIRE(fty::AssetSnapshot::write(file.path, 1, {}, sampleElements()));
+    auto size = std::filesystem::file_size(file.path);
+
+    fty::AssetSnapshot snapshot;
+
+    SECTION("missing")
+    {
+        std::filesystem::remove(file.path);
+        CHECK(!snapshot.open(file.path));
+    }
+
+    SECTION("truncated")
+    {
+        std::filesystem::resize_file(file.path, size - 1);
+        CHECK(!snapshot.open(file.path));
+    }
+
+    SECTION("header only")
+    {
+        std::filesystem::resize_file(file.path, 16);
+        CHECK(!snapshot.open(file.path));
+    }
+
+    SECTION("trailing garbage")
+    {
+        std::ofstream(file.path, std::ios::app | std::ios::binary) << "garbage";
+        CHECK(!snapshot.open(file.path));
+    }
+
+    SECTION("not a snapshot")
+    {
+        file.patch(0, "XXXX");
+        CHECK(!snapshot.open(file.path));
+    }
+
+    SECTION("other version")
+    {
+        // right after the 8 byte magic
+        file.patch(8, std::string("\x63\0\0\0", 4));
+        CHECK(!snapshot.open(file.path));
+    }
+
+    CHECK(!snapshot.isOpen());
+    CHECK(snapshot.size() == 0);
+}